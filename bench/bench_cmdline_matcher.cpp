@@ -0,0 +1,106 @@
+// Compares the compiled command-line matcher against the previous chain of
+// lowercase-copy + wstring::find calls used by check_command_line_for_preset.
+
+#include <benchmark/benchmark.h>
+
+#include <cwctype>
+#include <string>
+
+#include "core/cmdline_matcher.h"
+
+namespace {
+
+std::wstring to_lower(std::wstring str) {
+    for (auto& c : str) c = towlower(c);
+    return str;
+}
+
+// Previous implementation, kept verbatim (minus preset lookup) as the baseline
+const wchar_t* legacy_check_command_line(const std::wstring& cmdLine) {
+    auto lowerCmd = to_lower(cmdLine);
+
+    if (lowerCmd.find(L"gemini-cli") != std::wstring::npos ||
+        lowerCmd.find(L"gemini\\cli") != std::wstring::npos ||
+        lowerCmd.find(L"gemini/cli") != std::wstring::npos ||
+        lowerCmd.find(L"@google\\gemini") != std::wstring::npos ||
+        lowerCmd.find(L"@google/gemini") != std::wstring::npos) {
+        return L"gemini";
+    }
+
+    if (lowerCmd.find(L"claude-code") != std::wstring::npos ||
+        lowerCmd.find(L"@anthropic") != std::wstring::npos) {
+        return L"claude";
+    }
+
+    if (lowerCmd.find(L"cursor") != std::wstring::npos) {
+        return L"cursor";
+    }
+
+    return nullptr;
+}
+
+// Node command line with a long --require chain and no match (worst case for both)
+std::wstring make_node_cmdline(int requireCount) {
+    std::wstring cmd = L"\"C:\\Program Files\\nodejs\\node.exe\"";
+    for (int i = 0; i < requireCount; i++) {
+        cmd += L" --require C:\\Users\\dev\\AppData\\Roaming\\npm\\node_modules\\some-loader-";
+        cmd += std::to_wstring(i);
+        cmd += L"\\dist\\register.js";
+    }
+    cmd += L" C:\\Users\\dev\\project\\scripts\\build.js --watch";
+    return cmd;
+}
+
+std::wstring make_gemini_cmdline(int requireCount) {
+    return make_node_cmdline(requireCount) +
+           L" C:\\Users\\dev\\AppData\\Roaming\\npm\\node_modules\\@google\\Gemini-CLI\\dist\\index.js";
+}
+
+void BM_LegacyChain_NoMatch(benchmark::State& state) {
+    std::wstring cmd = make_node_cmdline(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacy_check_command_line(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+void BM_Matcher_NoMatch(benchmark::State& state) {
+    std::wstring cmd = make_node_cmdline(static_cast<int>(state.range(0)));
+    const CmdlineMatcher& matcher = default_cmdline_matcher();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matcher.match(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+void BM_LegacyChain_Gemini(benchmark::State& state) {
+    std::wstring cmd = make_gemini_cmdline(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacy_check_command_line(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+void BM_Matcher_Gemini(benchmark::State& state) {
+    std::wstring cmd = make_gemini_cmdline(static_cast<int>(state.range(0)));
+    const CmdlineMatcher& matcher = default_cmdline_matcher();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matcher.match(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+void BM_Matcher_Compile(benchmark::State& state) {
+    for (auto _ : state) {
+        CmdlineMatcher matcher(CMDLINE_RULES, CMDLINE_RULE_COUNT);
+        benchmark::DoNotOptimize(&matcher);
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_LegacyChain_NoMatch)->Arg(0)->Arg(8)->Arg(64);
+BENCHMARK(BM_Matcher_NoMatch)->Arg(0)->Arg(8)->Arg(64);
+BENCHMARK(BM_LegacyChain_Gemini)->Arg(0)->Arg(8)->Arg(64);
+BENCHMARK(BM_Matcher_Gemini)->Arg(0)->Arg(8)->Arg(64);
+BENCHMARK(BM_Matcher_Compile);
@@ -0,0 +1,165 @@
+// Hook install, status and uninstall on agent settings files. Real settings.json
+// files can carry permission allowlists of thousands of entries, so sizes run from
+// a fresh config to several megabytes; Codex configs grow with [mcp_servers.*] tables. The DOM variants parse and reserialize the
+// whole document, which is what the in-place patcher replaced. The status benchmarks
+// compare re-reading the config with asking the install manifest.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "core/hook_config.h"
+#include "core/install_manifest.h"
+#include "core/json_value.h"
+#include "core/toml_index.h"
+
+namespace {
+
+const char* EXE = "C:\\Users\\dev\\AppData\\Local\\Programs\\toasty\\toasty.exe";
+
+// Pretty-printed Claude settings of about `size` bytes: a permissions allowlist,
+// a few scalar settings and an existing Stop hook that isn't ours
+std::string make_settings(size_t size) {
+    std::string text = "{\n  \"model\": \"opus\",\n  \"permissions\": {\n    \"allow\": [\n";
+    for (int i = 0; text.size() < size; i++) {
+        text += "      \"Bash(npm run test -- --filter \\\"suite ";
+        text += std::to_string(i);
+        text += "\\\")\",\n      \"Read(C:\\\\src\\\\app\\\\packages\\\\module";
+        text += std::to_string(i);
+        text += "\\\\**)\",\n";
+    }
+    text += "      \"WebFetch(domain:docs.example.com)\"\n    ]\n  },\n  \"includeCoAuthoredBy\": false,\n"
+            "  \"hooks\": {\n    \"Stop\": [\n      {\n        \"hooks\": [\n          {\n"
+            "            \"type\": \"command\",\n            \"command\": \"say done\"\n          }\n        ]\n      }\n"
+            "    ]\n  }\n}\n";
+    return text;
+}
+
+void config_sizes(benchmark::internal::Benchmark* b) {
+    for (long size : {1L << 10, 64L << 10, 1L << 20, 8L << 20}) b->Arg(size);
+}
+
+void BM_AddHook(benchmark::State& state) {
+    std::string settings = make_settings(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string config = settings;
+        benchmark::DoNotOptimize(add_toasty_hook(HookAgent::Claude, config, EXE));
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+void BM_AddHook_Dom(benchmark::State& state) {
+    std::string settings = make_settings(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        JsonValue root;
+        JsonValue::parse(settings, root);
+        root.find("hooks")->find("Stop")->append(JsonValue::object());
+        benchmark::DoNotOptimize(root.stringify());
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+void BM_HasHook(benchmark::State& state) {
+    std::string settings = make_settings(static_cast<size_t>(state.range(0)));
+    add_toasty_hook(HookAgent::Claude, settings, EXE);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(has_toasty_hook(HookAgent::Claude, settings));
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+void BM_RemoveHook(benchmark::State& state) {
+    std::string settings = make_settings(static_cast<size_t>(state.range(0)));
+    add_toasty_hook(HookAgent::Claude, settings, EXE);
+    for (auto _ : state) {
+        std::string config = settings;
+        benchmark::DoNotOptimize(remove_toasty_hook(HookAgent::Claude, config));
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+// Codex config.toml with `count` [mcp_servers.*] tables, each with multi-line args
+// and an env inline table, and an old toasty notify left inside [windows] at the end
+std::string make_codex_config(size_t count) {
+    std::string text = "model = \"o3\"\napproval_policy = \"on-request\"\n\n";
+    for (size_t i = 0; i < count; i++) {
+        std::string name = "server" + std::to_string(i);
+        text += "[mcp_servers." + name + "]\ncommand = \"npx\"\nargs = [\n  \"-y\",\n  \"@example/" + name +
+                "-mcp\",\n  \"--port=[" + std::to_string(3000 + i) + "]\",\n]\n"
+                "env = { TOKEN = \"${" + name + "_TOKEN}\", LOG = \"info\" }  # [not a table]\n\n";
+    }
+    text += "[windows]\nnotify = [\"C:\\\\old\\\\toasty.exe\", \"Codex finished\"]\nsandbox = \"unelevated\"\n";
+    return text;
+}
+
+void server_counts(benchmark::internal::Benchmark* b) {
+    for (long count : {4L, 64L, 1024L, 16384L}) b->Arg(count);
+}
+
+void BM_IndexToml(benchmark::State& state) {
+    std::string config = make_codex_config(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index_toml(config));
+    }
+    state.SetBytesProcessed(state.iterations() * config.size());
+}
+
+void BM_AddCodexNotify(benchmark::State& state) {
+    std::string settings = make_codex_config(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string config = settings;
+        benchmark::DoNotOptimize(add_toasty_hook(HookAgent::Codex, config, EXE));
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+void BM_RemoveCodexNotify(benchmark::State& state) {
+    std::string settings = make_codex_config(static_cast<size_t>(state.range(0)));
+    add_toasty_hook(HookAgent::Codex, settings, EXE);
+    for (auto _ : state) {
+        std::string config = settings;
+        benchmark::DoNotOptimize(remove_toasty_hook(HookAgent::Codex, config));
+    }
+    state.SetBytesProcessed(state.iterations() * settings.size());
+}
+
+// --status for one config on disk, without and with the install manifest
+std::filesystem::path write_status_config(size_t size) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "toasty_bench_status.json";
+    std::string config = make_settings(size);
+    add_toasty_hook(HookAgent::Claude, config, EXE);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << config;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    return path;
+}
+
+void BM_StatusFromFile(benchmark::State& state) {
+    std::filesystem::path path = write_status_config(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(is_hook_installed(HookAgent::Claude, path));
+    }
+}
+
+void BM_StatusFromManifest(benchmark::State& state) {
+    std::filesystem::path path = write_status_config(static_cast<size_t>(state.range(0)));
+    InstallManifest manifest = InstallManifest::load(std::filesystem::path());
+    manifest.record(HookAgent::Claude, path);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manifest.check(HookAgent::Claude, path));
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_AddHook)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddHook_Dom)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_HasHook)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RemoveHook)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IndexToml)->Apply(server_counts)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddCodexNotify)->Apply(server_counts)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RemoveCodexNotify)->Apply(server_counts)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StatusFromFile)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StatusFromManifest)->Apply(config_sizes)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,6 @@
+// Shared entry point for toasty_bench. Pass --benchmark_format=json (or
+// --benchmark_out=<file> --benchmark_out_format=json) for machine-readable results.
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,54 @@
+// Preset lookups on the auto-detection path: one find_preset per ancestor
+// process name, then check_command_line_for_preset on its command line.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "core/presets.h"
+
+namespace {
+
+void BM_FindPreset_Hit(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(find_preset(L"Cursor"));
+    }
+}
+
+void BM_FindPreset_Miss(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(find_preset(L"powershell"));
+    }
+}
+
+// Command line of state.range(0) bytes (wide chars), ending in an agent's entry
+// script when `match` is set
+std::wstring make_cmdline(size_t size, bool match) {
+    std::wstring cmd = L"\"C:\\Program Files\\nodejs\\node.exe\" --no-warnings";
+    while (cmd.size() < size) cmd += L" --require C:\\Users\\dev\\AppData\\Roaming\\npm\\loader\\register.js";
+    if (match) cmd += L" C:\\Users\\dev\\AppData\\Roaming\\npm\\node_modules\\@anthropic-ai\\claude-code\\cli.js";
+    return cmd;
+}
+
+void BM_CheckCommandLine_NoMatch(benchmark::State& state) {
+    std::wstring cmd = make_cmdline(static_cast<size_t>(state.range(0)), false);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(check_command_line_for_preset(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+void BM_CheckCommandLine_Match(benchmark::State& state) {
+    std::wstring cmd = make_cmdline(static_cast<size_t>(state.range(0)), true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(check_command_line_for_preset(cmd));
+    }
+    state.SetBytesProcessed(state.iterations() * cmd.size() * sizeof(wchar_t));
+}
+
+}  // namespace
+
+BENCHMARK(BM_FindPreset_Hit);
+BENCHMARK(BM_FindPreset_Miss);
+BENCHMARK(BM_CheckCommandLine_NoMatch)->Arg(64)->Arg(1 << 10)->Arg(32 << 10);
+BENCHMARK(BM_CheckCommandLine_Match)->Arg(64)->Arg(1 << 10)->Arg(32 << 10);
@@ -0,0 +1,57 @@
+// Notification text cleanup. Cost should follow the kept output, not the input:
+// a 4 MB agent log cut to the toast limit costs about the same as a 4 KB one.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "core/sanitize.h"
+#include "core/sinks.h"
+
+namespace {
+
+// Colored build output: SGR escapes around status words, CRLF line ends
+std::string make_colored_log(size_t size) {
+    std::string chunk = "\x1b[1;32m  PASS\x1b[0m src/app.test.ts (12 tests) \xE2\x9C\x93 caf\xC3\xA9\r\n";
+    std::string text;
+    text.reserve(size + chunk.size());
+    while (text.size() < size) text += chunk;
+    text.resize(size);
+    return text;
+}
+
+void BM_SanitizeText_Toast(benchmark::State& state) {
+    std::string text = make_colored_log(static_cast<size_t>(state.range(0)));
+    size_t limit = sink_message_limit(SinkKind::Toast);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sanitize_text(text, limit));
+    }
+}
+
+void BM_SanitizeText_Full(benchmark::State& state) {
+    std::string text = make_colored_log(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sanitize_text(text, text.size() + 16));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_SanitizeJsonString_Toast(benchmark::State& state) {
+    std::string raw;
+    for (char c : make_colored_log(static_cast<size_t>(state.range(0)))) {
+        if (c == '\x1b') raw += "\\u001b";
+        else if (c == '\r') raw += "\\r";
+        else if (c == '\n') raw += "\\n";
+        else raw += c;
+    }
+    size_t limit = sink_message_limit(SinkKind::Toast);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sanitize_json_string(raw, limit));
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SanitizeText_Toast)->Arg(256)->Arg(4 << 10)->Arg(4 << 20);
+BENCHMARK(BM_SanitizeText_Full)->Arg(256)->Arg(64 << 10);
+BENCHMARK(BM_SanitizeJsonString_Toast)->Arg(4 << 10)->Arg(4 << 20);
@@ -0,0 +1,162 @@
+#include "core/atomic_file.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Unique per process and call, so concurrent writers never share a temp file
+fs::path temp_path_for(const fs::path& target) {
+    static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    long pid = static_cast<long>(getpid());
+#endif
+    fs::path temp = target;
+    temp += "." + std::to_string(pid) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+    return temp;
+}
+
+// The file a path refers to, following symlinks so a linked config (e.g. from a
+// dotfiles repo) stays a link
+fs::path resolve_target(const fs::path& path) {
+    std::error_code ec;
+    if (!fs::is_symlink(path, ec)) return path;
+    fs::path target = fs::weakly_canonical(path, ec);
+    return ec ? path : target;
+}
+
+#ifdef _WIN32
+
+std::string last_error_text() {
+    return std::error_code(static_cast<int>(GetLastError()), std::system_category()).message();
+}
+
+bool write_and_flush(const fs::path& temp, std::string_view content, std::string& error) {
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = last_error_text();
+        return false;
+    }
+    bool ok = true;
+    size_t written = 0;
+    while (ok && written < content.size()) {
+        size_t remaining = content.size() - written;
+        DWORD chunk = remaining > (1u << 30) ? (1u << 30) : static_cast<DWORD>(remaining);
+        DWORD done = 0;
+        ok = WriteFile(file, content.data() + written, chunk, &done, nullptr) != FALSE;
+        written += done;
+    }
+    ok = ok && FlushFileBuffers(file) != FALSE;
+    if (!ok) error = last_error_text();
+    CloseHandle(file);
+    return ok;
+}
+
+// Another process may have the target open without FILE_SHARE_DELETE for a moment
+// (an editor or the agent reading it), so sharing violations are retried briefly
+bool replace_file(const fs::path& temp, const fs::path& target, std::string& error) {
+    for (int attempt = 0; attempt < 50; attempt++) {
+        if (MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            return true;
+        }
+        DWORD code = GetLastError();
+        if (code != ERROR_SHARING_VIOLATION && code != ERROR_ACCESS_DENIED) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    error = last_error_text();
+    return false;
+}
+
+#else
+
+std::string errno_text() {
+    return std::error_code(errno, std::generic_category()).message();
+}
+
+// existing: the mode of the file being replaced, or nullptr for a new file (created
+// with the umask applied, like any other)
+bool write_and_flush(const fs::path& temp, std::string_view content, std::string& error, const struct stat* existing) {
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        error = errno_text();
+        return false;
+    }
+    bool ok = true;
+    size_t written = 0;
+    while (ok && written < content.size()) {
+        ssize_t done = write(fd, content.data() + written, content.size() - written);
+        if (done < 0 && errno == EINTR) continue;
+        ok = done > 0;
+        if (ok) written += static_cast<size_t>(done);
+    }
+    // open() applied the umask; a replaced file keeps its exact mode
+    ok = ok && (!existing || fchmod(fd, existing->st_mode & 07777) == 0) && fsync(fd) == 0;
+    if (!ok) error = errno_text();
+    close(fd);
+    return ok;
+}
+
+bool replace_file(const fs::path& temp, const fs::path& target, std::string& error) {
+    if (rename(temp.c_str(), target.c_str()) != 0) {
+        error = errno_text();
+        return false;
+    }
+    // Make the rename itself durable
+    fs::path dir = target.parent_path().empty() ? fs::path(".") : target.parent_path();
+    int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
+#endif
+
+}  // namespace
+
+bool write_file_atomic(const fs::path& path, std::string_view content, std::string& error) {
+    error.clear();
+    fs::path target = resolve_target(path);
+    fs::path temp = temp_path_for(target);
+
+#ifdef _WIN32
+    bool written = write_and_flush(temp, content, error);
+#else
+    struct stat existing;
+    bool replacing = stat(target.c_str(), &existing) == 0;
+    bool written = write_and_flush(temp, content, error, replacing ? &existing : nullptr);
+#endif
+
+    if (!written || !replace_file(temp, target, error)) {
+        std::error_code ec;
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+FileStamp file_stamp(const fs::path& path) {
+    FileStamp stamp;
+    std::error_code ec;
+    fs::file_status status = fs::status(path, ec);
+    if (ec || !fs::exists(status)) return stamp;
+    stamp.exists = true;
+    stamp.size = fs::file_size(path, ec);
+    stamp.modified = fs::last_write_time(path, ec);
+    return stamp;
+}
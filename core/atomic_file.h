@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Replace a file's contents in one step: the bytes go to a temp file next to it, are
+// flushed to disk, and the temp file is renamed over the target. Readers see the old
+// file or the new one, never a truncated mix, and a crash mid-write leaves the old
+// file intact. A symlinked path is written through to its target, and an existing
+// file keeps its permissions (POSIX).
+bool write_file_atomic(const std::filesystem::path& path, std::string_view content, std::string& error);
+
+// Size and modification time, to notice that another program rewrote a file between
+// reading it and replacing it
+struct FileStamp {
+    bool exists = false;
+    uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+FileStamp file_stamp(const std::filesystem::path& path);
@@ -0,0 +1,216 @@
+#include "core/char_scan.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define TOASTY_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles AVX2 intrinsics without a target switch
+#define TOASTY_TARGET_AVX2
+#else
+#define TOASTY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// Character code as an unsigned value (wchar_t is signed on some platforms)
+template <typename Char>
+uint32_t code_of(Char c) {
+    if constexpr (sizeof(Char) == 1) return static_cast<unsigned char>(c);
+    else if constexpr (sizeof(Char) == 2) return static_cast<uint16_t>(c);
+    else return static_cast<uint32_t>(c);
+}
+
+// The set as a bitmap over ASCII
+struct AsciiMask {
+    uint64_t bits[2] = {0, 0};
+
+    explicit AsciiMask(const CharSet& set) {
+        if (set.controls) bits[0] = 0xFFFFFFFFu;
+        for (size_t k = 0; k < set.count; k++) {
+            unsigned char c = static_cast<unsigned char>(set.chars[k]);
+            if (c < 0x80) bits[c >> 6] |= uint64_t(1) << (c & 63);
+        }
+    }
+
+    bool contains(uint32_t code) const {
+        return code < 0x80 && ((bits[code >> 6] >> (code & 63)) & 1);
+    }
+};
+
+template <typename Char>
+size_t scan_scalar(const Char* text, size_t size, const CharSet& set) {
+    AsciiMask mask(set);
+    for (size_t i = 0; i < size; i++) {
+        if (mask.contains(code_of(text[i]))) return i;
+    }
+    return size;
+}
+
+unsigned first_bit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#ifdef TOASTY_SCAN_X86
+
+// Lane operations by character width. movemask gives one bit per byte, so a hit at
+// bit b is character b / sizeof(Char).
+template <size_t Width>
+struct Sse2Lanes {
+    static __m128i splat(uint32_t c) {
+        if constexpr (Width == 1) return _mm_set1_epi8(static_cast<char>(c));
+        else if constexpr (Width == 2) return _mm_set1_epi16(static_cast<short>(c));
+        else return _mm_set1_epi32(static_cast<int>(c));
+    }
+    static __m128i equal(__m128i a, __m128i b) {
+        if constexpr (Width == 1) return _mm_cmpeq_epi8(a, b);
+        else if constexpr (Width == 2) return _mm_cmpeq_epi16(a, b);
+        else return _mm_cmpeq_epi32(a, b);
+    }
+    // Lanes with an unsigned value below 0x20
+    static __m128i control(__m128i v) {
+        if constexpr (Width == 1) return _mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8(0x1F)), _mm_setzero_si128());
+        else if constexpr (Width == 2) return _mm_cmpeq_epi16(_mm_subs_epu16(v, _mm_set1_epi16(0x1F)), _mm_setzero_si128());
+        else {
+            const __m128i bias = _mm_set1_epi32(INT32_MIN);
+            return _mm_cmplt_epi32(_mm_xor_si128(v, bias), _mm_set1_epi32(INT32_MIN + 0x20));
+        }
+    }
+};
+
+template <typename Char>
+size_t scan_sse2(const Char* text, size_t size, const CharSet& set) {
+    using Lanes = Sse2Lanes<sizeof(Char)>;
+    constexpr size_t PER_VECTOR = 16 / sizeof(Char);
+
+    __m128i needles[CharSet::MAX_CHARS];
+    for (size_t k = 0; k < set.count; k++) needles[k] = Lanes::splat(static_cast<unsigned char>(set.chars[k]));
+
+    size_t i = 0;
+    for (; i + PER_VECTOR <= size; i += PER_VECTOR) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i hit = set.controls ? Lanes::control(v) : _mm_setzero_si128();
+        for (size_t k = 0; k < set.count; k++) hit = _mm_or_si128(hit, Lanes::equal(v, needles[k]));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask) return i + first_bit(mask) / sizeof(Char);
+    }
+    return i + scan_scalar(text + i, size - i, set);
+}
+
+template <size_t Width>
+struct Avx2Lanes {
+    TOASTY_TARGET_AVX2 static __m256i splat(uint32_t c) {
+        if constexpr (Width == 1) return _mm256_set1_epi8(static_cast<char>(c));
+        else if constexpr (Width == 2) return _mm256_set1_epi16(static_cast<short>(c));
+        else return _mm256_set1_epi32(static_cast<int>(c));
+    }
+    TOASTY_TARGET_AVX2 static __m256i equal(__m256i a, __m256i b) {
+        if constexpr (Width == 1) return _mm256_cmpeq_epi8(a, b);
+        else if constexpr (Width == 2) return _mm256_cmpeq_epi16(a, b);
+        else return _mm256_cmpeq_epi32(a, b);
+    }
+    TOASTY_TARGET_AVX2 static __m256i control(__m256i v) {
+        if constexpr (Width == 1) return _mm256_cmpeq_epi8(_mm256_subs_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_setzero_si256());
+        else if constexpr (Width == 2) return _mm256_cmpeq_epi16(_mm256_subs_epu16(v, _mm256_set1_epi16(0x1F)), _mm256_setzero_si256());
+        else {
+            const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+            return _mm256_cmpgt_epi32(_mm256_set1_epi32(INT32_MIN + 0x20), _mm256_xor_si256(v, bias));
+        }
+    }
+};
+
+template <typename Char>
+TOASTY_TARGET_AVX2 size_t scan_avx2(const Char* text, size_t size, const CharSet& set) {
+    using Lanes = Avx2Lanes<sizeof(Char)>;
+    constexpr size_t PER_VECTOR = 32 / sizeof(Char);
+
+    __m256i needles[CharSet::MAX_CHARS];
+    for (size_t k = 0; k < set.count; k++) needles[k] = Lanes::splat(static_cast<unsigned char>(set.chars[k]));
+
+    size_t i = 0;
+    for (; i + PER_VECTOR <= size; i += PER_VECTOR) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i hit = set.controls ? Lanes::control(v) : _mm256_setzero_si256();
+        for (size_t k = 0; k < set.count; k++) hit = _mm256_or_si256(hit, Lanes::equal(v, needles[k]));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask) return i + first_bit(mask) / sizeof(Char);
+    }
+    // The remainder is shorter than one AVX2 vector but may fill an SSE2 one
+    return i + scan_sse2(text + i, size - i, set);
+}
+
+bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    // The OS must save the YMM registers on context switches
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif  // TOASTY_SCAN_X86
+
+SimdLevel best_simd_level() {
+#ifdef TOASTY_SCAN_X86
+    static const SimdLevel best = cpu_has_avx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    return best;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+std::atomic<SimdLevel>& current_level() {
+    static std::atomic<SimdLevel> level{best_simd_level()};
+    return level;
+}
+
+template <typename Char>
+size_t find_in_set(std::basic_string_view<Char> text, const CharSet& set, size_t from) {
+    if (from >= text.size()) return text.size();
+    const Char* start = text.data() + from;
+    size_t size = text.size() - from;
+    switch (current_level().load(std::memory_order_relaxed)) {
+#ifdef TOASTY_SCAN_X86
+        case SimdLevel::Avx2: return from + scan_avx2(start, size, set);
+        case SimdLevel::Sse2: return from + scan_sse2(start, size, set);
+#endif
+        default: return from + scan_scalar(start, size, set);
+    }
+}
+
+}  // namespace
+
+size_t find_first_in_set(std::string_view text, const CharSet& set, size_t from) {
+    return find_in_set(text, set, from);
+}
+
+size_t find_first_in_set(std::wstring_view text, const CharSet& set, size_t from) {
+    return find_in_set(text, set, from);
+}
+
+SimdLevel simd_level() {
+    return current_level().load(std::memory_order_relaxed);
+}
+
+void force_simd_level(SimdLevel level) {
+    SimdLevel best = best_simd_level();
+    current_level().store(level > best ? best : level, std::memory_order_relaxed);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Vectorized search for the next character that needs escaping. Escapers use it to
+// copy the clean runs between special characters in bulk, and to skip the copy
+// entirely when there is nothing to escape.
+
+// Up to CharSet::MAX_CHARS ASCII characters, optionally plus every control
+// character below 0x20
+struct CharSet {
+    static constexpr size_t MAX_CHARS = 8;
+
+    char chars[MAX_CHARS];
+    size_t count;
+    bool controls;
+};
+
+// Index of the first character of text in set, at or after from; text.size() if none
+size_t find_first_in_set(std::string_view text, const CharSet& set, size_t from = 0);
+size_t find_first_in_set(std::wstring_view text, const CharSet& set, size_t from = 0);
+
+// Implementation picked at startup from what the CPU supports: AVX2 or SSE2 on
+// x86/x64, scalar elsewhere. force_simd_level lets tests and benchmarks pin a
+// lower level (a level the CPU lacks is clamped to the best supported one).
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+SimdLevel simd_level();
+void force_simd_level(SimdLevel level);
@@ -0,0 +1,114 @@
+#include "core/cmdline_matcher.h"
+
+#include <climits>
+#include <deque>
+
+const CmdlineRule CMDLINE_RULES[] = {
+    // Gemini CLI (multiple install layouts)
+    { L"gemini-cli",     L"gemini", 30 },
+    { L"gemini\\cli",    L"gemini", 30 },
+    { L"gemini/cli",     L"gemini", 30 },
+    { L"@google\\gemini", L"gemini", 30 },
+    { L"@google/gemini", L"gemini", 30 },
+
+    // Claude Code (in case it runs via Node too)
+    { L"claude-code",    L"claude", 20 },
+    { L"@anthropic",     L"claude", 20 },
+
+    // Cursor
+    { L"cursor",         L"cursor", 10 },
+};
+
+const size_t CMDLINE_RULE_COUNT = sizeof(CMDLINE_RULES) / sizeof(CMDLINE_RULES[0]);
+
+namespace {
+
+// ASCII case fold; everything outside ASCII maps to NUL, which no pattern contains
+inline int fold_char(wchar_t c) {
+    if (c >= 0x80) return 0;
+    if (c >= L'A' && c <= L'Z') return c - L'A' + L'a';
+    return static_cast<int>(c);
+}
+
+}  // namespace
+
+CmdlineMatcher::CmdlineMatcher(const CmdlineRule* rules, size_t count)
+    : rules(rules), topPriority(INT_MIN) {
+    // Build the trie; -1 marks a missing edge until failure links fill it in
+    transitions.assign(ALPHABET, -1);
+    outputs.assign(1, -1);
+
+    auto better = [rules](int32_t a, int32_t b) {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        return rules[b].priority > rules[a].priority ? b : a;
+    };
+
+    for (size_t r = 0; r < count; r++) {
+        int32_t state = 0;
+        for (wchar_t c : rules[r].pattern) {
+            int32_t& edge = transitions[state * ALPHABET + fold_char(c)];
+            if (edge < 0) {
+                edge = static_cast<int32_t>(outputs.size());
+                outputs.push_back(-1);
+                transitions.resize(transitions.size() + ALPHABET, -1);
+            }
+            state = transitions[state * ALPHABET + fold_char(c)];
+        }
+        outputs[state] = better(outputs[state], static_cast<int32_t>(r));
+        if (rules[r].priority > topPriority) topPriority = rules[r].priority;
+    }
+
+    // Breadth-first: resolve failure links into a complete DFA and merge outputs
+    std::vector<int32_t> failure(outputs.size(), 0);
+    std::deque<int32_t> queue;
+    for (int c = 0; c < ALPHABET; c++) {
+        int32_t& edge = transitions[c];
+        if (edge < 0) {
+            edge = 0;
+        } else {
+            failure[edge] = 0;
+            queue.push_back(edge);
+        }
+    }
+
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+        outputs[state] = better(outputs[state], outputs[failure[state]]);
+
+        for (int c = 0; c < ALPHABET; c++) {
+            int32_t& edge = transitions[state * ALPHABET + c];
+            int32_t fallback = transitions[failure[state] * ALPHABET + c];
+            if (edge < 0) {
+                edge = fallback;
+            } else {
+                failure[edge] = fallback;
+                queue.push_back(edge);
+            }
+        }
+    }
+}
+
+const CmdlineRule* CmdlineMatcher::match(std::wstring_view text) const {
+    const int32_t* next = transitions.data();
+    const int32_t* out = outputs.data();
+
+    int32_t state = 0;
+    int32_t best = -1;
+    for (wchar_t c : text) {
+        state = next[state * ALPHABET + fold_char(c)];
+        int32_t hit = out[state];
+        if (hit >= 0 && (best < 0 || rules[hit].priority > rules[best].priority)) {
+            best = hit;
+            if (rules[best].priority == topPriority) break;  // Nothing can beat it
+        }
+    }
+
+    return best < 0 ? nullptr : &rules[best];
+}
+
+const CmdlineMatcher& default_cmdline_matcher() {
+    static const CmdlineMatcher matcher(CMDLINE_RULES, CMDLINE_RULE_COUNT);
+    return matcher;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A command-line pattern that identifies an AI CLI running under a generic host
+// (node.exe, python.exe, ...). Patterns are ASCII and matched case-insensitively.
+struct CmdlineRule {
+    std::wstring_view pattern;
+    std::wstring_view preset;   // Name of the AppPreset this pattern selects
+    int priority;               // Highest priority wins when several rules match
+};
+
+// Built-in rules used by process-tree auto-detection
+extern const CmdlineRule CMDLINE_RULES[];
+extern const size_t CMDLINE_RULE_COUNT;
+
+// Case-insensitive multi-pattern matcher (Aho-Corasick compiled into a dense DFA).
+// Built once; match() scans a command line in a single pass without allocating.
+class CmdlineMatcher {
+public:
+    CmdlineMatcher(const CmdlineRule* rules, size_t count);
+
+    // Returns the highest-priority rule whose pattern occurs in text, or nullptr
+    const CmdlineRule* match(std::wstring_view text) const;
+
+private:
+    static constexpr int ALPHABET = 128;  // Non-ASCII input never matches an ASCII pattern
+
+    const CmdlineRule* rules;
+    std::vector<int32_t> transitions;  // state * ALPHABET + char -> next state
+    std::vector<int32_t> outputs;      // state -> best rule ending here (via suffix links), -1 if none
+    int topPriority;
+};
+
+// Matcher over CMDLINE_RULES, compiled on first use
+const CmdlineMatcher& default_cmdline_matcher();
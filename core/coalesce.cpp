@@ -0,0 +1,196 @@
+#include "core/coalesce.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "core/file_lock.h"
+#include "core/presets.h"
+#include "core/strings.h"
+
+namespace {
+
+const char BURST_MAGIC[] = "TOASTY-BURST 1\n";
+const int SPOOL_LOCK_TIMEOUT_MS = 2000;
+
+std::filesystem::path lock_path_for(const std::filesystem::path& spoolPath) {
+    std::filesystem::path lockPath = spoolPath;
+    lockPath += ".lock";
+    return lockPath;
+}
+
+std::string read_spool(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool write_spool(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file << data;
+    return file.good();
+}
+
+// Parse one unsigned decimal followed by a single separator character
+template <typename T>
+bool read_number(std::string_view data, size_t& pos, T& value, char separator) {
+    const char* begin = data.data() + pos;
+    const char* end = data.data() + data.size();
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc() || result.ptr == end || *result.ptr != separator) return false;
+    pos = static_cast<size_t>(result.ptr - data.data()) + 1;
+    return true;
+}
+
+}  // namespace
+
+int parse_coalesce_window(std::string_view text) {
+    int ms = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), ms);
+    if (result.ec == std::errc::result_out_of_range && !text.empty() && text[0] != '-') {
+        return MAX_BURST_WINDOW_MS;
+    }
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() || ms <= 0) {
+        return 0;
+    }
+    return std::min(ms, MAX_BURST_WINDOW_MS);
+}
+
+std::string serialize_burst(const BurstState& state) {
+    std::ostringstream out;
+    out << BURST_MAGIC << state.leaderPid << ' ' << state.leaderStart << ' '
+        << state.deadlineMs << ' ' << state.entries.size() << '\n';
+    for (const auto& entry : state.entries) {
+        out << entry.source.size() << ' ' << entry.title.size() << ' ' << entry.message.size() << '\n'
+            << entry.source << entry.title << entry.message;
+    }
+    return out.str();
+}
+
+bool parse_burst(std::string_view data, BurstState& state) {
+    state = BurstState();
+    std::string_view magic(BURST_MAGIC);
+    if (data.substr(0, magic.size()) != magic) return false;
+
+    size_t pos = magic.size();
+    size_t count = 0;
+    if (!read_number(data, pos, state.leaderPid, ' ') ||
+        !read_number(data, pos, state.leaderStart, ' ') ||
+        !read_number(data, pos, state.deadlineMs, ' ') ||
+        !read_number(data, pos, count, '\n')) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        size_t sourceLen = 0, titleLen = 0, messageLen = 0;
+        if (!read_number(data, pos, sourceLen, ' ') ||
+            !read_number(data, pos, titleLen, ' ') ||
+            !read_number(data, pos, messageLen, '\n')) {
+            return false;
+        }
+        size_t total = sourceLen + titleLen + messageLen;
+        if (total > data.size() - pos) return false;
+
+        BurstEntry entry;
+        entry.source = data.substr(pos, sourceLen);
+        entry.title = data.substr(pos + sourceLen, titleLen);
+        entry.message = data.substr(pos + sourceLen + titleLen, messageLen);
+        state.entries.push_back(std::move(entry));
+        pos += total;
+    }
+    return true;
+}
+
+BurstRole join_burst(const std::filesystem::path& spoolPath, const BurstEntry& entry,
+                     uint32_t pid, uint64_t startTime, int windowMs, int64_t nowMs,
+                     const ProcessAliveFn& isAlive) {
+    FileLock lock(lock_path_for(spoolPath), SPOOL_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        return BurstRole::Alone;  // Can't coordinate: show our own notification
+    }
+
+    BurstState state;
+    bool open = parse_burst(read_spool(spoolPath), state) && !state.entries.empty() &&
+                nowMs <= state.deadlineMs + BURST_GRACE_MS &&
+                isAlive(state.leaderPid, state.leaderStart);
+
+    BurstRole role = BurstRole::Follower;
+    if (!open) {
+        // Start a new burst (keeping any entries an abandoned leader never showed)
+        state.leaderPid = pid;
+        state.leaderStart = startTime;
+        state.deadlineMs = nowMs + windowMs;
+        role = BurstRole::Leader;
+    }
+    state.entries.push_back(entry);
+
+    if (!write_spool(spoolPath, serialize_burst(state))) {
+        return BurstRole::Alone;
+    }
+    return role;
+}
+
+bool close_burst(const std::filesystem::path& spoolPath, uint32_t pid, uint64_t startTime,
+                 std::vector<BurstEntry>& entries) {
+    entries.clear();
+    FileLock lock(lock_path_for(spoolPath), SPOOL_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        return true;
+    }
+
+    // Only a takeover changes the leader. The spool then holds the new leader's burst,
+    // or nothing once that closed, and our entry went with it.
+    BurstState state;
+    if (!parse_burst(read_spool(spoolPath), state) ||
+        state.leaderPid != pid || state.leaderStart != startTime) {
+        return false;
+    }
+
+    write_spool(spoolPath, "");
+    entries = std::move(state.entries);
+    return true;
+}
+
+BurstSummary summarize_burst(const std::vector<BurstEntry>& entries) {
+    BurstSummary summary;
+    if (entries.empty()) return summary;
+
+    if (entries.size() == 1) {
+        summary.title = entries[0].title;
+        summary.message = entries[0].message;
+        summary.source = entries[0].source;
+        return summary;
+    }
+
+    // Count per source, in order of first arrival
+    std::vector<std::pair<std::string, size_t>> counts;
+    bool allAgents = true;
+    for (const auto& entry : entries) {
+        allAgents = allAgents && find_preset(from_utf8(entry.source)) != nullptr;
+        bool found = false;
+        for (auto& count : counts) {
+            if (count.first == entry.source) {
+                count.second++;
+                found = true;
+                break;
+            }
+        }
+        if (!found) counts.emplace_back(entry.source, 1);
+    }
+
+    summary.title = std::to_string(entries.size()) + (allAgents ? " agents finished" : " notifications");
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (i > 0) summary.message += ", ";
+        summary.message += counts[i].first;
+        if (counts[i].second > 1) {
+            summary.message += " \xC3\x97" + std::to_string(counts[i].second);  // U+00D7 multiplication sign
+        }
+    }
+    if (counts.size() == 1) {
+        summary.source = counts[0].first;
+    }
+    return summary;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Burst coalescing: notifications that arrive within a short window, typically from
+// concurrent toasty processes, are merged into one summary toast. Processes share a
+// small spool file guarded by a FileLock. The first arrival leads the burst, waits
+// out the window, then shows everything that joined; later arrivals just append.
+// All strings are UTF-8.
+
+struct BurstEntry {
+    std::string source;   // Preset name, or the title when no preset applies
+    std::string title;
+    std::string message;
+};
+
+struct BurstState {
+    uint32_t leaderPid = 0;
+    uint64_t leaderStart = 0;   // Leader's process start time, guards against PID reuse
+    int64_t deadlineMs = 0;     // Wall clock (ms since epoch) when the leader closes the burst
+    std::vector<BurstEntry> entries;
+};
+
+// Alone: the spool couldn't be used, so show the notification now without a window
+enum class BurstRole { Leader, Follower, Alone };
+
+// A burst whose leader is this late past its deadline is considered abandoned
+const int64_t BURST_GRACE_MS = 2000;
+
+// The leader waits out the window inside the agent's hook, which is killed after 5 s
+// (Copilot timeoutSec, Gemini timeout): longer windows are cut to this, leaving time
+// to show the summary
+const int MAX_BURST_WINDOW_MS = 3000;
+
+// TOASTY_COALESCE_MS: the window in ms, capped at MAX_BURST_WINDOW_MS; 0 (off) if
+// empty or not a positive number
+int parse_coalesce_window(std::string_view text);
+
+// Liveness check for a burst leader, supplied by the platform layer
+using ProcessAliveFn = std::function<bool(uint32_t pid, uint64_t startTime)>;
+
+std::string serialize_burst(const BurstState& state);
+bool parse_burst(std::string_view data, BurstState& state);
+
+// Append entry to the open burst, or open a new one led by (pid, startTime).
+// Entries of an abandoned burst (dead or stuck leader) are carried into the new one.
+BurstRole join_burst(const std::filesystem::path& spoolPath, const BurstEntry& entry,
+                     uint32_t pid, uint64_t startTime, int windowMs, int64_t nowMs,
+                     const ProcessAliveFn& isAlive);
+
+// Leader only: close the burst and move everything that joined it into entries. False
+// if another process took the burst over, carrying our entry into its own: show
+// nothing then, or the notification appears twice. If the spool can't be locked,
+// entries is left empty and the leader shows its own notification.
+bool close_burst(const std::filesystem::path& spoolPath, uint32_t pid, uint64_t startTime,
+                 std::vector<BurstEntry>& entries);
+
+struct BurstSummary {
+    std::string title;
+    std::string message;
+    std::string source;   // Set when every entry shares one source
+};
+
+// One entry is returned as-is; several become "3 agents finished" / "claude ×2, gemini",
+// or "3 notifications" when a source isn't an agent preset (plain `toasty "Build done"`)
+BurstSummary summarize_burst(const std::vector<BurstEntry>& entries);
@@ -0,0 +1,86 @@
+#include "core/file_lock.h"
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Retry a non-blocking lock attempt until it succeeds or the timeout expires
+template <typename TryLock>
+bool lock_with_timeout(TryLock tryLock, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        if (tryLock()) return true;
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+FileLock::FileLock(const std::filesystem::path& path, int timeoutMs) {
+    handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return;
+
+    auto tryLock = [this](DWORD flags) {
+        OVERLAPPED overlapped = {};
+        return LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK | flags, 0, 1, 0, &overlapped) != FALSE;
+    };
+
+    if (timeoutMs < 0) {
+        isLocked = tryLock(0);
+    } else {
+        isLocked = lock_with_timeout([&tryLock]() { return tryLock(LOCKFILE_FAIL_IMMEDIATELY); }, timeoutMs);
+    }
+}
+
+FileLock::~FileLock() {
+    if (handle == INVALID_HANDLE_VALUE) return;
+    if (isLocked) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(handle, 0, 1, 0, &overlapped);
+    }
+    CloseHandle(handle);
+}
+
+#else
+
+FileLock::FileLock(const std::filesystem::path& path, int timeoutMs) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return;
+
+    auto tryLock = [this](int flags) {
+        int result;
+        do {
+            result = flock(fd, LOCK_EX | flags);
+        } while (result != 0 && errno == EINTR);
+        return result == 0;
+    };
+
+    if (timeoutMs < 0) {
+        isLocked = tryLock(0);
+    } else {
+        isLocked = lock_with_timeout([&tryLock]() { return tryLock(LOCK_NB); }, timeoutMs);
+    }
+}
+
+FileLock::~FileLock() {
+    if (fd < 0) return;
+    if (isLocked) flock(fd, LOCK_UN);
+    close(fd);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+// Exclusive advisory lock on a lock file, held for the lifetime of the object.
+// Cooperating toasty processes (and threads) serialize on the same path.
+// LockFileEx on Windows, flock elsewhere.
+class FileLock {
+public:
+    // timeoutMs < 0 waits forever; check locked() afterwards
+    explicit FileLock(const std::filesystem::path& path, int timeoutMs = -1);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool locked() const { return isLocked; }
+
+private:
+#ifdef _WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+    bool isLocked = false;
+};
@@ -0,0 +1,665 @@
+#include "core/history_log.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+
+#include "core/atomic_file.h"
+#include "core/file_lock.h"
+#include "core/json_value.h"
+#include "core/sanitize.h"
+#include "core/strings.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t TIME_INDEX_MAGIC = 0x54485354;    // "TSHT"
+const uint32_t PRESET_INDEX_MAGIC = 0x50485354;  // "TSHP"
+const uint32_t CATALOG_MAGIC = 0x43485354;       // "TSHC"
+const size_t HEADER_BYTES = 16;                  // [u32 magic][u32 version][u64 sequence]
+const size_t RECORD_HEADER_BYTES = 8;            // [u32 body size][u32 checksum]
+const size_t RECORD_FIXED_BYTES = 26;            // Body up to the variable-length fields
+const size_t TIME_ENTRY_BYTES = 16;              // [i64 latest before][u32 offset][u32 record number]
+const size_t PRESET_ENTRY_BYTES = 8;             // [u32 preset hash][u32 offset]
+const size_t CATALOG_ENTRY_BYTES = 40;           // [u64 sequence][i64 first][i64 latest][u64 bloom][u32 records][u32 0]
+const uint32_t MAX_RECORD_BYTES = 4 * 1024 * 1024;
+const size_t MAX_STORED_MESSAGE = 1024 * 1024;
+const int HISTORY_LOCK_TIMEOUT_MS = 2000;
+const int64_t NO_TIME = std::numeric_limits<int64_t>::min();
+const size_t HISTORY_LINE_MESSAGE_BYTES = 160;   // --history shows the start of long messages
+
+// Little endian regardless of the host, so a log survives being copied elsewhere
+void put_u16(std::string& out, uint16_t value) {
+    for (int i = 0; i < 2; i++) out += static_cast<char>(value >> (8 * i));
+}
+
+void put_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out += static_cast<char>(value >> (8 * i));
+}
+
+void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out += static_cast<char>(value >> (8 * i));
+}
+
+uint64_t get_le(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | static_cast<unsigned char>(data[i]);
+    return value;
+}
+
+// Preset names are matched case-insensitively; 0 is kept for "no preset"
+uint32_t preset_hash(std::string_view preset) {
+    uint32_t hash = fnv1a_32(to_lower_ascii(preset));
+    return hash == 0 ? 1 : hash;
+}
+
+uint64_t bloom_bit(uint32_t hash) {
+    return 1ULL << (hash % 64);
+}
+
+std::string header(uint32_t magic, uint64_t sequence) {
+    std::string out;
+    put_u32(out, magic);
+    put_u32(out, HISTORY_VERSION);
+    put_u64(out, sequence);
+    return out;
+}
+
+bool valid_header(const std::string& bytes, uint32_t magic) {
+    return bytes.size() >= HEADER_BYTES && get_le(bytes.data(), 4) == magic &&
+           get_le(bytes.data() + 4, 4) == HISTORY_VERSION;
+}
+
+std::string read_header(const fs::path& path) {
+    std::string bytes(HEADER_BYTES, '\0');
+    std::ifstream file(path, std::ios::binary);
+    file.read(bytes.data(), HEADER_BYTES);
+    bytes.resize(static_cast<size_t>(file.gcount()));
+    return bytes;
+}
+
+bool append_file(const fs::path& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    file.flush();
+    return file.good();
+}
+
+// Fixed-size entries after the header; a torn last entry is ignored
+template <typename Entry, typename Decode>
+std::vector<Entry> read_entries(const fs::path& path, uint32_t magic, size_t entryBytes, Decode decode) {
+    std::vector<Entry> entries;
+    std::string bytes = read_file_bytes(path);
+    if (!valid_header(bytes, magic)) return entries;
+    for (size_t pos = HEADER_BYTES; pos + entryBytes <= bytes.size(); pos += entryBytes) {
+        entries.push_back(decode(bytes.data() + pos));
+    }
+    return entries;
+}
+
+struct TimeMark {
+    int64_t latestBefore;    // Latest timestamp of the records before this one
+    uint32_t offset;
+    uint32_t record;
+};
+
+struct PresetEntry {
+    uint32_t hash;
+    uint32_t offset;
+};
+
+struct CatalogEntry {
+    uint64_t sequence = 0;
+    int64_t firstMs = 0;
+    int64_t latestMs = 0;
+    uint64_t bloom = 0;
+    uint32_t records = 0;
+};
+
+std::vector<TimeMark> read_time_marks(const fs::path& path) {
+    return read_entries<TimeMark>(path, TIME_INDEX_MAGIC, TIME_ENTRY_BYTES, [](const char* p) {
+        return TimeMark{ static_cast<int64_t>(get_le(p, 8)), static_cast<uint32_t>(get_le(p + 8, 4)),
+                         static_cast<uint32_t>(get_le(p + 12, 4)) };
+    });
+}
+
+std::vector<PresetEntry> read_preset_entries(const fs::path& path) {
+    return read_entries<PresetEntry>(path, PRESET_INDEX_MAGIC, PRESET_ENTRY_BYTES, [](const char* p) {
+        return PresetEntry{ static_cast<uint32_t>(get_le(p, 4)), static_cast<uint32_t>(get_le(p + 4, 4)) };
+    });
+}
+
+std::vector<CatalogEntry> read_catalog(const fs::path& path) {
+    return read_entries<CatalogEntry>(path, CATALOG_MAGIC, CATALOG_ENTRY_BYTES, [](const char* p) {
+        CatalogEntry entry;
+        entry.sequence = get_le(p, 8);
+        entry.firstMs = static_cast<int64_t>(get_le(p + 8, 8));
+        entry.latestMs = static_cast<int64_t>(get_le(p + 16, 8));
+        entry.bloom = get_le(p + 24, 8);
+        entry.records = static_cast<uint32_t>(get_le(p + 32, 4));
+        return entry;
+    });
+}
+
+std::string encode_catalog_entry(const CatalogEntry& entry) {
+    std::string out;
+    put_u64(out, entry.sequence);
+    put_u64(out, static_cast<uint64_t>(entry.firstMs));
+    put_u64(out, static_cast<uint64_t>(entry.latestMs));
+    put_u64(out, entry.bloom);
+    put_u32(out, entry.records);
+    put_u32(out, 0);
+    return out;
+}
+
+std::string encode_record(const HistoryRecord& record) {
+    std::string_view preset = std::string_view(record.preset).substr(0, 0xffff);
+    std::string_view title = std::string_view(record.title).substr(0, 0xffff);
+    std::string_view message = std::string_view(record.message).substr(0, MAX_STORED_MESSAGE);
+    size_t sinkCount = std::min<size_t>(record.sinks.size(), 0xff);
+
+    std::string body;
+    put_u64(body, static_cast<uint64_t>(record.timestampMs));
+    put_u64(body, fnv1a_64(record.message));
+    body += static_cast<char>(record.outcome);
+    body += static_cast<char>(sinkCount);
+    put_u16(body, static_cast<uint16_t>(preset.size()));
+    put_u16(body, static_cast<uint16_t>(title.size()));
+    put_u32(body, static_cast<uint32_t>(message.size()));
+    body += preset;
+    body += title;
+    body += message;
+    for (size_t i = 0; i < sinkCount; i++) {
+        std::string_view name = std::string_view(record.sinks[i].name).substr(0, 0xff);
+        body += static_cast<char>(name.size());
+        body += name;
+        body += static_cast<char>(record.sinks[i].status);
+    }
+
+    std::string out;
+    put_u32(out, static_cast<uint32_t>(body.size()));
+    put_u32(out, fnv1a_32(body));
+    return out + body;
+}
+
+bool decode_record(std::string_view body, HistoryRecord& record) {
+    if (body.size() < RECORD_FIXED_BYTES) return false;
+    const char* p = body.data();
+    record.timestampMs = static_cast<int64_t>(get_le(p, 8));
+    record.messageHash = get_le(p + 8, 8);
+    record.outcome = static_cast<HistoryOutcome>(static_cast<uint8_t>(p[16]));
+    size_t sinkCount = static_cast<uint8_t>(p[17]);
+    size_t presetLen = get_le(p + 18, 2);
+    size_t titleLen = get_le(p + 20, 2);
+    size_t messageLen = get_le(p + 22, 4);
+
+    size_t pos = RECORD_FIXED_BYTES;
+    if (body.size() - pos < presetLen + titleLen + messageLen) return false;
+    record.preset.assign(body.substr(pos, presetLen));
+    pos += presetLen;
+    record.title.assign(body.substr(pos, titleLen));
+    pos += titleLen;
+    record.message.assign(body.substr(pos, messageLen));
+    pos += messageLen;
+
+    record.sinks.clear();
+    for (size_t i = 0; i < sinkCount; i++) {
+        if (pos >= body.size()) return false;
+        size_t nameLen = static_cast<uint8_t>(body[pos++]);
+        if (body.size() - pos < nameLen + 1) return false;
+        HistorySink sink;
+        sink.name.assign(body.substr(pos, nameLen));
+        pos += nameLen;
+        sink.status = static_cast<HistorySinkStatus>(static_cast<uint8_t>(body[pos++]));
+        record.sinks.push_back(std::move(sink));
+    }
+    return true;
+}
+
+// The record at offset, if it is whole; next is where the one after it starts
+bool read_record_at(std::ifstream& file, uint64_t offset, std::string& body, uint64_t& next) {
+    char head[RECORD_HEADER_BYTES];
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    if (!file.read(head, RECORD_HEADER_BYTES)) return false;
+    uint32_t size = static_cast<uint32_t>(get_le(head, 4));
+    if (size < RECORD_FIXED_BYTES || size > MAX_RECORD_BYTES) return false;
+    body.resize(size);
+    if (!file.read(body.data(), size)) return false;
+    if (fnv1a_32(body) != static_cast<uint32_t>(get_le(head + 4, 4))) return false;
+    next = offset + RECORD_HEADER_BYTES + size;
+    return true;
+}
+
+int64_t record_time(std::string_view body) {
+    return static_cast<int64_t>(get_le(body.data(), 8));
+}
+
+struct SegmentFiles {
+    uint64_t sequence = 0;
+    fs::path log;
+    fs::path timeIndex;
+    fs::path presetIndex;
+};
+
+SegmentFiles segment_files(const fs::path& dir, uint64_t sequence) {
+    char stem[24];
+    std::snprintf(stem, sizeof(stem), "%08llu", static_cast<unsigned long long>(sequence));
+    SegmentFiles files;
+    files.sequence = sequence;
+    files.log = dir / (std::string(stem) + ".seg");
+    files.timeIndex = dir / (std::string(stem) + ".tix");
+    files.presetIndex = dir / (std::string(stem) + ".pix");
+    return files;
+}
+
+// Segment sequence numbers present in dir, oldest first
+std::vector<uint64_t> list_segments(const fs::path& dir) {
+    std::vector<uint64_t> sequences;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".seg") continue;
+        std::string stem = it->path().stem().string();
+        uint64_t sequence = 0;
+        auto result = std::from_chars(stem.data(), stem.data() + stem.size(), sequence);
+        if (result.ec == std::errc() && result.ptr == stem.data() + stem.size() && sequence > 0) {
+            sequences.push_back(sequence);
+        }
+    }
+    std::sort(sequences.begin(), sequences.end());
+    return sequences;
+}
+
+// Where the active segment stands, found from its last time mark. A record torn by
+// a crash (and any index entry pointing at or past it) is cut off here.
+struct SegmentTail {
+    uint64_t end = HEADER_BYTES;
+    uint32_t records = 0;
+    int64_t latestMs = NO_TIME;
+};
+
+// Cut a fixed-width index back to whole entries (and, given offsetOf, to entries that
+// point below end) before anything is appended to it: a torn entry would otherwise
+// shift every later one. A file without a valid header is removed and started over.
+// Only the header and last entry are read unless something needs cutting.
+void trim_index(const fs::path& path, uint32_t magic, size_t entryBytes, uint64_t end,
+                const std::function<uint64_t(const char*)>& offsetOf) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec) return;
+    std::ifstream file(path, std::ios::binary);
+    std::string head(HEADER_BYTES, '\0');
+    file.read(head.data(), HEADER_BYTES);
+    if (!file || !valid_header(head, magic)) {
+        file.close();
+        fs::remove(path, ec);
+        return;
+    }
+
+    uintmax_t whole = size - (size - HEADER_BYTES) % entryBytes;
+    if (whole == size) {
+        if (whole == HEADER_BYTES || !offsetOf) return;
+        std::string last(entryBytes, '\0');
+        file.seekg(static_cast<std::streamoff>(whole - entryBytes));
+        if (file.read(last.data(), static_cast<std::streamsize>(entryBytes)) && offsetOf(last.data()) < end) return;
+    }
+    file.close();
+
+    uintmax_t keep = whole;
+    if (offsetOf) {
+        std::string bytes = read_file_bytes(path);
+        keep = HEADER_BYTES;
+        while (keep + entryBytes <= whole && offsetOf(bytes.data() + keep) < end) keep += entryBytes;
+    }
+    fs::resize_file(path, keep, ec);
+}
+
+SegmentTail recover_tail(const SegmentFiles& files) {
+    SegmentTail tail;
+    trim_index(files.timeIndex, TIME_INDEX_MAGIC, TIME_ENTRY_BYTES, std::numeric_limits<uint64_t>::max(), nullptr);
+    std::vector<TimeMark> marks = read_time_marks(files.timeIndex);
+
+    // Start from the last mark whose record is intact
+    std::ifstream log(files.log, std::ios::binary);
+    std::string body;
+    uint64_t next = 0;
+    uint64_t pos = HEADER_BYTES;
+    while (!marks.empty()) {
+        if (read_record_at(log, marks.back().offset, body, next)) {
+            pos = marks.back().offset;
+            tail.records = marks.back().record;
+            tail.latestMs = marks.back().latestBefore;
+            break;
+        }
+        marks.pop_back();
+    }
+
+    while (read_record_at(log, pos, body, next)) {
+        tail.records++;
+        tail.latestMs = std::max(tail.latestMs, record_time(body));
+        pos = next;
+    }
+    tail.end = pos;
+    log.close();
+
+    std::error_code ec;
+    if (fs::file_size(files.log, ec) > tail.end && !ec) {
+        fs::resize_file(files.log, tail.end, ec);
+    }
+    trim_index(files.timeIndex, TIME_INDEX_MAGIC, TIME_ENTRY_BYTES, tail.end,
+               [](const char* p) { return get_le(p + 8, 4); });
+    trim_index(files.presetIndex, PRESET_INDEX_MAGIC, PRESET_ENTRY_BYTES, tail.end,
+               [](const char* p) { return get_le(p + 4, 4); });
+    return tail;
+}
+
+bool create_segment(const SegmentFiles& files) {
+    std::ofstream log(files.log, std::ios::binary | std::ios::trunc);
+    std::string head = header(HISTORY_SEGMENT_MAGIC, files.sequence);
+    log.write(head.data(), static_cast<std::streamsize>(head.size()));
+    std::error_code ec;
+    fs::remove(files.timeIndex, ec);
+    fs::remove(files.presetIndex, ec);
+    return log.good();
+}
+
+// Catalog entry for a full segment: its time range and which presets it holds
+CatalogEntry seal_segment(const SegmentFiles& files, const SegmentTail& tail) {
+    CatalogEntry entry;
+    entry.sequence = files.sequence;
+    entry.latestMs = tail.latestMs;
+    entry.records = tail.records;
+    std::ifstream log(files.log, std::ios::binary);
+    std::string body;
+    uint64_t next = 0;
+    entry.firstMs = read_record_at(log, HEADER_BYTES, body, next) ? record_time(body) : tail.latestMs;
+    for (const PresetEntry& preset : read_preset_entries(files.presetIndex)) {
+        entry.bloom |= bloom_bit(preset.hash);
+    }
+    return entry;
+}
+
+void remove_segment(const SegmentFiles& files) {
+    std::error_code ec;
+    fs::remove(files.log, ec);
+    fs::remove(files.timeIndex, ec);
+    fs::remove(files.presetIndex, ec);
+}
+
+bool read_matching(const SegmentFiles& files, const HistoryQuery& query, uint32_t presetHash,
+                   std::vector<HistoryRecord>& out, HistoryQueryStats& stats) {
+    // Every record before the last mark whose predecessors are all older than
+    // --since is too old: start there
+    uint64_t start = HEADER_BYTES;
+    std::vector<TimeMark> marks = read_time_marks(files.timeIndex);
+    auto after = std::partition_point(marks.begin(), marks.end(),
+                                      [&](const TimeMark& mark) { return mark.latestBefore < query.sinceMs; });
+    if (after != marks.begin()) start = std::prev(after)->offset;
+
+    std::ifstream log(files.log, std::ios::binary);
+    if (!log) return false;
+    std::string body;
+    uint64_t next = 0;
+    auto take = [&](uint64_t offset) {
+        if (!read_record_at(log, offset, body, next)) return false;
+        stats.recordsRead++;
+        HistoryRecord record;
+        if (decode_record(body, record) && record.timestampMs >= query.sinceMs &&
+            (query.preset.empty() || equals_ignore_case(record.preset, query.preset))) {
+            out.push_back(std::move(record));
+        }
+        return true;
+    };
+
+    if (presetHash != 0) {
+        for (const PresetEntry& entry : read_preset_entries(files.presetIndex)) {
+            if (entry.hash == presetHash && entry.offset >= start) take(entry.offset);
+        }
+    } else {
+        for (uint64_t pos = start; take(pos); pos = next) {}
+    }
+    return true;
+}
+
+bool parse_int(std::string_view text, int& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+}  // namespace
+
+const char* history_outcome_name(HistoryOutcome outcome) {
+    switch (outcome) {
+        case HistoryOutcome::Delivered: return "delivered";
+        case HistoryOutcome::Failed: return "failed";
+        case HistoryOutcome::RateLimited: return "rate limited";
+    }
+    return "";
+}
+
+const char* history_sink_status_name(HistorySinkStatus status) {
+    switch (status) {
+        case HistorySinkStatus::Delivered: return "delivered";
+        case HistorySinkStatus::Failed: return "failed";
+        case HistorySinkStatus::TimedOut: return "timed out";
+        case HistorySinkStatus::Queued: return "queued";
+    }
+    return "";
+}
+
+HistoryLog::HistoryLog(fs::path dir, size_t segmentBytes, size_t maxSegments)
+    : dir(std::move(dir)), segmentBytes(segmentBytes), maxSegments(maxSegments == 0 ? 1 : maxSegments) {}
+
+bool HistoryLog::append(const HistoryRecord& record, std::string& error) {
+    error.clear();
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    FileLock lock(dir / "history.lock", HISTORY_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        error = "Timed out waiting for the history lock";
+        return false;
+    }
+
+    std::string bytes = encode_record(record);
+    std::vector<uint64_t> sequences = list_segments(dir);
+    SegmentFiles files = segment_files(dir, sequences.empty() ? 1 : sequences.back());
+    SegmentTail tail;
+    if (sequences.empty() || !valid_header(read_header(files.log), HISTORY_SEGMENT_MAGIC)) {
+        if (!create_segment(files)) {
+            error = "Could not create " + files.log.string();
+            return false;
+        }
+        if (sequences.empty()) sequences.push_back(files.sequence);
+    } else {
+        tail = recover_tail(files);
+    }
+
+    // Roll to a new segment once this one is full. The full one is only sealed in the
+    // catalog once its successor exists: a sealed segment must never be appended to.
+    if (tail.records > 0 && tail.end + bytes.size() > segmentBytes) {
+        SegmentFiles next = segment_files(dir, files.sequence + 1);
+        if (!create_segment(next)) {
+            error = "Could not create " + next.log.string();
+            return false;
+        }
+
+        fs::path catalogPath = dir / "history.catalog";
+        trim_index(catalogPath, CATALOG_MAGIC, CATALOG_ENTRY_BYTES, 0, nullptr);
+        std::string entry = encode_catalog_entry(seal_segment(files, tail));
+        if (!fs::exists(catalogPath, ec)) entry = header(CATALOG_MAGIC, 0) + entry;
+        append_file(catalogPath, entry);
+
+        files = next;
+        sequences.push_back(files.sequence);
+        tail = SegmentTail();
+
+        if (sequences.size() > maxSegments) {
+            size_t drop = sequences.size() - maxSegments;
+            for (size_t i = 0; i < drop; i++) remove_segment(segment_files(dir, sequences[i]));
+            std::string catalog = header(CATALOG_MAGIC, 0);
+            for (const CatalogEntry& sealed : read_catalog(catalogPath)) {
+                if (sealed.sequence > sequences[drop - 1]) catalog += encode_catalog_entry(sealed);
+            }
+            std::string writeError;
+            write_file_atomic(catalogPath, catalog, writeError);  // Stale entries are harmless
+        }
+    }
+
+    uint64_t offset = tail.end;
+    if (!append_file(files.log, bytes)) {
+        error = "Could not write " + files.log.string();
+        return false;
+    }
+
+    // Index entries follow their record, so a crash between them only costs a scan
+    if (tail.records % HISTORY_TIME_STRIDE == 0) {
+        std::string mark = fs::exists(files.timeIndex, ec) ? "" : header(TIME_INDEX_MAGIC, files.sequence);
+        put_u64(mark, static_cast<uint64_t>(tail.latestMs));
+        put_u32(mark, static_cast<uint32_t>(offset));
+        put_u32(mark, tail.records);
+        append_file(files.timeIndex, mark);
+    }
+    if (!record.preset.empty()) {
+        std::string entry = fs::exists(files.presetIndex, ec) ? "" : header(PRESET_INDEX_MAGIC, files.sequence);
+        put_u32(entry, preset_hash(record.preset));
+        put_u32(entry, static_cast<uint32_t>(offset));
+        append_file(files.presetIndex, entry);
+    }
+    return true;
+}
+
+std::vector<HistoryRecord> HistoryLog::query(const HistoryQuery& query, HistoryQueryStats* stats) const {
+    HistoryQueryStats local;
+    HistoryQueryStats& counts = stats ? *stats : local;
+    counts = HistoryQueryStats();
+
+    std::map<uint64_t, CatalogEntry> sealed;
+    for (const CatalogEntry& entry : read_catalog(dir / "history.catalog")) sealed[entry.sequence] = entry;
+    uint32_t presetHash = query.preset.empty() ? 0 : preset_hash(query.preset);
+
+    std::vector<HistoryRecord> records;
+    std::vector<uint64_t> sequences = list_segments(dir);
+    for (uint64_t sequence : sequences) {
+        counts.segments++;
+        // The newest segment takes appends, so a catalog entry for it is stale
+        auto found = sequence == sequences.back() ? sealed.end() : sealed.find(sequence);
+        if (found != sealed.end()) {
+            if (found->second.latestMs < query.sinceMs) continue;
+            if (presetHash != 0 && !(found->second.bloom & bloom_bit(presetHash))) continue;
+        }
+        if (read_matching(segment_files(dir, sequence), query, presetHash, records, counts)) {
+            counts.segmentsRead++;
+        }
+    }
+    return records;
+}
+
+fs::path history_directory(const fs::path& dataDir, std::string_view setting) {
+    std::string value = to_lower_ascii(setting);
+    if (value == "off" || value == "0" || dataDir.empty()) {
+        return fs::path();
+    }
+    return dataDir / "history";
+}
+
+bool parse_history_since(std::string_view text, int64_t nowMs, int64_t& sinceMs) {
+    if (text.empty()) return false;
+
+    // Duration: 90s, 30m, 2h, 7d
+    char unit = text.back();
+    int64_t unitMs = unit == 's' ? 1000 : unit == 'm' ? 60000 : unit == 'h' ? 3600000 : unit == 'd' ? 86400000 : 0;
+    int amount = 0;
+    if (unitMs != 0 && parse_int(text.substr(0, text.size() - 1), amount) && amount >= 0) {
+        sinceMs = nowMs - amount * unitMs;
+        return true;
+    }
+
+    // Local date: YYYY-MM-DD, optionally followed by ' ' or 'T' and HH:MM
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    if (text.size() < 10 || text[4] != '-' || text[7] != '-' || !parse_int(text.substr(0, 4), year) ||
+        !parse_int(text.substr(5, 2), month) || !parse_int(text.substr(8, 2), day)) {
+        return false;
+    }
+    if (text.size() > 10) {
+        if (text.size() != 16 || (text[10] != ' ' && text[10] != 'T') || text[13] != ':' ||
+            !parse_int(text.substr(11, 2), hour) || !parse_int(text.substr(14, 2), minute)) {
+            return false;
+        }
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59) return false;
+
+    std::tm local = {};
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_hour = hour;
+    local.tm_min = minute;
+    local.tm_isdst = -1;
+    std::time_t seconds = std::mktime(&local);
+    if (seconds == static_cast<std::time_t>(-1)) return false;
+    sinceMs = static_cast<int64_t>(seconds) * 1000;
+    return true;
+}
+
+std::string history_line(const HistoryRecord& record) {
+    std::time_t seconds = static_cast<std::time_t>(record.timestampMs / 1000);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char when[32];
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+
+    std::string line = when;
+    line += "  ";
+    std::string preset = record.preset.empty() ? "-" : record.preset;
+    preset.resize(std::max<size_t>(preset.size(), 8), ' ');
+    line += preset;
+    line += "  ";
+    line += sanitize_text(record.title, MAX_TITLE_BYTES, true);
+    line += ": ";
+    line += sanitize_text(record.message, HISTORY_LINE_MESSAGE_BYTES, true);
+
+    std::string failed;
+    for (const HistorySink& sink : record.sinks) {
+        if (sink.status == HistorySinkStatus::Delivered) continue;
+        failed += failed.empty() ? "" : ", ";
+        failed += sink.name + " " + history_sink_status_name(sink.status);
+    }
+    if (record.outcome != HistoryOutcome::Delivered || !failed.empty()) {
+        line += "  [";
+        line += history_outcome_name(record.outcome);
+        if (!failed.empty()) line += "; " + failed;
+        line += "]";
+    }
+    return line;
+}
+
+std::string history_json(const HistoryRecord& record) {
+    JsonValue sinks = JsonValue::array();
+    for (const HistorySink& sink : record.sinks) {
+        JsonValue item = JsonValue::object();
+        item.set("name", JsonValue::string(sink.name));
+        item.set("status", JsonValue::string(history_sink_status_name(sink.status)));
+        sinks.append(std::move(item));
+    }
+
+    JsonValue root = JsonValue::object();
+    root.set("time", JsonValue::number(static_cast<long long>(record.timestampMs)));
+    root.set("preset", JsonValue::string(record.preset));
+    root.set("title", JsonValue::string(record.title));
+    root.set("message", JsonValue::string(record.message));
+    root.set("outcome", JsonValue::string(history_outcome_name(record.outcome)));
+    root.set("sinks", std::move(sinks));
+    std::string out;
+    root.stringify_to(out);
+    return out;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Notification history: every dispatched (or rate-limited) notification appended to a
+// compact binary log under the data directory, so "what finished while I was away?"
+// has an answer. Appends from concurrent toasty processes serialize on a FileLock.
+//
+// The log is a run of segments (NNNNNNNN.seg), each rolled at segmentBytes and the
+// oldest deleted past maxSegments. Next to each segment:
+//   .tix  sparse time index: every HISTORY_TIME_STRIDE records, the offset of the
+//         record and the latest timestamp seen up to it, so --since seeks instead of
+//         reading the segment from the start
+//   .pix  preset index: preset hash and offset of every record that has a preset, so
+//         --app reads only that preset's records
+// history.catalog holds one entry per sealed segment (time range, record count and a
+// 64-bit preset bloom filter), so whole segments are skipped without opening them.
+//
+// Records: [u32 body size][u32 FNV-1a of body][body], little endian. A record torn by
+// a crash fails its checksum; the next append truncates it, and cuts the indexes and
+// catalog back to whole entries that point at intact records. Index entries are only
+// written after their record, so a lost one means a longer scan, never a wrong answer.
+
+const uint32_t HISTORY_SEGMENT_MAGIC = 0x4c485354;  // "TSHL"
+const uint32_t HISTORY_VERSION = 1;
+const uint32_t HISTORY_TIME_STRIDE = 16;
+const size_t HISTORY_SEGMENT_BYTES = 1024 * 1024;
+const size_t HISTORY_MAX_SEGMENTS = 32;
+
+enum class HistoryOutcome : uint8_t {
+    Delivered,     // Every required sink delivered
+    Failed,        // A required sink failed or timed out
+    RateLimited,   // Dropped by the rate limit; not shown
+};
+
+enum class HistorySinkStatus : uint8_t { Delivered, Failed, TimedOut, Queued };
+
+const char* history_outcome_name(HistoryOutcome outcome);
+const char* history_sink_status_name(HistorySinkStatus status);
+
+struct HistorySink {
+    std::string name;
+    HistorySinkStatus status = HistorySinkStatus::Delivered;
+};
+
+struct HistoryRecord {
+    int64_t timestampMs = 0;        // Unix epoch
+    std::string preset;             // Preset name, empty if none
+    std::string title;
+    std::string message;
+    uint64_t messageHash = 0;       // FNV-1a of message; filled in by append()
+    HistoryOutcome outcome = HistoryOutcome::Delivered;
+    std::vector<HistorySink> sinks;
+};
+
+struct HistoryQuery {
+    int64_t sinceMs = 0;            // Records at or after this time
+    std::string preset;             // Only this preset (case-insensitive); empty for all
+};
+
+// What a query touched, to show the indexes doing their job
+struct HistoryQueryStats {
+    size_t segments = 0;            // Segments in the log
+    size_t segmentsRead = 0;        // Segments whose records were read
+    size_t recordsRead = 0;
+};
+
+class HistoryLog {
+public:
+    explicit HistoryLog(std::filesystem::path dir, size_t segmentBytes = HISTORY_SEGMENT_BYTES,
+                        size_t maxSegments = HISTORY_MAX_SEGMENTS);
+
+    // Append one record; false with error if the log could not be locked or written
+    bool append(const HistoryRecord& record, std::string& error);
+
+    // Matching records in the order they were appended
+    std::vector<HistoryRecord> query(const HistoryQuery& query, HistoryQueryStats* stats = nullptr) const;
+
+    const std::filesystem::path& directory() const { return dir; }
+
+private:
+    std::filesystem::path dir;
+    size_t segmentBytes;
+    size_t maxSegments;
+};
+
+// Where a CLI records history: dataDir/history, or empty when TOASTY_HISTORY (setting)
+// is "off" or "0" or there is no data directory
+std::filesystem::path history_directory(const std::filesystem::path& dataDir, std::string_view setting);
+
+// --since: a duration back from nowMs ("90s", "30m", "2h", "7d") or a local date and
+// time ("2026-10-17", "2026-10-17 13:30", "2026-10-17T13:30")
+bool parse_history_since(std::string_view text, int64_t nowMs, int64_t& sinceMs);
+
+// One line of --history: local time, preset, "title: message" on one line, and the
+// outcome plus any sink that didn't deliver when it wasn't a clean delivery
+std::string history_line(const HistoryRecord& record);
+
+// --history --json: one object per line, {"time" (ms), "preset", "title", "message",
+// "outcome", "sinks": [{"name", "status"}]}
+std::string history_json(const HistoryRecord& record);
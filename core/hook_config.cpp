@@ -0,0 +1,533 @@
+#include "core/hook_config.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#include "core/atomic_file.h"
+#include "core/file_lock.h"
+#include "core/json_patch.h"
+#include "core/json_value.h"
+#include "core/strings.h"
+#include "core/toml_index.h"
+
+namespace fs = std::filesystem;
+
+const HookAgentInfo HOOK_AGENTS[] = {
+    { HookAgent::Claude,  "claude",  "Claude Code",    "Stop",       ".claude/settings.json",     ".claude", false },
+    { HookAgent::Gemini,  "gemini",  "Gemini CLI",     "AfterAgent", ".gemini/settings.json",     ".gemini", false },
+    { HookAgent::Copilot, "copilot", "GitHub Copilot", "sessionEnd", ".github/hooks/toasty.json", ".github", true },
+    { HookAgent::Codex,   "codex",   "OpenAI Codex",   "notify",     ".codex/config.toml",        ".codex",  false },
+};
+
+const size_t HOOK_AGENT_COUNT = sizeof(HOOK_AGENTS) / sizeof(HOOK_AGENTS[0]);
+
+namespace {
+
+// Installs from several terminals at once queue up rather than fail
+const int HOOK_LOCK_TIMEOUT_MS = 10000;
+
+// Times an edit is redone when the config changes while it is being edited
+const int HOOK_EDIT_ATTEMPTS = 5;
+
+bool mentions_toasty(std::string_view text) {
+    return text.find("toasty") != std::string_view::npos;
+}
+
+// A hook entry is ours if its command (direct, or in a nested hooks array as Claude
+// and Gemini use) or its Copilot bash command runs toasty
+bool is_toasty_hook(const JsonValue& item) {
+    if (!item.is_object()) return false;
+    if (mentions_toasty(item.get_string("command")) || mentions_toasty(item.get_string("bash"))) {
+        return true;
+    }
+    const JsonValue* inner = item.find("hooks");
+    if (inner && inner->is_array()) {
+        for (const auto& innerHook : inner->items()) {
+            if (innerHook.is_object() && mentions_toasty(innerHook.get_string("command"))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The hook entry toasty installs for a JSON-configured agent
+JsonValue make_hook_entry(HookAgent agent, std::string_view exePath) {
+    JsonValue entry = JsonValue::object();
+    if (agent == HookAgent::Copilot) {
+        // bash runs toasty from PATH; PowerShell gets the full path, escaped
+        entry.set("type", JsonValue::string("command"));
+        entry.set("bash", JsonValue::string(hook_command(agent, exePath)));
+        entry.set("powershell", JsonValue::string(escape_json_string(exePath) + " 'Copilot finished' -t 'GitHub Copilot'"));
+        entry.set("timeoutSec", JsonValue::number(5));
+        return entry;
+    }
+
+    // Claude Code and Gemini CLI require a nested "hooks" array
+    JsonValue innerHook = JsonValue::object();
+    innerHook.set("type", JsonValue::string("command"));
+    if (agent == HookAgent::Gemini) {
+        innerHook.set("name", JsonValue::string("toasty-notification"));
+    }
+    innerHook.set("command", JsonValue::string(hook_command(agent, exePath)));
+    if (agent == HookAgent::Claude) {
+        innerHook.set("timeout", JsonValue::number(5000));
+    }
+
+    JsonValue innerHooks = JsonValue::array();
+    innerHooks.append(std::move(innerHook));
+    if (agent == HookAgent::Gemini) {
+        entry.set("matcher", JsonValue::string("*"));
+    }
+    entry.set("hooks", std::move(innerHooks));
+    return entry;
+}
+
+// A hooks.<event> element is toasty's. Copilot entries are recognized by their bash
+// command only when checking for an install. Only elements that mention toasty at
+// all are parsed.
+bool is_toasty_element(std::string_view element, HookAgent agent, bool forInstall) {
+    if (!mentions_toasty(element)) return false;
+    JsonValue item;
+    if (!JsonValue::parse(element, item)) return false;
+    return forInstall && agent == HookAgent::Copilot ? mentions_toasty(item.get_string("bash")) : is_toasty_hook(item);
+}
+
+// Where hooks and hooks.<event> sit in a config, located without parsing the rest
+struct HookSpans {
+    bool rootIsObject = false;
+    bool hasHooks = false;
+    bool hasEvent = false;
+    JsonSpan root;
+    JsonSpan hooks;
+    JsonSpan event;
+};
+
+// False if config is not valid JSON
+bool locate_hooks(std::string_view config, HookAgent agent, HookSpans& spans) {
+    if (!json_locate_root(config, spans.root)) return false;
+    spans.rootIsObject = json_type_at(config, spans.root) == JsonType::Object;
+    spans.hasHooks = spans.rootIsObject && json_find_member(config, spans.root, "hooks", spans.hooks);
+    spans.hasEvent = spans.hasHooks && json_type_at(config, spans.hooks) == JsonType::Object &&
+                     json_find_member(config, spans.hooks, hook_agent_info(agent).hookType, spans.event);
+    return true;
+}
+
+bool event_has_toasty_hook(std::string_view config, const HookSpans& spans, HookAgent agent) {
+    if (!spans.hasEvent || json_type_at(config, spans.event) != JsonType::Array) return false;
+    for (const JsonSpan& element : json_array_elements(config, spans.event)) {
+        if (is_toasty_element(config.substr(element.begin, element.end - element.begin), agent, true)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A new config holding only our hook, indented like the agents write their own
+std::string make_hook_config(HookAgent agent, std::string_view exePath) {
+    JsonValue root = JsonValue::object();
+    if (agent == HookAgent::Copilot) {
+        root.set("version", JsonValue::number(1));
+    }
+    JsonValue array = JsonValue::array();
+    array.append(make_hook_entry(agent, exePath));
+    root.set("hooks", JsonValue::object()).set(hook_agent_info(agent).hookType, std::move(array));
+
+    std::string config;
+    root.stringify_to(config, "  ", "");
+    config += '\n';
+    return config;
+}
+
+// A notify key (at any level) that runs toasty
+bool is_toasty_notify(std::string_view content, const TomlKey& key) {
+    return key.name == "notify" && mentions_toasty(content.substr(key.begin, key.end - key.begin));
+}
+
+// A replacement of config[offset + begin, offset + end)
+struct TomlSplice {
+    size_t begin;
+    size_t end;
+    std::string_view replacement;
+};
+
+// Apply splices (in order, not overlapping) in place, back to front so the earlier
+// offsets stay valid. Only the bytes after each splice move.
+void apply_splices(std::string& config, size_t offset, const std::vector<TomlSplice>& splices) {
+    for (auto it = splices.rbegin(); it != splices.rend(); ++it) {
+        config.replace(offset + it->begin, it->end - it->begin, it->replacement);
+    }
+}
+
+// Codex: make toasty the top-level notify command. An existing top-level notify is
+// replaced where it stands, otherwise ours goes before the first table. Any other
+// toasty notify (older versions put one inside a table) is removed. One pass indexes
+// the file; the edits are splices of whole key spans. A UTF-8 BOM is kept. Returns
+// whether config changed.
+bool install_codex_notify(std::string& config, std::string_view exePath) {
+    std::string notifyLine = hook_command(HookAgent::Codex, exePath) + "\n";
+
+    size_t bomSize = std::string_view(config).substr(0, 3) == "\xEF\xBB\xBF" ? 3 : 0;
+    std::string_view content = std::string_view(config).substr(bomSize);
+    if (content.empty()) {
+        config += notifyLine;
+        return true;
+    }
+
+    TomlIndex index = index_toml(content, "notify");
+    const TomlKey* topNotify = nullptr;
+    for (const TomlKey& key : index.keys) {
+        if (key.table == TOML_TOP_LEVEL && key.name == "notify") {
+            topNotify = &key;
+            break;
+        }
+    }
+
+    std::vector<TomlSplice> splices;
+    for (const TomlKey& key : index.keys) {
+        if (&key == topNotify) {
+            if (content.substr(key.begin, key.end - key.begin) != notifyLine) {
+                splices.push_back({key.begin, key.end, notifyLine});
+            }
+        } else if (is_toasty_notify(content, key)) {
+            splices.push_back({key.begin, key.end, ""});
+        }
+    }
+    bool beforeTable = !topNotify && !index.tables.empty();
+    if (beforeTable) {
+        size_t firstTable = index.tables.front().begin;
+        splices.push_back({firstTable, firstTable, notifyLine});
+        std::stable_sort(splices.begin(), splices.end(),
+                         [](const TomlSplice& a, const TomlSplice& b) { return a.begin < b.begin; });
+    }
+    if (splices.empty() && topNotify) {
+        return false;
+    }
+
+    apply_splices(config, bomSize, splices);
+    if (!topNotify && !beforeTable) {
+        if (config.size() > bomSize && config.back() != '\n') config += '\n';
+        config += notifyLine;
+    }
+    return true;
+}
+
+// Codex: drop every notify key that runs toasty. Returns whether config changed.
+bool remove_codex_notify(std::string& config) {
+    std::vector<TomlSplice> splices;
+    for (const TomlKey& key : index_toml(config, "notify").keys) {
+        if (is_toasty_notify(config, key)) splices.push_back({key.begin, key.end, ""});
+    }
+    apply_splices(config, 0, splices);
+    return !splices.empty();
+}
+
+// Save the config as it was before our edit to path.bak; on failure says why in warning
+bool backup_config(const fs::path& path, std::string_view original, std::string& warning) {
+    fs::path backupPath = path;
+    backupPath += ".bak";
+    std::string error;
+    if (!write_file_atomic(backupPath, original, error)) {
+        warning = "Failed to create backup: " + error;
+        return false;
+    }
+    return true;
+}
+
+// Lock file serializing toasty's edits of one config. It lives in the temp directory,
+// named after a hash of the config's absolute path, so nothing extra appears next to
+// the config (Copilot's sits inside the user's repository).
+fs::path config_lock_path(const fs::path& configPath) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(configPath, ec).lexically_normal();
+    uint64_t hash = fnv1a_64(path_key(absolute));
+
+    fs::path dir = fs::temp_directory_path(ec);
+    if (ec) {
+        fs::path fallback = configPath;
+        fallback += ".lock";
+        return fallback;
+    }
+    char name[40];
+    std::snprintf(name, sizeof(name), "toasty-hook-%016llx.lock", static_cast<unsigned long long>(hash));
+    return dir / name;
+}
+
+}  // namespace
+
+const HookAgentInfo& hook_agent_info(HookAgent agent) {
+    return HOOK_AGENTS[static_cast<size_t>(agent)];
+}
+
+fs::path hook_config_path(HookAgent agent, const fs::path& home, const fs::path& repoDir) {
+    const HookAgentInfo& info = hook_agent_info(agent);
+    fs::path path = (info.perRepository ? repoDir : home) / info.configFile;
+    return path.make_preferred();
+}
+
+bool detect_hook_agent(HookAgent agent, const fs::path& home, const fs::path& repoDir) {
+    const HookAgentInfo& info = hook_agent_info(agent);
+    std::error_code ec;
+    return fs::exists((info.perRepository ? repoDir : home) / info.detectDir, ec);
+}
+
+std::string hook_command(HookAgent agent, std::string_view exePath) {
+    switch (agent) {
+        case HookAgent::Claude:
+            return normalize_path_for_shell(exePath) + " \"Task complete\" -t \"Claude Code\"";
+        case HookAgent::Gemini:
+            return normalize_path_for_shell(exePath) + " \"Gemini finished\" -t \"Gemini\"";
+        case HookAgent::Copilot:
+            return "toasty 'Copilot finished' -t 'GitHub Copilot'";
+        case HookAgent::Codex: {
+            // TOML basic string: double backslashes and escape quotes
+            std::string escapedPath;
+            for (char c : exePath) {
+                if (c == '\\' || c == '"') escapedPath += '\\';
+                escapedPath += c;
+            }
+            return "notify = [\"" + escapedPath + "\", \"Codex finished\", \"-t\", \"Codex\"]";
+        }
+    }
+    return "";
+}
+
+bool has_toasty_hook(HookAgent agent, std::string_view config) {
+    if (agent == HookAgent::Codex) {
+        if (!mentions_toasty(config)) return false;
+        for (const TomlKey& key : index_toml(config, "notify").keys) {
+            if (is_toasty_notify(config, key)) return true;
+        }
+        return false;
+    }
+
+    HookSpans spans;
+    return !config.empty() && locate_hooks(config, agent, spans) && event_has_toasty_hook(config, spans, agent);
+}
+
+// JSON configs are edited in place: only hooks.<event> (or whichever of hooks and
+// the event array is missing or of the wrong type) changes, byte for byte the rest
+// of the file is left as the user wrote it
+HookEdit add_toasty_hook(HookAgent agent, std::string& config, std::string_view exePath) {
+    if (agent == HookAgent::Codex) {
+        return install_codex_notify(config, exePath) ? HookEdit::Changed : HookEdit::Unchanged;
+    }
+
+    if (config.empty()) {
+        config = make_hook_config(agent, exePath);
+        return HookEdit::Changed;
+    }
+    HookSpans spans;
+    if (!locate_hooks(config, agent, spans) || !spans.rootIsObject) {
+        return HookEdit::Invalid;
+    }
+    if (event_has_toasty_hook(config, spans, agent)) {
+        return HookEdit::Unchanged;
+    }
+
+    JsonPatch patch(config);
+    std::vector<JsonValue::Member> rootMembers;
+    if (agent == HookAgent::Copilot) {
+        JsonSpan version;
+        if (!json_find_member(config, spans.root, "version", version)) {
+            rootMembers.emplace_back("version", JsonValue::number(1));
+        } else if (config.compare(version.begin, version.end - version.begin, "1") != 0) {
+            patch.replace_value(version, JsonValue::number(1));
+        }
+    }
+
+    // Add whatever is missing of hooks.<event>; values of the wrong type are replaced
+    const char* event = hook_agent_info(agent).hookType;
+    JsonValue entry = make_hook_entry(agent, exePath);
+    JsonValue array = JsonValue::array();
+    array.append(entry);
+    if (!spans.hasHooks || json_type_at(config, spans.hooks) != JsonType::Object) {
+        JsonValue hooks = JsonValue::object();
+        hooks.set(event, std::move(array));
+        if (spans.hasHooks) {
+            patch.replace_value(spans.hooks, hooks);
+        } else {
+            rootMembers.emplace_back("hooks", std::move(hooks));
+        }
+    } else if (!spans.hasEvent) {
+        patch.append_members(spans.hooks, {{event, std::move(array)}});
+    } else if (json_type_at(config, spans.event) != JsonType::Array) {
+        patch.replace_value(spans.event, array);
+    } else {
+        patch.append_element(spans.event, entry);
+    }
+    if (!rootMembers.empty()) {
+        patch.append_members(spans.root, rootMembers);
+    }
+
+    config = patch.apply();
+    return HookEdit::Changed;
+}
+
+HookEdit remove_toasty_hook(HookAgent agent, std::string& config) {
+    if (agent == HookAgent::Codex) {
+        if (!mentions_toasty(config)) return HookEdit::Unchanged;
+        return remove_codex_notify(config) ? HookEdit::Changed : HookEdit::Unchanged;
+    }
+
+    HookSpans spans;
+    if (!locate_hooks(config, agent, spans)) {
+        return HookEdit::Invalid;
+    }
+    if (!spans.hasEvent || json_type_at(config, spans.event) != JsonType::Array) {
+        return HookEdit::Unchanged;
+    }
+
+    std::vector<JsonSpan> elements = json_array_elements(config, spans.event);
+    std::vector<bool> erase(elements.size());
+    bool any = false;
+    for (size_t i = 0; i < elements.size(); i++) {
+        erase[i] = is_toasty_element(std::string_view(config).substr(elements[i].begin, elements[i].end - elements[i].begin),
+                                     agent, false);
+        any = any || erase[i];
+    }
+    if (!any) {
+        return HookEdit::Unchanged;
+    }
+
+    JsonPatch patch(config);
+    patch.erase_elements(spans.event, elements, erase);
+    config = patch.apply();
+    return HookEdit::Changed;
+}
+
+bool install_hook_file(HookAgent agent, const fs::path& configPath, std::string_view exePath, std::string& warning) {
+    warning.clear();
+
+    // Codex and Copilot configs may not exist yet; create their directory
+    std::error_code ec;
+    if (agent == HookAgent::Codex || agent == HookAgent::Copilot) {
+        fs::create_directories(configPath.parent_path(), ec);
+    }
+
+    FileLock lock(config_lock_path(configPath), HOOK_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        warning = "Timed out waiting for another toasty to finish editing the config";
+        return false;
+    }
+
+    // The lock keeps other toasty processes out, but the agent may rewrite its own
+    // config at any moment; if the file changed under the edit, redo it on the new one
+    for (int attempt = 1;; attempt++) {
+        FileStamp stamp = file_stamp(configPath);
+        std::string original = read_file_bytes(configPath);
+        std::string content = original;
+
+        bool startedFresh = false;
+        HookEdit edit = add_toasty_hook(agent, content, exePath);
+        if (edit == HookEdit::Invalid) {
+            startedFresh = true;
+            content.clear();
+            edit = add_toasty_hook(agent, content, exePath);
+        }
+        if (edit == HookEdit::Unchanged) {
+            return true;
+        }
+        if (file_stamp(configPath) != stamp && attempt < HOOK_EDIT_ATTEMPTS) {
+            continue;
+        }
+
+        if (!original.empty()) {
+            backup_config(configPath, original, warning);
+        }
+        if (startedFresh) {
+            warning = "Failed to parse existing config, starting fresh";
+        }
+        std::string error;
+        if (!write_file_atomic(configPath, content, error)) {
+            warning = "Failed to write config: " + error;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool uninstall_hook_file(HookAgent agent, const fs::path& configPath, std::string& error) {
+    error.clear();
+    std::error_code ec;
+
+    FileLock lock(config_lock_path(configPath), HOOK_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        error = "Timed out waiting for another toasty to finish editing the config";
+        return false;
+    }
+
+    if (agent == HookAgent::Copilot) {
+        // .github/hooks/toasty.json holds nothing but our hook
+        if (fs::exists(configPath, ec)) {
+            backup_config(configPath, read_file_bytes(configPath), error);
+            fs::remove(configPath, ec);
+            if (ec) {
+                error = ec.message();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (int attempt = 1;; attempt++) {
+        FileStamp stamp = file_stamp(configPath);
+        std::string original = read_file_bytes(configPath);
+        if (original.empty()) {
+            return true;  // Nothing to uninstall
+        }
+
+        std::string content = original;
+        HookEdit edit = remove_toasty_hook(agent, content);
+        if (edit == HookEdit::Invalid) {
+            std::u8string path = configPath.u8string();
+            error = "Failed to parse " + std::string(path.begin(), path.end());
+            return false;
+        }
+        if (edit == HookEdit::Unchanged) {
+            return true;
+        }
+        if (file_stamp(configPath) != stamp && attempt < HOOK_EDIT_ATTEMPTS) {
+            continue;
+        }
+
+        backup_config(configPath, original, error);
+        std::string writeError;
+        if (!write_file_atomic(configPath, content, writeError)) {
+            error = "Failed to write config: " + writeError;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool is_hook_installed(HookAgent agent, const fs::path& configPath) {
+    return has_toasty_hook(agent, read_file_bytes(configPath));
+}
+
+std::vector<RepoHookResult> apply_repository_hooks(HookAgent agent, const fs::path& root, std::string_view exePath,
+                                                   bool install, size_t threads, RepoWalkStats& stats) {
+    std::mutex mutex;
+    std::vector<RepoHookResult> results;
+    stats = walk_repositories(root, threads, [&](const fs::path& repo) {
+        RepoHookResult result;
+        result.repo = repo;
+        fs::path configPath = hook_config_path(agent, fs::path(), repo);
+        bool wasInstalled = is_hook_installed(agent, configPath);
+        if (install == wasInstalled) {
+            result.outcome = RepoHookOutcome::Unchanged;
+        } else {
+            bool ok = install ? install_hook_file(agent, configPath, exePath, result.message)
+                              : uninstall_hook_file(agent, configPath, result.message);
+            result.outcome = ok ? RepoHookOutcome::Changed : RepoHookOutcome::Failed;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    });
+    std::sort(results.begin(), results.end(),
+              [](const RepoHookResult& a, const RepoHookResult& b) { return a.repo < b.repo; });
+    return results;
+}
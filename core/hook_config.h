@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/repo_walker.h"
+
+// Agent hook configuration: where each agent keeps its config, and how toasty's hook
+// is added to, found in and removed from it. Edits are UTF-8 text to text so both
+// CLIs share them: Claude, Gemini and Copilot configs are patched in place with
+// JsonPatch (only the hooks.<event> array is touched), Codex through its top-level
+// TOML notify key.
+
+enum class HookAgent { Claude, Gemini, Copilot, Codex };
+
+struct HookAgentInfo {
+    HookAgent agent;
+    const char* name;          // --install argument
+    const char* displayName;
+    const char* hookType;      // Event the hook is registered for
+    const char* configFile;    // Relative to the home directory, or the repo for Copilot
+    const char* detectDir;     // Present when the agent is installed / in use
+    bool perRepository;
+};
+
+extern const HookAgentInfo HOOK_AGENTS[];
+extern const size_t HOOK_AGENT_COUNT;
+
+const HookAgentInfo& hook_agent_info(HookAgent agent);
+
+// Config file for an agent. Copilot hooks are per repository (repoDir, which may be
+// empty for the current directory); the others live under home.
+std::filesystem::path hook_config_path(HookAgent agent, const std::filesystem::path& home,
+                                       const std::filesystem::path& repoDir);
+
+// Whether the agent looks installed (Copilot: the repo has a .github directory)
+bool detect_hook_agent(HookAgent agent, const std::filesystem::path& home, const std::filesystem::path& repoDir);
+
+// Command line the hook runs for exePath (Codex: the notify line)
+std::string hook_command(HookAgent agent, std::string_view exePath);
+
+enum class HookEdit {
+    Unchanged,   // Already in the wanted state; config untouched
+    Changed,     // config rewritten
+    Invalid,     // Existing config could not be parsed; config untouched
+};
+
+bool has_toasty_hook(HookAgent agent, std::string_view config);
+HookEdit add_toasty_hook(HookAgent agent, std::string& config, std::string_view exePath);
+HookEdit remove_toasty_hook(HookAgent agent, std::string& config);
+
+// File-level install, uninstall and status. An existing config is backed up to
+// <path>.bak before it is changed. An unparsable config is replaced (install) or left
+// alone (uninstall); warning/error says why. Copilot's config is toasty's own file
+// and is deleted on uninstall. Edits are serialized across toasty processes with a
+// FileLock and written with write_file_atomic, so concurrent installs queue up
+// instead of losing each other's changes, and readers never see a partial file.
+bool install_hook_file(HookAgent agent, const std::filesystem::path& configPath, std::string_view exePath,
+                       std::string& warning);
+bool uninstall_hook_file(HookAgent agent, const std::filesystem::path& configPath, std::string& error);
+bool is_hook_installed(HookAgent agent, const std::filesystem::path& configPath);
+
+// Per-repository hooks (Copilot) across a tree of repositories: every repository
+// under root (see walk_repositories) is visited in parallel and the hook installed
+// or removed there. Results are sorted by repository path.
+enum class RepoHookOutcome { Changed, Unchanged, Failed };
+
+struct RepoHookResult {
+    std::filesystem::path repo;
+    RepoHookOutcome outcome = RepoHookOutcome::Unchanged;
+    std::string message;       // Warning or error, if any
+};
+
+std::vector<RepoHookResult> apply_repository_hooks(HookAgent agent, const std::filesystem::path& root,
+                                                   std::string_view exePath, bool install, size_t threads,
+                                                   RepoWalkStats& stats);
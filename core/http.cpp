@@ -0,0 +1,657 @@
+#include "core/http.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "core/strings.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#else
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef TOASTY_HAVE_OPENSSL
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#endif
+#endif
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+// Parse "Name: value" lines (status line excluded) into response headers
+void parse_header_lines(std::string_view block, HttpResponse& response) {
+    while (!block.empty()) {
+        size_t end = block.find('\n');
+        std::string_view line = block.substr(0, end);
+        block = end == std::string_view::npos ? std::string_view() : block.substr(end + 1);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        response.headers.emplace_back(std::string(trim(line.substr(0, colon))),
+                                      std::string(trim(line.substr(colon + 1))));
+    }
+}
+
+}  // namespace
+
+bool parse_http_url(std::string_view url, HttpOrigin& origin, std::string& path) {
+    origin = HttpOrigin();
+    if (url.substr(0, 8) == "https://") {
+        url.remove_prefix(8);
+    } else if (url.substr(0, 7) == "http://") {
+        url.remove_prefix(7);
+        origin.tls = false;
+        origin.port = 80;
+    }
+
+    size_t slash = url.find('/');
+    std::string_view authority = url.substr(0, slash);
+    path = slash == std::string_view::npos ? "/" : std::string(url.substr(slash));
+
+    size_t colon = authority.rfind(':');
+    if (colon != std::string_view::npos && authority.find(']', colon) == std::string_view::npos) {
+        std::string_view portText = authority.substr(colon + 1);
+        unsigned port = 0;
+        auto result = std::from_chars(portText.data(), portText.data() + portText.size(), port);
+        if (result.ec != std::errc() || result.ptr != portText.data() + portText.size() || port == 0 || port > 65535) {
+            return false;
+        }
+        origin.port = static_cast<uint16_t>(port);
+        authority = authority.substr(0, colon);
+    }
+
+    origin.host = std::string(authority);
+    return !origin.host.empty();
+}
+
+const std::string* HttpResponse::header(std::string_view name) const {
+    for (const auto& entry : headers) {
+        if (equals_ignore_case(entry.first, name)) return &entry.second;
+    }
+    return nullptr;
+}
+
+#ifdef _WIN32
+
+namespace {
+
+// One WinHTTP session for the transport's lifetime. WinHTTP keeps the underlying
+// TCP/TLS connections alive per session, so reusing the session and the per-origin
+// connect handles is what makes later requests skip the handshake.
+class WinHttpTransport : public HttpTransport {
+public:
+    explicit WinHttpTransport(const HttpOptions& options) : options(options) {
+        session = WinHttpOpen(from_utf8(options.userAgent).c_str(), WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                              WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+        if (session) {
+            WinHttpSetTimeouts(session, options.connectTimeoutMs, options.connectTimeoutMs,
+                               options.ioTimeoutMs, options.ioTimeoutMs);
+        }
+    }
+
+    ~WinHttpTransport() override {
+        for (auto& connection : connections) {
+            WinHttpCloseHandle(connection.second);
+        }
+        if (session) WinHttpCloseHandle(session);
+    }
+
+    bool send(const HttpOrigin& origin, const HttpRequest& request, HttpResponse& response) override {
+        response = HttpResponse();
+        HINTERNET connection = connect(origin);
+        if (!connection) return false;
+
+        HINTERNET handle = WinHttpOpenRequest(connection, from_utf8(request.method).c_str(), from_utf8(request.path).c_str(),
+                                              nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                              origin.tls ? WINHTTP_FLAG_SECURE : 0);
+        if (!handle) return false;
+
+        std::wstring headers;
+        for (const auto& header : request.headers) {
+            headers += from_utf8(header.first) + L": " + from_utf8(header.second) + L"\r\n";
+        }
+
+        bool ok = WinHttpSendRequest(handle,
+                                     headers.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : headers.c_str(),
+                                     headers.empty() ? 0 : (DWORD)-1L,
+                                     request.body.empty() ? WINHTTP_NO_REQUEST_DATA : (LPVOID)request.body.data(),
+                                     (DWORD)request.body.size(), (DWORD)request.body.size(), 0) &&
+                  WinHttpReceiveResponse(handle, nullptr);
+
+        if (ok) {
+            DWORD status = 0;
+            DWORD size = sizeof(status);
+            WinHttpQueryHeaders(handle, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX);
+            response.status = (int)status;
+
+            size = 0;
+            WinHttpQueryHeaders(handle, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                                WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+            if (size > 0) {
+                std::wstring raw(size / sizeof(wchar_t), L'\0');
+                if (WinHttpQueryHeaders(handle, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                                        &raw[0], &size, WINHTTP_NO_HEADER_INDEX)) {
+                    std::string block = to_utf8(raw.substr(0, size / sizeof(wchar_t)));
+                    size_t firstLine = block.find('\n');
+                    if (firstLine != std::string::npos) {
+                        parse_header_lines(std::string_view(block).substr(firstLine + 1), response);
+                    }
+                }
+            }
+
+            DWORD available = 0;
+            if (request.onBody) {
+                // Stream through a fixed buffer; closing the request handle abandons the rest
+                char buffer[8 * 1024];
+                size_t delivered = 0;
+                while (delivered < options.maxBodyBytes &&
+                       WinHttpQueryDataAvailable(handle, &available) && available > 0) {
+                    DWORD chunk = (DWORD)std::min<size_t>({ available, sizeof(buffer), options.maxBodyBytes - delivered });
+                    DWORD read = 0;
+                    if (!WinHttpReadData(handle, buffer, chunk, &read) || read == 0) break;
+                    delivered += read;
+                    if (!request.onBody(std::string_view(buffer, read))) break;
+                }
+            } else {
+                while (response.body.size() < options.maxBodyBytes &&
+                       WinHttpQueryDataAvailable(handle, &available) && available > 0) {
+                    size_t offset = response.body.size();
+                    DWORD chunk = (DWORD)std::min<size_t>(available, options.maxBodyBytes - offset);
+                    response.body.resize(offset + chunk);
+                    DWORD read = 0;
+                    if (!WinHttpReadData(handle, &response.body[offset], chunk, &read)) {
+                        response.body.resize(offset);
+                        break;
+                    }
+                    response.body.resize(offset + read);
+                }
+            }
+        }
+
+        WinHttpCloseHandle(handle);
+        return ok;
+    }
+
+private:
+    HINTERNET connect(const HttpOrigin& origin) {
+        if (!session) return nullptr;
+        for (auto& connection : connections) {
+            if (connection.first == origin) return connection.second;
+        }
+        HINTERNET connection = WinHttpConnect(session, from_utf8(origin.host).c_str(), origin.port, 0);
+        if (connection) connections.emplace_back(origin, connection);
+        return connection;
+    }
+
+    HttpOptions options;
+    HINTERNET session = nullptr;
+    std::vector<std::pair<HttpOrigin, HINTERNET>> connections;
+};
+
+}  // namespace
+
+std::unique_ptr<HttpTransport> create_http_transport(const HttpOptions& options) {
+    return std::make_unique<WinHttpTransport>(options);
+}
+
+#else
+
+namespace {
+
+const size_t MAX_HEADER_BYTES = 64 * 1024;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;  // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+// A connected byte stream: a plain socket, or TLS over one
+class Stream {
+public:
+    explicit Stream(int fd) : fd(fd) {}
+    virtual ~Stream() { close(fd); }
+
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+
+    virtual bool write_all(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t sent = ::send(fd, data, size, SEND_FLAGS);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Bytes read, 0 at end of stream, -1 on error or timeout
+    virtual long read_some(char* data, size_t size) {
+        for (;;) {
+            ssize_t received = ::recv(fd, data, size, 0);
+            if (received < 0 && errno == EINTR) continue;
+            return static_cast<long>(received);
+        }
+    }
+
+    std::string buffer;   // Read but not yet consumed
+    bool reused = false;  // Served an earlier request
+
+protected:
+    int fd;
+};
+
+#ifdef TOASTY_HAVE_OPENSSL
+// OpenSSL's socket BIO writes with write(), which raises SIGPIPE when the peer
+// has gone. This one sends with SEND_FLAGS, so a dropped connection is an error
+// return and the process's signal handling is left alone.
+int socket_bio_fd(BIO* bio) {
+    return static_cast<int>(reinterpret_cast<intptr_t>(BIO_get_data(bio)));
+}
+
+int socket_bio_write(BIO* bio, const char* data, int size) {
+    for (;;) {
+        ssize_t sent = ::send(socket_bio_fd(bio), data, static_cast<size_t>(size), SEND_FLAGS);
+        if (sent < 0 && errno == EINTR) continue;
+        return static_cast<int>(sent);
+    }
+}
+
+int socket_bio_read(BIO* bio, char* data, int size) {
+    for (;;) {
+        ssize_t received = ::recv(socket_bio_fd(bio), data, static_cast<size_t>(size), 0);
+        if (received < 0 && errno == EINTR) continue;
+        return static_cast<int>(received);
+    }
+}
+
+long socket_bio_ctrl(BIO*, int command, long, void*) {
+    return command == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+int socket_bio_create(BIO* bio) {
+    BIO_set_init(bio, 1);
+    return 1;
+}
+
+// The fd stays owned by the Stream; the BIO only borrows it
+BIO* new_socket_bio(int fd) {
+    static BIO_METHOD* method = [] {
+        BIO_METHOD* created = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "toasty socket");
+        if (created) {
+            BIO_meth_set_write(created, socket_bio_write);
+            BIO_meth_set_read(created, socket_bio_read);
+            BIO_meth_set_ctrl(created, socket_bio_ctrl);
+            BIO_meth_set_create(created, socket_bio_create);
+        }
+        return created;
+    }();
+    if (!method) return nullptr;
+
+    BIO* bio = BIO_new(method);
+    if (bio) BIO_set_data(bio, reinterpret_cast<void*>(static_cast<intptr_t>(fd)));
+    return bio;
+}
+
+class TlsStream : public Stream {
+public:
+    TlsStream(int fd, SSL* ssl) : Stream(fd), ssl(ssl) {}
+
+    ~TlsStream() override {
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+    }
+
+    bool write_all(const char* data, size_t size) override {
+        while (size > 0) {
+            int sent = SSL_write(ssl, data, static_cast<int>(std::min<size_t>(size, 1 << 20)));
+            if (sent <= 0) return false;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    long read_some(char* data, size_t size) override {
+        int received = SSL_read(ssl, data, static_cast<int>(std::min<size_t>(size, 1 << 20)));
+        if (received > 0) return received;
+        return SSL_get_error(ssl, received) == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+    }
+
+private:
+    SSL* ssl;
+};
+#endif
+
+// Resolve and connect with a timeout, then switch to blocking I/O with socket timeouts
+int connect_socket(const HttpOrigin& origin, const HttpOptions& options) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(origin.host.c_str(), std::to_string(origin.port).c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) continue;
+
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        bool connected = ::connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+        if (!connected && errno == EINPROGRESS) {
+            pollfd waitFd = { fd, POLLOUT, 0 };
+            int error = 0;
+            socklen_t length = sizeof(error);
+            connected = poll(&waitFd, 1, options.connectTimeoutMs) == 1 &&
+                        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+        }
+        if (connected) {
+            fcntl(fd, F_SETFL, flags);
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) return -1;
+
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+    timeval timeout = { options.ioTimeoutMs / 1000, (options.ioTimeoutMs % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return fd;
+}
+
+// Fill the stream buffer until it holds at least size bytes
+bool fill(Stream& stream, size_t size) {
+    char chunk[16 * 1024];
+    while (stream.buffer.size() < size) {
+        long received = stream.read_some(chunk, sizeof(chunk));
+        if (received <= 0) return false;
+        stream.buffer.append(chunk, static_cast<size_t>(received));
+    }
+    return true;
+}
+
+// Where body bytes go: response.body, or the request's onBody callback. Counts bytes
+// against the limit and remembers when the callback asked to stop.
+class BodySink {
+public:
+    BodySink(const HttpRequest& request, HttpResponse& response, size_t limit)
+        : request(request), response(response), limit(limit) {}
+
+    // False once nothing more should be read (limit reached or callback stopped)
+    bool take(std::string_view bytes) {
+        bytes = bytes.substr(0, limit - delivered);
+        delivered += bytes.size();
+        if (request.onBody) {
+            if (!bytes.empty() && !request.onBody(bytes)) stopped = true;
+        } else {
+            response.body.append(bytes);
+        }
+        return !done();
+    }
+
+    bool done() const { return stopped || delivered >= limit; }
+    size_t size() const { return delivered; }
+
+private:
+    const HttpRequest& request;
+    HttpResponse& response;
+    size_t limit;
+    size_t delivered = 0;
+    bool stopped = false;
+};
+
+// Consume size bytes of body as they arrive. Stops early (returning true) when the
+// sink is done; the caller must then drop the connection.
+bool read_body_bytes(Stream& stream, size_t size, BodySink& sink) {
+    char chunk[16 * 1024];
+    while (size > 0) {
+        if (stream.buffer.empty()) {
+            long received = stream.read_some(chunk, std::min(sizeof(chunk), size));
+            if (received <= 0) return false;
+            stream.buffer.append(chunk, static_cast<size_t>(received));
+        }
+        size_t take = std::min(size, stream.buffer.size());
+        bool more = sink.take(std::string_view(stream.buffer).substr(0, take));
+        stream.buffer.erase(0, take);
+        size -= take;
+        if (!more) return true;
+    }
+    return true;
+}
+
+// Read a CRLF-terminated line from the stream buffer
+bool read_line(Stream& stream, std::string& line) {
+    size_t end;
+    while ((end = stream.buffer.find("\r\n")) == std::string::npos) {
+        if (stream.buffer.size() > MAX_HEADER_BYTES || !fill(stream, stream.buffer.size() + 1)) return false;
+    }
+    line = stream.buffer.substr(0, end);
+    stream.buffer.erase(0, end + 2);
+    return true;
+}
+
+class SocketTransport : public HttpTransport {
+public:
+    explicit SocketTransport(const HttpOptions& options) : options(options) {}
+
+    ~SocketTransport() override {
+#ifdef TOASTY_HAVE_OPENSSL
+        if (tlsContext) SSL_CTX_free(tlsContext);
+#endif
+    }
+
+    bool send(const HttpOrigin& origin, const HttpRequest& request, HttpResponse& response) override {
+        std::string head = request.method + " " + request.path + " HTTP/1.1\r\n"
+                           "Host: " + origin.host + "\r\n"
+                           "User-Agent: " + options.userAgent + "\r\n"
+                           "Connection: keep-alive\r\n";
+        for (const auto& header : request.headers) {
+            head += header.first + ": " + header.second + "\r\n";
+        }
+        if (!request.body.empty() || request.method == "POST" || request.method == "PUT") {
+            head += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        head += "\r\n";
+
+        // A pooled connection may have been closed by the server while idle;
+        // if it fails before any response arrives, retry once on a fresh one
+        for (int attempt = 0; attempt < 2; attempt++) {
+            std::unique_ptr<Stream> stream = take_connection(origin);
+            if (!stream) return false;
+
+            bool started = false;
+            bool keepAlive = false;
+            bool reused = stream->reused;
+            if (stream->write_all(head.data(), head.size()) &&
+                stream->write_all(request.body.data(), request.body.size()) &&
+                read_response(*stream, request, response, started, keepAlive)) {
+                if (keepAlive) {
+                    stream->reused = true;
+                    pool.emplace_back(origin, std::move(stream));
+                }
+                return true;
+            }
+            if (!reused || started) return false;
+        }
+        return false;
+    }
+
+private:
+    std::unique_ptr<Stream> take_connection(const HttpOrigin& origin) {
+        for (auto it = pool.begin(); it != pool.end(); ++it) {
+            if (it->first == origin) {
+                std::unique_ptr<Stream> stream = std::move(it->second);
+                pool.erase(it);
+                return stream;
+            }
+        }
+
+        int fd = connect_socket(origin, options);
+        if (fd < 0) return nullptr;
+        if (!origin.tls) return std::make_unique<Stream>(fd);
+
+#ifdef TOASTY_HAVE_OPENSSL
+        if (!tlsContext) {
+            tlsContext = SSL_CTX_new(TLS_client_method());
+            if (!tlsContext) {
+                close(fd);
+                return nullptr;
+            }
+            SSL_CTX_set_default_verify_paths(tlsContext);
+            SSL_CTX_set_verify(tlsContext, SSL_VERIFY_PEER, nullptr);
+            SSL_CTX_set_min_proto_version(tlsContext, TLS1_2_VERSION);
+        }
+
+        SSL* ssl = SSL_new(tlsContext);
+        BIO* bio = ssl ? new_socket_bio(fd) : nullptr;
+        if (!bio) {
+            if (ssl) SSL_free(ssl);
+            close(fd);
+            return nullptr;
+        }
+        SSL_set_tlsext_host_name(ssl, origin.host.c_str());
+        SSL_set1_host(ssl, origin.host.c_str());
+        SSL_set_bio(ssl, bio, bio);
+        if (SSL_connect(ssl) != 1) {
+            SSL_free(ssl);
+            close(fd);
+            return nullptr;
+        }
+        return std::make_unique<TlsStream>(fd, ssl);
+#else
+        close(fd);  // Built without OpenSSL: https is unavailable
+        return nullptr;
+#endif
+    }
+
+    bool read_response(Stream& stream, const HttpRequest& request, HttpResponse& response,
+                       bool& started, bool& keepAlive) {
+        response = HttpResponse();
+
+        std::string statusLine;
+        if (!read_line(stream, statusLine)) return false;
+        started = true;
+        // Skip interim 1xx responses (e.g. 100 Continue)
+        while (statusLine.size() > 12 && statusLine.compare(9, 1, "1") == 0) {
+            std::string line;
+            do {
+                if (!read_line(stream, line)) return false;
+            } while (!line.empty());
+            if (!read_line(stream, statusLine)) return false;
+        }
+        if (statusLine.size() < 12 || statusLine.compare(0, 5, "HTTP/") != 0) return false;
+        auto parsed = std::from_chars(statusLine.data() + 9, statusLine.data() + 12, response.status);
+        if (parsed.ec != std::errc()) return false;
+
+        std::string block;
+        for (;;) {
+            std::string line;
+            if (!read_line(stream, line)) return false;
+            if (line.empty()) break;
+            block += line + "\n";
+            if (block.size() > MAX_HEADER_BYTES) return false;
+        }
+        parse_header_lines(block, response);
+
+        const std::string* connection = response.header("Connection");
+        keepAlive = statusLine.compare(0, 8, "HTTP/1.1") == 0 &&
+                    !(connection && equals_ignore_case(*connection, "close"));
+
+        bool noBody = request.method == "HEAD" || response.status == 204 || response.status == 304;
+        const std::string* transferEncoding = response.header("Transfer-Encoding");
+        const std::string* contentLength = response.header("Content-Length");
+        BodySink sink(request, response, options.maxBodyBytes);
+
+        // Whether the whole body was consumed, leaving the connection reusable
+        bool complete = true;
+
+        if (noBody) {
+            // Nothing to read
+        } else if (transferEncoding && equals_ignore_case(*transferEncoding, "chunked")) {
+            complete = false;
+            while (!sink.done()) {
+                std::string sizeLine;
+                if (!read_line(stream, sizeLine)) return false;
+                size_t chunkSize = 0;
+                auto result = std::from_chars(sizeLine.data(), sizeLine.data() + sizeLine.size(), chunkSize, 16);
+                if (result.ec != std::errc()) return false;
+                if (chunkSize == 0) {
+                    std::string trailer;
+                    do {
+                        if (!read_line(stream, trailer)) return false;
+                    } while (!trailer.empty());
+                    complete = true;
+                    break;
+                }
+                std::string crlf;
+                if (!read_body_bytes(stream, chunkSize, sink) || (!sink.done() && !read_line(stream, crlf))) {
+                    return false;
+                }
+            }
+        } else if (contentLength) {
+            size_t length = 0;
+            auto result = std::from_chars(contentLength->data(), contentLength->data() + contentLength->size(), length);
+            if (result.ec != std::errc()) return false;
+            // A body over the limit is not drained just to keep the connection
+            if (!read_body_bytes(stream, std::min(length, options.maxBodyBytes), sink)) return false;
+            complete = sink.size() == length;
+        } else {
+            // Body runs to end of stream
+            keepAlive = false;
+            char chunk[16 * 1024];
+            bool more = sink.take(stream.buffer);
+            stream.buffer.clear();
+            long received;
+            while (more && (received = stream.read_some(chunk, sizeof(chunk))) > 0) {
+                more = sink.take(std::string_view(chunk, static_cast<size_t>(received)));
+            }
+        }
+
+        // Abandoned or truncated bodies leave unread bytes on the connection
+        if (!complete) keepAlive = false;
+        return true;
+    }
+
+    HttpOptions options;
+    std::vector<std::pair<HttpOrigin, std::unique_ptr<Stream>>> pool;
+#ifdef TOASTY_HAVE_OPENSSL
+    SSL_CTX* tlsContext = nullptr;
+#endif
+};
+
+}  // namespace
+
+std::unique_ptr<HttpTransport> create_http_transport(const HttpOptions& options) {
+    return std::make_unique<SocketTransport>(options);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Small HTTP/1.1 client for ntfy pushes and the update check.
+// Backends: WinHTTP on Windows; sockets elsewhere, with https through OpenSSL when the
+// build found it. A transport keeps connections open per origin, so the daemon or a
+// background worker pays DNS, TCP and TLS setup once for many requests.
+
+struct HttpOrigin {
+    bool tls = true;
+    std::string host;
+    uint16_t port = 443;
+
+    bool operator==(const HttpOrigin& other) const {
+        return tls == other.tls && port == other.port && host == other.host;
+    }
+};
+
+// Split "https://host[:port]/path", "http://..." or a bare "host[/path]" (https assumed)
+bool parse_http_url(std::string_view url, HttpOrigin& origin, std::string& path);
+
+struct HttpRequest {
+    std::string method = "GET";
+    std::string path = "/";
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    // When set, response body bytes are handed over as they arrive instead of being
+    // stored in HttpResponse::body. Return false to stop reading early; the connection
+    // is then closed rather than pooled. maxBodyBytes still bounds the total.
+    std::function<bool(std::string_view)> onBody;
+};
+
+struct HttpResponse {
+    int status = 0;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    // Case-insensitive header lookup; nullptr if absent
+    const std::string* header(std::string_view name) const;
+};
+
+struct HttpOptions {
+    std::string userAgent = "Toasty/1.0";
+    int connectTimeoutMs = 3000;
+    int ioTimeoutMs = 5000;
+    size_t maxBodyBytes = 1024 * 1024;   // Longer bodies are truncated
+};
+
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+
+    // Returns false on network failure; any HTTP status is a successful exchange.
+    // Connections to the same origin are reused across calls.
+    virtual bool send(const HttpOrigin& origin, const HttpRequest& request, HttpResponse& response) = 0;
+};
+
+std::unique_ptr<HttpTransport> create_http_transport(const HttpOptions& options = HttpOptions());
@@ -0,0 +1,248 @@
+#include "core/install_manifest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+
+#include "core/atomic_file.h"
+#include "core/json_value.h"
+#include "core/strings.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const MANIFEST_MAGIC = "TOASTY-MANIFEST 1";
+const size_t MANIFEST_FIELDS = 8;
+
+fs::path absolute_path(const fs::path& path) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    return (ec ? path : absolute).lexically_normal();
+}
+
+bool is_recent(fs::file_time_type modified) {
+    return fs::file_time_type::clock::now() - modified <
+           std::chrono::seconds(InstallManifest::RACY_WINDOW_SECONDS);
+}
+
+bool stamp_matches(const ManifestEntry& entry, const FileStamp& stamp) {
+    if (!stamp.exists) return !entry.exists;
+    return entry.exists && entry.size == stamp.size &&
+           entry.modified == static_cast<int64_t>(stamp.modified.time_since_epoch().count());
+}
+
+std::string path_utf8(const fs::path& path) {
+    std::u8string text = path.u8string();
+    return std::string(text.begin(), text.end());
+}
+
+bool parse_agent(std::string_view name, HookAgent& agent) {
+    for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+        if (name == HOOK_AGENTS[i].name) {
+            agent = HOOK_AGENTS[i].agent;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One manifest line; false if it isn't one of ours
+bool parse_entry(std::string_view line, ManifestEntry& entry) {
+    std::string_view fields[MANIFEST_FIELDS];
+    for (size_t i = 0; i + 1 < MANIFEST_FIELDS; i++) {
+        size_t tab = line.find('\t');
+        if (tab == std::string_view::npos) return false;
+        fields[i] = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+    }
+    fields[MANIFEST_FIELDS - 1] = line;  // The path, which may itself contain tabs
+
+    if (!parse_agent(fields[0], entry.agent) || fields[7].empty()) return false;
+    entry.exists = fields[1] == "1";
+    entry.installed = fields[2] == "1";
+    try {
+        entry.size = std::stoull(std::string(fields[3]));
+        entry.modified = std::stoll(std::string(fields[4]));
+        entry.contentHash = std::stoull(std::string(fields[5]), nullptr, 16);
+    } catch (...) {
+        return false;
+    }
+    entry.location = std::string(fields[6]);
+    entry.config = fs::path(std::u8string(fields[7].begin(), fields[7].end()));
+    return true;
+}
+
+}  // namespace
+
+const char* hook_check_name(HookCheck check) {
+    switch (check) {
+        case HookCheck::Stamp: return "stamp";
+        case HookCheck::Hash: return "hash";
+        case HookCheck::Parsed: return "parsed";
+    }
+    return "";
+}
+
+std::string hook_location(HookAgent agent) {
+    if (agent == HookAgent::Codex) {
+        return "notify";
+    }
+    return std::string("hooks.") + hook_agent_info(agent).hookType;
+}
+
+InstallManifest InstallManifest::load(const fs::path& path) {
+    InstallManifest manifest;
+    manifest.manifestPath = path;
+    std::ifstream file(path, std::ios::binary);
+    std::string line;
+    if (!std::getline(file, line) || line != MANIFEST_MAGIC) {
+        return manifest;
+    }
+    while (std::getline(file, line)) {
+        ManifestEntry entry;
+        if (!parse_entry(line, entry)) continue;
+        std::string key = path_key(entry.config);
+        auto found = manifest.index.find(key);
+        if (found != manifest.index.end()) {
+            manifest.list[found->second] = std::move(entry);  // The later line wins
+        } else {
+            manifest.index.emplace(std::move(key), manifest.list.size());
+            manifest.list.push_back(std::move(entry));
+        }
+    }
+    return manifest;
+}
+
+const ManifestEntry* InstallManifest::find(const fs::path& configPath) const {
+    auto found = index.find(path_key(absolute_path(configPath)));
+    return found == index.end() ? nullptr : &list[found->second];
+}
+
+ManifestEntry& InstallManifest::entry_for(HookAgent agent, const fs::path& config) {
+    auto [found, added] = index.emplace(path_key(config), list.size());
+    if (added) {
+        list.emplace_back();
+        list.back().config = config;
+    }
+    ManifestEntry& entry = list[found->second];
+    if (entry.agent != agent || added) {
+        entry.agent = agent;
+        entry.exists = false;   // Recorded for another agent: nothing to trust
+        entry.contentHash = 0;
+    }
+    entry.location = hook_location(agent);
+    return entry;
+}
+
+HookStatus InstallManifest::check(HookAgent agent, const fs::path& configPath) {
+    return refresh(agent, configPath, true);
+}
+
+HookStatus InstallManifest::record(HookAgent agent, const fs::path& configPath) {
+    return refresh(agent, configPath, false);
+}
+
+HookStatus InstallManifest::refresh(HookAgent agent, const fs::path& configPath, bool trustStamp) {
+    fs::path config = absolute_path(configPath);
+    FileStamp stamp = file_stamp(config);
+    if (trustStamp) {
+        const ManifestEntry* known = find(config);
+        if (known && known->agent == agent && stamp_matches(*known, stamp) &&
+            (!stamp.exists || !is_recent(stamp.modified))) {
+            return {known->installed, HookCheck::Stamp};
+        }
+    }
+
+    ManifestEntry& entry = entry_for(agent, config);
+    HookStatus status;
+    if (!stamp.exists) {
+        status.check = HookCheck::Stamp;  // Nothing to read
+        dirty = dirty || entry.exists || entry.installed;
+        entry.exists = false;
+        entry.installed = false;
+        entry.size = 0;
+        entry.modified = 0;
+        entry.contentHash = 0;
+        return status;
+    }
+
+    std::string content = read_file_bytes(config);
+    uint64_t hash = fnv1a_64(content);
+    if (trustStamp && entry.exists && hash == entry.contentHash) {
+        status = {entry.installed, HookCheck::Hash};
+    } else {
+        status = {has_toasty_hook(agent, content), HookCheck::Parsed};
+    }
+
+    // A file rewritten while it was being read is recorded without a stamp, so the
+    // next check reads it again
+    bool settled = file_stamp(config) == stamp;
+    entry.exists = true;
+    entry.installed = status.installed;
+    entry.size = settled ? stamp.size : 0;
+    entry.modified = settled ? static_cast<int64_t>(stamp.modified.time_since_epoch().count()) : 0;
+    entry.contentHash = hash;
+    dirty = true;
+    return status;
+}
+
+bool InstallManifest::save(std::string& error) {
+    error.clear();
+    if (!dirty || manifestPath.empty()) {
+        return true;
+    }
+
+    std::string text = MANIFEST_MAGIC;
+    text += '\n';
+    for (const ManifestEntry& entry : list) {
+        std::u8string path = entry.config.generic_u8string();
+        if (path.find(u8'\n') != std::u8string::npos || path.find(u8'\r') != std::u8string::npos) {
+            continue;  // Can't be stored on one line; it will just be parsed next time
+        }
+        char numbers[96];
+        std::snprintf(numbers, sizeof(numbers), "\t%d\t%d\t%llu\t%lld\t%016llx\t", entry.exists ? 1 : 0,
+                      entry.installed ? 1 : 0, static_cast<unsigned long long>(entry.size),
+                      static_cast<long long>(entry.modified), static_cast<unsigned long long>(entry.contentHash));
+        text += hook_agent_info(entry.agent).name;
+        text += numbers;
+        text += entry.location;
+        text += '\t';
+        text.append(path.begin(), path.end());
+        text += '\n';
+    }
+
+    std::error_code ec;
+    fs::create_directories(manifestPath.parent_path(), ec);
+    if (!write_file_atomic(manifestPath, text, error)) {
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+std::string status_json(const std::vector<AgentStatus>& agents, std::string_view version, const fs::path& manifestPath) {
+    JsonValue list = JsonValue::array();
+    for (const AgentStatus& status : agents) {
+        const HookAgentInfo& info = hook_agent_info(status.agent);
+        JsonValue item = JsonValue::object();
+        item.set("name", JsonValue::string(info.name));
+        item.set("displayName", JsonValue::string(info.displayName));
+        item.set("detected", JsonValue::boolean(status.detected));
+        item.set("installed", JsonValue::boolean(status.hook.installed));
+        item.set("config", JsonValue::string(path_utf8(status.config)));
+        item.set("location", JsonValue::string(hook_location(status.agent)));
+        item.set("checkedBy", JsonValue::string(hook_check_name(status.hook.check)));
+        list.append(std::move(item));
+    }
+
+    JsonValue root = JsonValue::object();
+    root.set("version", JsonValue::string(std::string(version)));
+    root.set("manifest", JsonValue::string(path_utf8(manifestPath)));
+    root.set("agents", std::move(list));
+    std::string out;
+    root.stringify_to(out, "  ", "");
+    out += '\n';
+    return out;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/hook_config.h"
+
+// What toasty last saw in each hook config it installed into, checked or removed from,
+// so --status and --uninstall don't re-read and re-parse every agent's config each time.
+// An entry is trusted while the config's size and modification time still match (one
+// stat); when they don't, the file is read and hashed, and only a changed hash means
+// parsing it again. A config modified within RACY_WINDOW of being recorded is always
+// hashed: a second edit in the same timestamp tick would leave the stamp unchanged.
+//
+// File: "TOASTY-MANIFEST 1", then one tab-separated line per config: agent, exists,
+// installed, size, mtime ticks, content hash (hex), location in the document, path.
+// A missing or foreign file loads as empty; a stale entry only costs a re-parse, so
+// concurrent toasty processes may overwrite each other's saves without a lock.
+
+struct ManifestEntry {
+    HookAgent agent = HookAgent::Claude;
+    std::filesystem::path config;   // Absolute
+    std::string location;           // Where the hook sits: hooks.<event>, or notify for Codex
+    bool exists = false;
+    bool installed = false;
+    uintmax_t size = 0;
+    int64_t modified = 0;           // file_time_type ticks
+    uint64_t contentHash = 0;       // FNV-1a of the file's bytes
+};
+
+// How a status was answered
+enum class HookCheck {
+    Stamp,   // Size and mtime matched the manifest
+    Hash,    // File re-read, same bytes as recorded
+    Parsed,  // File changed (or was never seen) and was parsed
+};
+
+const char* hook_check_name(HookCheck check);
+
+struct HookStatus {
+    bool installed = false;
+    HookCheck check = HookCheck::Parsed;
+};
+
+// "hooks.Stop", "notify", ...
+std::string hook_location(HookAgent agent);
+
+class InstallManifest {
+public:
+    static constexpr int64_t RACY_WINDOW_SECONDS = 2;
+
+    // Load path; a missing or unreadable manifest is empty
+    static InstallManifest load(const std::filesystem::path& path);
+
+    // Whether toasty's hook is in configPath, from the manifest when it is still current
+    HookStatus check(HookAgent agent, const std::filesystem::path& configPath);
+
+    // After toasty changed configPath: forget what was recorded and parse it again
+    HookStatus record(HookAgent agent, const std::filesystem::path& configPath);
+
+    // Write the manifest if anything changed since it was loaded
+    bool save(std::string& error);
+
+    const std::filesystem::path& path() const { return manifestPath; }
+    const std::vector<ManifestEntry>& entries() const { return list; }
+    const ManifestEntry* find(const std::filesystem::path& configPath) const;
+
+private:
+    HookStatus refresh(HookAgent agent, const std::filesystem::path& configPath, bool trustStamp);
+    ManifestEntry& entry_for(HookAgent agent, const std::filesystem::path& config);
+
+    std::filesystem::path manifestPath;
+    std::vector<ManifestEntry> list;
+    std::unordered_map<std::string, size_t> index;   // Generic path -> position in list
+    bool dirty = false;
+};
+
+// One agent's line in --status
+struct AgentStatus {
+    HookAgent agent = HookAgent::Claude;
+    bool detected = false;
+    HookStatus hook;
+    std::filesystem::path config;
+};
+
+// --status --json: {"version", "manifest", "agents": [{"name", "displayName",
+// "detected", "installed", "config", "location", "checkedBy"}]}, for tools that poll it
+std::string status_json(const std::vector<AgentStatus>& agents, std::string_view version,
+                        const std::filesystem::path& manifestPath);
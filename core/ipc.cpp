@@ -0,0 +1,545 @@
+#include "core/ipc.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "core/strings.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void put_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint32_t get_u32(const char* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+}  // namespace
+
+void IpcMessage::set(uint8_t tag, std::string value) {
+    for (auto& field : fields) {
+        if (field.first == tag) {
+            field.second = std::move(value);
+            return;
+        }
+    }
+    fields.emplace_back(tag, std::move(value));
+}
+
+const std::string* IpcMessage::get(uint8_t tag) const {
+    for (const auto& field : fields) {
+        if (field.first == tag) return &field.second;
+    }
+    return nullptr;
+}
+
+std::string encode_ipc_message(const IpcMessage& message) {
+    size_t size = 4 + 1;
+    for (const auto& field : message.fields) size += 5 + field.second.size();
+
+    std::string frame;
+    frame.reserve(size);
+    put_u32(frame, static_cast<uint32_t>(size - 4));
+    frame.push_back(static_cast<char>(message.type));
+    for (const auto& field : message.fields) {
+        frame.push_back(static_cast<char>(field.first));
+        put_u32(frame, static_cast<uint32_t>(field.second.size()));
+        frame += field.second;
+    }
+    return frame;
+}
+
+bool decode_ipc_payload(std::string_view payload, IpcMessage& message) {
+    if (payload.empty()) return false;
+
+    message.type = static_cast<uint8_t>(payload[0]);
+    message.fields.clear();
+
+    size_t pos = 1;
+    while (pos < payload.size()) {
+        if (payload.size() - pos < 5) return false;
+        uint8_t tag = static_cast<uint8_t>(payload[pos]);
+        uint32_t length = get_u32(payload.data() + pos + 1);
+        pos += 5;
+        if (length > payload.size() - pos) return false;
+        message.fields.emplace_back(tag, std::string(payload.substr(pos, length)));
+        pos += length;
+    }
+    return true;
+}
+
+bool IpcConnection::send(const IpcMessage& message, int timeoutMs) {
+    std::string frame = encode_ipc_message(message);
+    if (frame.size() - 4 > IPC_MAX_FRAME) return false;
+    return write_all(frame.data(), frame.size(), timeoutMs);
+}
+
+bool IpcConnection::receive(IpcMessage& message, int timeoutMs) {
+    char header[4];
+    if (!read_exact(header, sizeof(header), timeoutMs)) return false;
+
+    uint32_t length = get_u32(header);
+    if (length == 0 || length > IPC_MAX_FRAME) return false;
+
+    std::string payload(length, '\0');
+    if (!read_exact(&payload[0], length, timeoutMs)) return false;
+    return decode_ipc_payload(payload, message);
+}
+
+namespace {
+
+// Milliseconds left until a deadline (-1 = no deadline)
+class Deadline {
+public:
+    explicit Deadline(int timeoutMs)
+        : infinite(timeoutMs < 0),
+          end(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs)) {}
+
+    int remaining() const {
+        if (infinite) return -1;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now()).count();
+        return left > 0 ? static_cast<int>(left) : 0;
+    }
+
+private:
+    bool infinite;
+    std::chrono::steady_clock::time_point end;
+};
+
+}  // namespace
+
+#ifdef _WIN32
+
+namespace {
+
+// Named pipe end opened for overlapped I/O, so every read and write can time out
+class PipeConnection : public IpcConnection {
+public:
+    explicit PipeConnection(HANDLE pipe)
+        : pipe(pipe), event(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+
+    ~PipeConnection() override {
+        if (event) CloseHandle(event);
+        if (pipe != INVALID_HANDLE_VALUE) CloseHandle(pipe);
+    }
+
+protected:
+    bool write_all(const char* data, size_t size, int timeoutMs) override {
+        Deadline deadline(timeoutMs);
+        while (size > 0) {
+            DWORD chunk = (DWORD)std::min<size_t>(size, 64 * 1024);
+            DWORD done = 0;
+            if (!transfer(false, const_cast<char*>(data), chunk, done, deadline.remaining()) || done == 0) {
+                return false;
+            }
+            data += done;
+            size -= done;
+        }
+        return true;
+    }
+
+    bool read_exact(char* data, size_t size, int timeoutMs) override {
+        Deadline deadline(timeoutMs);
+        while (size > 0) {
+            DWORD chunk = (DWORD)std::min<size_t>(size, 64 * 1024);
+            DWORD done = 0;
+            if (!transfer(true, data, chunk, done, deadline.remaining()) || done == 0) {
+                return false;
+            }
+            data += done;
+            size -= done;
+        }
+        return true;
+    }
+
+private:
+    bool transfer(bool read, char* buffer, DWORD size, DWORD& done, int timeoutMs) {
+        if (!event) return false;
+
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = event;
+        ResetEvent(event);
+
+        BOOL ok = read ? ReadFile(pipe, buffer, size, nullptr, &overlapped)
+                       : WriteFile(pipe, buffer, size, nullptr, &overlapped);
+        if (!ok) {
+            if (GetLastError() != ERROR_IO_PENDING) return false;
+            DWORD wait = WaitForSingleObject(event, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs);
+            if (wait != WAIT_OBJECT_0) {
+                CancelIo(pipe);
+                GetOverlappedResult(pipe, &overlapped, &done, TRUE);
+                return false;
+            }
+        }
+        return GetOverlappedResult(pipe, &overlapped, &done, FALSE) != FALSE;
+    }
+
+    HANDLE pipe;
+    HANDLE event;
+};
+
+// SID of the user a process runs as; empty on failure
+std::vector<BYTE> process_user_sid(HANDLE process) {
+    std::vector<BYTE> sid;
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(process, TOKEN_QUERY, &token)) return sid;
+
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    std::vector<BYTE> buffer(size);
+    if (size > 0 && GetTokenInformation(token, TokenUser, buffer.data(), size, &size)) {
+        PSID user = reinterpret_cast<TOKEN_USER*>(buffer.data())->User.Sid;
+        if (IsValidSid(user)) {
+            DWORD length = GetLengthSid(user);
+            sid.resize(length);
+            if (!CopySid(length, sid.data(), user)) sid.clear();
+        }
+    }
+    CloseHandle(token);
+    return sid;
+}
+
+// Protected DACL with a single ACE for the current user. Without it the pipe
+// gets the default DACL, which also lets other accounts open it.
+struct OwnerOnlySecurity {
+    std::vector<BYTE> sid;
+    std::vector<BYTE> acl;
+    SECURITY_DESCRIPTOR descriptor = {};
+    SECURITY_ATTRIBUTES attributes = {};
+
+    bool init() {
+        sid = process_user_sid(GetCurrentProcess());
+        if (sid.empty()) return false;
+
+        DWORD aclSize = sizeof(ACL) + sizeof(ACCESS_ALLOWED_ACE) - sizeof(DWORD) + GetLengthSid(sid.data());
+        acl.resize(aclSize);
+        PACL dacl = reinterpret_cast<PACL>(acl.data());
+        if (!InitializeAcl(dacl, aclSize, ACL_REVISION) ||
+            !AddAccessAllowedAce(dacl, ACL_REVISION, FILE_ALL_ACCESS, sid.data()) ||
+            !InitializeSecurityDescriptor(&descriptor, SECURITY_DESCRIPTOR_REVISION) ||
+            !SetSecurityDescriptorDacl(&descriptor, TRUE, dacl, FALSE) ||
+            !SetSecurityDescriptorControl(&descriptor, SE_DACL_PROTECTED, SE_DACL_PROTECTED)) {
+            return false;
+        }
+
+        attributes.nLength = sizeof(attributes);
+        attributes.lpSecurityDescriptor = &descriptor;
+        attributes.bInheritHandle = FALSE;
+        return true;
+    }
+};
+
+HANDLE create_pipe_instance(const std::wstring& name, bool first) {
+    OwnerOnlySecurity security;
+    if (!security.init()) return INVALID_HANDLE_VALUE;
+
+    DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+    return CreateNamedPipeW(name.c_str(), openMode,
+                            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                            PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, &security.attributes);
+}
+
+// The pipe name is predictable, so another account could create it before our
+// daemon does. Only talk to a server process running as the current user.
+bool server_is_current_user(HANDLE pipe) {
+    ULONG serverPid = 0;
+    if (!GetNamedPipeServerProcessId(pipe, &serverPid)) return false;
+
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, serverPid);
+    if (!process) return false;
+    std::vector<BYTE> server = process_user_sid(process);
+    CloseHandle(process);
+
+    std::vector<BYTE> self = process_user_sid(GetCurrentProcess());
+    return !server.empty() && !self.empty() && EqualSid(server.data(), self.data());
+}
+
+class PipeListener : public IpcListener {
+public:
+    PipeListener(std::wstring name, HANDLE first) : name(std::move(name)), next(first) {}
+
+    ~PipeListener() override {
+        if (next != INVALID_HANDLE_VALUE) CloseHandle(next);
+    }
+
+    std::unique_ptr<IpcConnection> accept() override {
+        if (next == INVALID_HANDLE_VALUE) {
+            next = create_pipe_instance(name, false);
+            if (next == INVALID_HANDLE_VALUE) return nullptr;
+        }
+        HANDLE pipe = next;
+        next = INVALID_HANDLE_VALUE;
+
+        HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = event;
+
+        BOOL connected = ConnectNamedPipe(pipe, &overlapped);
+        if (!connected) {
+            DWORD error = GetLastError();
+            if (error == ERROR_IO_PENDING) {
+                DWORD unused = 0;
+                connected = GetOverlappedResult(pipe, &overlapped, &unused, TRUE);
+            } else {
+                connected = (error == ERROR_PIPE_CONNECTED);
+            }
+        }
+        if (event) CloseHandle(event);
+
+        if (!connected) {
+            CloseHandle(pipe);
+            return nullptr;
+        }
+        return std::make_unique<PipeConnection>(pipe);
+    }
+
+private:
+    std::wstring name;
+    HANDLE next;
+};
+
+}  // namespace
+
+std::string default_ipc_endpoint() {
+    wchar_t user[256] = {};
+    DWORD size = 256;
+    if (!GetUserNameW(user, &size)) user[0] = L'\0';
+
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+
+    return "\\\\.\\pipe\\toasty-" + to_utf8(user) + "-" + std::to_string(session);
+}
+
+std::unique_ptr<IpcConnection> ipc_connect(const std::string& endpoint, int timeoutMs) {
+    std::wstring name = from_utf8(endpoint);
+    Deadline deadline(timeoutMs);
+
+    for (;;) {
+        // SECURITY_IDENTIFICATION: the server may identify us, never impersonate us
+        HANDLE pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE) {
+            if (!server_is_current_user(pipe)) {
+                CloseHandle(pipe);
+                return nullptr;
+            }
+            return std::make_unique<PipeConnection>(pipe);
+        }
+        if (GetLastError() != ERROR_PIPE_BUSY) {
+            return nullptr;  // No daemon
+        }
+
+        int remaining = deadline.remaining();
+        if (remaining == 0 || !WaitNamedPipeW(name.c_str(), remaining < 0 ? NMPWAIT_WAIT_FOREVER : (DWORD)remaining)) {
+            return nullptr;
+        }
+    }
+}
+
+std::unique_ptr<IpcListener> ipc_listen(const std::string& endpoint) {
+    std::wstring name = from_utf8(endpoint);
+
+    // FILE_FLAG_FIRST_PIPE_INSTANCE fails if another daemon already owns the name
+    HANDLE first = create_pipe_instance(name, true);
+    if (first == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    return std::make_unique<PipeListener>(std::move(name), first);
+}
+
+#else  // POSIX
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+bool wait_fd(int fd, short events, int timeoutMs) {
+    pollfd pfd = { fd, events, 0 };
+    int result;
+    do {
+        result = poll(&pfd, 1, timeoutMs);
+    } while (result < 0 && errno == EINTR);
+    return result > 0;
+}
+
+bool make_address(const std::string& endpoint, sockaddr_un& address) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path)) return false;
+    std::copy(endpoint.begin(), endpoint.end(), address.sun_path);
+    return true;
+}
+
+class SocketConnection : public IpcConnection {
+public:
+    explicit SocketConnection(int fd) : fd(fd) {
+        set_nonblocking(fd);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    }
+
+    ~SocketConnection() override { close(fd); }
+
+protected:
+    bool write_all(const char* data, size_t size, int timeoutMs) override {
+        Deadline deadline(timeoutMs);
+        while (size > 0) {
+            ssize_t written = ::send(fd, data, size, SEND_FLAGS);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_fd(fd, POLLOUT, deadline.remaining())) continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool read_exact(char* data, size_t size, int timeoutMs) override {
+        Deadline deadline(timeoutMs);
+        while (size > 0) {
+            ssize_t received = ::recv(fd, data, size, 0);
+            if (received == 0) return false;  // Peer closed
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_fd(fd, POLLIN, deadline.remaining())) continue;
+                return false;
+            }
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+private:
+    int fd;
+};
+
+class SocketListener : public IpcListener {
+public:
+    SocketListener(int fd, std::string path) : fd(fd), path(std::move(path)) {}
+
+    ~SocketListener() override {
+        close(fd);
+        unlink(path.c_str());
+    }
+
+    std::unique_ptr<IpcConnection> accept() override {
+        for (;;) {
+            int client = ::accept(fd, nullptr, nullptr);
+            if (client >= 0) return std::make_unique<SocketConnection>(client);
+            if (errno != EINTR && errno != ECONNABORTED) return nullptr;
+        }
+    }
+
+private:
+    int fd;
+    std::string path;
+};
+
+// Create (or reuse) a directory only we can enter. /tmp is shared, so the name
+// may already exist: accept it only if it is a real directory we own with no
+// group or other access.
+bool make_private_directory(const std::string& path) {
+    if (mkdir(path.c_str(), S_IRWXU) != 0 && errno != EEXIST) return false;
+
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0) return false;
+    return S_ISDIR(info.st_mode) && info.st_uid == getuid() && (info.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+}
+
+}  // namespace
+
+std::string default_ipc_endpoint() {
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && runtimeDir[0] != '\0') {
+        return std::string(runtimeDir) + "/toasty.sock";
+    }
+
+    std::string directory = "/tmp/toasty-" + std::to_string(getuid());
+    if (!make_private_directory(directory)) return "";
+    return directory + "/toasty.sock";
+}
+
+std::unique_ptr<IpcConnection> ipc_connect(const std::string& endpoint, int timeoutMs) {
+    sockaddr_un address;
+    if (!make_address(endpoint, address)) return nullptr;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return nullptr;
+    set_nonblocking(fd);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        if (errno != EINPROGRESS && errno != EAGAIN) {
+            close(fd);
+            return nullptr;  // No daemon (ENOENT / ECONNREFUSED)
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (!wait_fd(fd, POLLOUT, timeoutMs) ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            close(fd);
+            return nullptr;
+        }
+    }
+    return std::make_unique<SocketConnection>(fd);
+}
+
+std::unique_ptr<IpcListener> ipc_listen(const std::string& endpoint) {
+    sockaddr_un address;
+    if (!make_address(endpoint, address)) return nullptr;
+
+    // A socket that still accepts connections belongs to a live daemon; anything
+    // else at that path is stale and can be replaced
+    if (ipc_connect(endpoint, 100)) return nullptr;
+    unlink(endpoint.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return nullptr;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        chmod(endpoint.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        listen(fd, 16) != 0) {
+        close(fd);
+        unlink(endpoint.c_str());
+        return nullptr;
+    }
+    return std::make_unique<SocketListener>(fd, endpoint);
+}
+
+#endif
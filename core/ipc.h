@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Local IPC between the toasty CLI and a resident "toasty --serve" daemon.
+// Transport: named pipe on Windows, Unix domain socket elsewhere.
+//
+// Framing: [u32 payload length][u8 type][field]*, each field [u8 tag][u32 length][bytes].
+// Integers are little-endian, strings are UTF-8. Unknown tags are ignored so the
+// protocol can grow without breaking older daemons.
+
+const uint32_t IPC_MAX_FRAME = 4 * 1024 * 1024;
+
+enum IpcMessageType : uint8_t {
+    IPC_PING = 1,
+    IPC_NOTIFY = 2,
+    IPC_REPLY = 0x80,
+};
+
+enum IpcFieldTag : uint8_t {
+    IPC_FIELD_TITLE = 1,
+    IPC_FIELD_MESSAGE = 2,
+    IPC_FIELD_ICON = 3,         // Resolved icon path
+    IPC_FIELD_WINDOW = 4,       // Decimal terminal window handle, for click-to-focus
+    IPC_FIELD_NTFY_SERVER = 5,
+    IPC_FIELD_NTFY_TOPIC = 6,
+    IPC_FIELD_STATUS = 7,       // Reply: "ok" or an error description
+};
+
+struct IpcMessage {
+    uint8_t type = 0;
+    std::vector<std::pair<uint8_t, std::string>> fields;
+
+    void set(uint8_t tag, std::string value);
+    const std::string* get(uint8_t tag) const;
+};
+
+// Encode a full frame, length prefix included
+std::string encode_ipc_message(const IpcMessage& message);
+
+// Decode one frame payload (the bytes after the length prefix)
+bool decode_ipc_payload(std::string_view payload, IpcMessage& message);
+
+// A connected stream. Timeouts are in milliseconds; negative waits forever.
+class IpcConnection {
+public:
+    virtual ~IpcConnection() = default;
+
+    bool send(const IpcMessage& message, int timeoutMs);
+    bool receive(IpcMessage& message, int timeoutMs);
+
+protected:
+    virtual bool write_all(const char* data, size_t size, int timeoutMs) = 0;
+    virtual bool read_exact(char* data, size_t size, int timeoutMs) = 0;
+};
+
+class IpcListener {
+public:
+    virtual ~IpcListener() = default;
+
+    // Blocks until a client connects; nullptr on error
+    virtual std::unique_ptr<IpcConnection> accept() = 0;
+};
+
+// Per-user endpoint: \\.\pipe\toasty-<user>-<session>, $XDG_RUNTIME_DIR/toasty.sock, or
+// /tmp/toasty-<uid>/toasty.sock in a 0700 directory we own. Empty when that
+// directory exists but fails the ownership check.
+std::string default_ipc_endpoint();
+
+// Connect to a daemon. Returns nullptr quickly when none is listening, and on
+// Windows when the pipe's server runs as another user.
+std::unique_ptr<IpcConnection> ipc_connect(const std::string& endpoint, int timeoutMs);
+
+// Start serving an endpoint. Returns nullptr if a live daemon already owns it.
+std::unique_ptr<IpcListener> ipc_listen(const std::string& endpoint);
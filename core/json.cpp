@@ -0,0 +1,217 @@
+#include "core/json.h"
+
+#include <cstdint>
+#include <cstdio>
+
+#include "core/char_scan.h"
+
+namespace {
+
+const CharSet JSON_STRING_SPECIALS = {{'"', '\\'}, 2, true};
+
+}  // namespace
+
+void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    size_t runStart = 0;
+    for (size_t i = find_first_in_set(text, JSON_STRING_SPECIALS); i < text.size();
+         i = find_first_in_set(text, JSON_STRING_SPECIALS, runStart)) {
+        out.append(text, runStart, i - runStart);
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+        }
+        runStart = i + 1;
+    }
+    out.append(text, runStart, std::string_view::npos);
+    out += '"';
+}
+
+namespace {
+
+bool is_json_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void skip_space(std::string_view text, size_t& i) {
+    while (i < text.size() && is_json_space(text[i])) i++;
+}
+
+// At an opening quote: set raw to the string's content and move past the closing quote
+bool scan_string(std::string_view text, size_t& i, std::string_view& raw) {
+    size_t start = ++i;
+    while (i < text.size()) {
+        if (text[i] == '\\') {
+            i += 2;
+        } else if (text[i] == '"') {
+            raw = text.substr(start, i - start);
+            i++;
+            return true;
+        } else {
+            i++;
+        }
+    }
+    return false;
+}
+
+// Move past one non-string value: a scalar, or a whole object or array
+bool skip_value(std::string_view text, size_t& i) {
+    int depth = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '"') {
+            std::string_view ignored;
+            if (!scan_string(text, i, ignored)) return false;
+            if (depth == 0) return true;
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) return true;  // End of the enclosing object
+            if (--depth == 0) {
+                i++;
+                return true;
+            }
+        } else if (depth == 0 && (c == ',' || is_json_space(c))) {
+            return true;
+        }
+        i++;
+    }
+    return depth == 0;
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool read_hex4(std::string_view raw, size_t at, unsigned& value) {
+    if (at + 4 > raw.size()) return false;
+    value = 0;
+    for (size_t k = at; k < at + 4; k++) {
+        int digit = hex_digit(raw[k]);
+        if (digit < 0) return false;
+        value = value * 16 + static_cast<unsigned>(digit);
+    }
+    return true;
+}
+
+void append_utf8(std::string& out, unsigned codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+}  // namespace
+
+bool scan_json_object(std::string_view json, const JsonMemberFn& onMember, size_t maxBytes) {
+    json = json.substr(0, maxBytes);
+    size_t i = 0;
+    skip_space(json, i);
+    if (i >= json.size() || json[i] != '{') return false;
+    i++;
+
+    for (;;) {
+        skip_space(json, i);
+        if (i >= json.size()) return false;
+        if (json[i] == '}') return true;
+
+        std::string_view key;
+        if (json[i] != '"' || !scan_string(json, i, key)) return false;
+        skip_space(json, i);
+        if (i >= json.size() || json[i] != ':') return false;
+        i++;
+        skip_space(json, i);
+        if (i >= json.size()) return false;
+
+        std::string_view value;
+        bool isString = json[i] == '"';
+        if (isString) {
+            if (!scan_string(json, i, value)) return false;
+        } else {
+            size_t start = i;
+            if (!skip_value(json, i) || i == start) return false;
+            value = json.substr(start, i - start);
+        }
+        if (!onMember(key, value, isString)) return true;
+
+        skip_space(json, i);
+        if (i >= json.size()) return false;
+        if (json[i] == ',') {
+            i++;
+        } else if (json[i] != '}') {
+            return false;
+        }
+    }
+}
+
+std::string json_unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (raw[i] != '\\' || i + 1 >= raw.size()) {
+            out += raw[i];
+            continue;
+        }
+
+        char escaped = raw[i + 1];
+        switch (escaped) {
+            case '"': case '\\': case '/': out += escaped; i++; break;
+            case 'b': out += '\b'; i++; break;
+            case 'f': out += '\f'; i++; break;
+            case 'n': out += '\n'; i++; break;
+            case 'r': out += '\r'; i++; break;
+            case 't': out += '\t'; i++; break;
+            case 'u': {
+                unsigned codePoint;
+                if (!read_hex4(raw, i + 2, codePoint)) {
+                    out += raw[i];
+                    break;
+                }
+                i += 5;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    unsigned low;
+                    if (i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+                        read_hex4(raw, i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else {
+                        codePoint = 0xFFFD;
+                    }
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    codePoint = 0xFFFD;
+                }
+                append_utf8(out, codePoint);
+                break;
+            }
+            default:
+                out += raw[i];
+                break;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Append text as a quoted JSON string. Input is UTF-8 and passes through unchanged
+// apart from quotes, backslashes and control characters.
+void append_json_string(std::string& out, std::string_view text);
+
+// Called for each top-level member. key and value are views into the scanned text:
+// for strings, the content between the quotes with escapes still in place (see
+// json_unescape); otherwise the raw token, e.g. 42, null or a whole nested object.
+// Return false to stop scanning.
+using JsonMemberFn = std::function<bool(std::string_view key, std::string_view value, bool isString)>;
+
+// On-demand, zero-copy walk over the members of a JSON object. Nested values are
+// skipped, not parsed, and nothing past the first maxBytes is looked at. Members
+// before a truncation or syntax error are still reported; the result says whether
+// the whole object was scanned cleanly.
+bool scan_json_object(std::string_view json, const JsonMemberFn& onMember, size_t maxBytes = SIZE_MAX);
+
+// Decode the escapes in a JSON string's content (\n, \", \uXXXX incl. surrogate
+// pairs) to UTF-8. Invalid escapes are kept literally.
+std::string json_unescape(std::string_view raw);
@@ -0,0 +1,377 @@
+#include "core/json_patch.h"
+
+#include <algorithm>
+
+#include "core/char_scan.h"
+#include "core/json.h"
+
+namespace {
+
+const CharSet STRING_STOPS = {{'"', '\\'}, 2, true};
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Walks JSON text without building anything. Accepts exactly what JsonValue's
+// parser accepts, including its depth limit, so a document that fails here would
+// also have failed JsonValue::parse.
+class Scanner {
+public:
+    Scanner(std::string_view text, size_t pos) : text(text), pos(pos) {}
+
+    std::string_view text;
+    size_t pos;
+
+    void skip_space() {
+        while (pos < text.size() && is_space(text[pos])) pos++;
+    }
+
+    bool at(char c) const {
+        return pos < text.size() && text[pos] == c;
+    }
+
+    // At the opening quote. Strings are the bulk of a config, so runs without quotes,
+    // backslashes or control characters are skipped with the vectorized scanner.
+    bool skip_string() {
+        pos++;
+        for (;;) {
+            pos = find_first_in_set(text, STRING_STOPS, pos);
+            if (pos >= text.size()) return false;
+            if (text[pos] == '"') {
+                pos++;
+                return true;
+            }
+            if (text[pos] != '\\') return false;  // Raw control character
+            pos += 2;
+        }
+    }
+
+    // At the first character of a value
+    bool skip_value(int depth) {
+        if (pos >= text.size()) return false;
+        char c = text[pos];
+        if (c == '{' || c == '[') {
+            if (depth >= JsonValue::MAX_DEPTH) return false;
+            return c == '{' ? skip_object(depth + 1) : skip_array(depth + 1);
+        }
+        if (c == '"') return skip_string();
+        if (c == '-' || (c >= '0' && c <= '9')) return skip_number();
+        for (std::string_view literal : {"true", "false", "null"}) {
+            if (text.substr(pos, literal.size()) == literal) {
+                pos += literal.size();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    bool is_digit(size_t at) const {
+        return at < text.size() && text[at] >= '0' && text[at] <= '9';
+    }
+
+    bool skip_number() {
+        if (text[pos] == '-') pos++;
+        if (!is_digit(pos)) return false;
+        if (text[pos] == '0') {
+            pos++;
+        } else {
+            while (is_digit(pos)) pos++;
+        }
+        if (at('.')) {
+            pos++;
+            if (!is_digit(pos)) return false;
+            while (is_digit(pos)) pos++;
+        }
+        if (at('e') || at('E')) {
+            pos++;
+            if (at('+') || at('-')) pos++;
+            if (!is_digit(pos)) return false;
+            while (is_digit(pos)) pos++;
+        }
+        return true;
+    }
+
+    bool skip_array(int depth) {
+        pos++;
+        skip_space();
+        if (at(']')) {
+            pos++;
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            if (!skip_value(depth)) return false;
+            skip_space();
+            if (at(']')) {
+                pos++;
+                return true;
+            }
+            if (!at(',')) return false;
+            pos++;
+        }
+    }
+
+    bool skip_object(int depth) {
+        pos++;
+        skip_space();
+        if (at('}')) {
+            pos++;
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            if (!at('"') || !skip_string()) return false;
+            skip_space();
+            if (!at(':')) return false;
+            pos++;
+            skip_space();
+            if (!skip_value(depth)) return false;
+            skip_space();
+            if (at('}')) {
+                pos++;
+                return true;
+            }
+            if (!at(',')) return false;
+            pos++;
+        }
+    }
+};
+
+// fn(key, value) for each member of a valid object; key spans include the quotes
+template <typename Fn>
+void for_each_member(std::string_view text, JsonSpan object, Fn fn) {
+    Scanner scanner(text, object.begin + 1);
+    scanner.skip_space();
+    if (scanner.at('}')) return;
+    for (;;) {
+        JsonSpan key{scanner.pos, 0};
+        scanner.skip_string();
+        key.end = scanner.pos;
+        scanner.skip_space();
+        scanner.pos++;  // ':'
+        scanner.skip_space();
+        JsonSpan value{scanner.pos, 0};
+        scanner.skip_value(0);
+        value.end = scanner.pos;
+        fn(key, value);
+        scanner.skip_space();
+        if (scanner.at('}')) return;
+        scanner.pos++;  // ','
+        scanner.skip_space();
+    }
+}
+
+// Indentation of the first indented line, e.g. "  " or "\t"
+std::string detect_indent_unit(std::string_view text) {
+    for (size_t pos = text.find('\n'); pos != std::string_view::npos; pos = text.find('\n', pos + 1)) {
+        size_t start = pos + 1;
+        size_t end = start;
+        while (end < text.size() && (text[end] == ' ' || text[end] == '\t')) end++;
+        if (end > start && end < text.size() && text[end] != '\n' && text[end] != '\r') {
+            return std::string(text.substr(start, end - start));
+        }
+    }
+    return "  ";
+}
+
+}  // namespace
+
+bool json_locate_root(std::string_view text, JsonSpan& root) {
+    Scanner scanner(text, 0);
+    scanner.skip_space();
+    size_t begin = scanner.pos;
+    if (!scanner.skip_value(0)) return false;
+    size_t end = scanner.pos;
+    scanner.skip_space();
+    if (scanner.pos != text.size()) return false;
+    root = {begin, end};
+    return true;
+}
+
+JsonType json_type_at(std::string_view text, JsonSpan value) {
+    switch (text[value.begin]) {
+        case '{': return JsonType::Object;
+        case '[': return JsonType::Array;
+        case '"': return JsonType::String;
+        case 't':
+        case 'f': return JsonType::Bool;
+        case 'n': return JsonType::Null;
+        default:  return JsonType::Number;
+    }
+}
+
+bool json_find_member(std::string_view text, JsonSpan object, std::string_view key, JsonSpan& value) {
+    bool found = false;
+    for_each_member(text, object, [&](JsonSpan keySpan, JsonSpan valueSpan) {
+        std::string_view raw = text.substr(keySpan.begin + 1, keySpan.end - keySpan.begin - 2);
+        bool matches = raw.find('\\') == std::string_view::npos ? raw == key : json_unescape(raw) == key;
+        if (matches) {
+            value = valueSpan;
+            found = true;
+        }
+    });
+    return found;
+}
+
+std::vector<JsonSpan> json_array_elements(std::string_view text, JsonSpan array) {
+    std::vector<JsonSpan> elements;
+    Scanner scanner(text, array.begin + 1);
+    scanner.skip_space();
+    if (scanner.at(']')) return elements;
+    for (;;) {
+        JsonSpan element{scanner.pos, 0};
+        scanner.skip_value(0);
+        element.end = scanner.pos;
+        elements.push_back(element);
+        scanner.skip_space();
+        if (scanner.at(']')) return elements;
+        scanner.pos++;  // ','
+        scanner.skip_space();
+    }
+}
+
+JsonPatch::JsonPatch(std::string_view text) : text(text) {
+    multiline = text.find('\n') != std::string_view::npos;
+    if (multiline) indentUnit = detect_indent_unit(text);
+}
+
+std::string JsonPatch::format_value(const JsonValue& value, std::string_view lineIndent, bool indented) const {
+    std::string out;
+    if (indented) {
+        value.stringify_to(out, indentUnit.empty() ? std::string_view("  ") : std::string_view(indentUnit), lineIndent);
+    } else {
+        value.stringify_to(out);
+    }
+    return out;
+}
+
+std::string_view JsonPatch::indent_of_line(size_t pos) const {
+    size_t lineStart = text.rfind('\n', pos);
+    lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+    size_t end = lineStart;
+    while (end < pos && (text[end] == ' ' || text[end] == '\t')) end++;
+    return text.substr(lineStart, end - lineStart);
+}
+
+// Whitespace directly before pos, not reaching below floor
+std::string_view JsonPatch::space_before(size_t pos, size_t floor) const {
+    size_t start = pos;
+    while (start > floor && is_space(text[start - 1])) start--;
+    return text.substr(start, pos - start);
+}
+
+// Entries go after the last one, separated the way it is separated from the entry
+// before it (or from the bracket). An empty container gets its entries on their own
+// lines when the document is indented.
+void JsonPatch::append_items(JsonSpan container, size_t lastBegin, size_t lastEnd,
+                             const std::vector<const JsonValue*>& values, const std::vector<std::string>& keys,
+                             std::string_view colon) {
+    bool hasEntries = lastBegin != std::string_view::npos;
+    std::string_view lastSpace = hasEntries ? space_before(lastBegin, container.begin + 1) : std::string_view();
+    bool indented = hasEntries ? lastSpace.find('\n') != std::string_view::npos : multiline;
+
+    std::string lineIndent;
+    std::string separator = ",";
+    if (hasEntries) {
+        if (indented) lineIndent = lastSpace.substr(lastSpace.rfind('\n') + 1);
+        separator += lastSpace;
+    } else if (indented) {
+        lineIndent = std::string(indent_of_line(container.begin)) + indentUnit;
+        separator += "\n" + lineIndent;
+    }
+    if (colon.empty()) colon = indented ? ": " : ":";
+
+    std::string inserted;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (hasEntries || i > 0) {
+            inserted += separator;
+        } else if (indented) {
+            inserted += "\n" + lineIndent;
+        }
+        if (!keys.empty()) {
+            append_json_string(inserted, keys[i]);
+            inserted += colon;
+        }
+        inserted += format_value(*values[i], lineIndent, indented);
+    }
+
+    if (hasEntries) {
+        edits.push_back({lastEnd, lastEnd, std::move(inserted)});
+    } else {
+        if (indented) {
+            inserted += '\n';
+            inserted += indent_of_line(container.begin);
+        }
+        edits.push_back({container.begin + 1, container.end - 1, std::move(inserted)});
+    }
+}
+
+void JsonPatch::replace_value(JsonSpan value, const JsonValue& replacement) {
+    edits.push_back({value.begin, value.end, format_value(replacement, indent_of_line(value.begin), multiline)});
+}
+
+void JsonPatch::append_members(JsonSpan object, const std::vector<JsonValue::Member>& members) {
+    size_t lastBegin = std::string_view::npos;
+    size_t lastEnd = 0;
+    std::string_view colon;
+    for_each_member(text, object, [&](JsonSpan key, JsonSpan value) {
+        lastBegin = key.begin;
+        lastEnd = value.end;
+        colon = text.substr(key.end, value.begin - key.end);
+    });
+
+    std::vector<const JsonValue*> values;
+    std::vector<std::string> keys;
+    for (const auto& member : members) {
+        keys.push_back(member.first);
+        values.push_back(&member.second);
+    }
+    append_items(object, lastBegin, lastEnd, values, keys, colon);
+}
+
+void JsonPatch::append_element(JsonSpan array, const JsonValue& value) {
+    std::vector<JsonSpan> elements = json_array_elements(text, array);
+    size_t lastBegin = elements.empty() ? std::string_view::npos : elements.back().begin;
+    size_t lastEnd = elements.empty() ? 0 : elements.back().end;
+    append_items(array, lastBegin, lastEnd, {&value}, {}, "");
+}
+
+// Leading removed elements take the separator after them, later ones the separator
+// before them, so the survivors keep their own spacing. Removing everything leaves [].
+void JsonPatch::erase_elements(JsonSpan array, const std::vector<JsonSpan>& elements, const std::vector<bool>& erase) {
+    size_t firstKept = 0;
+    while (firstKept < elements.size() && erase[firstKept]) firstKept++;
+    if (firstKept == elements.size()) {
+        if (!elements.empty()) edits.push_back({array.begin + 1, array.end - 1, ""});
+        return;
+    }
+    if (firstKept > 0) {
+        edits.push_back({elements[0].begin, elements[firstKept].begin, ""});
+    }
+    for (size_t i = firstKept + 1; i < elements.size(); i++) {
+        if (erase[i]) edits.push_back({elements[i - 1].end, elements[i].end, ""});
+    }
+}
+
+std::string JsonPatch::apply() const {
+    std::vector<const Edit*> ordered;
+    size_t growth = 0;
+    for (const Edit& edit : edits) {
+        ordered.push_back(&edit);
+        growth += edit.replacement.size();
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const Edit* a, const Edit* b) { return a->begin < b->begin; });
+
+    std::string out;
+    out.reserve(text.size() + growth);
+    size_t copied = 0;
+    for (const Edit* edit : ordered) {
+        out.append(text.substr(copied, edit->begin - copied));
+        out += edit->replacement;
+        copied = edit->end;
+    }
+    out.append(text.substr(copied));
+    return out;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/json_value.h"
+
+// Format-preserving edits of JSON text. The document is checked once against the
+// same grammar JsonValue::parse accepts, without building a tree; values are then
+// located as byte spans and edits splice new text in or out, so every byte outside
+// an edit stays as it was. New values are laid out like their neighbours: on their
+// own line with the document's indentation, or inline in a compact document.
+
+struct JsonSpan {
+    size_t begin = 0;
+    size_t end = 0;     // Past the value's last byte
+};
+
+// Validate text and find its top-level value; false if text is not valid JSON
+bool json_locate_root(std::string_view text, JsonSpan& root);
+
+// Type of the value at a span of valid JSON
+JsonType json_type_at(std::string_view text, JsonSpan value);
+
+// Value of an object member; if a key repeats the last one wins, as in JsonValue::parse
+bool json_find_member(std::string_view text, JsonSpan object, std::string_view key, JsonSpan& value);
+
+// Element spans of an array, in order
+std::vector<JsonSpan> json_array_elements(std::string_view text, JsonSpan array);
+
+// A set of edits against one document, applied together. Spans refer to the original
+// text, so edits never shift each other; they must not overlap.
+class JsonPatch {
+public:
+    explicit JsonPatch(std::string_view text);
+
+    void replace_value(JsonSpan value, const JsonValue& replacement);
+    void append_members(JsonSpan object, const std::vector<JsonValue::Member>& members);
+    void append_element(JsonSpan array, const JsonValue& value);
+
+    // Remove the elements flagged in erase (parallel to elements, as returned by
+    // json_array_elements) along with their separators
+    void erase_elements(JsonSpan array, const std::vector<JsonSpan>& elements, const std::vector<bool>& erase);
+
+    bool empty() const { return edits.empty(); }
+
+    // The edited document
+    std::string apply() const;
+
+private:
+    struct Edit {
+        size_t begin;
+        size_t end;
+        std::string replacement;
+    };
+
+    std::string format_value(const JsonValue& value, std::string_view lineIndent, bool indented) const;
+    std::string_view indent_of_line(size_t pos) const;
+    std::string_view space_before(size_t pos, size_t floor) const;
+    void append_items(JsonSpan container, size_t lastBegin, size_t lastEnd,
+                      const std::vector<const JsonValue*>& values, const std::vector<std::string>& keys,
+                      std::string_view colon);
+
+    std::string_view text;
+    bool multiline = false;     // The document spans several lines
+    std::string indentUnit;     // One level of its indentation
+    std::vector<Edit> edits;
+};
@@ -0,0 +1,298 @@
+#include "core/json_value.h"
+
+#include "core/json.h"
+
+namespace {
+
+class Parser {
+public:
+    explicit Parser(std::string_view text) : text(text) {}
+
+    bool parse_document(JsonValue& out) {
+        if (!parse_value(out, 0)) return false;
+        skip_space();
+        return pos == text.size();
+    }
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+
+    void skip_space() {
+        while (pos < text.size() &&
+               (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) {
+            pos++;
+        }
+    }
+
+    bool consume(std::string_view literal) {
+        if (text.substr(pos, literal.size()) != literal) return false;
+        pos += literal.size();
+        return true;
+    }
+
+    bool is_digit(size_t at) const {
+        return at < text.size() && text[at] >= '0' && text[at] <= '9';
+    }
+
+    bool parse_string(std::string& out) {
+        size_t start = ++pos;  // Past the opening quote
+        bool escaped = false;
+        while (pos < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[pos]);
+            if (c == '"') {
+                std::string_view raw = text.substr(start, pos - start);
+                out = escaped ? json_unescape(raw) : std::string(raw);
+                pos++;
+                return true;
+            }
+            if (c < 0x20) return false;
+            if (c == '\\') {
+                escaped = true;
+                pos++;
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    bool parse_number(std::string& out) {
+        size_t start = pos;
+        if (text[pos] == '-') pos++;
+        if (!is_digit(pos)) return false;
+        if (text[pos] == '0') {
+            pos++;
+        } else {
+            while (is_digit(pos)) pos++;
+        }
+        if (pos < text.size() && text[pos] == '.') {
+            pos++;
+            if (!is_digit(pos)) return false;
+            while (is_digit(pos)) pos++;
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            pos++;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) pos++;
+            if (!is_digit(pos)) return false;
+            while (is_digit(pos)) pos++;
+        }
+        out.assign(text.substr(start, pos - start));
+        return true;
+    }
+
+    bool parse_value(JsonValue& out, int depth) {
+        skip_space();
+        if (pos >= text.size()) return false;
+
+        char c = text[pos];
+        if (c == '{' || c == '[') {
+            if (depth >= JsonValue::MAX_DEPTH) return false;
+            return c == '{' ? parse_object(out, depth + 1) : parse_array(out, depth + 1);
+        }
+        if (c == '"') {
+            std::string value;
+            if (!parse_string(value)) return false;
+            out = JsonValue::string(std::move(value));
+            return true;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            std::string raw;
+            if (!parse_number(raw)) return false;
+            out = JsonValue::number_text(std::move(raw));
+            return true;
+        }
+        if (consume("true")) { out = JsonValue::boolean(true); return true; }
+        if (consume("false")) { out = JsonValue::boolean(false); return true; }
+        if (consume("null")) { out = JsonValue(); return true; }
+        return false;
+    }
+
+    bool parse_array(JsonValue& out, int depth) {
+        out = JsonValue::array();
+        pos++;
+        skip_space();
+        if (pos < text.size() && text[pos] == ']') {
+            pos++;
+            return true;
+        }
+        for (;;) {
+            JsonValue item;
+            if (!parse_value(item, depth)) return false;
+            out.items().push_back(std::move(item));
+            skip_space();
+            if (pos >= text.size()) return false;
+            if (text[pos] == ']') {
+                pos++;
+                return true;
+            }
+            if (text[pos++] != ',') return false;
+        }
+    }
+
+    bool parse_object(JsonValue& out, int depth) {
+        out = JsonValue::object();
+        pos++;
+        skip_space();
+        if (pos < text.size() && text[pos] == '}') {
+            pos++;
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            std::string key;
+            if (pos >= text.size() || text[pos] != '"' || !parse_string(key)) return false;
+            skip_space();
+            if (pos >= text.size() || text[pos++] != ':') return false;
+            JsonValue value;
+            if (!parse_value(value, depth)) return false;
+            out.set(key, std::move(value));  // Duplicate keys: the last one wins
+            skip_space();
+            if (pos >= text.size()) return false;
+            if (text[pos] == '}') {
+                pos++;
+                return true;
+            }
+            if (text[pos++] != ',') return false;
+        }
+    }
+};
+
+}  // namespace
+
+JsonValue JsonValue::boolean(bool value) {
+    JsonValue result;
+    result.kind = JsonType::Bool;
+    result.flag = value;
+    return result;
+}
+
+JsonValue JsonValue::number(long long value) {
+    return number_text(std::to_string(value));
+}
+
+JsonValue JsonValue::number_text(std::string text) {
+    JsonValue result;
+    result.kind = JsonType::Number;
+    result.scalar = std::move(text);
+    return result;
+}
+
+JsonValue JsonValue::string(std::string value) {
+    JsonValue result;
+    result.kind = JsonType::String;
+    result.scalar = std::move(value);
+    return result;
+}
+
+JsonValue JsonValue::array() {
+    JsonValue result;
+    result.kind = JsonType::Array;
+    return result;
+}
+
+JsonValue JsonValue::object() {
+    JsonValue result;
+    result.kind = JsonType::Object;
+    return result;
+}
+
+bool JsonValue::parse(std::string_view text, JsonValue& out) {
+    JsonValue parsed;
+    if (!Parser(text).parse_document(parsed)) return false;
+    out = std::move(parsed);
+    return true;
+}
+
+JsonValue* JsonValue::find(std::string_view key) {
+    for (auto& member : fields) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const {
+    for (const auto& member : fields) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+JsonValue& JsonValue::set(std::string_view key, JsonValue value) {
+    if (kind != JsonType::Object) *this = object();
+    if (JsonValue* existing = find(key)) {
+        *existing = std::move(value);
+        return *existing;
+    }
+    fields.emplace_back(std::string(key), std::move(value));
+    return fields.back().second;
+}
+
+std::string_view JsonValue::get_string(std::string_view key) const {
+    const JsonValue* value = find(key);
+    return value && value->is_string() ? std::string_view(value->scalar) : std::string_view();
+}
+
+void JsonValue::append(JsonValue value) {
+    if (kind != JsonType::Array) *this = array();
+    elements.push_back(std::move(value));
+}
+
+std::string JsonValue::stringify() const {
+    std::string out;
+    stringify_to(out);
+    return out;
+}
+
+void JsonValue::stringify_to(std::string& out) const {
+    switch (kind) {
+        case JsonType::Null:   out += "null"; break;
+        case JsonType::Bool:   out += flag ? "true" : "false"; break;
+        case JsonType::Number: out += scalar; break;
+        case JsonType::String: append_json_string(out, scalar); break;
+        case JsonType::Array:
+            out += '[';
+            for (size_t i = 0; i < elements.size(); i++) {
+                if (i > 0) out += ',';
+                elements[i].stringify_to(out);
+            }
+            out += ']';
+            break;
+        case JsonType::Object:
+            out += '{';
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (i > 0) out += ',';
+                append_json_string(out, fields[i].first);
+                out += ':';
+                fields[i].second.stringify_to(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+void JsonValue::stringify_to(std::string& out, std::string_view indentUnit, std::string_view lineIndent) const {
+    bool isArray = kind == JsonType::Array;
+    size_t count = isArray ? elements.size() : fields.size();
+    if ((kind != JsonType::Array && kind != JsonType::Object) || count == 0) {
+        stringify_to(out);
+        return;
+    }
+
+    std::string innerIndent = std::string(lineIndent) + std::string(indentUnit);
+    out += isArray ? '[' : '{';
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) out += ',';
+        out += '\n';
+        out += innerIndent;
+        if (isArray) {
+            elements[i].stringify_to(out, indentUnit, innerIndent);
+        } else {
+            append_json_string(out, fields[i].first);
+            out += ": ";
+            fields[i].second.stringify_to(out, indentUnit, innerIndent);
+        }
+    }
+    out += '\n';
+    out += lineIndent;
+    out += isArray ? ']' : '}';
+}
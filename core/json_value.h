@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Small JSON document model for editing agent config files. Objects keep their
+// members in document order (so a rewritten config reads like the original) and
+// numbers keep their source text, so values we don't touch round-trip unchanged.
+// Strings are stored unescaped, UTF-8.
+
+enum class JsonType { Null, Bool, Number, String, Array, Object };
+
+class JsonValue {
+public:
+    using Member = std::pair<std::string, JsonValue>;
+
+    JsonValue() = default;
+    static JsonValue boolean(bool value);
+    static JsonValue number(long long value);
+    static JsonValue number_text(std::string text);   // Already-valid JSON number text
+    static JsonValue string(std::string value);
+    static JsonValue array();
+    static JsonValue object();
+
+    // Parse a complete document (trailing whitespace only). Nesting deeper than
+    // MAX_DEPTH is rejected rather than recursed into.
+    static bool parse(std::string_view text, JsonValue& out);
+    static constexpr int MAX_DEPTH = 256;
+
+    JsonType type() const { return kind; }
+    bool is_object() const { return kind == JsonType::Object; }
+    bool is_array() const { return kind == JsonType::Array; }
+    bool is_string() const { return kind == JsonType::String; }
+
+    // String content, or a number's source text; empty for other types
+    const std::string& text() const { return scalar; }
+    bool as_bool() const { return flag; }
+
+    // Array elements and object members (empty for other types)
+    std::vector<JsonValue>& items() { return elements; }
+    const std::vector<JsonValue>& items() const { return elements; }
+    std::vector<Member>& members() { return fields; }
+    const std::vector<Member>& members() const { return fields; }
+
+    // Object member lookup; nullptr if absent or not an object
+    JsonValue* find(std::string_view key);
+    const JsonValue* find(std::string_view key) const;
+
+    // Replace the member's value in place, or append it. Non-objects become objects.
+    JsonValue& set(std::string_view key, JsonValue value);
+
+    // String member, or empty if absent or not a string
+    std::string_view get_string(std::string_view key) const;
+
+    // Append to an array. Non-arrays become arrays.
+    void append(JsonValue value);
+
+    // Compact serialization
+    std::string stringify() const;
+    void stringify_to(std::string& out) const;
+
+    // Indented serialization, one member or element per line. lineIndent is the
+    // indentation of the line the value starts on; empty containers stay {} / [].
+    void stringify_to(std::string& out, std::string_view indentUnit, std::string_view lineIndent) const;
+
+private:
+    JsonType kind = JsonType::Null;
+    bool flag = false;
+    std::string scalar;
+    std::vector<JsonValue> elements;
+    std::vector<Member> fields;
+};
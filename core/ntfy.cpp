@@ -0,0 +1,42 @@
+#include "core/ntfy.h"
+
+#include "core/json.h"
+
+std::string build_ntfy_json(const NtfyMessage& message) {
+    std::string json = "{\"topic\":";
+    append_json_string(json, message.topic);
+    if (!message.title.empty()) {
+        json += ",\"title\":";
+        append_json_string(json, message.title);
+    }
+    json += ",\"message\":";
+    append_json_string(json, message.message);
+    json += '}';
+    return json;
+}
+
+size_t publish_ntfy(HttpTransport& transport, std::string_view server, const std::vector<NtfyMessage>& messages) {
+    HttpOrigin origin;
+    std::string basePath;
+    if (!parse_http_url(server, origin, basePath)) {
+        return 0;
+    }
+
+    size_t accepted = 0;
+    for (const auto& message : messages) {
+        HttpRequest request;
+        request.method = "POST";
+        request.path = basePath;
+        request.headers.emplace_back("Content-Type", "application/json");
+        request.body = build_ntfy_json(message);
+
+        HttpResponse response;
+        if (!transport.send(origin, request, response)) {
+            break;  // Server unreachable: the rest would fail the same way
+        }
+        if (response.status >= 200 && response.status < 300) {
+            accepted++;
+        }
+    }
+    return accepted;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/http.h"
+
+// ntfy push notifications, sent with ntfy's JSON publish format: one POST to the
+// server root whose body carries topic, title and message. Unlike the header-based
+// form this keeps non-ASCII titles intact. Strings are UTF-8.
+
+struct NtfyMessage {
+    std::string topic;
+    std::string title;
+    std::string message;
+};
+
+// {"topic":"...","title":"...","message":"..."}
+std::string build_ntfy_json(const NtfyMessage& message);
+
+// Publish messages to one server (host name or http(s) URL) back to back over the
+// transport's pooled connection. Returns how many the server accepted.
+size_t publish_ntfy(HttpTransport& transport, std::string_view server, const std::vector<NtfyMessage>& messages);
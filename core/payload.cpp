@@ -0,0 +1,186 @@
+#include "core/payload.h"
+
+#include <algorithm>
+
+#include "core/json.h"
+#include "core/json_value.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct PayloadAlias {
+    const char* key;
+    std::string_view AgentPayload::*field;
+    int rank;   // Lower wins when several aliases are present
+};
+
+const PayloadAlias PAYLOAD_ALIASES[] = {
+    { "hook_event_name",        &AgentPayload::eventName,   0 },  // Claude, Gemini
+    { "hookEventName",          &AgentPayload::eventName,   1 },
+    { "type",                   &AgentPayload::eventName,   2 },  // Codex notify
+    { "event",                  &AgentPayload::eventName,   3 },
+    { "session_id",             &AgentPayload::sessionId,   0 },
+    { "sessionId",              &AgentPayload::sessionId,   1 },  // Copilot
+    { "thread-id",              &AgentPayload::sessionId,   2 },  // Codex
+    { "conversation_id",        &AgentPayload::sessionId,   3 },
+    { "cwd",                    &AgentPayload::cwd,         0 },
+    { "last_assistant_message", &AgentPayload::lastMessage, 0 },
+    { "last-assistant-message", &AgentPayload::lastMessage, 1 },  // Codex
+    { "prompt_response",        &AgentPayload::lastMessage, 2 },  // Gemini AfterAgent
+    { "message",                &AgentPayload::lastMessage, 3 },  // Claude Notification
+};
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+}  // namespace
+
+bool parse_agent_payload(std::string_view json, AgentPayload& payload, size_t maxBytes) {
+    payload = AgentPayload();
+    int ranks[4] = { 99, 99, 99, 99 };
+    std::string_view AgentPayload::*const fields[4] = {
+        &AgentPayload::eventName, &AgentPayload::sessionId, &AgentPayload::cwd, &AgentPayload::lastMessage };
+
+    scan_json_object(json, [&](std::string_view key, std::string_view value, bool isString) {
+        if (!isString || value.empty()) return true;
+        for (const auto& alias : PAYLOAD_ALIASES) {
+            if (key != alias.key) continue;
+            size_t slot = std::find(fields, fields + 4, alias.field) - fields;
+            if (alias.rank < ranks[slot]) {
+                ranks[slot] = alias.rank;
+                payload.*alias.field = value;
+            }
+            break;
+        }
+        return true;
+    }, maxBytes);
+
+    return !payload.empty();
+}
+
+std::string payload_summary(std::string_view text, size_t maxChars) {
+    // First line with any content
+    std::string_view line;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+        while (!line.empty() && is_blank(line.front())) line.remove_prefix(1);
+        while (!line.empty() && is_blank(line.back())) line.remove_suffix(1);
+        if (!line.empty()) break;
+    }
+
+    // Cut on a code point boundary (UTF-8 continuation bytes are 10xxxxxx)
+    size_t chars = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+        if ((static_cast<unsigned char>(line[i]) & 0xC0) == 0x80) continue;
+        if (chars++ == maxChars) {
+            return std::string(line.substr(0, i)) + "...";
+        }
+    }
+    return std::string(line);
+}
+
+#ifdef _WIN32
+
+bool read_stdin_payload(std::string& out, size_t maxBytes, int idleMs) {
+    out.clear();
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    if (input == nullptr || input == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    char buffer[16 * 1024];
+    DWORD read = 0;
+    DWORD type = GetFileType(input);
+    if (type == FILE_TYPE_DISK) {
+        // Redirected from a file: reads can't block
+        while (out.size() < maxBytes &&
+               ReadFile(input, buffer, (DWORD)std::min(sizeof(buffer), maxBytes - out.size()), &read, nullptr) &&
+               read > 0) {
+            out.append(buffer, read);
+        }
+    } else if (type == FILE_TYPE_PIPE) {
+        // Only ever read what PeekNamedPipe reports, so ReadFile never waits
+        ULONGLONG idleSince = GetTickCount64();
+        while (out.size() < maxBytes) {
+            DWORD available = 0;
+            if (!PeekNamedPipe(input, nullptr, 0, nullptr, &available, nullptr)) {
+                break;  // Writer closed the pipe
+            }
+            if (available == 0) {
+                if (GetTickCount64() - idleSince >= (ULONGLONG)idleMs) break;
+                Sleep(1);
+                continue;
+            }
+            DWORD want = (DWORD)std::min<size_t>({ available, sizeof(buffer), maxBytes - out.size() });
+            if (!ReadFile(input, buffer, want, &read, nullptr) || read == 0) {
+                break;
+            }
+            out.append(buffer, read);
+            idleSince = GetTickCount64();
+        }
+    }
+    // FILE_TYPE_CHAR is a console (or NUL): never read
+
+    return !out.empty();
+}
+
+#else
+
+bool read_stdin_payload(std::string& out, size_t maxBytes, int idleMs) {
+    out.clear();
+    struct stat info;
+    if (isatty(STDIN_FILENO) || fstat(STDIN_FILENO, &info) != 0) {
+        return false;
+    }
+
+    char buffer[16 * 1024];
+    while (out.size() < maxBytes) {
+        // Regular files are always readable; pipes and sockets only once data arrives
+        if (!S_ISREG(info.st_mode)) {
+            pollfd waitFd = { STDIN_FILENO, POLLIN, 0 };
+            int ready = poll(&waitFd, 1, idleMs);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) break;
+        }
+        ssize_t received = read(STDIN_FILENO, buffer, std::min(sizeof(buffer), maxBytes - out.size()));
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        out.append(buffer, static_cast<size_t>(received));
+    }
+
+    return !out.empty();
+}
+
+#endif
+
+bool is_payload_argument(std::string_view argument) {
+    if (argument.empty() || argument[0] != '{') return false;
+    JsonValue value;
+    return JsonValue::parse(argument, value) && value.is_object();
+}
+
+bool read_agent_payload(std::string_view argument, std::string& text, AgentPayload& payload) {
+    if (!argument.empty()) {
+        text = std::string(argument);
+        if (parse_agent_payload(text, payload)) {
+            return true;
+        }
+    }
+    if (read_stdin_payload(text) && parse_agent_payload(text, payload)) {
+        return true;
+    }
+    text.clear();
+    payload = AgentPayload();
+    return false;
+}
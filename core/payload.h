@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Agent hook payloads. Claude, Gemini and Copilot hooks pipe a JSON event to stdin;
+// Codex `notify` passes one as the last argument. Only a few top-level fields are
+// pulled out, as views into the payload text: nothing is copied or decoded until a
+// field is actually used (json_unescape).
+
+const size_t MAX_PAYLOAD_BYTES = 64 * 1024;
+const int PAYLOAD_IDLE_MS = 25;
+
+// Raw (still escaped) JSON string contents; empty when the payload lacks the field.
+// Views into the text given to parse_agent_payload(), which must outlive them.
+struct AgentPayload {
+    std::string_view eventName;    // hook_event_name, hookEventName, type, event
+    std::string_view sessionId;    // session_id, sessionId, thread-id, conversation_id
+    std::string_view cwd;
+    std::string_view lastMessage;  // last_assistant_message, last-assistant-message,
+                                   // prompt_response, message
+
+    bool empty() const {
+        return eventName.empty() && sessionId.empty() && cwd.empty() && lastMessage.empty();
+    }
+};
+
+// Scan at most maxBytes of a JSON object for the payload fields. Each field takes the
+// highest-priority alias present. Returns false if nothing was recognized.
+bool parse_agent_payload(std::string_view json, AgentPayload& payload, size_t maxBytes = MAX_PAYLOAD_BYTES);
+
+// One display line from a decoded message: the first non-blank line, trimmed, cut to
+// maxChars code points with "..." appended when shortened.
+std::string payload_summary(std::string_view text, size_t maxChars = 200);
+
+// Read a payload piped to stdin, without ever blocking on it: a console/TTY is
+// skipped, and a pipe is only read while data keeps arriving (idleMs without new
+// bytes ends the read, so an empty pipe left open costs idleMs). Reads at most
+// maxBytes. Returns true if anything was read.
+bool read_stdin_payload(std::string& out, size_t maxBytes = MAX_PAYLOAD_BYTES, int idleMs = PAYLOAD_IDLE_MS);
+
+// Whether the last command-line argument is a Codex event rather than the message: it
+// has to be a complete JSON object. A message or template that merely starts with '{'
+// ("{event}: done") is not.
+bool is_payload_argument(std::string_view argument);
+
+// The agent's hook event: argument (Codex passes it last) if it parses as one, else
+// stdin. text receives the JSON, and payload's fields are views into it. False, with
+// both cleared, if there is no payload.
+bool read_agent_payload(std::string_view argument, std::string& text, AgentPayload& payload);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/sinks.h"
+
+// Host services the CLI front ends need on top of the portable core. Each build links
+// one backend: main.cpp implements it with Win32/WinRT, platform_posix.cpp with /proc,
+// XDG directories and the desktop's notification tool. The notification path is
+// POSIX-only: wmain has its own, with the ancestry cache, click-to-focus and the daemon.
+
+struct ProcessInfo {
+    std::wstring exeName;       // Lowercase, without extension
+    std::wstring commandLine;
+};
+
+class Platform {
+public:
+    virtual ~Platform() = default;
+
+    // Where agent configs live
+    virtual std::filesystem::path home_dir() const = 0;
+
+    // toasty's per-user state and caches; may not exist yet
+    virtual std::filesystem::path data_dir() const = 0;
+
+    // This executable, as written into agent hooks
+    virtual std::filesystem::path exe_path() const = 0;
+
+#ifndef _WIN32
+    // Ancestors of this process, parent first, for preset detection
+    virtual std::vector<ProcessInfo> ancestor_processes(size_t maxDepth) const = 0;
+
+    // Show a desktop notification; false if it could not be shown
+    virtual bool show_notification(const Notification& notification) const = 0;
+#endif
+};
+
+std::unique_ptr<Platform> create_platform();
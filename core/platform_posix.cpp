@@ -0,0 +1,141 @@
+#include "core/platform.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <pwd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+#include "core/strings.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read_proc_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Run a program with arguments (no shell) and wait for it; true if it exited 0
+bool run_program(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+class PosixPlatform : public Platform {
+public:
+    fs::path home_dir() const override {
+        const char* home = getenv("HOME");
+        if (home && *home) return home;
+        passwd* entry = getpwuid(getuid());
+        return entry && entry->pw_dir ? fs::path(entry->pw_dir) : fs::path();
+    }
+
+    // $XDG_STATE_HOME/toasty, else ~/.local/state/toasty
+    fs::path data_dir() const override {
+        const char* state = getenv("XDG_STATE_HOME");
+        if (state && *state == '/') return fs::path(state) / "toasty";
+        fs::path home = home_dir();
+        return home.empty() ? fs::path() : home / ".local" / "state" / "toasty";
+    }
+
+    fs::path exe_path() const override {
+#ifdef __APPLE__
+        char buffer[4096];
+        uint32_t size = sizeof(buffer);
+        if (_NSGetExecutablePath(buffer, &size) != 0) return fs::path();
+        std::error_code ec;
+        fs::path path = fs::canonical(buffer, ec);
+        return ec ? fs::path(buffer) : path;
+#else
+        std::error_code ec;
+        fs::path path = fs::read_symlink("/proc/self/exe", ec);
+        return ec ? fs::path() : path;
+#endif
+    }
+
+    std::vector<ProcessInfo> ancestor_processes(size_t maxDepth) const override {
+        std::vector<ProcessInfo> ancestors;
+#ifdef __linux__
+        pid_t pid = getppid();
+        while (pid > 1 && ancestors.size() < maxDepth) {
+            fs::path proc = fs::path("/proc") / std::to_string(pid);
+
+            // stat is "pid (comm) state ppid ..."; comm may itself contain ") "
+            std::string stat = read_proc_file(proc / "stat");
+            size_t close = stat.rfind(')');
+            if (close == std::string::npos) break;
+
+            ProcessInfo info;
+            std::string name = read_proc_file(proc / "comm");
+            while (!name.empty() && name.back() == '\n') name.pop_back();
+            info.exeName = to_lower(from_utf8(name));
+
+            // Arguments are NUL-separated
+            std::string cmdline = read_proc_file(proc / "cmdline");
+            std::replace(cmdline.begin(), cmdline.end(), '\0', ' ');
+            info.commandLine = from_utf8(cmdline);
+            ancestors.push_back(std::move(info));
+
+            std::istringstream fields(stat.substr(close + 1));
+            std::string state;
+            pid_t parent = 0;
+            if (!(fields >> state >> parent) || parent == pid) break;
+            pid = parent;
+        }
+#else
+        (void)maxDepth;
+#endif
+        return ancestors;
+    }
+
+    bool show_notification(const Notification& notification) const override {
+#ifdef __APPLE__
+        // Arguments go through argv, so nothing needs AppleScript quoting
+        return run_program({ "osascript",
+                             "-e", "on run argv",
+                             "-e", "display notification (item 2 of argv) with title (item 1 of argv)",
+                             "-e", "end run",
+                             notification.title, notification.message });
+#else
+        std::vector<std::string> args = { "notify-send", "--app-name=Toasty" };
+        if (!notification.iconPath.empty()) {
+            args.push_back("--icon=" + notification.iconPath);
+        }
+        args.push_back("--");  // A title starting with '-' is not an option
+        args.push_back(notification.title);
+        args.push_back(notification.message);
+        return run_program(args);
+#endif
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<Platform> create_platform() {
+    return std::make_unique<PosixPlatform>();
+}
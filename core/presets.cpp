@@ -0,0 +1,34 @@
+#include "core/presets.h"
+
+#include "core/cmdline_matcher.h"
+#include "core/strings.h"
+#include "resource.h"
+
+const AppPreset APP_PRESETS[] = {
+    { L"claude", L"Claude", IDI_CLAUDE },
+    { L"copilot", L"GitHub Copilot", IDI_COPILOT },
+    { L"gemini", L"Gemini", IDI_GEMINI },
+    { L"codex", L"Codex", IDI_CODEX },
+    { L"cursor", L"Cursor", IDI_CURSOR }
+};
+
+const size_t APP_PRESET_COUNT = sizeof(APP_PRESETS) / sizeof(APP_PRESETS[0]);
+
+const AppPreset* find_preset(std::wstring_view name) {
+    for (size_t i = 0; i < APP_PRESET_COUNT; i++) {
+        if (equals_ignore_case(APP_PRESETS[i].name, name)) {
+            return &APP_PRESETS[i];
+        }
+    }
+    return nullptr;
+}
+
+const AppPreset* check_command_line_for_preset(std::wstring_view cmdLine) {
+    const CmdlineRule* rule = default_cmdline_matcher().match(cmdLine);
+    return rule ? find_preset(rule->preset) : nullptr;
+}
+
+const AppPreset* match_process_preset(std::wstring_view exeName, std::wstring_view cmdLine) {
+    const AppPreset* preset = find_preset(exeName);
+    return preset ? preset : check_command_line_for_preset(cmdLine);
+}
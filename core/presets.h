@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Built-in app presets: selected with --app <name>, or by process-tree detection
+struct AppPreset {
+    std::wstring name;
+    std::wstring title;
+    int iconResourceId;   // Embedded PNG (IDI_* in resource.h)
+};
+
+extern const AppPreset APP_PRESETS[];
+extern const size_t APP_PRESET_COUNT;
+
+// Find preset by name (case-insensitive)
+const AppPreset* find_preset(std::wstring_view name);
+
+// Check if command line contains a known CLI pattern (see CMDLINE_RULES)
+const AppPreset* check_command_line_for_preset(std::wstring_view cmdLine);
+
+// Preset for one ancestor process: by executable name (lowercase, no extension),
+// else by a CLI pattern in its command line (agents running under node, python, ...)
+const AppPreset* match_process_preset(std::wstring_view exeName, std::wstring_view cmdLine);
@@ -0,0 +1,146 @@
+#include "core/rate_limit.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/file_lock.h"
+#include "core/strings.h"
+
+namespace {
+
+const char RATE_MAGIC[] = "TOASTY-RATE 1";
+const size_t MAX_BUCKETS = 64;
+const int RATE_LOCK_TIMEOUT_MS = 500;
+
+template <typename T>
+bool parse_number(std::string_view text, T& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+std::vector<TokenBucket> read_buckets(const std::filesystem::path& path) {
+    std::vector<TokenBucket> buckets;
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) || line != RATE_MAGIC) {
+        return buckets;
+    }
+
+    while (std::getline(file, line) && buckets.size() < MAX_BUCKETS) {
+        std::istringstream fields(line);
+        TokenBucket bucket;
+        if (fields >> std::hex >> bucket.key >> std::dec >> bucket.milliTokens
+                   >> bucket.lastRefillMs >> bucket.suppressed) {
+            buckets.push_back(bucket);
+        }
+    }
+    return buckets;
+}
+
+bool write_buckets(const std::filesystem::path& path, const std::vector<TokenBucket>& buckets) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    file << RATE_MAGIC << '\n';
+    for (const auto& bucket : buckets) {
+        file << std::hex << bucket.key << std::dec << ' ' << bucket.milliTokens << ' '
+             << bucket.lastRefillMs << ' ' << bucket.suppressed << '\n';
+    }
+    return file.good();
+}
+
+}  // namespace
+
+bool parse_rate_limit(std::string_view spec, RateLimit& limit) {
+    if (spec == "0" || spec == "off") {
+        limit.capacity = 0;
+        return true;
+    }
+
+    size_t slash = spec.find('/');
+    if (slash == std::string_view::npos) return false;
+
+    int capacity = 0, seconds = 0;
+    if (!parse_number(spec.substr(0, slash), capacity) ||
+        !parse_number(spec.substr(slash + 1), seconds) ||
+        capacity <= 0 || seconds <= 0 || seconds > 86400) {
+        return false;
+    }
+    limit.capacity = capacity;
+    limit.periodMs = seconds * 1000;
+    return true;
+}
+
+uint64_t rate_limit_key(std::string_view source, std::string_view cwd) {
+    // 64-bit FNV-1a over "source\0cwd"
+    return fnv1a_64(cwd, fnv1a_64(std::string_view("\0", 1), fnv1a_64(source)));
+}
+
+RateDecision take_token(TokenBucket& bucket, const RateLimit& limit, int64_t nowMs) {
+    RateDecision decision;
+    if (limit.capacity <= 0) {
+        return decision;
+    }
+
+    const int64_t full = static_cast<int64_t>(limit.capacity) * 1000;
+    if (bucket.lastRefillMs == 0 || nowMs < bucket.lastRefillMs) {
+        // New bucket, or the clock went backwards: start full
+        bucket.milliTokens = full;
+    } else {
+        int64_t elapsed = nowMs - bucket.lastRefillMs;
+        int64_t refill = elapsed >= limit.periodMs ? full : elapsed * full / limit.periodMs;
+        bucket.milliTokens = std::min(full, bucket.milliTokens + refill);
+    }
+    bucket.lastRefillMs = nowMs;
+
+    if (bucket.milliTokens < 1000) {
+        bucket.suppressed++;
+        decision.allowed = false;
+        return decision;
+    }
+
+    bucket.milliTokens -= 1000;
+    decision.suppressed = bucket.suppressed;
+    bucket.suppressed = 0;
+    return decision;
+}
+
+RateDecision take_rate_token(const std::filesystem::path& statePath, uint64_t key,
+                             const RateLimit& limit, int64_t nowMs) {
+    if (limit.capacity <= 0) {
+        return RateDecision();
+    }
+
+    std::filesystem::path lockPath = statePath;
+    lockPath += ".lock";
+    FileLock lock(lockPath, RATE_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        return RateDecision();
+    }
+
+    std::vector<TokenBucket> buckets = read_buckets(statePath);
+    auto it = std::find_if(buckets.begin(), buckets.end(),
+                           [key](const TokenBucket& b) { return b.key == key; });
+    TokenBucket bucket;
+    bucket.key = key;
+    if (it != buckets.end()) {
+        bucket = *it;
+        buckets.erase(it);
+    }
+
+    RateDecision decision = take_token(bucket, limit, nowMs);
+
+    // Most recently used first; the oldest sources fall off the end
+    buckets.insert(buckets.begin(), bucket);
+    if (buckets.size() > MAX_BUCKETS) {
+        buckets.resize(MAX_BUCKETS);
+    }
+
+    if (!write_buckets(statePath, buckets)) {
+        return RateDecision();
+    }
+    return decision;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+// Per-source token bucket, so a runaway hook loop can't flood the desktop (and ntfy).
+// Buckets are keyed by preset + working directory and persisted in a small state file
+// guarded by a FileLock, because every notification is a fresh process.
+
+struct RateLimit {
+    int capacity = 5;        // Burst size; 0 disables limiting
+    int periodMs = 30000;    // Time to refill a full bucket
+};
+
+struct TokenBucket {
+    uint64_t key = 0;
+    int64_t milliTokens = 0;   // Tokens x 1000, so partial refills accumulate
+    int64_t lastRefillMs = 0;
+    uint32_t suppressed = 0;   // Events dropped since the last allowed one
+};
+
+struct RateDecision {
+    bool allowed = true;
+    uint32_t suppressed = 0;   // When allowed: dropped events to fold into this notification
+};
+
+// Parse "<count>/<seconds>" (e.g. "5/30"); "0" or "off" disables limiting
+bool parse_rate_limit(std::string_view spec, RateLimit& limit);
+
+// Stable bucket key for a source (preset name, or title) and working directory
+uint64_t rate_limit_key(std::string_view source, std::string_view cwd);
+
+// Refill a bucket to nowMs and try to spend one token
+RateDecision take_token(TokenBucket& bucket, const RateLimit& limit, int64_t nowMs);
+
+// take_token() against the persisted bucket for key. Fails open: if the state
+// can't be locked or written, the event is allowed.
+RateDecision take_rate_token(const std::filesystem::path& statePath, uint64_t key,
+                             const RateLimit& limit, int64_t nowMs);
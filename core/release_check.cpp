@@ -0,0 +1,237 @@
+#include "core/release_check.h"
+
+#include <fstream>
+
+namespace {
+
+const char RELEASE_MAGIC[] = "TOASTY-RELEASE 1";
+
+int hex_value(unsigned char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool is_single_line(const std::string& text) {
+    return text.find_first_of("\r\n") == std::string::npos;
+}
+
+}  // namespace
+
+bool ReleaseScanner::feed(std::string_view chunk) {
+    if (finished) return false;
+
+    for (char ch : chunk) {
+        if (++scanned > maxBytes) {
+            finished = true;
+            return false;
+        }
+        unsigned char c = static_cast<unsigned char>(ch);
+
+        if (inString) {
+            if (unicodeDigits > 0) {
+                int digit = hex_value(c);
+                if (digit < 0) {
+                    finished = true;
+                    return false;
+                }
+                unicodeValue = unicodeValue * 16 + static_cast<unsigned>(digit);
+                if (--unicodeDigits == 0) {
+                    unicodeDigits = -1;
+                    append_code_point(unicodeValue);
+                }
+            } else if (escape) {
+                escape = false;
+                switch (c) {
+                    case '"': case '\\': case '/': append(ch); break;
+                    case 'b': append('\b'); break;
+                    case 'f': append('\f'); break;
+                    case 'n': append('\n'); break;
+                    case 'r': append('\r'); break;
+                    case 't': append('\t'); break;
+                    case 'u': unicodeDigits = 4; unicodeValue = 0; break;
+                    default:
+                        finished = true;
+                        return false;
+                }
+            } else if (c == '\\') {
+                escape = true;
+            } else if (c == '"') {
+                end_string();
+                if (found()) {
+                    finished = true;
+                    return false;
+                }
+            } else {
+                append(ch);
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '"':
+                inString = true;
+                text.clear();
+                overflow = false;
+                highSurrogate = 0;
+                stringIsKey = depth == 1 && expectKey;
+                capturing = stringIsKey || (depth == 1 && afterColon && pending != Field::None);
+                break;
+            case '{':
+            case '[':
+                if (depth == 1) {
+                    // A nested member value: skipped whole
+                    afterColon = false;
+                    pending = Field::None;
+                }
+                if (++depth == 1) expectKey = c == '{';
+                break;
+            case '}':
+            case ']':
+                if (--depth <= 0) {
+                    // End of the top-level value (or a stray bracket)
+                    finished = true;
+                    return false;
+                }
+                break;
+            case ':':
+                if (depth == 1) afterColon = true;
+                break;
+            case ',':
+                if (depth == 1) {
+                    expectKey = true;
+                    afterColon = false;
+                    pending = Field::None;
+                }
+                break;
+            case ' ': case '\t': case '\r': case '\n':
+                break;
+            default:
+                // Number, true, false or null
+                if (depth == 1 && afterColon) {
+                    afterColon = false;
+                    pending = Field::None;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+void ReleaseScanner::end_string() {
+    inString = false;
+    if (depth != 1) return;
+
+    if (stringIsKey) {
+        pending = overflow ? Field::None
+                : text == "tag_name" ? Field::TagName
+                : text == "html_url" ? Field::HtmlUrl
+                : Field::None;
+        expectKey = false;
+        return;
+    }
+
+    if (capturing && !overflow) {
+        (pending == Field::TagName ? tagName : htmlUrl) = text;
+    }
+    afterColon = false;
+    pending = Field::None;
+}
+
+void ReleaseScanner::append(char ch) {
+    if (!capturing) return;
+    if (text.size() >= MAX_VALUE_BYTES) {
+        overflow = true;
+        return;
+    }
+    text += ch;
+}
+
+void ReleaseScanner::append_code_point(unsigned codePoint) {
+    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+        highSurrogate = codePoint;
+        return;
+    }
+    if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+        codePoint = highSurrogate ? 0x10000 + ((highSurrogate - 0xD800) << 10) + (codePoint - 0xDC00) : 0xFFFD;
+    } else if (highSurrogate) {
+        append_code_point(0xFFFD);  // Unpaired high surrogate
+    }
+    highSurrogate = 0;
+
+    if (codePoint < 0x80) {
+        append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        append(static_cast<char>(0xF0 | (codePoint >> 18)));
+        append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+ReleaseCheckResult fetch_latest_release(HttpTransport& transport, const HttpOrigin& origin,
+                                        const std::string& path, ReleaseInfo& info) {
+    bool conditional = !info.etag.empty() && !info.tagName.empty();
+
+    HttpRequest request;
+    request.path = path;
+    request.headers.emplace_back("Accept", "application/vnd.github+json");
+    if (conditional) {
+        request.headers.emplace_back("If-None-Match", info.etag);
+    }
+
+    ReleaseScanner scanner;
+    request.onBody = [&scanner](std::string_view bytes) { return scanner.feed(bytes); };
+
+    HttpResponse response;
+    if (!transport.send(origin, request, response)) {
+        return ReleaseCheckResult::Failed;
+    }
+    if (response.status == 304 && conditional) {
+        return ReleaseCheckResult::NotModified;
+    }
+    if (response.status != 200 || !scanner.found()) {
+        return ReleaseCheckResult::Failed;
+    }
+
+    const std::string* etag = response.header("ETag");
+    info.etag = etag ? *etag : std::string();
+    info.tagName = std::move(scanner.tagName);
+    info.htmlUrl = std::move(scanner.htmlUrl);
+    return ReleaseCheckResult::Updated;
+}
+
+ReleaseInfo load_release_cache(const std::filesystem::path& path) {
+    ReleaseInfo info;
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) || line != RELEASE_MAGIC) {
+        return info;
+    }
+
+    ReleaseInfo loaded;
+    if (std::getline(file, loaded.etag) && std::getline(file, loaded.tagName) &&
+        std::getline(file, loaded.htmlUrl)) {
+        info = std::move(loaded);
+    }
+    return info;
+}
+
+bool save_release_cache(const std::filesystem::path& path, const ReleaseInfo& info) {
+    if (!is_single_line(info.etag) || !is_single_line(info.tagName) || !is_single_line(info.htmlUrl)) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    file << RELEASE_MAGIC << '\n' << info.etag << '\n' << info.tagName << '\n' << info.htmlUrl << '\n';
+    return file.good();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "core/http.h"
+
+// Latest-release lookup for the update check. Requests are conditional (If-None-Match
+// with the cached ETag), so most checks end in a bodiless 304 that GitHub doesn't count
+// against the rate limit. A 200 body is scanned as it streams in and the download stops
+// as soon as the top-level tag_name and html_url have been seen.
+
+struct ReleaseInfo {
+    std::string etag;
+    std::string tagName;
+    std::string htmlUrl;
+};
+
+// Incremental scanner for the top-level "tag_name" and "html_url" string members of a
+// JSON object. Nested objects (author, assets) are skipped, not parsed. Bounded: gives
+// up after maxBytes, and values longer than MAX_VALUE_BYTES are dropped.
+class ReleaseScanner {
+public:
+    static constexpr size_t MAX_VALUE_BYTES = 1024;
+
+    explicit ReleaseScanner(size_t maxBytes = 256 * 1024) : maxBytes(maxBytes) {}
+
+    // Scan the next chunk. Returns false once scanning is over (both fields found,
+    // the byte budget spent, or malformed input); later chunks are ignored.
+    bool feed(std::string_view chunk);
+
+    bool found() const { return !tagName.empty() && !htmlUrl.empty(); }
+
+    std::string tagName;
+    std::string htmlUrl;
+
+private:
+    enum class Field { None, TagName, HtmlUrl };
+
+    void end_string();
+    void append(char ch);
+    void append_code_point(unsigned codePoint);
+
+    size_t maxBytes;
+    size_t scanned = 0;
+    bool finished = false;
+    int depth = 0;
+    bool expectKey = false;      // At depth 1, the next string is a member name
+    bool afterColon = false;     // At depth 1, the next token is a member value
+    Field pending = Field::None; // Member whose value comes next
+    bool inString = false;
+    bool capturing = false;      // Current string is a key or a wanted value
+    bool stringIsKey = false;
+    bool overflow = false;
+    bool escape = false;
+    int unicodeDigits = -1;      // Hex digits left in a \uXXXX escape, -1 if none
+    unsigned unicodeValue = 0;
+    unsigned highSurrogate = 0;
+    std::string text;
+};
+
+enum class ReleaseCheckResult {
+    Updated,      // 200: info now holds the latest release and its ETag
+    NotModified,  // 304: the cached info is still current
+    Failed,       // Network error, unexpected status or unusable body; info unchanged
+};
+
+// GET path from origin, conditional on info.etag when info already names a release.
+ReleaseCheckResult fetch_latest_release(HttpTransport& transport, const HttpOrigin& origin,
+                                        const std::string& path, ReleaseInfo& info);
+
+// Cache file: "TOASTY-RELEASE 1", then etag, tag and url lines. A missing or foreign
+// file loads as empty, which makes the next request unconditional.
+ReleaseInfo load_release_cache(const std::filesystem::path& path);
+bool save_release_cache(const std::filesystem::path& path, const ReleaseInfo& info);
@@ -0,0 +1,153 @@
+#include "core/repo_walker.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+const char* const PRUNED_DIRS[] = {
+    ".git",             // Internals of a repository (its presence is what marks one)
+    "node_modules",
+};
+
+const size_t PRUNED_DIR_COUNT = sizeof(PRUNED_DIRS) / sizeof(PRUNED_DIRS[0]);
+
+namespace {
+
+const size_t MAX_WALK_THREADS = 64;
+
+bool is_pruned(const fs::path& name) {
+    for (size_t i = 0; i < PRUNED_DIR_COUNT; i++) {
+        if (name == PRUNED_DIRS[i]) return true;
+    }
+    return false;
+}
+
+class Walker {
+public:
+    Walker(size_t threads, const std::function<void(const fs::path&)>& visit) : visit(visit) {
+        for (size_t i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+    }
+
+    void run(const fs::path& root) {
+        pending = 1;
+        queues[0]->dirs.push_back(root);
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < queues.size(); i++) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+        work(0);
+        for (auto& worker : workers) worker.join();
+    }
+
+    std::atomic<size_t> directories{0};
+    std::atomic<size_t> repositories{0};
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<fs::path> dirs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    const std::function<void(const fs::path&)>& visit;
+    std::atomic<size_t> pending{0};    // Directories queued or being listed
+
+    bool pop_own(size_t self, fs::path& dir) {
+        Queue& queue = *queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.dirs.empty()) return false;
+        dir = std::move(queue.dirs.back());
+        queue.dirs.pop_back();
+        return true;
+    }
+
+    bool steal(size_t self, fs::path& dir) {
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            Queue& victim = *queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.dirs.empty()) {
+                dir = std::move(victim.dirs.front());
+                victim.dirs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs until every queued directory has been listed. An idle worker spins
+    // briefly (new work usually shows up fast), then backs off.
+    void work(size_t self) {
+        fs::path dir;
+        int idle = 0;
+        while (pending.load() > 0) {
+            if (pop_own(self, dir) || steal(self, dir)) {
+                list(self, dir);
+                pending.fetch_sub(1);
+                idle = 0;
+            } else if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+    // Queue the subdirectories of dir, and report it if it is a repository
+    void list(size_t self, const fs::path& dir) {
+        directories.fetch_add(1, std::memory_order_relaxed);
+        bool isRepository = false;
+        std::vector<fs::path> children;
+
+        std::error_code ec;
+        fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            fs::path name = it->path().filename();
+            if (name == ".git") {
+                isRepository = true;
+                continue;
+            }
+            std::error_code statusEc;
+            if (fs::is_directory(it->symlink_status(statusEc)) && !is_pruned(name)) {
+                children.push_back(it->path());
+            }
+        }
+
+        if (!children.empty()) {
+            pending.fetch_add(children.size());
+            Queue& queue = *queues[self];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (auto& child : children) queue.dirs.push_back(std::move(child));
+        }
+        if (isRepository) {
+            repositories.fetch_add(1, std::memory_order_relaxed);
+            visit(dir);
+        }
+    }
+};
+
+}  // namespace
+
+RepoWalkStats walk_repositories(const fs::path& root, size_t threads,
+                                const std::function<void(const fs::path&)>& visit) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > MAX_WALK_THREADS) threads = MAX_WALK_THREADS;
+
+    auto start = std::chrono::steady_clock::now();
+    Walker walker(threads, visit);
+    walker.run(root);
+
+    RepoWalkStats stats;
+    stats.directories = walker.directories.load();
+    stats.repositories = walker.repositories.load();
+    stats.threads = threads;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+
+// Parallel search for git repositories under a root, for per-repository hooks across
+// a checkout of many repos. Each worker thread owns a deque of directories: it pushes
+// the subdirectories it finds and pops them from the same end (depth first, so its
+// working set stays small), and an idle worker steals from the other end of someone
+// else's deque (the shallow directories, which carry the most work).
+//
+// A directory holding a .git entry (a directory, or a file for worktrees and
+// submodules) is a repository; the walk continues below it to find nested ones.
+// PRUNED_DIRS are never entered, and neither are symlinks, so links can't loop.
+
+extern const char* const PRUNED_DIRS[];
+extern const size_t PRUNED_DIR_COUNT;
+
+struct RepoWalkStats {
+    size_t directories = 0;     // Directories listed
+    size_t repositories = 0;
+    size_t threads = 0;
+    double seconds = 0;
+};
+
+// visit(repoDir) runs on the worker threads, so it may be called concurrently.
+// threads == 0 uses one per hardware thread.
+RepoWalkStats walk_repositories(const std::filesystem::path& root, size_t threads,
+                                const std::function<void(const std::filesystem::path&)>& visit);
@@ -0,0 +1,345 @@
+#include "core/sanitize.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+const char32_t REPLACEMENT_CHAR = 0xFFFD;
+const std::string_view ELLIPSIS = "...";
+
+// Input is searched for escapes in windows this size, so a huge string is never
+// scanned much past the point where the output fills up
+const size_t JSON_SCAN_WINDOW = 4096;
+
+struct CodeRange {
+    char32_t first;
+    char32_t last;
+};
+
+// Characters that never start a grapheme cluster: combining marks and vowel signs of
+// the common scripts, Hangul vowel/final jamo, ZWJ/ZWNJ, variation selectors, emoji
+// skin tone modifiers and tag characters. A subset of UAX #29 Extend/SpacingMark,
+// enough that a cut never separates a letter from its accents or splits an emoji
+// sequence.
+const CodeRange CLUSTER_EXTEND[] = {
+    { 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x05BF, 0x05BF },
+    { 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 }, { 0x05C7, 0x05C7 }, { 0x0610, 0x061A },
+    { 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x06DF, 0x06E4 },
+    { 0x06E7, 0x06E8 }, { 0x06EA, 0x06ED }, { 0x0900, 0x0903 }, { 0x093A, 0x093C },
+    { 0x093E, 0x094F }, { 0x0951, 0x0957 }, { 0x0962, 0x0963 }, { 0x0981, 0x0983 },
+    { 0x09BC, 0x09BC }, { 0x09BE, 0x09CD }, { 0x09D7, 0x09D7 }, { 0x0E31, 0x0E31 },
+    { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E }, { 0x1160, 0x11FF }, { 0x1AB0, 0x1AFF },
+    { 0x1DC0, 0x1DFF }, { 0x200C, 0x200D }, { 0x20D0, 0x20FF }, { 0x302A, 0x302F },
+    { 0x3099, 0x309A }, { 0xD7B0, 0xD7FF }, { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F },
+    { 0xFF9E, 0xFF9F }, { 0x1F3FB, 0x1F3FF }, { 0xE0020, 0xE007F }, { 0xE0100, 0xE01EF },
+};
+
+bool in_ranges(char32_t codePoint, const CodeRange* begin, const CodeRange* end) {
+    const CodeRange* range = std::upper_bound(begin, end, codePoint,
+        [](char32_t value, const CodeRange& r) { return value < r.first; });
+    return range != begin && codePoint <= std::prev(range)->last;
+}
+
+bool is_cluster_extend(char32_t codePoint) {
+    return codePoint >= 0x0300 && in_ranges(codePoint, std::begin(CLUSTER_EXTEND), std::end(CLUSTER_EXTEND));
+}
+
+// Symbols and emoji that join the previous cluster after a ZWJ (family, profession,
+// flag sequences, ...)
+bool is_pictographic(char32_t codePoint) {
+    return (codePoint >= 0x2600 && codePoint <= 0x27BF) || (codePoint >= 0x1F000 && codePoint <= 0x1FAFF);
+}
+
+bool is_regional_indicator(char32_t codePoint) {
+    return codePoint >= 0x1F1E6 && codePoint <= 0x1F1FF;
+}
+
+size_t utf8_length(char32_t codePoint) {
+    return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x10000 ? 3 : 4;
+}
+
+void append_utf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool read_hex4(std::string_view text, size_t at, char32_t& value) {
+    if (at + 4 > text.size()) return false;
+    value = 0;
+    for (size_t k = 0; k < 4; k++) {
+        char c = text[at + k];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+TextSanitizer::TextSanitizer(size_t maxBytes, bool singleLine) : maxBytes(maxBytes), singleLine(singleLine) {
+    out.reserve(std::min<size_t>(maxBytes, 256));
+}
+
+bool TextSanitizer::write(std::string_view utf8) {
+    for (size_t i = 0; i < utf8.size() && !isFull; i++) {
+        unsigned char byte = static_cast<unsigned char>(utf8[i]);
+
+        if (partialLength > 0) {
+            if ((byte & 0xC0) == 0x80) {
+                partial = (partial << 6) | (byte & 0x3F);
+                if (++partialSeen == partialLength) {
+                    char32_t minimum = partialLength == 2 ? 0x80 : partialLength == 3 ? 0x800 : 0x10000;
+                    bool valid = partial >= minimum && partial <= 0x10FFFF && !(partial >= 0xD800 && partial <= 0xDFFF);
+                    int length = partialLength;
+                    partialLength = 0;
+                    if (valid) {
+                        accept(partial);
+                    } else {
+                        // One U+FFFD per byte, as from_utf8 does
+                        for (int k = 0; k < length; k++) accept(REPLACEMENT_CHAR);
+                    }
+                }
+                continue;
+            }
+            flush_partial();   // Truncated sequence; this byte starts over
+            if (isFull) break;
+        }
+
+        if (byte >= 0x20 && byte < 0x7F && escape == EscapeState::None) {
+            // Printable ASCII outside a sequence: always its own cluster
+            if (out.size() + ELLIPSIS.size() <= maxBytes) cut = out.size();
+            if (out.size() >= maxBytes) {
+                isFull = true;
+                break;
+            }
+            out += static_cast<char>(byte);
+            regionalIndicators = 0;
+            previous = byte;
+            afterCr = false;
+        } else if (byte < 0x80) {
+            accept(byte);
+        } else if ((byte & 0xE0) == 0xC0) {
+            partial = byte & 0x1F; partialLength = 2; partialSeen = 1;
+        } else if ((byte & 0xF0) == 0xE0) {
+            partial = byte & 0x0F; partialLength = 3; partialSeen = 1;
+        } else if ((byte & 0xF8) == 0xF0) {
+            partial = byte & 0x07; partialLength = 4; partialSeen = 1;
+        } else {
+            accept(REPLACEMENT_CHAR);
+        }
+    }
+    return !isFull;
+}
+
+bool TextSanitizer::put(char32_t codePoint) {
+    flush_partial();
+    if (!isFull) accept(codePoint);
+    return !isFull;
+}
+
+void TextSanitizer::flush_partial() {
+    int seen = partialSeen;
+    if (partialLength == 0) return;
+    partialLength = 0;
+    for (int k = 0; k < seen && !isFull; k++) accept(REPLACEMENT_CHAR);
+}
+
+std::string TextSanitizer::finish() {
+    flush_partial();
+    if (isFull) {
+        out.resize(cut);
+        while (!out.empty() && (out.back() == ' ' || out.back() == '\n' || out.back() == '\t')) out.pop_back();
+        if (maxBytes >= ELLIPSIS.size()) out += ELLIPSIS;
+    }
+    return std::move(out);
+}
+
+// Escape sequences follow ECMA-48: ESC [ params final (CSI), ESC ] ... BEL/ST (OSC,
+// and likewise DCS, SOS, PM, APC), ESC intermediates final, and their C1 forms
+bool TextSanitizer::accept(char32_t codePoint) {
+    switch (escape) {
+        case EscapeState::None:
+            break;
+        case EscapeState::Start:
+            escape = EscapeState::None;
+            if (codePoint == '[') {
+                escape = EscapeState::Csi;
+                return true;
+            }
+            if (codePoint == ']' || codePoint == 'P' || codePoint == 'X' || codePoint == '^' || codePoint == '_') {
+                escape = EscapeState::String;
+                return true;
+            }
+            if (codePoint >= 0x20 && codePoint <= 0x2F) {
+                escape = EscapeState::Intermediate;
+                return true;
+            }
+            if (codePoint >= 0x30 && codePoint <= 0x7E) return true;
+            break;   // Not a sequence: the ESC is dropped, the character kept
+        case EscapeState::Csi:
+            if (codePoint >= 0x20 && codePoint <= 0x3F) return true;
+            escape = EscapeState::None;
+            if (codePoint >= 0x40 && codePoint <= 0x7E) return true;
+            break;
+        case EscapeState::Intermediate:
+            if (codePoint >= 0x20 && codePoint <= 0x2F) return true;
+            escape = EscapeState::None;
+            if (codePoint >= 0x30 && codePoint <= 0x7E) return true;
+            break;
+        case EscapeState::String:
+            if (codePoint == 0x07 || codePoint == 0x9C) escape = EscapeState::None;
+            else if (codePoint == 0x1B) escape = EscapeState::StringEnd;
+            return true;
+        case EscapeState::StringEnd:
+            if (codePoint == '\\') {
+                escape = EscapeState::None;
+                return true;
+            }
+            escape = EscapeState::Start;   // The ESC ended the string and starts a new sequence
+            return accept(codePoint);
+    }
+
+    if (codePoint == 0x1B) {
+        escape = EscapeState::Start;
+        return true;
+    }
+    if (codePoint == 0x9B) {
+        escape = EscapeState::Csi;
+        return true;
+    }
+    if (codePoint == 0x90 || codePoint == 0x98 || codePoint == 0x9D || codePoint == 0x9E || codePoint == 0x9F) {
+        escape = EscapeState::String;
+        return true;
+    }
+
+    bool wasCr = afterCr;
+    afterCr = codePoint == '\r';
+    if (codePoint == '\r' || codePoint == '\n') {
+        if (codePoint == '\n' && wasCr) return true;
+        return emit(singleLine ? ' ' : '\n');
+    }
+    if (codePoint == '\t') return emit(singleLine ? ' ' : '\t');
+    if (codePoint < 0x20 || (codePoint >= 0x7F && codePoint <= 0x9F)) return true;
+    return emit(codePoint);
+}
+
+bool TextSanitizer::starts_cluster(char32_t codePoint) const {
+    if (previous == 0 || previous == '\n' || previous == '\t') return true;
+    if (is_cluster_extend(codePoint)) return false;
+    if (previous == 0x200D && is_pictographic(codePoint)) return false;
+    if (is_regional_indicator(codePoint) && regionalIndicators % 2 == 1) return false;
+    return true;
+}
+
+bool TextSanitizer::emit(char32_t codePoint) {
+    if (starts_cluster(codePoint) && out.size() + ELLIPSIS.size() <= maxBytes) {
+        cut = out.size();
+    }
+    if (out.size() + utf8_length(codePoint) > maxBytes) {
+        isFull = true;
+        return false;
+    }
+    append_utf8(out, codePoint);
+    regionalIndicators = is_regional_indicator(codePoint) ? regionalIndicators + 1 : 0;
+    previous = codePoint;
+    return true;
+}
+
+std::string sanitize_text(std::string_view utf8, size_t maxBytes, bool singleLine) {
+    TextSanitizer sanitizer(maxBytes, singleLine);
+    sanitizer.write(utf8);
+    return sanitizer.finish();
+}
+
+std::string sanitize_text(std::wstring_view text, size_t maxBytes, bool singleLine) {
+    TextSanitizer sanitizer(maxBytes, singleLine);
+    for (size_t i = 0; i < text.size() && !sanitizer.full(); i++) {
+        char32_t cp = static_cast<char32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text.size() &&
+                text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<char32_t>(text[i + 1]) - 0xDC00);
+                i++;
+            }
+        }
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) cp = REPLACEMENT_CHAR;
+        sanitizer.put(cp);
+    }
+    return sanitizer.finish();
+}
+
+std::string sanitize_json_string(std::string_view raw, size_t maxBytes, bool singleLine) {
+    TextSanitizer sanitizer(maxBytes, singleLine);
+    size_t i = 0;
+    while (i < raw.size() && !sanitizer.full()) {
+        // Plain bytes up to the next escape go through the UTF-8 decoder as they are
+        size_t windowEnd = std::min(raw.size(), i + JSON_SCAN_WINDOW);
+        size_t slash = raw.substr(0, windowEnd).find('\\', i);
+        if (slash == std::string_view::npos) {
+            sanitizer.write(raw.substr(i, windowEnd - i));
+            i = windowEnd;
+            continue;
+        }
+        sanitizer.write(raw.substr(i, slash - i));
+        i = slash;
+        if (i + 1 >= raw.size()) {
+            sanitizer.put('\\');
+            break;
+        }
+
+        // Same decoding as json_unescape: invalid escapes are kept literally
+        char escaped = raw[i + 1];
+        char32_t codePoint;
+        switch (escaped) {
+            case '"': case '\\': case '/': sanitizer.put(static_cast<char32_t>(escaped)); i += 2; break;
+            case 'b': sanitizer.put('\b'); i += 2; break;
+            case 'f': sanitizer.put('\f'); i += 2; break;
+            case 'n': sanitizer.put('\n'); i += 2; break;
+            case 'r': sanitizer.put('\r'); i += 2; break;
+            case 't': sanitizer.put('\t'); i += 2; break;
+            case 'u':
+                if (!read_hex4(raw, i + 2, codePoint)) {
+                    sanitizer.put('\\');
+                    i++;
+                    break;
+                }
+                i += 6;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    char32_t low;
+                    if (i + 1 < raw.size() && raw[i] == '\\' && raw[i + 1] == 'u' &&
+                        read_hex4(raw, i + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else {
+                        codePoint = REPLACEMENT_CHAR;
+                    }
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    codePoint = REPLACEMENT_CHAR;
+                }
+                sanitizer.put(codePoint);
+                break;
+            default:
+                sanitizer.put('\\');
+                i++;
+                break;
+        }
+    }
+    return sanitizer.finish();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Notification text cleanup in one streaming pass: ANSI escape sequences (CSI, OSC,
+// DCS, ...) are stripped, control characters dropped (\n and \t are kept, \r and
+// \r\n become \n), invalid UTF-8 is replaced with U+FFFD, and the result is cut to
+// a byte budget on a grapheme cluster boundary with "..." appended. Input stops
+// being read once the budget is full, so the cost follows the output size.
+
+// Upper bound for any message or title, applied once where the text enters toasty;
+// each sink may cut further (SinkConfig::maxMessageBytes)
+const size_t MAX_MESSAGE_BYTES = 64 * 1024;
+const size_t MAX_TITLE_BYTES = 256;
+
+class TextSanitizer {
+public:
+    // singleLine turns \n and \t into spaces (titles)
+    explicit TextSanitizer(size_t maxBytes, bool singleLine = false);
+
+    // Feed UTF-8; a sequence split across calls is carried over. Returns false once
+    // the budget is full and further input would be ignored.
+    bool write(std::string_view utf8);
+
+    // Feed one code point (e.g. a decoded escape)
+    bool put(char32_t codePoint);
+
+    bool full() const { return isFull; }
+
+    // The sanitized UTF-8 text; the sanitizer is spent afterwards
+    std::string finish();
+
+private:
+    enum class EscapeState { None, Start, Csi, Intermediate, String, StringEnd };
+
+    void flush_partial();
+    bool accept(char32_t codePoint);
+    bool emit(char32_t codePoint);
+    bool starts_cluster(char32_t codePoint) const;
+
+    std::string out;
+    size_t maxBytes;
+    bool singleLine;
+    bool isFull = false;
+    size_t cut = 0;               // Last cluster boundary that leaves room for "..."
+
+    EscapeState escape = EscapeState::None;
+    bool afterCr = false;
+
+    char32_t partial = 0;         // UTF-8 sequence in progress
+    int partialLength = 0;        // Total bytes of that sequence, 0 if none
+    int partialSeen = 0;
+
+    char32_t previous = 0;        // Last code point written, 0 at the start
+    size_t regionalIndicators = 0;
+};
+
+std::string sanitize_text(std::string_view utf8, size_t maxBytes, bool singleLine = false);
+std::string sanitize_text(std::wstring_view text, size_t maxBytes, bool singleLine = false);
+
+// Sanitize the raw (still escaped) content of a JSON string, decoding as it goes, so
+// a huge field costs no more than the part that is kept
+std::string sanitize_json_string(std::string_view raw, size_t maxBytes, bool singleLine = false);
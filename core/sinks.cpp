@@ -0,0 +1,376 @@
+#include "core/sinks.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include "core/atomic_file.h"
+#include "core/file_lock.h"
+#include "core/http.h"
+#include "core/json.h"
+#include "core/sanitize.h"
+#include "core/strings.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct SinkDefaults {
+    SinkKind kind;
+    const char* name;
+    bool needsTarget;
+    int deadlineMs;
+    bool required;
+    size_t maxMessageBytes;
+};
+
+// Toasts show a few lines and their XML payload is capped at 5 KB; ntfy turns longer
+// messages into attachments
+const SinkDefaults SINK_DEFAULTS[] = {
+    { SinkKind::Toast,   "toast",   false, 5000, true,  1024 },
+    { SinkKind::Ntfy,    "ntfy",    false, 2000, false, 4096 },
+    { SinkKind::Webhook, "webhook", true,  3000, false, MAX_MESSAGE_BYTES },
+    { SinkKind::File,    "file",    true,  1000, true,  MAX_MESSAGE_BYTES },
+    { SinkKind::Stdout,  "stdout",  false, 1000, true,  MAX_MESSAGE_BYTES },
+};
+
+const SinkDefaults* find_sink_defaults(std::string_view name) {
+    for (const auto& defaults : SINK_DEFAULTS) {
+        if (name == defaults.name) return &defaults;
+    }
+    return nullptr;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+    return text;
+}
+
+class WebhookSink : public NotificationSink {
+public:
+    WebhookSink(std::string url, int deadlineMs) : url(std::move(url)), deadlineMs(deadlineMs) {}
+
+    bool deliver(const Notification& notification) override {
+        HttpOrigin origin;
+        HttpRequest request;
+        if (!parse_http_url(url, origin, request.path)) return false;
+
+        HttpOptions options;
+        options.connectTimeoutMs = deadlineMs;
+        options.ioTimeoutMs = deadlineMs;
+        options.maxBodyBytes = 4096;
+        auto transport = create_http_transport(options);
+
+        request.method = "POST";
+        request.headers.emplace_back("Content-Type", "application/json");
+        request.body = notification_json(notification);
+
+        HttpResponse response;
+        return transport->send(origin, request, response) && response.status >= 200 && response.status < 300;
+    }
+
+private:
+    std::string url;
+    int deadlineMs;
+};
+
+// Append-only JSON lines; concurrent toasty processes serialize on the lock file
+class FileSink : public NotificationSink {
+public:
+    explicit FileSink(const std::string& path) : path(std::u8string(path.begin(), path.end())) {}
+
+    bool deliver(const Notification& notification) override {
+        std::filesystem::path lockPath = path;
+        lockPath += ".lock";
+        FileLock lock(lockPath, 1000);
+        if (!lock.locked()) return false;
+
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        if (!file) return false;
+        file << notification_json(notification) << '\n';
+        return file.good();
+    }
+
+private:
+    std::filesystem::path path;
+};
+
+class StdoutSink : public NotificationSink {
+public:
+    bool deliver(const Notification& notification) override {
+        std::string line = notification_json(notification) + "\n";
+        return std::fwrite(line.data(), 1, line.size(), stdout) == line.size() && std::fflush(stdout) == 0;
+    }
+};
+
+// Completion state shared with a sink's thread, which may outlive dispatch_sinks()
+struct SinkState {
+    std::mutex mutex;
+    std::condition_variable finishedCv;
+    bool finished = false;
+    bool delivered = false;
+    Clock::time_point finishedAt;
+};
+
+}  // namespace
+
+const char* sink_kind_name(SinkKind kind) {
+    for (const auto& defaults : SINK_DEFAULTS) {
+        if (defaults.kind == kind) return defaults.name;
+    }
+    return "unknown";
+}
+
+size_t sink_message_limit(SinkKind kind) {
+    for (const auto& defaults : SINK_DEFAULTS) {
+        if (defaults.kind == kind) return defaults.maxMessageBytes;
+    }
+    return MAX_MESSAGE_BYTES;
+}
+
+bool parse_sink_configs(std::string_view text, std::vector<SinkConfig>& configs, std::string& error) {
+    configs.clear();
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view entry = trim(text.substr(0, comma));
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+        if (entry.empty()) continue;
+
+        SinkConfig config;
+        std::optional<bool> required;
+        if (entry.back() == '!' || entry.back() == '?') {
+            required = entry.back() == '!';
+            entry.remove_suffix(1);
+        }
+
+        // A deadline suffix is "@<digits>" at the very end, so URLs with '@' still parse
+        std::optional<int> deadline;
+        size_t at = entry.rfind('@');
+        if (at != std::string_view::npos) {
+            std::string_view digits = entry.substr(at + 1);
+            int value = 0;
+            auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            if (!digits.empty() && result.ec == std::errc() && result.ptr == digits.data() + digits.size()) {
+                if (value <= 0 || value > 60000) {
+                    error = "deadline out of range in '" + std::string(entry) + "'";
+                    return false;
+                }
+                deadline = value;
+                entry = entry.substr(0, at);
+            }
+        }
+
+        size_t equals = entry.find('=');
+        std::string_view name = trim(entry.substr(0, equals));
+        const SinkDefaults* defaults = find_sink_defaults(name);
+        if (!defaults) {
+            error = "unknown sink '" + std::string(name) + "'";
+            return false;
+        }
+        if (equals != std::string_view::npos) {
+            config.target = std::string(trim(entry.substr(equals + 1)));
+        }
+        if (defaults->needsTarget && config.target.empty()) {
+            error = std::string(defaults->name) + " sink needs a target (" + defaults->name + "=...)";
+            return false;
+        }
+        if (!defaults->needsTarget && !config.target.empty()) {
+            error = std::string(defaults->name) + " sink takes no target";
+            return false;
+        }
+
+        config.kind = defaults->kind;
+        config.deadlineMs = deadline.value_or(defaults->deadlineMs);
+        config.required = required.value_or(defaults->required);
+        config.maxMessageBytes = defaults->maxMessageBytes;
+        configs.push_back(std::move(config));
+    }
+
+    if (configs.empty()) {
+        error = "no sinks configured";
+        return false;
+    }
+    return true;
+}
+
+std::string notification_json(const Notification& notification) {
+    std::string json = "{\"title\":";
+    append_json_string(json, notification.title);
+    json += ",\"message\":";
+    append_json_string(json, notification.message);
+    json += ",\"source\":";
+    append_json_string(json, notification.source);
+    json += ",\"cwd\":";
+    append_json_string(json, notification.cwd);
+    json += ",\"timestamp\":" + std::to_string(notification.timestampMs) + "}";
+    return json;
+}
+
+bool parse_notification_json(std::string_view json, Notification& notification) {
+    notification = Notification();
+    return scan_json_object(json, [&notification](std::string_view key, std::string_view value, bool isString) {
+        if (isString) {
+            if (key == "title") notification.title = json_unescape(value);
+            else if (key == "message") notification.message = json_unescape(value);
+            else if (key == "source") notification.source = json_unescape(value);
+            else if (key == "cwd") notification.cwd = json_unescape(value);
+        } else if (key == "timestamp") {
+            std::from_chars(value.data(), value.data() + value.size(), notification.timestampMs);
+        }
+        return true;
+    });
+}
+
+std::unique_ptr<NotificationSink> create_portable_sink(const SinkConfig& config) {
+    switch (config.kind) {
+        case SinkKind::Webhook: return std::make_unique<WebhookSink>(config.target, config.deadlineMs);
+        case SinkKind::File: return std::make_unique<FileSink>(config.target);
+        case SinkKind::Stdout: return std::make_unique<StdoutSink>();
+        default: return nullptr;
+    }
+}
+
+std::vector<SinkResult> dispatch_sinks(const std::vector<SinkTask>& tasks, const Notification& notification) {
+    Clock::time_point start = Clock::now();
+    std::vector<std::shared_ptr<SinkState>> states;
+
+    // Threads are detached: a sink that misses its deadline is abandoned, not joined
+    for (const auto& task : tasks) {
+        auto state = std::make_shared<SinkState>();
+        states.push_back(state);
+        std::thread([sink = task.sink, state, notification = notification, limit = task.maxMessageBytes]() mutable {
+            // The message is already clean; this only cuts it to the sink's size
+            if (limit > 0 && notification.message.size() > limit) {
+                notification.message = sanitize_text(notification.message, limit);
+            }
+            bool delivered = false;
+            try {
+                delivered = sink && sink->deliver(notification);
+            } catch (...) {
+                delivered = false;
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished = true;
+            state->delivered = delivered;
+            state->finishedAt = Clock::now();
+            state->finishedCv.notify_all();
+        }).detach();
+    }
+
+    std::vector<SinkResult> results(tasks.size());
+    auto wait = [&](size_t i, Clock::time_point until) {
+        SinkState& state = *states[i];
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.finishedCv.wait_until(lock, until, [&state]() { return state.finished; });
+
+        SinkResult& result = results[i];
+        result.name = tasks[i].name;
+        result.required = tasks[i].required;
+        result.delivered = state.finished && state.delivered;
+        result.timedOut = !state.finished;
+        Clock::time_point end = state.finished ? state.finishedAt : Clock::now();
+        result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    };
+
+    bool anyRequired = false;
+    Clock::time_point requiredDone = start;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (!tasks[i].required) continue;
+        anyRequired = true;
+        wait(i, start + std::chrono::milliseconds(tasks[i].deadlineMs));
+        requiredDone = std::max(requiredDone, Clock::now());
+    }
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (tasks[i].required) continue;
+        Clock::time_point deadline = start + std::chrono::milliseconds(tasks[i].deadlineMs);
+        wait(i, anyRequired ? std::min(deadline, requiredDone) : deadline);
+
+        // Cut short by the required sinks rather than its own deadline: let the worker finish it
+        SinkResult& result = results[i];
+        if (result.timedOut && tasks[i].handoff && Clock::now() < deadline) {
+            Notification handed = notification;
+            size_t limit = tasks[i].maxMessageBytes;
+            if (limit > 0 && handed.message.size() > limit) {
+                handed.message = sanitize_text(handed.message, limit);
+            }
+            try {
+                result.handedOff = tasks[i].handoff(handed);
+            } catch (...) {
+                result.handedOff = false;
+            }
+            result.timedOut = !result.handedOff;
+        }
+    }
+    return results;
+}
+
+bool sink_can_queue(SinkKind kind) {
+    return kind != SinkKind::Toast && kind != SinkKind::Stdout;
+}
+
+bool queue_sink_job(const std::filesystem::path& dir, const SinkConfig& config, const Notification& notification) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    // Millisecond time first, so names sort oldest first
+    int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string name = std::to_string(nowMs) + "-" + std::to_string(std::random_device()()) + ".sink";
+
+    std::string job = std::string(sink_kind_name(config.kind)) + "\n" + config.target + "\n" +
+                      std::to_string(config.deadlineMs) + "\n" + notification_json(notification);
+    std::string error;
+    return write_file_atomic(dir / name, job, error);
+}
+
+std::vector<SinkJob> claim_sink_jobs(const std::filesystem::path& dir) {
+    std::vector<std::filesystem::path> queued;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".sink") {
+            queued.push_back(it->path());
+        }
+    }
+    std::sort(queued.begin(), queued.end());
+
+    std::vector<SinkJob> jobs;
+    for (const auto& path : queued) {
+        std::filesystem::path claimed = path;
+        claimed.replace_extension(".claimed");
+        std::filesystem::rename(path, claimed, ec);
+        if (ec) continue;  // Another worker took it
+
+        std::string content = read_file_bytes(claimed);
+        std::filesystem::remove(claimed, ec);
+
+        // kind \n target \n deadline \n notification JSON
+        size_t first = content.find('\n');
+        size_t second = first == std::string::npos ? first : content.find('\n', first + 1);
+        size_t third = second == std::string::npos ? second : content.find('\n', second + 1);
+        if (third == std::string::npos) continue;
+
+        SinkJob job;
+        const SinkDefaults* defaults = find_sink_defaults(std::string_view(content).substr(0, first));
+        std::string_view deadline = std::string_view(content).substr(second + 1, third - second - 1);
+        auto parsed = std::from_chars(deadline.data(), deadline.data() + deadline.size(), job.config.deadlineMs);
+        if (!defaults || parsed.ec != std::errc() || job.config.deadlineMs <= 0 ||
+            !parse_notification_json(std::string_view(content).substr(third + 1), job.notification)) {
+            continue;
+        }
+        job.config.kind = defaults->kind;
+        job.config.target = content.substr(first + 1, second - first - 1);
+        job.config.maxMessageBytes = defaults->maxMessageBytes;
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Notification fan-out. Every configured sink (toast, ntfy, webhook, file, stdout)
+// runs on its own thread with its own deadline, so a slow or failing sink can't hold
+// up the others. dispatch_sinks() returns once every required sink has finished or
+// hit its deadline: latency is set by the slowest required sink, not the sum. A
+// best-effort sink still running then is handed to a detached worker through the
+// sink queue below, so the process can exit without cutting it off.
+
+struct Notification {
+    std::string title;     // UTF-8 throughout
+    std::string message;
+    std::string iconPath;
+    std::string source;    // Preset name, empty if none
+    std::string cwd;
+    int64_t timestampMs = 0;
+};
+
+enum class SinkKind { Toast, Ntfy, Webhook, File, Stdout };
+
+struct SinkConfig {
+    SinkKind kind = SinkKind::Toast;
+    std::string target;    // Webhook URL or file path
+    int deadlineMs = 0;
+    bool required = false;
+    size_t maxMessageBytes = 0;   // Longer messages are cut (grapheme-safe) for this sink
+};
+
+const char* sink_kind_name(SinkKind kind);
+
+// Default maxMessageBytes for a kind of sink
+size_t sink_message_limit(SinkKind kind);
+
+// Parse a comma-separated sink list. Each entry is kind[=target][@deadlineMs][!|?]:
+//   toast, ntfy, stdout          no target
+//   webhook=<url>, file=<path>   target required
+//   @ms overrides the default deadline; ! makes a sink required, ? best-effort.
+// Local sinks (toast, file, stdout) are required by default, network sinks are not.
+bool parse_sink_configs(std::string_view text, std::vector<SinkConfig>& configs, std::string& error);
+
+class NotificationSink {
+public:
+    virtual ~NotificationSink() = default;
+
+    // Runs on a worker thread; returns false (or throws) on failure
+    virtual bool deliver(const Notification& notification) = 0;
+};
+
+// Adapts a callable, for sinks implemented by the platform layer. The callable may
+// outlive the dispatch call if it misses its deadline, so it must capture by value.
+class FunctionSink : public NotificationSink {
+public:
+    explicit FunctionSink(std::function<bool(const Notification&)> function) : function(std::move(function)) {}
+    bool deliver(const Notification& notification) override { return function(notification); }
+
+private:
+    std::function<bool(const Notification&)> function;
+};
+
+// {"title":...,"message":...,"source":...,"cwd":...,"timestamp":...}
+std::string notification_json(const Notification& notification);
+
+// Read notification_json() back; iconPath is not part of it. False if json isn't an object.
+bool parse_notification_json(std::string_view json, Notification& notification);
+
+// Sinks with no platform dependency: webhook (POST notification_json), file (append one
+// JSON line under a FileLock) and stdout (one JSON line). nullptr for toast and ntfy.
+std::unique_ptr<NotificationSink> create_portable_sink(const SinkConfig& config);
+
+struct SinkTask {
+    std::string name;
+    std::shared_ptr<NotificationSink> sink;
+    int deadlineMs = 0;
+    bool required = false;
+    size_t maxMessageBytes = 0;   // 0: the message as given
+
+    // Best-effort sinks only: takes over a delivery still running when the required
+    // sinks are done (queue_sink_job for the detached worker). Empty: it is abandoned.
+    std::function<bool(const Notification&)> handoff;
+};
+
+struct SinkResult {
+    std::string name;
+    bool required = false;
+    bool delivered = false;
+    bool timedOut = false;     // Still running at its deadline; abandoned
+    bool handedOff = false;    // Still running when the required sinks were done; handed off
+    int64_t elapsedMs = 0;
+};
+
+// Start every sink at once and wait for the required ones. Best-effort sinks get until
+// the required ones are done (or their own deadline when nothing is required); one
+// still running then goes to its handoff, if it has one. The abandoned thread may
+// still finish first, so a handed-off delivery can arrive twice.
+std::vector<SinkResult> dispatch_sinks(const std::vector<SinkTask>& tasks, const Notification& notification);
+
+// Whether a detached worker can deliver this kind of sink: all but toast and stdout,
+// which need this process's desktop session and output
+bool sink_can_queue(SinkKind kind);
+
+// Best-effort deliveries waiting for the detached worker (toasty --drain-queue). One
+// file per job in dir: kind, target and deadline on a line each, then
+// notification_json(). Jobs are written as .tmp and renamed to .sink, so the worker
+// never reads half a job.
+struct SinkJob {
+    SinkConfig config;
+    Notification notification;
+};
+
+bool queue_sink_job(const std::filesystem::path& dir, const SinkConfig& config, const Notification& notification);
+
+// Take every queued job, oldest first. Each is claimed by renaming it, so concurrent
+// workers never deliver the same job twice; unreadable jobs are dropped.
+std::vector<SinkJob> claim_sink_jobs(const std::filesystem::path& dir);
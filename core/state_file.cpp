@@ -0,0 +1,185 @@
+#include "core/state_file.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "core/file_lock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t HEADER_MAGIC = 0;
+const size_t HEADER_VERSION = 4;
+const size_t HEADER_SIZE = 8;
+const size_t HEADER_SEQUENCE = 12;
+const size_t FIELDS_OFFSET = 16;
+const size_t FIELD_COUNT = sizeof(ToastyState) / sizeof(uint64_t);
+const int STATE_LOCK_TIMEOUT_MS = 1000;
+
+static_assert(sizeof(ToastyState) % sizeof(uint64_t) == 0, "ToastyState must hold only u64 fields");
+static_assert(FIELDS_OFFSET + sizeof(ToastyState) <= STATE_FILE_SIZE, "ToastyState outgrew the state file");
+
+std::atomic_ref<uint32_t> word32(unsigned char* view, size_t offset) {
+    return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(view + offset));
+}
+
+std::atomic_ref<uint64_t> field(unsigned char* view, size_t index) {
+    return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(view + FIELDS_OFFSET + index * sizeof(uint64_t)));
+}
+
+}  // namespace
+
+std::unique_ptr<StateFile> StateFile::open(const std::filesystem::path& path) {
+    std::unique_ptr<StateFile> state(new StateFile());
+    state->lockPath = path;
+    state->lockPath += ".lock";
+    if (!state->map(path)) {
+        return nullptr;
+    }
+    state->validate();
+    return state;
+}
+
+#ifdef _WIN32
+
+bool StateFile::map(const std::filesystem::path& path) {
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+
+    // Grows a new (empty) file to STATE_FILE_SIZE zero bytes
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, STATE_FILE_SIZE, nullptr);
+    if (!mapping) return false;
+
+    view = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, STATE_FILE_SIZE));
+    return view != nullptr;
+}
+
+StateFile::~StateFile() {
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+}
+
+#else
+
+bool StateFile::map(const std::filesystem::path& path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) return false;
+    if (info.st_size < static_cast<off_t>(STATE_FILE_SIZE) && ftruncate(fd, STATE_FILE_SIZE) != 0) {
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, STATE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) return false;
+    view = static_cast<unsigned char*>(mapped);
+    return true;
+}
+
+StateFile::~StateFile() {
+    if (view) munmap(view, STATE_FILE_SIZE);
+    if (fd >= 0) close(fd);
+}
+
+#endif
+
+// Reset a missing, foreign or older-format file. Checked again under the lock, since
+// another process may be initializing it at the same moment.
+void StateFile::validate() {
+    auto valid = [this]() {
+        return word32(view, HEADER_MAGIC).load(std::memory_order_acquire) == STATE_FILE_MAGIC &&
+               word32(view, HEADER_VERSION).load(std::memory_order_relaxed) == STATE_FILE_VERSION &&
+               word32(view, HEADER_SIZE).load(std::memory_order_relaxed) == STATE_FILE_SIZE;
+    };
+    if (valid()) return;
+
+    FileLock lock(lockPath, STATE_LOCK_TIMEOUT_MS);
+    if (!lock.locked() || valid()) return;
+
+    word32(view, HEADER_MAGIC).store(0, std::memory_order_relaxed);
+    word32(view, HEADER_SEQUENCE).store(0, std::memory_order_relaxed);
+    store_fields(ToastyState());
+    word32(view, HEADER_VERSION).store(STATE_FILE_VERSION, std::memory_order_relaxed);
+    word32(view, HEADER_SIZE).store(STATE_FILE_SIZE, std::memory_order_relaxed);
+    word32(view, HEADER_MAGIC).store(STATE_FILE_MAGIC, std::memory_order_release);
+}
+
+ToastyState StateFile::load_fields() const {
+    uint64_t words[FIELD_COUNT];
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        words[i] = field(view, i).load(std::memory_order_relaxed);
+    }
+    ToastyState state;
+    std::memcpy(&state, words, sizeof(state));
+    return state;
+}
+
+void StateFile::store_fields(const ToastyState& state) {
+    uint64_t words[FIELD_COUNT];
+    std::memcpy(words, &state, sizeof(state));
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        field(view, i).store(words[i], std::memory_order_relaxed);
+    }
+}
+
+ToastyState StateFile::read() const {
+    auto sequence = word32(view, HEADER_SEQUENCE);
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0) {
+            ToastyState state = load_fields();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return state;
+            }
+        }
+        std::this_thread::yield();
+    }
+
+    // A writer died mid-update (odd sequence) or is very slow: read under the lock
+    FileLock lock(lockPath, STATE_LOCK_TIMEOUT_MS);
+    return load_fields();
+}
+
+bool StateFile::update(const std::function<void(ToastyState&)>& mutate) {
+    FileLock lock(lockPath, STATE_LOCK_TIMEOUT_MS);
+    if (!lock.locked()) {
+        return false;
+    }
+
+    ToastyState current = load_fields();
+    ToastyState next = current;
+    mutate(next);
+    if (next == current) {
+        return true;
+    }
+
+    // An odd sequence left by a writer that died holding the lock is simply moved on
+    auto sequence = word32(view, HEADER_SEQUENCE);
+    uint32_t start = sequence.load(std::memory_order_relaxed) | 1;
+    sequence.store(start, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store_fields(next);
+    sequence.store(start + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t StateFile::sequence() const {
+    return word32(view, HEADER_SEQUENCE).load(std::memory_order_acquire);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+// Compact per-user state shared by every toasty process, memory-mapped from one small
+// file (%LOCALAPPDATA%\Toasty\state.bin). Readers take consistent snapshots without
+// locking (seqlock); writers serialize on a FileLock and only touch the mapping when a
+// value actually changes, so a normal run costs one map and no writes.
+//
+// Layout: [u32 magic][u32 version][u32 size][u32 sequence][u64 fields...], native endian.
+// A file with a different magic, version or size is reset, never misread.
+
+const uint32_t STATE_FILE_MAGIC = 0x41545354;  // "TSTA"
+const uint32_t STATE_FILE_VERSION = 1;
+const uint32_t STATE_FILE_SIZE = 256;
+
+// Snapshot of the shared state. Only u64 fields, appended at the end when the
+// format grows (with a version bump).
+struct ToastyState {
+    uint64_t registrationFingerprint = 0;  // Hash of what ensure_registered() last wrote
+    uint64_t lastUpdateCheck = 0;          // FILETIME ticks of the last update check
+    uint64_t lastConsoleWindow = 0;        // Click-to-focus target (HWND)
+    uint64_t lastNotification = 0;         // FILETIME ticks of the last toast shown
+    uint64_t notificationCount = 0;
+    uint64_t focusCount = 0;
+
+    bool operator==(const ToastyState&) const = default;
+};
+
+class StateFile {
+public:
+    // Map the state file, creating or resetting it as needed. nullptr on failure.
+    static std::unique_ptr<StateFile> open(const std::filesystem::path& path);
+    ~StateFile();
+
+    StateFile(const StateFile&) = delete;
+    StateFile& operator=(const StateFile&) = delete;
+
+    // Lock-free consistent snapshot
+    ToastyState read() const;
+
+    // Apply a change under the writer lock. Nothing is written if mutate leaves the
+    // state unchanged. Returns false if the lock could not be taken.
+    bool update(const std::function<void(ToastyState&)>& mutate);
+
+    // Seqlock counter (even when idle); advances by two per committed write
+    uint32_t sequence() const;
+
+private:
+    StateFile() = default;
+    bool map(const std::filesystem::path& path);
+    void validate();
+    ToastyState load_fields() const;
+    void store_fields(const ToastyState& state);
+
+    std::filesystem::path lockPath;
+    unsigned char* view = nullptr;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
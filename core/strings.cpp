@@ -0,0 +1,317 @@
+#include "core/strings.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cwctype>
+#include <fstream>
+#include <iterator>
+
+#include "core/char_scan.h"
+
+namespace {
+
+const char32_t REPLACEMENT_CHAR = 0xFFFD;
+
+void append_utf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+void append_wide(std::wstring& out, char32_t cp) {
+    if constexpr (sizeof(wchar_t) == 2) {
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out += static_cast<wchar_t>(0xD800 | (cp >> 10));
+            out += static_cast<wchar_t>(0xDC00 | (cp & 0x3FF));
+            return;
+        }
+    }
+    out += static_cast<wchar_t>(cp);
+}
+
+// Decode one UTF-8 sequence at text[i], advancing i. Invalid or truncated sequences
+// (including overlongs and encoded surrogates) consume one byte and yield U+FFFD.
+char32_t decode_utf8(std::string_view text, size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    if (lead < 0x80) {
+        i++;
+        return lead;
+    }
+
+    size_t length;
+    char32_t cp;
+    char32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2; cp = lead & 0x1F; minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3; cp = lead & 0x0F; minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4; cp = lead & 0x07; minimum = 0x10000;
+    } else {
+        i++;
+        return REPLACEMENT_CHAR;
+    }
+
+    if (i + length > text.size()) {
+        i++;
+        return REPLACEMENT_CHAR;
+    }
+    for (size_t k = 1; k < length; k++) {
+        unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xC0) != 0x80) {
+            i++;
+            return REPLACEMENT_CHAR;
+        }
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    if (cp < minimum || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        i++;
+        return REPLACEMENT_CHAR;
+    }
+    i += length;
+    return cp;
+}
+
+// Parse a leading (optionally signed) decimal integer, as std::stoi would
+bool parse_leading_int(std::wstring_view text, int& value) {
+    size_t i = 0;
+    while (i < text.size() && iswspace(text[i])) i++;
+    bool negative = false;
+    if (i < text.size() && (text[i] == L'-' || text[i] == L'+')) {
+        negative = text[i] == L'-';
+        i++;
+    }
+    size_t start = i;
+    long long result = 0;
+    while (i < text.size() && text[i] >= L'0' && text[i] <= L'9') {
+        result = result * 10 + (text[i] - L'0');
+        if (result > INT_MAX) return false;
+        i++;
+    }
+    if (i == start) return false;
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+const CharSet XML_SPECIALS = {{'&', '<', '>', '"', '\''}, 5, false};
+const CharSet JSON_SPECIALS = {{'\\', '"', '\n', '\r', '\t'}, 5, false};
+
+std::string_view xml_entity(uint32_t c) {
+    switch (c) {
+        case '&':  return "&amp;";
+        case '<':  return "&lt;";
+        case '>':  return "&gt;";
+        case '"':  return "&quot;";
+        default:   return "&apos;";
+    }
+}
+
+std::string_view json_escape(uint32_t c) {
+    switch (c) {
+        case '\\': return "\\\\";
+        case '"':  return "\\\"";
+        case '\n': return "\\n";
+        case '\r': return "\\r";
+        default:   return "\\t";
+    }
+}
+
+// Copy text to out, replacing each character in set (the first at index first) with
+// its escape. The clean runs between special characters are appended in bulk.
+template <typename Char, typename Escape>
+void append_escaped(std::basic_string<Char>& out, std::basic_string_view<Char> text, const CharSet& set,
+                    Escape escape, size_t first) {
+    size_t runStart = 0;
+    for (size_t i = first; i < text.size(); i = find_first_in_set(text, set, runStart)) {
+        out.append(text.data() + runStart, i - runStart);
+        for (char e : escape(static_cast<uint32_t>(text[i]))) out += static_cast<Char>(e);
+        runStart = i + 1;
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+}
+
+template <typename Char, typename Escape>
+std::basic_string<Char> escape_impl(std::basic_string_view<Char> text, const CharSet& set, Escape escape) {
+    size_t first = find_first_in_set(text, set);
+    if (first == text.size()) return std::basic_string<Char>(text);
+
+    // Room for a few escapes per line of text; longer outputs grow as usual
+    std::basic_string<Char> result;
+    result.reserve(text.size() + text.size() / 8 + 16);
+    append_escaped(result, text, set, escape, first);
+    return result;
+}
+
+template <typename Char, typename Escape>
+bool escape_in_place_impl(std::basic_string<Char>& text, const CharSet& set, Escape escape) {
+    std::basic_string_view<Char> view(text);
+    size_t first = find_first_in_set(view, set);
+    if (first == view.size()) return false;
+
+    std::basic_string<Char> result;
+    result.reserve(text.size() + text.size() / 8 + 16);
+    append_escaped(result, view, set, escape, first);
+    text = std::move(result);
+    return true;
+}
+
+template <typename Char>
+std::basic_string<Char> normalize_path_impl(std::basic_string_view<Char> path) {
+    std::basic_string<Char> result(path);
+    std::replace(result.begin(), result.end(), Char('\\'), Char('/'));
+    return result;
+}
+
+}  // namespace
+
+std::string to_utf8(std::wstring_view text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        char32_t cp = static_cast<char32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text.size() &&
+                text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (static_cast<char32_t>(text[i + 1]) - 0xDC00);
+                i++;
+            }
+        }
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) cp = REPLACEMENT_CHAR;
+        append_utf8(result, cp);
+    }
+    return result;
+}
+
+std::wstring from_utf8(std::string_view text) {
+    std::wstring result;
+    result.reserve(text.size());
+    size_t i = 0;
+    while (i < text.size()) {
+        append_wide(result, decode_utf8(text, i));
+    }
+    return result;
+}
+
+std::wstring to_lower(std::wstring str) {
+    for (auto& c : str) c = towlower(c);
+    return str;
+}
+
+std::string to_lower_ascii(std::string_view text) {
+    std::string lower(text);
+    for (char& c : lower) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return lower;
+}
+
+bool equals_ignore_case(std::wstring_view a, std::wstring_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (towlower(a[i]) != towlower(b[i])) return false;
+    }
+    return true;
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        unsigned char x = static_cast<unsigned char>(a[i]);
+        unsigned char y = static_cast<unsigned char>(b[i]);
+        if (x >= 'A' && x <= 'Z') x = static_cast<unsigned char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<unsigned char>(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+std::wstring escape_xml(std::wstring_view text) { return escape_impl(text, XML_SPECIALS, xml_entity); }
+std::string escape_xml(std::string_view text) { return escape_impl(text, XML_SPECIALS, xml_entity); }
+
+bool escape_xml_in_place(std::wstring& text) { return escape_in_place_impl(text, XML_SPECIALS, xml_entity); }
+bool escape_xml_in_place(std::string& text) { return escape_in_place_impl(text, XML_SPECIALS, xml_entity); }
+
+void append_xml_escaped(std::wstring& out, std::wstring_view text) {
+    append_escaped(out, text, XML_SPECIALS, xml_entity, find_first_in_set(text, XML_SPECIALS));
+}
+
+void append_xml_escaped(std::string& out, std::string_view text) {
+    append_escaped(out, text, XML_SPECIALS, xml_entity, find_first_in_set(text, XML_SPECIALS));
+}
+
+std::wstring escape_json_string(std::wstring_view text) { return escape_impl(text, JSON_SPECIALS, json_escape); }
+std::string escape_json_string(std::string_view text) { return escape_impl(text, JSON_SPECIALS, json_escape); }
+
+bool escape_json_string_in_place(std::wstring& text) { return escape_in_place_impl(text, JSON_SPECIALS, json_escape); }
+bool escape_json_string_in_place(std::string& text) { return escape_in_place_impl(text, JSON_SPECIALS, json_escape); }
+
+std::wstring normalize_path_for_shell(std::wstring_view path) { return normalize_path_impl(path); }
+std::string normalize_path_for_shell(std::string_view path) { return normalize_path_impl(path); }
+
+bool is_newer_version(std::wstring_view localVersion, std::wstring_view remoteVersion) {
+    // Parse major.minor after an optional leading 'v'; unparsable parts count as 0
+    auto parse = [](std::wstring_view v, int& major, int& minor) {
+        major = 0; minor = 0;
+        if (!v.empty() && (v[0] == L'v' || v[0] == L'V')) v.remove_prefix(1);
+        size_t dot = v.find(L'.');
+        if (parse_leading_int(v.substr(0, dot), major) && dot != std::wstring_view::npos) {
+            parse_leading_int(v.substr(dot + 1), minor);
+        }
+    };
+
+    int localMajor, localMinor, remoteMajor, remoteMinor;
+    parse(localVersion, localMajor, localMinor);
+    parse(remoteVersion, remoteMajor, remoteMinor);
+
+    if (remoteMajor > localMajor) return true;
+    if (remoteMajor == localMajor && remoteMinor > localMinor) return true;
+    return false;
+}
+
+uint64_t fnv1a_64(std::string_view bytes, uint64_t hash) {
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint32_t fnv1a_32(std::string_view bytes) {
+    uint32_t hash = 0x811c9dc5u;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+std::string path_key(const std::filesystem::path& path) {
+    std::u8string text = path.generic_u8string();
+    std::string key(text.begin(), text.end());
+#ifdef _WIN32
+    key = to_lower_ascii(key);
+#endif
+    return key;
+}
+
+std::string read_file_bytes(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return "";
+    }
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
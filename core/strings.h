@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Text helpers shared by the CLIs. Wide strings are UTF-16 on Windows and UTF-32
+// elsewhere; narrow strings are UTF-8.
+
+// UTF-8 <-> wide. Malformed input (bad UTF-8, lone surrogates) becomes U+FFFD.
+std::string to_utf8(std::wstring_view text);
+std::wstring from_utf8(std::string_view text);
+
+std::wstring to_lower(std::wstring str);
+
+// Lowercase A-Z only; other bytes, UTF-8 sequences included, pass through
+std::string to_lower_ascii(std::string_view text);
+
+// Case-insensitive comparison without allocating; the narrow form folds ASCII only
+// (header names, schemes)
+bool equals_ignore_case(std::wstring_view a, std::wstring_view b);
+bool equals_ignore_case(std::string_view a, std::string_view b);
+
+// Escape & < > " ' for XML text and attribute values. The _in_place forms return
+// false without touching (or allocating for) text that has nothing to escape;
+// append_xml_escaped writes straight into a document being built.
+std::wstring escape_xml(std::wstring_view text);
+std::string escape_xml(std::string_view text);
+bool escape_xml_in_place(std::wstring& text);
+bool escape_xml_in_place(std::string& text);
+void append_xml_escaped(std::wstring& out, std::wstring_view text);
+void append_xml_escaped(std::string& out, std::string_view text);
+
+// Escape backslashes, quotes, \n, \r and \t for JSON strings
+std::wstring escape_json_string(std::wstring_view text);
+std::string escape_json_string(std::string_view text);
+bool escape_json_string_in_place(std::wstring& text);
+bool escape_json_string_in_place(std::string& text);
+
+// Convert backslashes to forward slashes for cross-shell compatibility.
+// Claude Code and Gemini CLI execute hook commands via bash (Git Bash / MSYS2
+// on Windows). Unquoted backslashes in bash are escape characters, so a path
+// like D:\app\toasty\toasty.exe is mangled to D:apptoastytoasty.exe.
+// Forward slashes are accepted by Windows APIs and safe in bash.
+std::wstring normalize_path_for_shell(std::wstring_view path);
+std::string normalize_path_for_shell(std::string_view path);
+
+// 64-bit FNV-1a, for content hashes and cache keys. Pass a previous result as hash
+// to continue over several pieces.
+const uint64_t FNV1A_64_OFFSET = 0xcbf29ce484222325ULL;
+uint64_t fnv1a_64(std::string_view bytes, uint64_t hash = FNV1A_64_OFFSET);
+
+// 32-bit FNV-1a, for record checksums and small filters
+uint32_t fnv1a_32(std::string_view bytes);
+
+// A path's generic UTF-8 form, for map and hash keys. ASCII case is folded on
+// Windows, where paths are case-insensitive.
+std::string path_key(const std::filesystem::path& path);
+
+// A whole file's bytes; empty if it is missing or can't be read
+std::string read_file_bytes(const std::filesystem::path& path);
+
+// Compare major.minor version strings ("0.3" vs "v0.4"); true if remoteVersion is newer
+bool is_newer_version(std::wstring_view localVersion, std::wstring_view remoteVersion);
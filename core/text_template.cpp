@@ -0,0 +1,215 @@
+#include "core/text_template.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+struct SlotName {
+    const char* name;
+    TemplateField field;
+    bool allowsBasename;
+};
+
+const SlotName SLOT_NAMES[] = {
+    { "preset",   TemplateField::Preset,   false },
+    { "cwd",      TemplateField::Cwd,      true },
+    { "repo",     TemplateField::Repo,     true },
+    { "branch",   TemplateField::Branch,   false },
+    { "event",    TemplateField::Event,    false },
+    { "session",  TemplateField::Session,  false },
+    { "message",  TemplateField::Message,  false },
+    { "duration", TemplateField::Duration, false },
+    { "env",      TemplateField::Env,      false },
+};
+
+// Last path component, ignoring trailing separators ("C:\src\toasty\" -> "toasty")
+std::string_view path_basename(std::string_view path) {
+    while (path.size() > 1 && (path.back() == '/' || path.back() == '\\')) path.remove_suffix(1);
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+std::string to_string(const std::filesystem::path& path) {
+    std::u8string text = path.u8string();
+    return std::string(text.begin(), text.end());
+}
+
+bool read_first_line(const std::filesystem::path& path, std::string& line) {
+    std::ifstream file(path);
+    if (!std::getline(file, line)) return false;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    return true;
+}
+
+}  // namespace
+
+TextTemplate TextTemplate::compile(std::string_view text) {
+    TextTemplate compiled;
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t brace = text.find_first_of("{}", i);
+        if (brace == std::string_view::npos) {
+            compiled.add_literal(text.substr(i));
+            break;
+        }
+        compiled.add_literal(text.substr(i, brace - i));
+        i = brace;
+
+        // {{ and }} escape a brace
+        if (i + 1 < text.size() && text[i + 1] == text[i]) {
+            compiled.add_literal(text.substr(i, 1));
+            i += 2;
+            continue;
+        }
+        size_t close = text[i] == '{' ? text.find_first_of("{}", i + 1) : std::string_view::npos;
+        if (close == std::string_view::npos || text[close] == '{') {
+            compiled.add_literal(text.substr(i, 1));
+            i++;
+            continue;
+        }
+
+        std::string_view inside = text.substr(i + 1, close - i - 1);
+        size_t colon = inside.find(':');
+        std::string_view name = inside.substr(0, colon);
+        std::string_view arg = colon == std::string_view::npos ? std::string_view() : inside.substr(colon + 1);
+
+        const SlotName* slot = nullptr;
+        for (const auto& candidate : SLOT_NAMES) {
+            if (name == candidate.name) {
+                slot = &candidate;
+                break;
+            }
+        }
+
+        Op op;
+        bool valid = slot != nullptr;
+        if (valid && slot->field == TemplateField::Env) {
+            valid = !arg.empty() && arg.find_first_of("{} ") == std::string_view::npos;
+            op.offset = static_cast<uint32_t>(compiled.pool.size());
+            op.length = static_cast<uint32_t>(arg.size());
+        } else if (valid && colon != std::string_view::npos) {
+            valid = slot->allowsBasename && arg == "basename";
+            op.basename = true;
+        }
+        if (!valid) {
+            // Not a slot: keep "{...}" as written
+            compiled.add_literal(text.substr(i, close - i + 1));
+            i = close + 1;
+            continue;
+        }
+
+        if (slot->field == TemplateField::Env) compiled.pool.append(arg);
+        op.field = slot->field;
+        compiled.ops.push_back(op);
+        compiled.fieldMask |= 1u << static_cast<unsigned>(slot->field);
+        i = close + 1;
+    }
+    return compiled;
+}
+
+void TextTemplate::add_literal(std::string_view text) {
+    if (text.empty()) return;
+    // Extend the previous literal when it ends the pool, so runs stay one op
+    if (!ops.empty() && ops.back().field == TemplateField::Count &&
+        ops.back().offset + ops.back().length == pool.size()) {
+        ops.back().length += static_cast<uint32_t>(text.size());
+    } else {
+        Op op;
+        op.offset = static_cast<uint32_t>(pool.size());
+        op.length = static_cast<uint32_t>(text.size());
+        ops.push_back(op);
+    }
+    pool.append(text);
+}
+
+std::vector<std::string_view> TextTemplate::env_names() const {
+    std::vector<std::string_view> names;
+    for (const auto& op : ops) {
+        if (op.field == TemplateField::Env) names.push_back(std::string_view(pool).substr(op.offset, op.length));
+    }
+    return names;
+}
+
+std::string_view TextTemplate::resolve(const Op& op, const TemplateValues& values) const {
+    if (op.field == TemplateField::Count) {
+        return std::string_view(pool).substr(op.offset, op.length);
+    }
+    if (op.field == TemplateField::Env) {
+        std::string_view name = std::string_view(pool).substr(op.offset, op.length);
+        for (const auto& entry : values.env) {
+            if (entry.first == name) return entry.second;
+        }
+        return std::string_view();
+    }
+    std::string_view value = values[op.field];
+    return op.basename ? path_basename(value) : value;
+}
+
+std::string TextTemplate::render(const TemplateValues& values) const {
+    size_t size = 0;
+    for (const auto& op : ops) size += resolve(op, values).size();
+
+    std::string out;
+    out.reserve(size);
+    for (const auto& op : ops) out.append(resolve(op, values));
+    return out;
+}
+
+std::string format_duration(int64_t ms) {
+    if (ms < 0) return std::string();
+    int64_t seconds = ms / 1000;
+    char text[32];
+    if (seconds < 60) {
+        std::snprintf(text, sizeof(text), "%llds", static_cast<long long>(seconds));
+    } else if (seconds < 3600) {
+        std::snprintf(text, sizeof(text), "%lldm %02llds", static_cast<long long>(seconds / 60),
+                      static_cast<long long>(seconds % 60));
+    } else {
+        std::snprintf(text, sizeof(text), "%lldh %02lldm", static_cast<long long>(seconds / 3600),
+                      static_cast<long long>(seconds / 60 % 60));
+    }
+    return text;
+}
+
+bool read_git_context(const std::filesystem::path& dir, std::string& repoRoot, std::string& branch) {
+    repoRoot.clear();
+    branch.clear();
+    std::error_code ec;
+    std::filesystem::path current = std::filesystem::absolute(dir, ec);
+    if (ec) return false;
+
+    for (;;) {
+        std::filesystem::path dotGit = current / ".git";
+        std::filesystem::path gitDir;
+        if (std::filesystem::is_directory(dotGit, ec)) {
+            gitDir = dotGit;
+        } else if (std::filesystem::is_regular_file(dotGit, ec)) {
+            // Worktrees and submodules: ".git" is a file holding "gitdir: <path>"
+            std::string line;
+            if (read_first_line(dotGit, line) && line.rfind("gitdir: ", 0) == 0) {
+                gitDir = std::filesystem::path(std::u8string(line.begin() + 8, line.end()));
+                if (gitDir.is_relative()) gitDir = current / gitDir;
+            }
+        }
+
+        if (!gitDir.empty()) {
+            repoRoot = to_string(current);
+            std::string head;
+            if (read_first_line(gitDir / "HEAD", head)) {
+                if (head.rfind("ref: refs/heads/", 0) == 0) {
+                    branch = head.substr(16);
+                } else if (head.rfind("ref: ", 0) == 0) {
+                    branch = head.substr(5);
+                } else {
+                    branch = head.substr(0, 7);  // Detached HEAD
+                }
+            }
+            return true;
+        }
+
+        std::filesystem::path parent = current.parent_path();
+        if (parent.empty() || parent == current) return false;
+        current = parent;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Title/message templates such as "{preset}: {cwd:basename} finished in {duration}".
+// A template is compiled once into a flat list of literal and slot ops; rendering
+// sizes the result first and then fills it, so it costs a single allocation. Only the
+// fields a template uses need to be resolved (uses()), which keeps git lookups and
+// process walks off the path of plain messages.
+//
+// Slots: {preset} {cwd} {repo} {branch} {event} {session} {message} {duration} and
+// {env:NAME}; {cwd:basename} and {repo:basename} keep the last path component. {{ and
+// }} are literal braces. Anything else in braces is kept as written, so ordinary text
+// with braces is never mangled.
+
+enum class TemplateField : uint8_t {
+    Preset,     // Preset title, e.g. "Claude"
+    Cwd,        // Working directory (hook payload, else the process)
+    Repo,       // Root of the enclosing git work tree
+    Branch,     // Current git branch, or a short commit id when detached
+    Event,      // Hook event name
+    Session,    // Agent session id
+    Message,    // First line of the agent's last message
+    Duration,   // How long the agent has been running, e.g. "4m 05s"
+    Env,        // Environment variable named by the slot
+    Count
+};
+
+// Resolved field values, UTF-8. Env holds (name, value) pairs for env_names().
+struct TemplateValues {
+    std::string fields[static_cast<size_t>(TemplateField::Count)];
+    std::vector<std::pair<std::string, std::string>> env;
+
+    std::string& operator[](TemplateField field) { return fields[static_cast<size_t>(field)]; }
+    const std::string& operator[](TemplateField field) const { return fields[static_cast<size_t>(field)]; }
+};
+
+class TextTemplate {
+public:
+    TextTemplate() = default;
+    static TextTemplate compile(std::string_view text);
+
+    // True when there are no slots: render() would return the text unchanged
+    bool is_literal() const { return fieldMask == 0; }
+    bool uses(TemplateField field) const { return (fieldMask >> static_cast<unsigned>(field)) & 1; }
+
+    // Variables referenced by {env:NAME} slots, in order of appearance
+    std::vector<std::string_view> env_names() const;
+
+    std::string render(const TemplateValues& values) const;
+
+private:
+    struct Op {
+        TemplateField field = TemplateField::Count;  // Count marks a literal
+        bool basename = false;
+        uint32_t offset = 0;   // Literal text, or the env name, in pool
+        uint32_t length = 0;
+    };
+
+    void add_literal(std::string_view text);
+    std::string_view resolve(const Op& op, const TemplateValues& values) const;
+
+    std::string pool;
+    std::vector<Op> ops;
+    uint32_t fieldMask = 0;
+};
+
+// "42s", "3m 05s", "1h 02m"; empty for negative durations
+std::string format_duration(int64_t ms);
+
+// Find the git work tree containing dir (walking up to the root) and read its HEAD.
+// Reads files only; never runs git. Returns false outside a repository.
+bool read_git_context(const std::filesystem::path& dir, std::string& repoRoot, std::string& branch);
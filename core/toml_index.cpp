@@ -0,0 +1,145 @@
+#include "core/toml_index.h"
+
+#include <array>
+
+namespace {
+
+// Everything that can change how a value continues: strings, brackets, comments
+// and the newline that may end it. Values are short, so a table lookup per byte
+// beats setting up a vector search for each one.
+constexpr std::array<bool, 256> VALUE_STOPS = [] {
+    std::array<bool, 256> stops{};
+    for (unsigned char c : {'"', '\'', '[', ']', '{', '}', '#', '\n'}) stops[c] = true;
+    return stops;
+}();
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && is_blank(text.front())) text.remove_prefix(1);
+    while (!text.empty() && is_blank(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+size_t next_line(std::string_view text, size_t pos) {
+    size_t newline = text.find('\n', pos);
+    return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+// Past the string whose opening quote is at pos. A single-line string that is not
+// closed ends at the newline; a multi-line one at the end of the text.
+size_t skip_string(std::string_view text, size_t pos) {
+    char quote = text[pos];
+    bool basic = quote == '"';
+    if (text.substr(pos, 3) == (basic ? "\"\"\"" : "'''")) {
+        std::string_view delimiter = text.substr(pos, 3);
+        pos += 3;
+        for (;;) {
+            size_t close = text.find(delimiter, pos);
+            if (close == std::string_view::npos) return text.size();
+            size_t backslashes = 0;
+            while (basic && close - backslashes > pos && text[close - backslashes - 1] == '\\') backslashes++;
+            if (backslashes % 2 == 1) {
+                pos = close + 1;
+                continue;
+            }
+            // Up to two more quotes belong to the content ("""a"""" is a" + ")
+            close += 3;
+            for (int extra = 0; extra < 2 && close < text.size() && text[close] == quote; extra++) close++;
+            return close;
+        }
+    }
+
+    for (pos++; pos < text.size(); pos++) {
+        char c = text[pos];
+        if (c == '\n') return pos;
+        if (c == quote) return pos + 1;
+        if (c == '\\' && basic) pos++;
+    }
+    return text.size();
+}
+
+// Past the newline that ends the value starting at pos
+size_t skip_value(std::string_view text, size_t pos) {
+    int depth = 0;
+    for (;;) {
+        while (pos < text.size() && !VALUE_STOPS[static_cast<unsigned char>(text[pos])]) pos++;
+        if (pos >= text.size()) return text.size();
+        switch (text[pos]) {
+            case '"':
+            case '\'':
+                pos = skip_string(text, pos);
+                break;
+            case '[':
+            case '{':
+                depth++;
+                pos++;
+                break;
+            case ']':
+            case '}':
+                if (depth > 0) depth--;
+                pos++;
+                break;
+            case '#': {
+                size_t newline = text.find('\n', pos);
+                if (newline == std::string_view::npos) return text.size();
+                pos = newline;
+                break;
+            }
+            default:  // '\n'
+                if (depth == 0) return pos + 1;
+                pos++;
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+TomlIndex index_toml(std::string_view text, std::string_view tableKey) {
+    TomlIndex index;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t lineStart = pos;
+        while (pos < text.size() && is_blank(text[pos])) pos++;
+        if (pos >= text.size()) break;
+
+        char c = text[pos];
+        if (c == '\n' || c == '#') {
+            pos = next_line(text, pos);
+            continue;
+        }
+
+        if (c == '[') {
+            // [table] or [[array.of.tables]]
+            size_t nameStart = pos + (text.substr(pos, 2) == "[[" ? 2 : 1);
+            size_t lineEnd = next_line(text, pos);
+            size_t nameEnd = text.substr(0, lineEnd).find(']', nameStart);
+            if (nameEnd == std::string_view::npos) nameEnd = lineEnd;
+            index.tables.push_back({trim(text.substr(nameStart, nameEnd - nameStart)), lineStart});
+            pos = lineEnd;
+            continue;
+        }
+
+        // key = value; quoted key parts may contain '='
+        size_t keyStart = pos;
+        while (pos < text.size() && text[pos] != '=' && text[pos] != '\n') {
+            pos = text[pos] == '"' || text[pos] == '\'' ? skip_string(text, pos) : pos + 1;
+        }
+        if (pos >= text.size() || text[pos] != '=') {
+            pos = next_line(text, pos);  // Not TOML; skipped
+            continue;
+        }
+        std::string_view name = trim(text.substr(keyStart, pos - keyStart));
+        size_t end = skip_value(text, pos + 1);
+        if (index.tables.empty()) {
+            index.keys.push_back({name, lineStart, end, TOML_TOP_LEVEL});
+        } else if (name == tableKey) {
+            index.keys.push_back({name, lineStart, end, index.tables.size() - 1});
+        }
+        pos = end;
+    }
+    return index;
+}
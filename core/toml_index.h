@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Line-level index of a TOML document, built in one pass over a string_view without
+// copying: where each table header starts and the byte span of each top-level
+// key/value line. Values are followed across lines (multi-line strings, arrays and inline
+// tables), so a '[' inside a value is never taken for a table and a key's span covers
+// its whole value. Values themselves are not parsed; edits splice whole spans.
+
+struct TomlTable {
+    std::string_view name;     // Between the brackets, trimmed ("mcp_servers.github")
+    size_t begin;              // Start of the header line
+};
+
+struct TomlKey {
+    std::string_view name;     // As written, dotted or quoted keys included
+    size_t begin;              // Start of the key's line, indentation included
+    size_t end;                // Past the newline ending its value (or the text end)
+    size_t table;              // Index into TomlIndex::tables, TOML_TOP_LEVEL before any
+};
+
+const size_t TOML_TOP_LEVEL = static_cast<size_t>(-1);
+
+struct TomlIndex {
+    std::vector<TomlTable> tables;
+    std::vector<TomlKey> keys;
+};
+
+// Keys inside tables are only recorded when named tableKey (configs can hold
+// thousands of them, and edits only care about one name)
+TomlIndex index_toml(std::string_view text, std::string_view tableKey = {});
@@ -0,0 +1,4 @@
+#pragma once
+
+// Release version, shared by both CLIs and the HTTP user agent
+#define TOASTY_VERSION_TEXT "0.7"
@@ -6,33 +6,57 @@
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Data.Xml.Dom.h>
-#include <winrt/Windows.Data.Json.h>
 #include <winrt/Windows.UI.Notifications.h>
 #include <winrt/Windows.Storage.h>
 #include <iostream>
 #include <string>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <tlhelp32.h>
-#include <winhttp.h>
 #include "resource.h"
+#include "core/coalesce.h"
+#include "core/history_log.h"
+#include "core/hook_config.h"
+#include "core/install_manifest.h"
+#include "core/http.h"
+#include "core/ipc.h"
+#include "core/json.h"
+#include "core/ntfy.h"
+#include "core/payload.h"
+#include "core/platform.h"
+#include "core/presets.h"
+#include "core/rate_limit.h"
+#include "core/release_check.h"
+#include "core/repo_walker.h"
+#include "core/sanitize.h"
+#include "core/sinks.h"
+#include "core/state_file.h"
+#include "core/strings.h"
+#include "core/text_template.h"
+#include "core/version.h"
 
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "ole32.lib")
-#pragma comment(lib, "winhttp.lib")
 
 using namespace winrt;
 using namespace Windows::Data::Xml::Dom;
-using namespace Windows::Data::Json;
 using namespace Windows::UI::Notifications;
 namespace fs = std::filesystem;
 
 const wchar_t* APP_ID = L"Toasty.CLI.Notification";
 const wchar_t* APP_NAME = L"Toasty";
 const wchar_t* PROTOCOL_NAME = L"toasty";
-const wchar_t* TOASTY_VERSION = L"0.7";
+const wchar_t* TOASTY_VERSION = L"" TOASTY_VERSION_TEXT;
 
 // Global flags
 bool g_dryRun = false;
@@ -46,22 +70,58 @@ struct HandleGuard {
     bool valid() const { return h && h != INVALID_HANDLE_VALUE; }
 };
 
-struct AppPreset {
-    std::wstring name;
-    std::wstring title;
-    int iconResourceId;
-};
+// Directory for toasty's per-user state and caches (%LOCALAPPDATA%\Toasty).
+// Not created here; writers create what they need so read-only paths stay cheap.
+const std::wstring& get_toasty_data_dir() {
+    static const std::wstring dir = []() -> std::wstring {
+        wchar_t localAppData[MAX_PATH];
+        if (FAILED(SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA, nullptr, 0, localAppData))) {
+            return L"";
+        }
+        return std::wstring(localAppData) + L"\\" + APP_NAME;
+    }();
+    return dir;
+}
 
-const AppPreset APP_PRESETS[] = {
-    { L"claude", L"Claude", IDI_CLAUDE },
-    { L"copilot", L"GitHub Copilot", IDI_COPILOT },
-    { L"gemini", L"Gemini", IDI_GEMINI },
-    { L"codex", L"Codex", IDI_CODEX },
-    { L"cursor", L"Cursor", IDI_CURSOR }
-};
+// Shared per-user state (%LOCALAPPDATA%\Toasty\state.bin): registration fingerprint,
+// update-check throttle, click-to-focus target and counters. Mapped once per process;
+// nullptr if the data directory is unavailable.
+StateFile* get_state_file() {
+    static std::unique_ptr<StateFile> state = []() -> std::unique_ptr<StateFile> {
+        const std::wstring& dataDir = get_toasty_data_dir();
+        if (dataDir.empty()) {
+            return nullptr;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(dataDir, ec);
+        return StateFile::open(std::filesystem::path(dataDir) / L"state.bin");
+    }();
+    return state.get();
+}
+
+// What toasty last recorded about each hook config (%LOCALAPPDATA%\Toasty\hooks.manifest,
+// see core/install_manifest.h). Loaded once per process; saved by the commands that use it.
+InstallManifest& get_install_manifest() {
+    static InstallManifest manifest = []() {
+        const std::wstring& dataDir = get_toasty_data_dir();
+        return InstallManifest::load(dataDir.empty() ? std::filesystem::path()
+                                                     : std::filesystem::path(dataDir) / L"hooks.manifest");
+    }();
+    return manifest;
+}
 
-// Extract embedded PNG resource to temp file and return path
-std::wstring extract_icon_to_temp(int resourceId) {
+void save_install_manifest() {
+    std::string error;
+    if (!get_install_manifest().save(error)) {
+        std::wcerr << L"Warning: Could not save " << get_install_manifest().path().wstring() << L": "
+                   << from_utf8(error) << L"\n";
+    }
+}
+
+// Return the path of an embedded PNG resource in the icon cache, writing it on first use.
+// Files live under %LOCALAPPDATA%\Toasty\icons\<version>\ and are named by content hash,
+// so each icon is written once per binary version and a cache hit costs a single stat.
+std::wstring extract_icon_to_cache(int resourceId) {
     HRSRC hResource = FindResourceW(nullptr, MAKEINTRESOURCEW(resourceId), MAKEINTRESOURCEW(10));
     if (!hResource) return L"";
     
@@ -74,51 +134,68 @@ std::wstring extract_icon_to_temp(int resourceId) {
     DWORD resourceSize = SizeofResource(nullptr, hResource);
     if (resourceSize == 0) return L"";
     
-    // Create temp file path using std::filesystem
-    wchar_t tempPathBuffer[MAX_PATH];
-    GetTempPathW(MAX_PATH, tempPathBuffer);
-    
-    std::filesystem::path tempPath(tempPathBuffer);
-    std::wstring fileName = L"toasty_icon_" + std::to_wstring(resourceId) + L".png";
-    tempPath /= fileName;
-    
-    // Write resource data to temp file
+    const std::wstring& dataDir = get_toasty_data_dir();
+    if (dataDir.empty()) return L"";
+
+    wchar_t hashHex[17];
+    swprintf_s(hashHex, L"%016llx",
+               static_cast<unsigned long long>(fnv1a_64(std::string_view(static_cast<const char*>(pLockedResource), resourceSize))));
+
+    std::filesystem::path cacheDir = std::filesystem::path(dataDir) / L"icons" / (std::wstring(L"v") + TOASTY_VERSION);
+    std::filesystem::path iconPath = cacheDir / (std::wstring(L"icon_") + std::to_wstring(resourceId) + L"_" + hashHex + L".png");
+
+    // Cache hit: the name encodes the content, so existence is enough
+    if (GetFileAttributesW(iconPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
+        return iconPath.wstring();
+    }
+
+    // Write resource data to a private temp file, then move it into place so a
+    // concurrent toasty never sees a partially written icon
     try {
-        std::ofstream file(tempPath, std::ios::binary);
-        if (!file) return L"";
-        
-        file.write(static_cast<const char*>(pLockedResource), resourceSize);
-        file.close();
-        
-        if (file.fail()) return L"";
-        
-        return tempPath.wstring();
+        std::filesystem::create_directories(cacheDir);
+
+        std::filesystem::path tempPath = iconPath;
+        tempPath += L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary);
+            if (!file) return L"";
+
+            file.write(static_cast<const char*>(pLockedResource), resourceSize);
+            file.close();
+
+            if (file.fail()) {
+                DeleteFileW(tempPath.c_str());
+                return L"";
+            }
+        }
+
+        if (!MoveFileExW(tempPath.c_str(), iconPath.c_str(), 0)) {
+            // Lost a race with another toasty (same content), or the move failed
+            DeleteFileW(tempPath.c_str());
+            if (GetFileAttributesW(iconPath.c_str()) == INVALID_FILE_ATTRIBUTES) return L"";
+        }
+
+        return iconPath.wstring();
     } catch (...) {
         // Failed to write icon file
         return L"";
     }
 }
 
-// Utility: Convert string to lowercase
-std::wstring to_lower(std::wstring str) {
-    for (auto& c : str) c = towlower(c);
-    return str;
-}
+// Get command line of a process using NtQueryInformationProcess with ProcessCommandLineInformation
+typedef NTSTATUS(NTAPI* NtQueryInformationProcessFn)(HANDLE, ULONG, PVOID, ULONG, PULONG);
 
-// Find preset by name (case-insensitive)
-const AppPreset* find_preset(const std::wstring& name) {
-    auto lowerName = to_lower(name);
-    for (const auto& preset : APP_PRESETS) {
-        if (to_lower(preset.name) == lowerName) {
-            return &preset;
+NtQueryInformationProcessFn get_nt_query_information_process() {
+    static NtQueryInformationProcessFn NtQueryInformationProcess = nullptr;
+    if (!NtQueryInformationProcess) {
+        HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+        if (ntdll) {
+            NtQueryInformationProcess = (NtQueryInformationProcessFn)GetProcAddress(ntdll, "NtQueryInformationProcess");
         }
     }
-    return nullptr;
+    return NtQueryInformationProcess;
 }
 
-// Get command line of a process using NtQueryInformationProcess with ProcessCommandLineInformation
-typedef NTSTATUS(NTAPI* NtQueryInformationProcessFn)(HANDLE, ULONG, PVOID, ULONG, PULONG);
-
 std::wstring get_process_command_line(DWORD pid) {
     std::wstring cmdLine;
 
@@ -127,15 +204,7 @@ std::wstring get_process_command_line(DWORD pid) {
         return L"";
     }
 
-    // Get NtQueryInformationProcess
-    static NtQueryInformationProcessFn NtQueryInformationProcess = nullptr;
-    if (!NtQueryInformationProcess) {
-        HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
-        if (ntdll) {
-            NtQueryInformationProcess = (NtQueryInformationProcessFn)GetProcAddress(ntdll, "NtQueryInformationProcess");
-        }
-    }
-
+    NtQueryInformationProcessFn NtQueryInformationProcess = get_nt_query_information_process();
     if (!NtQueryInformationProcess) {
         CloseHandle(hProcess);
         return L"";
@@ -175,114 +244,395 @@ std::wstring get_process_command_line(DWORD pid) {
     return cmdLine;
 }
 
-// Check if command line contains a known CLI pattern
-const AppPreset* check_command_line_for_preset(const std::wstring& cmdLine) {
-    auto lowerCmd = to_lower(cmdLine);
+// One entry of the process table snapshot
+struct ProcessEntry {
+    DWORD parentPid = 0;
+    std::wstring exeName;               // Lowercase, without extension
+    mutable ULONGLONG creationTime = 0; // FILETIME ticks, queried lazily (0 = unknown)
+    mutable bool creationTimeQueried = false;
+};
+
+// Process table indexed by PID. Taken once per invocation and shared by every
+// ancestry walk, so each level is a hash lookup instead of a full Toolhelp scan.
+struct ProcessTable {
+    std::unordered_map<DWORD, ProcessEntry> entries;
 
-    // Check for Gemini CLI (multiple patterns)
-    if (lowerCmd.find(L"gemini-cli") != std::wstring::npos ||
-        lowerCmd.find(L"gemini\\cli") != std::wstring::npos ||
-        lowerCmd.find(L"gemini/cli") != std::wstring::npos ||
-        lowerCmd.find(L"@google\\gemini") != std::wstring::npos ||
-        lowerCmd.find(L"@google/gemini") != std::wstring::npos) {
-        return find_preset(L"gemini");
+    const ProcessEntry* find(DWORD pid) const {
+        auto it = entries.find(pid);
+        return it == entries.end() ? nullptr : &it->second;
     }
+};
 
-    // Check for Claude Code (in case it runs via Node too)
-    if (lowerCmd.find(L"claude-code") != std::wstring::npos ||
-        lowerCmd.find(L"@anthropic") != std::wstring::npos) {
-        return find_preset(L"claude");
+// Get process creation time in FILETIME ticks (0 if the process is gone or inaccessible)
+ULONGLONG get_process_creation_time(DWORD pid) {
+    HandleGuard process(OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid));
+    if (!process.valid()) {
+        return 0;
     }
 
-    // Check for Cursor
-    if (lowerCmd.find(L"cursor") != std::wstring::npos) {
-        return find_preset(L"cursor");
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(process, &creation, &exitTime, &kernel, &user)) {
+        return 0;
     }
 
-    return nullptr;
+    ULARGE_INTEGER value;
+    value.LowPart = creation.dwLowDateTime;
+    value.HighPart = creation.dwHighDateTime;
+    return value.QuadPart;
 }
 
-// Walk up process tree to find a matching AI CLI preset
-const AppPreset* detect_preset_from_ancestors(bool debug = false) {
+ULONGLONG get_creation_time(const ProcessTable& table, DWORD pid) {
+    const ProcessEntry* entry = table.find(pid);
+    if (!entry) {
+        return 0;
+    }
+    if (!entry->creationTimeQueried) {
+        entry->creationTime = get_process_creation_time(pid);
+        entry->creationTimeQueried = true;
+    }
+    return entry->creationTime;
+}
+
+// Take a single Toolhelp snapshot and index it by PID
+ProcessTable snapshot_process_table() {
+    ProcessTable table;
+
     HandleGuard snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0));
     if (!snapshot.valid()) {
-        return nullptr;
+        return table;
+    }
+
+    PROCESSENTRY32W pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32W);
+    if (Process32FirstW(snapshot, &pe32)) {
+        table.entries.reserve(1024);
+        do {
+            ProcessEntry entry;
+            entry.parentPid = pe32.th32ParentProcessID;
+
+            // Extract just the filename without extension, lowercased for matching
+            std::wstring exeName = pe32.szExeFile;
+            size_t dotPos = exeName.find_last_of(L'.');
+            if (dotPos != std::wstring::npos) {
+                exeName.resize(dotPos);
+            }
+            entry.exeName = to_lower(std::move(exeName));
+
+            table.entries.emplace(pe32.th32ProcessID, std::move(entry));
+        } while (Process32NextW(snapshot, &pe32));
     }
 
+    return table;
+}
+
+// Return the ancestors of the current process, nearest first (max 20 levels).
+// Stops at the root, at loops, and at reused PIDs: a "parent" created after its
+// child is a different process that inherited the PID of the real, exited parent.
+std::vector<DWORD> get_ancestor_pids(const ProcessTable& table) {
+    std::vector<DWORD> ancestors;
+
     DWORD currentPid = GetCurrentProcessId();
+    for (int depth = 0; depth < 20; depth++) {
+        const ProcessEntry* current = table.find(currentPid);
+        if (!current) {
+            break;
+        }
+
+        DWORD parentPid = current->parentPid;
+        if (parentPid == 0 || parentPid == currentPid || !table.find(parentPid)) {
+            break;  // Reached root, loop, or parent already exited
+        }
+
+        ULONGLONG childCreated = get_creation_time(table, currentPid);
+        ULONGLONG parentCreated = get_creation_time(table, parentPid);
+        if (childCreated != 0 && parentCreated != 0 && parentCreated > childCreated) {
+            break;  // PID reuse
+        }
+
+        ancestors.push_back(parentPid);
+        currentPid = parentPid;
+    }
+
+    return ancestors;
+}
 
+// Walk up process tree to find a matching AI CLI preset
+// matchedPid (optional) receives the ancestor that matched
+const AppPreset* detect_preset_from_ancestors(const ProcessTable& table, bool debug = false, DWORD* matchedPid = nullptr) {
     if (debug) {
-        std::wcerr << L"[DEBUG] Starting from PID: " << currentPid << L"\n";
+        std::wcerr << L"[DEBUG] Starting from PID: " << GetCurrentProcessId() << L"\n";
     }
 
-    // Walk up the process tree (max 20 levels to avoid infinite loops)
-    for (int depth = 0; depth < 20; depth++) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        DWORD parentPid = 0;
-
-        // Find current process to get parent PID
-        if (Process32FirstW(snapshot, &pe32)) {
-            do {
-                if (pe32.th32ProcessID == currentPid) {
-                    parentPid = pe32.th32ParentProcessID;
-                    break;
-                }
-            } while (Process32NextW(snapshot, &pe32));
+    std::vector<DWORD> ancestors = get_ancestor_pids(table);
+    for (size_t depth = 0; depth < ancestors.size(); depth++) {
+        DWORD pid = ancestors[depth];
+        const ProcessEntry* entry = table.find(pid);
+
+        // Get command line for this process
+        std::wstring cmdLine = get_process_command_line(pid);
+
+        if (debug) {
+            std::wcerr << L"[DEBUG] Level " << depth << L": PID=" << pid
+                       << L" Name=" << entry->exeName << L"\n";
+            std::wcerr << L"[DEBUG]   CmdLine: " << (cmdLine.empty() ? L"(empty)" : cmdLine.substr(0, 100)) << L"\n";
         }
 
-        if (parentPid == 0 || parentPid == currentPid) {
-            break;  // Reached root or loop
+        // By name, else by CLI pattern in the command line (node.exe, etc.), as on POSIX
+        if (const AppPreset* preset = match_process_preset(entry->exeName, cmdLine)) {
+            if (debug) std::wcerr << L"[DEBUG] MATCH: " << preset->name << L"\n";
+            if (matchedPid) *matchedPid = pid;
+            return preset;
         }
+    }
 
-        // Find parent process name
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        if (Process32FirstW(snapshot, &pe32)) {
-            do {
-                if (pe32.th32ProcessID == parentPid) {
-                    // Extract just the filename without extension
-                    std::wstring exeName = pe32.szExeFile;
-                    size_t dotPos = exeName.find_last_of(L'.');
-                    if (dotPos != std::wstring::npos) {
-                        exeName = exeName.substr(0, dotPos);
-                    }
+    return nullptr;
+}
 
-                    // Convert to lowercase for matching
-                    auto lowerExeName = to_lower(exeName);
+// Identity of an ancestor process. PIDs are reused, (pid, creation time) is not.
+struct AncestorKey {
+    DWORD pid;
+    ULONGLONG creationTime;
+};
 
-                    // Get command line for this process
-                    std::wstring cmdLine = get_process_command_line(parentPid);
+// Ancestry cache: remembers what the process-tree walk resolved for a given ancestor,
+// so repeated hook firings from the same agent session skip the snapshot and the
+// per-level command line queries. Entries only match while that exact process is alive.
+const DWORD ANCESTRY_CACHE_MAGIC = 0x43415454;  // "TTAC"
+const DWORD ANCESTRY_CACHE_VERSION = 2;
+const size_t ANCESTRY_CACHE_MAX_ENTRIES = 32;
+const int ANCESTRY_CACHE_MAX_DEPTH = 4;
+
+// AncestryCacheEntry::flags - which results are known for the ancestor
+const DWORD ANCESTRY_PRESET_KNOWN = 0x1;
+const DWORD ANCESTRY_WINDOW_KNOWN = 0x2;
+
+struct AncestryCacheHeader {
+    DWORD magic;
+    DWORD version;
+    DWORD count;
+};
 
-                    if (debug) {
-                        std::wcerr << L"[DEBUG] Level " << depth << L": PID=" << parentPid
-                                   << L" Name=" << exeName << L"\n";
-                        std::wcerr << L"[DEBUG]   CmdLine: " << (cmdLine.empty() ? L"(empty)" : cmdLine.substr(0, 100)) << L"\n";
-                    }
+struct AncestryCacheEntry {
+    DWORD pid;
+    DWORD flags;
+    ULONGLONG creationTime;
+    wchar_t preset[16];        // Preset name, empty if no agent was detected
+    ULONGLONG terminalWindow;  // HWND found by the ancestor walk, 0 if none
+    ULONGLONG lastUsed;        // FILETIME ticks, for eviction
+};
 
-                    // Check if this matches a preset by name
-                    const AppPreset* preset = find_preset(lowerExeName);
-                    if (preset) {
-                        if (debug) std::wcerr << L"[DEBUG] MATCH by name: " << lowerExeName << L"\n";
-                        return preset;
-                    }
+ULONGLONG get_filetime_now() {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER value;
+    value.LowPart = now.dwLowDateTime;
+    value.HighPart = now.dwHighDateTime;
+    return value.QuadPart;
+}
 
-                    // Check command line for CLI patterns (handles node.exe, etc.)
-                    preset = check_command_line_for_preset(cmdLine);
-                    if (preset) {
-                        if (debug) std::wcerr << L"[DEBUG] MATCH by cmdline\n";
-                        return preset;
-                    }
+// Milliseconds since the Unix epoch
+int64_t get_unix_time_ms() {
+    return static_cast<int64_t>(get_filetime_now() / 10000 - 11644473600000ULL);
+}
+
+// Query parent PID, creation time and (optionally) exe name of one process, without a snapshot
+bool query_process_identity(HANDLE process, DWORD& parentPid, ULONGLONG& creationTime, std::wstring* exeName) {
+    NtQueryInformationProcessFn NtQueryInformationProcess = get_nt_query_information_process();
+    if (!NtQueryInformationProcess) {
+        return false;
+    }
+
+    // ProcessBasicInformation (0)
+    struct BASIC_INFORMATION {
+        NTSTATUS ExitStatus;
+        PVOID PebBaseAddress;
+        ULONG_PTR AffinityMask;
+        LONG BasePriority;
+        ULONG_PTR UniqueProcessId;
+        ULONG_PTR InheritedFromUniqueProcessId;
+    };
+
+    BASIC_INFORMATION info = {};
+    if (NtQueryInformationProcess(process, 0, &info, sizeof(info), nullptr) != 0) {
+        return false;
+    }
+    parentPid = (DWORD)info.InheritedFromUniqueProcessId;
+
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(process, &creation, &exitTime, &kernel, &user)) {
+        return false;
+    }
+    ULARGE_INTEGER value;
+    value.LowPart = creation.dwLowDateTime;
+    value.HighPart = creation.dwHighDateTime;
+    creationTime = value.QuadPart;
+
+    if (exeName) {
+        wchar_t imagePath[MAX_PATH];
+        DWORD size = MAX_PATH;
+        if (!QueryFullProcessImageNameW(process, 0, imagePath, &size)) {
+            return false;
+        }
+        fs::path image(std::wstring(imagePath, size));
+        *exeName = to_lower(image.stem().wstring());
+    }
+
+    return true;
+}
+
+// Nearest ancestors (parent first), resolved one process at a time. Stops after an
+// ancestor whose exe name is a preset: anything above it cannot change the result.
+std::vector<AncestorKey> get_nearest_ancestor_keys() {
+    std::vector<AncestorKey> keys;
+
+    DWORD parentPid = 0;
+    ULONGLONG childCreated = 0;
+    if (!query_process_identity(GetCurrentProcess(), parentPid, childCreated, nullptr)) {
+        return keys;
+    }
+
+    for (int depth = 0; depth < ANCESTRY_CACHE_MAX_DEPTH && parentPid != 0; depth++) {
+        HandleGuard process(OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, parentPid));
+        if (!process.valid()) {
+            break;  // Exited or inaccessible
+        }
+
+        DWORD grandparentPid = 0;
+        ULONGLONG created = 0;
+        std::wstring exeName;
+        if (!query_process_identity(process, grandparentPid, created, &exeName) || created > childCreated) {
+            break;  // PID reuse
+        }
+
+        keys.push_back({ parentPid, created });
+        if (find_preset(exeName)) {
+            break;
+        }
+
+        childCreated = created;
+        parentPid = grandparentPid;
+    }
+
+    return keys;
+}
+
+std::wstring get_ancestry_cache_path() {
+    const std::wstring& dir = get_toasty_data_dir();
+    return dir.empty() ? L"" : dir + L"\\ancestry.cache";
+}
+
+std::vector<AncestryCacheEntry> read_ancestry_cache() {
+    std::vector<AncestryCacheEntry> entries;
+
+    std::wstring path = get_ancestry_cache_path();
+    if (path.empty()) return entries;
+
+    std::ifstream file(path, std::ios::binary);
+    AncestryCacheHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != ANCESTRY_CACHE_MAGIC || header.version != ANCESTRY_CACHE_VERSION ||
+        header.count > ANCESTRY_CACHE_MAX_ENTRIES) {
+        return entries;
+    }
+
+    entries.resize(header.count);
+    if (!file.read(reinterpret_cast<char*>(entries.data()), header.count * sizeof(AncestryCacheEntry))) {
+        entries.clear();
+    }
+    for (auto& entry : entries) {
+        entry.preset[15] = L'\0';
+    }
+    return entries;
+}
+
+void write_ancestry_cache(const std::vector<AncestryCacheEntry>& entries) {
+    std::wstring path = get_ancestry_cache_path();
+    if (path.empty()) return;
+    CreateDirectoryW(get_toasty_data_dir().c_str(), nullptr);  // Fails harmlessly if it exists
+
+    // Write a private temp file and swap it in, so concurrent hooks never read a torn file
+    std::wstring tempPath = path + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        AncestryCacheHeader header = { ANCESTRY_CACHE_MAGIC, ANCESTRY_CACHE_VERSION, (DWORD)entries.size() };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AncestryCacheEntry));
+        if (!file.good()) {
+            file.close();
+            DeleteFileW(tempPath.c_str());
+            return;
+        }
+    }
+    if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(tempPath.c_str());
+    }
+}
+
+// Find the nearest cached ancestor that is still alive
+bool lookup_ancestry_cache(const std::vector<AncestorKey>& keys, AncestryCacheEntry& result) {
+    if (keys.empty()) return false;
+
+    std::vector<AncestryCacheEntry> entries = read_ancestry_cache();
+    for (const auto& key : keys) {
+        for (const auto& entry : entries) {
+            if (entry.pid == key.pid && entry.creationTime == key.creationTime) {
+                result = entry;
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-                    break;
+// Record what was resolved for every ancestor on the fast path (merging with what was
+// already known), dropping entries whose process has exited and evicting the least
+// recently used beyond the cap
+void store_ancestry_cache(const std::vector<AncestorKey>& keys, const AncestryCacheEntry& resolved) {
+    if (keys.empty() || resolved.flags == 0) return;
+
+    ULONGLONG now = get_filetime_now();
+    std::vector<AncestryCacheEntry> entries;
+    std::vector<AncestryCacheEntry> previous(keys.size(), AncestryCacheEntry{});
+    for (const auto& entry : read_ancestry_cache()) {
+        bool replaced = false;
+        for (size_t k = 0; k < keys.size(); k++) {
+            if (entry.pid == keys[k].pid) {
+                if (entry.creationTime == keys[k].creationTime) {
+                    previous[k] = entry;
                 }
-            } while (Process32NextW(snapshot, &pe32));
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced && get_process_creation_time(entry.pid) == entry.creationTime) {
+            entries.push_back(entry);
         }
+    }
 
-        // Move up to parent
-        currentPid = parentPid;
+    for (size_t k = 0; k < keys.size(); k++) {
+        AncestryCacheEntry entry = previous[k];
+        entry.pid = keys[k].pid;
+        entry.creationTime = keys[k].creationTime;
+        if (resolved.flags & ANCESTRY_PRESET_KNOWN) {
+            wcsncpy_s(entry.preset, resolved.preset, _TRUNCATE);
+        }
+        if (resolved.flags & ANCESTRY_WINDOW_KNOWN) {
+            entry.terminalWindow = resolved.terminalWindow;
+        }
+        entry.flags |= resolved.flags;
+        entry.lastUsed = now;
+        entries.push_back(entry);
     }
 
-    return nullptr;
+    if (entries.size() > ANCESTRY_CACHE_MAX_ENTRIES) {
+        std::sort(entries.begin(), entries.end(), [](const AncestryCacheEntry& a, const AncestryCacheEntry& b) {
+            return a.lastUsed > b.lastUsed;
+        });
+        entries.resize(ANCESTRY_CACHE_MAX_ENTRIES);
+    }
+
+    write_ancestry_cache(entries);
 }
 
 void print_usage() {
@@ -291,21 +641,52 @@ void print_usage() {
                << L"  toasty <message> [options]\n"
                << L"  toasty --install [agent]\n"
                << L"  toasty --uninstall\n"
-               << L"  toasty --status\n\n"
+               << L"  toasty --status\n"
+               << L"  toasty --history [--since <when>] [--app <name>]\n\n"
                << L"Options:\n"
                << L"  -t, --title <text>   Set notification title (default: \"Notification\")\n"
                << L"  --app <name>         Use AI CLI preset (claude, copilot, gemini, codex, cursor)\n"
                << L"  -i, --icon <path>    Custom icon path (PNG recommended, 48x48px)\n"
+               << L"  --priority <level>   normal (default) or high; high bypasses rate limiting\n"
                << L"  -v, --version        Show version and exit\n"
                << L"  -h, --help           Show this help\n"
                << L"  --install [agent]    Install hooks for AI CLI agents (claude, gemini, copilot, codex, or all)\n"
                << L"  --uninstall          Remove hooks from all AI CLI agents\n"
-               << L"  --status             Show installation status\n"
+               << L"  --recursive <root>   With --install copilot or --uninstall: every repository under <root>\n"
+               << L"  --status [--json]    Show installation status (--json: machine-readable)\n"
+               << L"  --history            List past notifications (--json: one object per line)\n"
+               << L"  --since <when>       With --history: 30m, 2h, 7d or 2026-10-17 [13:30] (default: 1d)\n"
                << L"  --register           Re-register app for notifications (troubleshooting)\n"
+               << L"  --serve              Run a resident daemon; later toasty calls forward to it\n"
                << L"  --dry-run            Show what would happen without executing side effects\n\n"
                << L"Push Notifications:\n"
                << L"  Set TOASTY_NTFY_TOPIC to send push notifications to your phone via ntfy.sh.\n"
                << L"  Set TOASTY_NTFY_SERVER to use a self-hosted ntfy server (default: ntfy.sh).\n\n"
+               << L"Daemon:\n"
+               << L"  While 'toasty --serve' runs, notifications are shown by the daemon.\n"
+               << L"  Set TOASTY_NO_DAEMON to always show them in-process.\n\n"
+               << L"Rate Limiting:\n"
+               << L"  Each source (preset + working directory) may show 5 notifications per 30s;\n"
+               << L"  extras are dropped and counted into the next one. Override with\n"
+               << L"  TOASTY_RATE_LIMIT=<count>/<seconds>, or set it to 'off'.\n\n"
+               << L"Sinks:\n"
+               << L"  TOASTY_SINKS lists where notifications go (default: toast,ntfy), and\n"
+               << L"  TOASTY_SINKS_<PRESET> (e.g. TOASTY_SINKS_CLAUDE) overrides it per preset.\n"
+               << L"  Entries: toast, ntfy, stdout, webhook=<url>, file=<path>, each optionally\n"
+               << L"  followed by @<ms> (deadline) and ! (required) or ? (best-effort).\n\n"
+               << L"Coalescing:\n"
+               << L"  Set TOASTY_COALESCE_MS (e.g. 1500) to merge notifications that arrive within\n"
+               << L"  that window into one summary toast, such as \"3 agents finished\".\n\n"
+               << L"History:\n"
+               << L"  Every notification is recorded under %LOCALAPPDATA%\\Toasty\\history, including\n"
+               << L"  rate-limited ones and sink failures. Set TOASTY_HISTORY=off to disable.\n\n"
+               << L"Agent Payloads:\n"
+               << L"  A JSON hook event piped on stdin (Claude, Gemini, Copilot) or passed as the\n"
+               << L"  last argument (Codex notify) is read for its event, session, working\n"
+               << L"  directory and last message. With no <message>, the last message is shown.\n\n"
+               << L"Templates:\n"
+               << L"  The message and -t may use {preset} {cwd} {cwd:basename} {repo} {branch}\n"
+               << L"  {event} {session} {message} {duration} {env:NAME}; {{ and }} are braces.\n\n"
                << L"Note: Toasty auto-detects known parent processes (Claude, Copilot, etc.)\n"
                << L"      and applies the appropriate preset automatically. Use --app to override.\n\n"
                << L"Examples:\n"
@@ -313,286 +694,153 @@ void print_usage() {
                << L"  toasty \"Task done\" -t \"Custom Title\"\n"
                << L"  toasty \"Analysis complete\" --app claude\n"
                << L"  toasty --install\n"
-               << L"  toasty --status\n";
+               << L"  toasty --status\n"
+               << L"  toasty --history --since 2h --app claude\n";
 }
 
-std::wstring escape_xml(const std::wstring& text) {
-    std::wstring result;
-    result.reserve(text.size());
-    for (wchar_t c : text) {
-        switch (c) {
-            case L'&':  result += L"&amp;"; break;
-            case L'<':  result += L"&lt;"; break;
-            case L'>':  result += L"&gt;"; break;
-            case L'"':  result += L"&quot;"; break;
-            case L'\'': result += L"&apos;"; break;
-            default:    result += c; break;
-        }
-    }
-    return result;
-}
+// ntfy push target, read from TOASTY_NTFY_TOPIC / TOASTY_NTFY_SERVER
+struct NtfyConfig {
+    std::wstring server;
+    std::wstring topic;
+};
 
-// Send push notification via ntfy.sh (non-blocking, fire-and-forget)
-// Only sends if TOASTY_NTFY_TOPIC env var is set.
-// Uses TOASTY_NTFY_SERVER env var for custom server (default: ntfy.sh).
-// Timeout is aggressive (5 seconds) so it never blocks the CLI.
-void send_ntfy_notification(const std::wstring& title, const std::wstring& message) {
+// Returns false if ntfy is not configured (no topic)
+bool get_ntfy_config(NtfyConfig& config) {
     // Check for topic
     wchar_t topicBuf[256] = {};
     if (!GetEnvironmentVariableW(L"TOASTY_NTFY_TOPIC", topicBuf, 256) || topicBuf[0] == L'\0') {
-        return;  // ntfy not configured, silently skip
+        return false;
     }
-    std::wstring topic(topicBuf);
+    config.topic = topicBuf;
 
     // Check for custom server (default: ntfy.sh)
     wchar_t serverBuf[256] = {};
-    std::wstring server = L"ntfy.sh";
+    config.server = L"ntfy.sh";
     if (GetEnvironmentVariableW(L"TOASTY_NTFY_SERVER", serverBuf, 256) && serverBuf[0] != L'\0') {
-        server = serverBuf;
-    }
-
-    // Build the path: /<topic>
-    std::wstring path = L"/" + topic;
-
-    // Convert title and message to UTF-8 for HTTP body
-    std::string bodyUtf8;
-    {
-        int size = WideCharToMultiByte(CP_UTF8, 0, message.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (size > 0) {
-            bodyUtf8.resize(size - 1);
-            WideCharToMultiByte(CP_UTF8, 0, message.c_str(), -1, &bodyUtf8[0], size, nullptr, nullptr);
-        }
-    }
-    std::string titleUtf8;
-    {
-        int size = WideCharToMultiByte(CP_UTF8, 0, title.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (size > 0) {
-            titleUtf8.resize(size - 1);
-            WideCharToMultiByte(CP_UTF8, 0, title.c_str(), -1, &titleUtf8[0], size, nullptr, nullptr);
-        }
-    }
-
-    // Fire-and-forget HTTP POST with aggressive timeout
-    HINTERNET hSession = WinHttpOpen(L"Toasty/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return;
-
-    // Set timeouts: 3s resolve, 3s connect, 5s send, 5s receive
-    WinHttpSetTimeouts(hSession, 3000, 3000, 5000, 5000);
-
-    HINTERNET hConnect = WinHttpConnect(hSession, server.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        return;
-    }
-
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", path.c_str(),
-        nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return;
+        config.server = serverBuf;
     }
+    return true;
+}
 
-    // Add title header
-    std::wstring titleHeader = L"Title: " + title;
-    WinHttpAddRequestHeaders(hRequest, titleHeader.c_str(), (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD);
+// Transport for ntfy and the update check. Callers keep one for the whole batch (or
+// the daemon's lifetime) so requests to the same server share a connection.
+// Timeouts are aggressive: 3s connect, 5s send/receive.
+std::unique_ptr<HttpTransport> create_toasty_transport() {
+    HttpOptions options;
+    options.userAgent = "Toasty/" + to_utf8(TOASTY_VERSION);
+    options.connectTimeoutMs = 3000;
+    options.ioTimeoutMs = 5000;
+    return create_http_transport(options);
+}
 
-    // Send the request (body is the message)
-    BOOL sent = WinHttpSendRequest(hRequest,
-        WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-        (LPVOID)bodyUtf8.c_str(), (DWORD)bodyUtf8.size(), (DWORD)bodyUtf8.size(), 0);
+NtfyMessage make_ntfy_message(const NtfyConfig& config, const std::wstring& title, const std::wstring& message) {
+    return { to_utf8(config.topic), sanitize_text(title, MAX_TITLE_BYTES, true),
+             sanitize_text(message, sink_message_limit(SinkKind::Ntfy)) };
+}
 
-    if (sent) {
-        WinHttpReceiveResponse(hRequest, nullptr);  // Wait for response (respects timeout)
+// Send queued push notifications via ntfy (fire-and-forget), grouped by server so
+// each server's messages go back to back over one connection
+void send_ntfy_batch(HttpTransport& transport, const std::vector<std::pair<std::wstring, NtfyMessage>>& jobs) {
+    std::vector<bool> sent(jobs.size(), false);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (sent[i]) continue;
+        std::vector<NtfyMessage> batch;
+        for (size_t j = i; j < jobs.size(); j++) {
+            if (!sent[j] && jobs[j].first == jobs[i].first) {
+                batch.push_back(jobs[j].second);
+                sent[j] = true;
+            }
+        }
+        publish_ntfy(transport, to_utf8(jobs[i].first), batch);
     }
+}
 
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
+void send_ntfy_notification(HttpTransport& transport, const NtfyConfig& config,
+                            const std::wstring& title, const std::wstring& message) {
+    send_ntfy_batch(transport, { { config.server, make_ntfy_message(config, title, message) } });
 }
 
 // Check if we should check for updates (throttle to once per day)
 bool should_check_for_updates() {
-    HKEY hKey;
-    std::wstring regKey = std::wstring(L"Software\\") + APP_NAME;
-
-    LONG result = RegOpenKeyExW(HKEY_CURRENT_USER, regKey.c_str(), 0, KEY_READ, &hKey);
-    if (result != ERROR_SUCCESS) return true;  // No key yet, check
-
-    FILETIME lastCheck = {};
-    DWORD size = sizeof(FILETIME);
-    result = RegQueryValueExW(hKey, L"LastUpdateCheck", nullptr, nullptr, (BYTE*)&lastCheck, &size);
-    RegCloseKey(hKey);
-
-    if (result != ERROR_SUCCESS) return true;  // No value yet, check
-
-    // Get current time
-    FILETIME now;
-    GetSystemTimeAsFileTime(&now);
-
-    // Convert to ULARGE_INTEGER for arithmetic (100-nanosecond intervals)
-    ULARGE_INTEGER ulNow, ulLast;
-    ulNow.LowPart = now.dwLowDateTime;
-    ulNow.HighPart = now.dwHighDateTime;
-    ulLast.LowPart = lastCheck.dwLowDateTime;
-    ulLast.HighPart = lastCheck.dwHighDateTime;
+    StateFile* state = get_state_file();
+    if (!state) {
+        return false;  // Nowhere to remember the check: don't hit GitHub on every run
+    }
 
     // 24 hours in 100-nanosecond intervals
-    ULONGLONG dayInterval = 24ULL * 60 * 60 * 10000000;
-    return (ulNow.QuadPart - ulLast.QuadPart) >= dayInterval;
+    const ULONGLONG dayInterval = 24ULL * 60 * 60 * 10000000;
+    ULONGLONG lastCheck = state->read().lastUpdateCheck;
+    ULONGLONG now = get_filetime_now();
+    return now < lastCheck || now - lastCheck >= dayInterval;
 }
 
 // Save the last update check timestamp
 void save_update_check_time() {
-    HKEY hKey;
-    std::wstring regKey = std::wstring(L"Software\\") + APP_NAME;
-
-    LONG result = RegCreateKeyExW(HKEY_CURRENT_USER, regKey.c_str(), 0, nullptr,
-                                   REG_OPTION_NON_VOLATILE, KEY_WRITE, nullptr, &hKey, nullptr);
-    if (result != ERROR_SUCCESS) return;
-
-    FILETIME now;
-    GetSystemTimeAsFileTime(&now);
-    RegSetValueExW(hKey, L"LastUpdateCheck", 0, REG_BINARY, (BYTE*)&now, sizeof(FILETIME));
-    RegCloseKey(hKey);
-}
-
-// Compare version strings (e.g., "0.3" vs "0.4")
-// Returns true if remoteVersion is newer than localVersion
-bool is_newer_version(const std::wstring& localVersion, const std::wstring& remoteVersion) {
-    // Strip leading 'v' if present
-    std::wstring local = localVersion;
-    std::wstring remote = remoteVersion;
-    if (!local.empty() && (local[0] == L'v' || local[0] == L'V')) local = local.substr(1);
-    if (!remote.empty() && (remote[0] == L'v' || remote[0] == L'V')) remote = remote.substr(1);
-
-    // Parse major.minor
-    auto parse = [](const std::wstring& v, int& major, int& minor) {
-        major = 0; minor = 0;
-        size_t dot = v.find(L'.');
-        if (dot != std::wstring::npos) {
-            try {
-                major = std::stoi(v.substr(0, dot));
-                minor = std::stoi(v.substr(dot + 1));
-            } catch (...) {}
-        } else {
-            try { major = std::stoi(v); } catch (...) {}
-        }
-    };
-
-    int localMajor, localMinor, remoteMajor, remoteMinor;
-    parse(local, localMajor, localMinor);
-    parse(remote, remoteMajor, remoteMinor);
-
-    if (remoteMajor > localMajor) return true;
-    if (remoteMajor == localMajor && remoteMinor > localMinor) return true;
-    return false;
+    if (StateFile* state = get_state_file()) {
+        ULONGLONG now = get_filetime_now();
+        state->update([now](ToastyState& s) { s.lastUpdateCheck = now; });
+    }
 }
 
 // Check GitHub releases for a newer version (non-blocking, throttled)
 // Returns true if an update toast was shown
-bool check_for_updates() {
+bool check_for_updates(HttpTransport& transport) {
     if (!should_check_for_updates()) return false;
 
     save_update_check_time();  // Save now so we don't retry on failure
 
-    // Hit GitHub API: GET /repos/shanselman/toasty/releases/latest
-    HINTERNET hSession = WinHttpOpen(L"Toasty/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return false;
+    // GET /repos/shanselman/toasty/releases/latest, conditional on the cached ETag:
+    // usually a 304 with no body, otherwise scanned only until tag_name and html_url
+    std::filesystem::path cachePath = std::filesystem::path(get_toasty_data_dir()) / L"release.cache";
+    ReleaseInfo release = load_release_cache(cachePath);
 
-    WinHttpSetTimeouts(hSession, 3000, 3000, 5000, 5000);
-
-    HINTERNET hConnect = WinHttpConnect(hSession, L"api.github.com", INTERNET_DEFAULT_HTTPS_PORT, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
+    HttpOrigin github;
+    github.host = "api.github.com";
+    ReleaseCheckResult result = fetch_latest_release(transport, github, "/repos/shanselman/toasty/releases/latest", release);
+    if (result == ReleaseCheckResult::Failed) {
         return false;
     }
+    if (result == ReleaseCheckResult::Updated) {
+        save_release_cache(cachePath, release);
+    }
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET",
-        L"/repos/shanselman/toasty/releases/latest",
-        nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
+    std::wstring tagName = from_utf8(release.tagName);
+    if (tagName.empty() || !is_newer_version(TOASTY_VERSION, tagName)) {
         return false;
     }
 
-    // GitHub API requires User-Agent
-    WinHttpAddRequestHeaders(hRequest, L"Accept: application/vnd.github+json", (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD);
-
-    BOOL sent = WinHttpSendRequest(hRequest,
-        WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0);
-
-    bool updateAvailable = false;
-
-    if (sent && WinHttpReceiveResponse(hRequest, nullptr)) {
-        // Read response body
-        std::string responseBody;
-        DWORD bytesRead = 0;
-        DWORD bytesAvailable = 0;
-
-        while (WinHttpQueryDataAvailable(hRequest, &bytesAvailable) && bytesAvailable > 0) {
-            std::vector<char> buffer(bytesAvailable);
-            if (WinHttpReadData(hRequest, buffer.data(), bytesAvailable, &bytesRead)) {
-                responseBody.append(buffer.data(), bytesRead);
-            }
-            // Cap response size to prevent memory issues
-            if (responseBody.size() > 32768) break;
-        }
+    // Only ever launch a GitHub page from the toast
+    std::wstring releaseUrl = L"https://github.com/shanselman/toasty/releases";
+    if (release.htmlUrl.rfind("https://github.com/", 0) == 0) {
+        releaseUrl = from_utf8(release.htmlUrl);
+    }
 
-        // Parse tag_name from JSON response using WinRT JSON parser
-        try {
-            int wideSize = MultiByteToWideChar(CP_UTF8, 0, responseBody.c_str(), -1, nullptr, 0);
-            if (wideSize > 0) {
-                std::wstring wideResponse(wideSize - 1, 0);
-                MultiByteToWideChar(CP_UTF8, 0, responseBody.c_str(), -1, &wideResponse[0], wideSize);
-
-                JsonObject json;
-                if (JsonObject::TryParse(wideResponse, json)) {
-                    std::wstring tagName = json.GetNamedString(L"tag_name", L"").c_str();
-                    std::wstring releaseName = json.GetNamedString(L"name", L"").c_str();
-                    std::wstring htmlUrl = json.GetNamedString(L"html_url", L"").c_str();
-
-                    if (!tagName.empty() && is_newer_version(TOASTY_VERSION, tagName)) {
-                        // Print to stderr
-                        std::wcerr << L"Update available: v" << TOASTY_VERSION
-                                   << L" → " << tagName
-                                   << L" (https://github.com/shanselman/toasty/releases)\n";
-
-                        // Show a toast notification about the update
-                        try {
-                            std::wstring updateXml =
-                                L"<toast activationType=\"protocol\" launch=\"https://github.com/shanselman/toasty/releases\">"
-                                L"<visual><binding template=\"ToastGeneric\">"
-                                L"<text>Toasty Update Available</text>"
-                                L"<text>v" + std::wstring(TOASTY_VERSION) + L" → " + tagName + L" — click to download</text>"
-                                L"</binding></visual></toast>";
-
-                            XmlDocument updateDoc;
-                            updateDoc.LoadXml(updateXml);
-                            ToastNotification updateToast(updateDoc);
-                            auto notifier = ToastNotificationManager::CreateToastNotifier(APP_ID);
-                            notifier.Show(updateToast);
-                        } catch (...) {
-                            // Update toast failed — not critical
-                        }
+    // Print to stderr
+    std::wcerr << L"Update available: v" << TOASTY_VERSION
+               << L" → " << tagName
+               << L" (" << releaseUrl << L")\n";
 
-                        updateAvailable = true;
-                    }
-                }
-            }
-        } catch (...) {
-            // JSON parse failed — silently ignore
-        }
+    // Show a toast notification about the update
+    try {
+        std::wstring updateXml =
+            L"<toast activationType=\"protocol\" launch=\"" + escape_xml(releaseUrl) + L"\">"
+            L"<visual><binding template=\"ToastGeneric\">"
+            L"<text>Toasty Update Available</text>"
+            L"<text>v" + std::wstring(TOASTY_VERSION) + L" → " + escape_xml(tagName) + L" — click to download</text>"
+            L"</binding></visual></toast>";
+
+        XmlDocument updateDoc;
+        updateDoc.LoadXml(updateXml);
+        ToastNotification updateToast(updateDoc);
+        auto notifier = ToastNotificationManager::CreateToastNotifier(APP_ID);
+        notifier.Show(updateToast);
+    } catch (...) {
+        // Update toast failed — not critical
     }
 
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    return updateAvailable;
+    return true;
 }
+
 bool register_protocol() {
     wchar_t exePath[MAX_PATH];
     GetModuleFileNameW(nullptr, exePath, MAX_PATH);
@@ -628,44 +876,32 @@ bool register_protocol() {
     return true;
 }
 
-// Save the console window handle to registry for later retrieval
-bool save_console_window_handle(HWND hwnd) {
-    HKEY hKey;
-    std::wstring regKey = std::wstring(L"Software\\") + APP_NAME;
-
-    LONG result = RegCreateKeyExW(HKEY_CURRENT_USER, regKey.c_str(), 0, nullptr,
-                                   REG_OPTION_NON_VOLATILE, KEY_WRITE, nullptr, &hKey, nullptr);
-    if (result != ERROR_SUCCESS) {
-        return false;
+// Record a shown toast: its click-to-focus target (if any), the time and the count.
+// One state update per notification; the window is only rewritten when it changes.
+void record_toast_shown(HWND hwnd) {
+    StateFile* state = get_state_file();
+    if (!state) {
+        return;
     }
-
-    ULONG_PTR handleValue = (ULONG_PTR)hwnd;
-    RegSetValueExW(hKey, L"LastConsoleWindow", 0, REG_QWORD, (BYTE*)&handleValue, sizeof(ULONG_PTR));
-    RegCloseKey(hKey);
-    return true;
+    ULONGLONG now = get_filetime_now();
+    state->update([hwnd, now](ToastyState& s) {
+        if (hwnd) {
+            s.lastConsoleWindow = (ULONGLONG)(ULONG_PTR)hwnd;
+        }
+        s.lastNotification = now;
+        s.notificationCount++;
+    });
 }
 
-// Retrieve the saved console window handle from registry
+// Retrieve the click-to-focus target saved by the last toast
 HWND get_saved_console_window_handle() {
-    HKEY hKey;
-    std::wstring regKey = std::wstring(L"Software\\") + APP_NAME;
-
-    LONG result = RegOpenKeyExW(HKEY_CURRENT_USER, regKey.c_str(), 0, KEY_READ, &hKey);
-    if (result != ERROR_SUCCESS) {
+    StateFile* state = get_state_file();
+    if (!state) {
         return nullptr;
     }
 
-    ULONG_PTR handleValue = 0;
-    DWORD size = sizeof(ULONG_PTR);
-    result = RegQueryValueExW(hKey, L"LastConsoleWindow", nullptr, nullptr, (BYTE*)&handleValue, &size);
-    RegCloseKey(hKey);
-
-    if (result != ERROR_SUCCESS) {
-        return nullptr;
-    }
-
-    HWND hwnd = (HWND)(ULONG_PTR)handleValue;
-    if (IsWindow(hwnd)) {
+    HWND hwnd = (HWND)(ULONG_PTR)state->read().lastConsoleWindow;
+    if (hwnd && IsWindow(hwnd)) {
         return hwnd;
     }
 
@@ -703,41 +939,13 @@ HWND find_window_for_process(DWORD pid) {
 }
 
 // Walk process tree to find the terminal/IDE window that launched us
-HWND find_ancestor_window() {
-    HandleGuard snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0));
-    if (!snapshot.valid()) {
-        return nullptr;
-    }
-
-    DWORD currentPid = GetCurrentProcessId();
-
-    // Walk up the process tree (max 20 levels)
-    for (int depth = 0; depth < 20; depth++) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        DWORD parentPid = 0;
-
-        // Find current process to get parent PID
-        if (Process32FirstW(snapshot, &pe32)) {
-            do {
-                if (pe32.th32ProcessID == currentPid) {
-                    parentPid = pe32.th32ParentProcessID;
-                    break;
-                }
-            } while (Process32NextW(snapshot, &pe32));
-        }
-
-        if (parentPid == 0 || parentPid == currentPid) {
-            break;
-        }
-
-        // Check if this parent has a visible window
-        HWND hwnd = find_window_for_process(parentPid);
+HWND find_ancestor_window(const ProcessTable& table) {
+    for (DWORD pid : get_ancestor_pids(table)) {
+        // Check if this ancestor has a visible window
+        HWND hwnd = find_window_for_process(pid);
         if (hwnd) {
             return hwnd;
         }
-
-        currentPid = parentPid;
     }
 
     return nullptr;
@@ -783,7 +991,7 @@ bool force_foreground_window(HWND hwnd) {
 }
 
 bool focus_console_window() {
-    // First try: saved console window handle from registry (most reliable)
+    // First try: saved console window handle (most reliable)
     HWND savedWindow = get_saved_console_window_handle();
     if (savedWindow != nullptr) {
         return force_foreground_window(savedWindow);
@@ -815,23 +1023,6 @@ bool focus_console_window() {
     return false;
 }
 
-// Escape backslashes and quotes for JSON strings
-std::wstring escape_json_string(const std::wstring& str) {
-    std::wstring result;
-    result.reserve(str.size());
-    for (wchar_t c : str) {
-        switch (c) {
-            case L'\\': result += L"\\\\"; break;
-            case L'"':  result += L"\\\""; break;
-            case L'\n': result += L"\\n"; break;
-            case L'\r': result += L"\\r"; break;
-            case L'\t': result += L"\\t"; break;
-            default:    result += c; break;
-        }
-    }
-    return result;
-}
-
 // Get the full path to the current executable
 std::wstring get_exe_path() {
     wchar_t exePath[MAX_PATH];
@@ -843,17 +1034,6 @@ std::wstring get_exe_path() {
     return std::wstring(exePath);
 }
 
-// Convert backslashes to forward slashes for cross-shell compatibility.
-// Claude Code and Gemini CLI execute hook commands via bash (Git Bash / MSYS2
-// on Windows). Unquoted backslashes in bash are escape characters, so a path
-// like D:\app\toasty\toasty.exe is mangled to D:apptoastytoasty.exe.
-// Forward slashes are accepted by Windows APIs and safe in bash.
-std::wstring normalize_path_for_shell(const std::wstring& path) {
-    std::wstring result = path;
-    std::replace(result.begin(), result.end(), L'\\', L'/');
-    return result;
-}
-
 // Expand environment variables in a path
 std::wstring expand_env(const std::wstring& path) {
     wchar_t expanded[MAX_PATH];
@@ -865,44 +1045,6 @@ std::wstring expand_env(const std::wstring& path) {
     return std::wstring(expanded);
 }
 
-// Check if a path exists
-bool path_exists(const std::wstring& path) {
-    DWORD attr = GetFileAttributesW(path.c_str());
-    return (attr != INVALID_FILE_ATTRIBUTES);
-}
-
-// Agent detection functions
-bool detect_claude() {
-    std::wstring claudePath = expand_env(L"%USERPROFILE%\\.claude");
-    return path_exists(claudePath);
-}
-
-bool detect_gemini() {
-    std::wstring geminiPath = expand_env(L"%USERPROFILE%\\.gemini");
-    return path_exists(geminiPath);
-}
-
-bool detect_copilot() {
-    // Check for .github directory AND hooks subdirectory as more specific indicator
-    return path_exists(L".github\\hooks") || path_exists(L".github");
-}
-
-bool detect_codex() {
-    std::wstring codexPath = expand_env(L"%USERPROFILE%\\.codex");
-    return path_exists(codexPath);
-}
-
-// Read file content as string
-std::string read_file(const std::wstring& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        return "";
-    }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
 // Write string to file
 bool write_file(const std::wstring& path, const std::string& content) {
     std::ofstream file(path, std::ios::binary);
@@ -913,1117 +1055,1417 @@ bool write_file(const std::wstring& path, const std::string& content) {
     return file.good();
 }
 
-// Backup a file
-bool backup_file(const std::wstring& path) {
-    std::wstring backupPath = path + L".bak";
-    try {
-        if (path_exists(path)) {
-            fs::copy_file(path, backupPath, fs::copy_options::overwrite_existing);
-        }
-        return true;
-    } catch (const std::exception& e) {
-        // Convert narrow string to wide string
-        int size = MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0);
-        if (size > 0) {
-            std::wstring wideMsg(size - 1, 0);
-            MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &wideMsg[0], size);
-            std::wcerr << L"Warning: Failed to create backup: " << wideMsg << L"\n";
-        } else {
-            std::wcerr << L"Warning: Failed to create backup\n";
-        }
-        return false;
-    }
+// Config file for an agent's hook (Copilot: relative to the current directory)
+std::wstring get_hook_config_path(const Platform& platform, HookAgent agent) {
+    return hook_config_path(agent, platform.home_dir(), std::filesystem::path()).wstring();
 }
 
-// Convert std::string to winrt::hstring
-hstring to_hstring(const std::string& str) {
-    int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
-    std::wstring wstr(size - 1, 0);
-    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wstr[0], size);
-    return hstring(wstr);
+bool detect_agent(const Platform& platform, HookAgent agent) {
+    return detect_hook_agent(agent, platform.home_dir(), std::filesystem::path());
 }
 
-// Convert winrt::hstring to std::string
-std::string from_hstring(const hstring& hstr) {
-    std::wstring wstr(hstr.c_str());
-    int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    std::string str(size - 1, 0);
-    WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &str[0], size, nullptr, nullptr);
-    return str;
+// From the manifest when the config hasn't changed since toasty last looked
+bool is_agent_hook_installed(const Platform& platform, HookAgent agent) {
+    return get_install_manifest().check(agent, get_hook_config_path(platform, agent)).installed;
 }
 
-// Check if a JSON hook array contains toasty
-bool has_toasty_hook(const JsonArray& hooks) {
-    for (const auto& hookItem : hooks) {
-        if (hookItem.ValueType() == JsonValueType::Object) {
-            auto hookObj = hookItem.GetObject();
-            // Check direct command field (correct format)
-            if (hookObj.HasKey(L"command")) {
-                std::wstring cmd = hookObj.GetNamedString(L"command").c_str();
-                if (cmd.find(L"toasty") != std::wstring::npos) {
-                    return true;
-                }
-            }
-            // Also check nested hooks array (legacy format)
-            if (hookObj.HasKey(L"hooks")) {
-                auto innerHooks = hookObj.GetNamedArray(L"hooks");
-                for (const auto& innerHook : innerHooks) {
-                    if (innerHook.ValueType() == JsonValueType::Object) {
-                        auto innerObj = innerHook.GetObject();
-                        if (innerObj.HasKey(L"command")) {
-                            std::wstring cmd = innerObj.GetNamedString(L"command").c_str();
-                            if (cmd.find(L"toasty") != std::wstring::npos) {
-                                return true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+// Add toasty's hook to one agent's config (see core/hook_config.h)
+bool install_agent_hook(const Platform& platform, HookAgent agent, const std::wstring& exePath) {
+    std::string warning;
+    std::wstring configPath = get_hook_config_path(platform, agent);
+    bool installed = install_hook_file(agent, configPath, to_utf8(exePath), warning);
+    get_install_manifest().record(agent, configPath);
+    if (!warning.empty()) {
+        std::wcerr << L"Warning: " << from_utf8(warning) << L"\n";
+    }
+    return installed;
+}
+
+bool uninstall_agent_hook(const Platform& platform, HookAgent agent) {
+    std::string error;
+    std::wstring configPath = get_hook_config_path(platform, agent);
+    bool removed = uninstall_hook_file(agent, configPath, error);
+    get_install_manifest().record(agent, configPath);
+    if (removed) {
+        return true;
     }
+    std::wcerr << L"Error uninstalling " << from_utf8(hook_agent_info(agent).displayName) << L" hook: "
+               << from_utf8(error) << L"\n";
     return false;
 }
 
-// Install hook for Claude Code
-bool install_claude(const std::wstring& exePath) {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.claude\\settings.json");
-    
-    JsonObject rootObj;
-    std::string existingContent = read_file(configPath);
-    
-    if (!existingContent.empty()) {
-        try {
-            backup_file(configPath);
-            rootObj = JsonObject::Parse(to_hstring(existingContent));
-        } catch (const hresult_error& ex) {
-            std::wcerr << L"Warning: Failed to parse existing config, starting fresh: " << ex.message().c_str() << L"\n";
-            rootObj = JsonObject();
-        }
+// --install copilot / --uninstall with --recursive: the per-repository hook in every
+// repository under root, found and edited in parallel
+int handle_recursive(const Platform& platform, const std::wstring& root, bool install) {
+    const HookAgentInfo& info = hook_agent_info(HookAgent::Copilot);
+    std::error_code ec;
+    std::filesystem::path rootPath = std::filesystem::absolute(root, ec).lexically_normal();
+    if (ec || !std::filesystem::is_directory(rootPath, ec)) {
+        std::wcerr << L"Error: Not a directory: " << root << L"\n";
+        return 1;
+    }
+    std::wstring exePath = platform.exe_path().wstring();
+    if (install && exePath.empty()) {
+        std::wcerr << L"Error: Could not determine toasty.exe path\n";
+        return 1;
     }
-    
-    // Build hook structure with nested "hooks" array (required by Claude Code)
-    JsonObject innerHook;
-    innerHook.SetNamedValue(L"type", JsonValue::CreateStringValue(L"command"));
 
-    std::wstring shellPath = normalize_path_for_shell(exePath);
-    std::wstring command = shellPath + L" \"Task complete\" -t \"Claude Code\"";
-    innerHook.SetNamedValue(L"command", JsonValue::CreateStringValue(command));
-    innerHook.SetNamedValue(L"timeout", JsonValue::CreateNumberValue(5000));
+    if (g_dryRun) {
+        std::mutex mutex;
+        std::vector<std::filesystem::path> repos;
+        walk_repositories(rootPath, 0, [&](const std::filesystem::path& repo) {
+            std::lock_guard<std::mutex> lock(mutex);
+            repos.push_back(repo);
+        });
+        std::sort(repos.begin(), repos.end());
+        for (const auto& repo : repos) {
+            std::wcout << L"[dry-run] Would " << (install ? L"write: " : L"remove: ")
+                       << hook_config_path(HookAgent::Copilot, std::filesystem::path(), repo).wstring() << L"\n";
+        }
+        std::wcout << L"[dry-run] " << repos.size() << L" repositories\n";
+        return 0;
+    }
 
-    JsonArray innerHooks;
-    innerHooks.Append(innerHook);
+    std::wcout << (install ? L"Installing " : L"Removing ") << from_utf8(info.displayName) << L" hooks under "
+               << rootPath.wstring() << L"...\n";
+    RepoWalkStats stats;
+    std::vector<RepoHookResult> results =
+        apply_repository_hooks(HookAgent::Copilot, rootPath, to_utf8(exePath), install, 0, stats);
+
+    size_t changed = 0;
+    size_t failed = 0;
+    for (const RepoHookResult& result : results) {
+        if (result.outcome == RepoHookOutcome::Changed) {
+            get_install_manifest().record(HookAgent::Copilot,
+                                          hook_config_path(HookAgent::Copilot, std::filesystem::path(), result.repo));
+        }
+        std::filesystem::path relative = result.repo.lexically_relative(rootPath);
+        std::wstring name = (relative == L"." ? rootPath.filename() : relative).wstring();
+        switch (result.outcome) {
+            case RepoHookOutcome::Changed:
+                changed++;
+                std::wcout << L"  [x] " << name;
+                if (install) {
+                    std::wcout << L": Added " << from_utf8(info.hookType) << L" hook\n";
+                } else {
+                    std::wcout << L": Removed hooks\n";
+                }
+                break;
+            case RepoHookOutcome::Unchanged:
+                std::wcout << (install ? L"  [x] " : L"  [ ] ") << name
+                           << (install ? L": Already installed\n" : L": Not installed\n");
+                break;
+            case RepoHookOutcome::Failed:
+                failed++;
+                std::wcout << L"  [ ] " << name << L": Failed";
+                if (!result.message.empty()) std::wcout << L": " << from_utf8(result.message);
+                std::wcout << L"\n";
+                continue;
+        }
+        if (!result.message.empty()) {
+            std::wcerr << L"Warning: " << name << L": " << from_utf8(result.message) << L"\n";
+        }
+    }
+
+    save_install_manifest();
+
+    double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    std::wcout << L"\n" << results.size() << L" repositories: " << changed << L" changed, "
+               << results.size() - changed - failed << L" unchanged, " << failed << L" failed\n";
+    std::wcout << L"Scanned " << stats.directories << L" directories in " << std::fixed << std::setprecision(2)
+               << stats.seconds << L"s with " << stats.threads << L" threads ("
+               << std::setprecision(0) << stats.directories / seconds << L" dirs/s, "
+               << stats.repositories / seconds << L" repos/s)\n";
+    return failed > 0 ? 1 : 0;
+}
 
-    JsonObject hookItem;
-    hookItem.SetNamedValue(L"hooks", innerHooks);
+// Show installation status. Hook state comes from the install manifest: a stat per
+// config, parsing only the ones that changed. --json prints it for tools to poll.
+void show_status(const Platform& platform, bool json) {
+    std::vector<AgentStatus> agents;
+    for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+        AgentStatus status;
+        status.agent = HOOK_AGENTS[i].agent;
+        status.detected = detect_agent(platform, status.agent);
+        status.config = std::filesystem::absolute(get_hook_config_path(platform, status.agent));
+        status.hook = get_install_manifest().check(status.agent, status.config);
+        agents.push_back(std::move(status));
+    }
+    save_install_manifest();
+
+    if (json) {
+        std::cout << status_json(agents, TOASTY_VERSION_TEXT, get_install_manifest().path());
+        return;
+    }
 
-    // Get or create hooks object
-    JsonObject hooksObj;
-    if (rootObj.HasKey(L"hooks")) {
-        hooksObj = rootObj.GetNamedObject(L"hooks");
+    std::wcout << L"Installation status:\n\n";
+    std::wcout << L"Detected agents:\n";
+    for (const AgentStatus& status : agents) {
+        std::wcout << L"  " << (status.detected ? L"[x] " : L"[ ] ") << from_utf8(hook_agent_info(status.agent).displayName);
+        if (status.agent == HookAgent::Copilot) std::wcout << L" (in current repo)";
+        std::wcout << L"\n";
     }
+    std::wcout << L"\n";
 
-    // Get or create Stop array
-    JsonArray stopArray;
-    if (hooksObj.HasKey(L"Stop")) {
-        stopArray = hooksObj.GetNamedArray(L"Stop");
-        if (has_toasty_hook(stopArray)) {
-            return true; // Already installed
-        }
+    std::wcout << L"Installed hooks:\n";
+    for (const AgentStatus& status : agents) {
+        std::wcout << L"  " << (status.hook.installed ? L"[x] " : L"[ ] ")
+                   << from_utf8(hook_agent_info(status.agent).displayName) << L"\n";
     }
 
-    stopArray.Append(hookItem);
-    hooksObj.SetNamedValue(L"Stop", stopArray);
-    rootObj.SetNamedValue(L"hooks", hooksObj);
-    
-    // Write to file
-    std::string jsonStr = from_hstring(rootObj.Stringify());
-    return write_file(configPath, jsonStr);
+    if (StateFile* state = get_state_file()) {
+        ToastyState snapshot = state->read();
+        std::wcout << L"\nNotifications shown: " << snapshot.notificationCount
+                   << L" (focused by click: " << snapshot.focusCount << L")\n";
+    }
 }
 
-// Install hook for Gemini CLI
-bool install_gemini(const std::wstring& exePath) {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.gemini\\settings.json");
+// Handle --install command
+void handle_install(const Platform& platform, const std::wstring& agent) {
+    std::wstring exePath = platform.exe_path().wstring();
     
-    JsonObject rootObj;
-    std::string existingContent = read_file(configPath);
+    if (exePath.empty()) {
+        std::wcerr << L"Error: Could not determine toasty.exe path\n";
+        return;
+    }
     
-    if (!existingContent.empty()) {
-        try {
-            backup_file(configPath);
-            rootObj = JsonObject::Parse(to_hstring(existingContent));
-        } catch (const hresult_error& ex) {
-            std::wcerr << L"Warning: Failed to parse existing config, starting fresh: " << ex.message().c_str() << L"\n";
-            rootObj = JsonObject();
+    bool installAll = agent.empty() || agent == L"all";
+    bool explicitAgent = !installAll;  // User explicitly named an agent
+    bool installClaude = installAll || agent == L"claude";
+    bool installGemini = installAll || agent == L"gemini";
+    bool installCopilot = installAll || agent == L"copilot";
+    bool installCodex = installAll || agent == L"codex";
+
+    if (g_dryRun) {
+        std::wcout << L"[dry-run] Install targets:";
+        if (installClaude) std::wcout << L" claude";
+        if (installGemini) std::wcout << L" gemini";
+        if (installCopilot) std::wcout << L" copilot";
+        if (installCodex) std::wcout << L" codex";
+        std::wcout << L"\n";
+        
+        for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+            const HookAgentInfo& info = HOOK_AGENTS[i];
+            bool selected = info.agent == HookAgent::Claude ? installClaude :
+                            info.agent == HookAgent::Gemini ? installGemini :
+                            info.agent == HookAgent::Copilot ? installCopilot : installCodex;
+            if (!selected) continue;
+            std::wcout << L"[dry-run] Would write: " << get_hook_config_path(platform, info.agent) << L"\n";
+            if (info.agent != HookAgent::Codex) {
+                std::wcout << L"[dry-run] Hook command: " << from_utf8(hook_command(info.agent, to_utf8(exePath))) << L"\n";
+            }
+            std::wcout << L"[dry-run] Hook type: " << from_utf8(info.hookType) << L"\n";
         }
+        return;
     }
-    
-    // Build hook structure with nested "hooks" array (required by Gemini CLI)
-    // Structure: hooks -> AfterAgent -> [ { matcher: "*", hooks: [ { command: ... } ] } ]
-    JsonObject innerHook;
-    innerHook.SetNamedValue(L"type", JsonValue::CreateStringValue(L"command"));
-    innerHook.SetNamedValue(L"name", JsonValue::CreateStringValue(L"toasty-notification"));
 
-    std::wstring shellPath = normalize_path_for_shell(exePath);
-    std::wstring command = shellPath + L" \"Gemini finished\" -t \"Gemini\"";
-    innerHook.SetNamedValue(L"command", JsonValue::CreateStringValue(command));
+    std::wcout << L"Detecting AI CLI agents...\n";
 
-    JsonArray innerHooks;
-    innerHooks.Append(innerHook);
+    bool claudeDetected = detect_agent(platform, HookAgent::Claude);
+    bool geminiDetected = detect_agent(platform, HookAgent::Gemini);
+    bool copilotDetected = detect_agent(platform, HookAgent::Copilot);
+    bool codexDetected = detect_agent(platform, HookAgent::Codex);
 
-    JsonObject hookItem;
-    hookItem.SetNamedValue(L"matcher", JsonValue::CreateStringValue(L"*"));
-    hookItem.SetNamedValue(L"hooks", innerHooks);
+    std::wcout << L"  " << (claudeDetected ? L"[x]" : L"[ ]") << L" Claude Code found\n";
+    std::wcout << L"  " << (geminiDetected ? L"[x]" : L"[ ]") << L" Gemini CLI found\n";
+    std::wcout << L"  " << (copilotDetected ? L"[x]" : L"[ ]") << L" GitHub Copilot (in current repo)\n";
+    std::wcout << L"  " << (codexDetected ? L"[x]" : L"[ ]") << L" OpenAI Codex found\n";
+    std::wcout << L"\n";
 
-    // Get or create hooks object
-    JsonObject hooksObj;
-    if (rootObj.HasKey(L"hooks")) {
-        hooksObj = rootObj.GetNamedObject(L"hooks");
-    }
+    std::wcout << L"Installing toasty hooks...\n";
 
-    // Get or create AfterAgent array
-    JsonArray afterAgentArray;
-    if (hooksObj.HasKey(L"AfterAgent")) {
-        afterAgentArray = hooksObj.GetNamedArray(L"AfterAgent");
-        // Check if our hook is already installed (check nested structure)
-        if (has_toasty_hook(afterAgentArray)) {
-            return true; // Already installed
+    bool anyInstalled = false;
+
+    // If user explicitly named an agent, install even if not detected
+    if (installClaude && (claudeDetected || explicitAgent)) {
+        if (install_agent_hook(platform, HookAgent::Claude, exePath)) {
+            std::wcout << L"  [x] Claude Code: Added Stop hook\n";
+            anyInstalled = true;
+        } else {
+            std::wcout << L"  [ ] Claude Code: Failed to install\n";
         }
     }
-
-    afterAgentArray.Append(hookItem);
-    hooksObj.SetNamedValue(L"AfterAgent", afterAgentArray);
-    rootObj.SetNamedValue(L"hooks", hooksObj);
-    
-    // Write to file
-    std::string jsonStr = from_hstring(rootObj.Stringify());
-    return write_file(configPath, jsonStr);
-}
-
-// Install hook for GitHub Copilot
-bool install_copilot(const std::wstring& exePath) {
-    std::wstring hooksDir = L".github\\hooks";
-    std::wstring configPath = hooksDir + L"\\toasty.json";
     
-    // Create .github/hooks directory if it doesn't exist
-    fs::create_directories(hooksDir);
-    
-    JsonObject rootObj;
-    std::string existingContent = read_file(configPath);
-    
-    if (!existingContent.empty()) {
-        try {
-            backup_file(configPath);
-            rootObj = JsonObject::Parse(to_hstring(existingContent));
-        } catch (const hresult_error& ex) {
-            std::wcerr << L"Warning: Failed to parse existing config, starting fresh: " << ex.message().c_str() << L"\n";
-            rootObj = JsonObject();
+    if (installGemini && (geminiDetected || explicitAgent)) {
+        if (install_agent_hook(platform, HookAgent::Gemini, exePath)) {
+            std::wcout << L"  [x] Gemini CLI: Added AfterAgent hook\n";
+            anyInstalled = true;
+        } else {
+            std::wcout << L"  [ ] Gemini CLI: Failed to install\n";
         }
     }
     
-    // Set version
-    rootObj.SetNamedValue(L"version", JsonValue::CreateNumberValue(1));
-    
-    // Build hook structure
-    JsonObject hookObj;
-    hookObj.SetNamedValue(L"type", JsonValue::CreateStringValue(L"command"));
-    
-    // For bash, use forward slashes and toasty (assuming it's in PATH)
-    hookObj.SetNamedValue(L"bash", JsonValue::CreateStringValue(L"toasty 'Copilot finished' -t 'GitHub Copilot'"));
-    
-    // For PowerShell, use the full exe path with escaped backslashes
-    std::wstring escapedPath = escape_json_string(exePath);
-    std::wstring psCommand = escapedPath + L" 'Copilot finished' -t 'GitHub Copilot'";
-    hookObj.SetNamedValue(L"powershell", JsonValue::CreateStringValue(psCommand));
-    
-    hookObj.SetNamedValue(L"timeoutSec", JsonValue::CreateNumberValue(5));
-    
-    // Get or create hooks object
-    JsonObject hooksObj;
-    if (rootObj.HasKey(L"hooks")) {
-        hooksObj = rootObj.GetNamedObject(L"hooks");
+    if (installCopilot && (copilotDetected || explicitAgent)) {
+        if (install_agent_hook(platform, HookAgent::Copilot, exePath)) {
+            std::wcout << L"  [x] GitHub Copilot: Added sessionEnd hook\n";
+            std::wcout << L"      Note: This is repo-level only, not global\n";
+            anyInstalled = true;
+        } else {
+            std::wcout << L"  [ ] GitHub Copilot: Failed to install\n";
+        }
     }
     
-    // Get or create sessionEnd array
-    JsonArray sessionEndArray;
-    if (hooksObj.HasKey(L"sessionEnd")) {
-        sessionEndArray = hooksObj.GetNamedArray(L"sessionEnd");
-        // Check if toasty is already there
-        for (const auto& item : sessionEndArray) {
-            if (item.ValueType() == JsonValueType::Object) {
-                auto obj = item.GetObject();
-                if (obj.HasKey(L"bash")) {
-                    std::wstring bash = obj.GetNamedString(L"bash").c_str();
-                    if (bash.find(L"toasty") != std::wstring::npos) {
-                        return true; // Already installed
-                    }
-                }
-            }
+    if (installCodex && (codexDetected || explicitAgent)) {
+        if (install_agent_hook(platform, HookAgent::Codex, exePath)) {
+            std::wcout << L"  [x] OpenAI Codex: Added notify hook\n";
+            anyInstalled = true;
+        } else {
+            std::wcout << L"  [ ] OpenAI Codex: Failed to install\n";
         }
     }
     
-    sessionEndArray.Append(hookObj);
-    hooksObj.SetNamedValue(L"sessionEnd", sessionEndArray);
-    rootObj.SetNamedValue(L"hooks", hooksObj);
-    
-    // Write to file
-    std::string jsonStr = from_hstring(rootObj.Stringify());
-    return write_file(configPath, jsonStr);
-}
-
-// Install hook for OpenAI Codex CLI
-// Codex uses TOML config at ~/.codex/config.toml with top-level notify = [..]
-bool install_codex(const std::wstring& exePath) {
-    std::wstring configDir = expand_env(L"%USERPROFILE%\\.codex");
-    std::wstring configPath = configDir + L"\\config.toml";
+    save_install_manifest();
 
-    // Create .codex directory if needed
-    fs::create_directories(configDir);
+    if (anyInstalled) {
+        std::wcout << L"\nDone! You'll get notifications when AI agents finish.\n";
+    } else {
+        std::wcout << L"\nNo agents were installed. Check detection status above.\n";
+    }
+}
 
-    std::string content = read_file(configPath);
+// Handle --uninstall command
+void handle_uninstall(const Platform& platform) {
+    if (g_dryRun) {
+        std::wcout << L"[dry-run] Would check and remove hooks from:\n";
+        std::wcout << L"[dry-run]   Claude: " << get_hook_config_path(platform, HookAgent::Claude) << L"\n";
+        std::wcout << L"[dry-run]   Gemini: " << get_hook_config_path(platform, HookAgent::Gemini) << L"\n";
+        std::wcout << L"[dry-run]   Copilot: " << get_hook_config_path(platform, HookAgent::Copilot) << L"\n";
+        std::wcout << L"[dry-run]   Codex: " << get_hook_config_path(platform, HookAgent::Codex) << L"\n";
+        return;
+    }
 
-    // Escape backslashes for TOML string
-    std::string exePathUtf8;
-    {
-        int size = WideCharToMultiByte(CP_UTF8, 0, exePath.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (size > 0) {
-            exePathUtf8.resize(size - 1);
-            WideCharToMultiByte(CP_UTF8, 0, exePath.c_str(), -1, &exePathUtf8[0], size, nullptr, nullptr);
+    std::wcout << L"Removing toasty hooks...\n";
+    
+    bool anyUninstalled = false;
+    
+    if (is_agent_hook_installed(platform, HookAgent::Claude)) {
+        if (uninstall_agent_hook(platform, HookAgent::Claude)) {
+            std::wcout << L"  [x] Claude Code: Removed hooks\n";
+            anyUninstalled = true;
+        } else {
+            std::wcout << L"  [ ] Claude Code: Failed to remove\n";
         }
     }
-    // Double backslashes for TOML
-    std::string escapedPath;
-    for (char c : exePathUtf8) {
-        if (c == '\\') escapedPath += "\\\\";
-        else escapedPath += c;
+    
+    if (is_agent_hook_installed(platform, HookAgent::Gemini)) {
+        if (uninstall_agent_hook(platform, HookAgent::Gemini)) {
+            std::wcout << L"  [x] Gemini CLI: Removed hooks\n";
+            anyUninstalled = true;
+        } else {
+            std::wcout << L"  [ ] Gemini CLI: Failed to remove\n";
+        }
     }
-
-    std::string notifyLine = "notify = [\"" + escapedPath + "\", \"Codex finished\", \"-t\", \"Codex\"]\n";
-    std::string bomPrefix;
-    if (content.size() >= 3 &&
-        static_cast<unsigned char>(content[0]) == 0xEF &&
-        static_cast<unsigned char>(content[1]) == 0xBB &&
-        static_cast<unsigned char>(content[2]) == 0xBF) {
-        bomPrefix = content.substr(0, 3);
-        content.erase(0, 3);
+    
+    if (is_agent_hook_installed(platform, HookAgent::Copilot)) {
+        if (uninstall_agent_hook(platform, HookAgent::Copilot)) {
+            std::wcout << L"  [x] GitHub Copilot: Removed hooks\n";
+            anyUninstalled = true;
+        } else {
+            std::wcout << L"  [ ] GitHub Copilot: Failed to remove\n";
+        }
     }
-
-    if (content.empty()) {
-        return write_file(configPath, bomPrefix + notifyLine);
+    
+    if (is_agent_hook_installed(platform, HookAgent::Codex)) {
+        if (uninstall_agent_hook(platform, HookAgent::Codex)) {
+            std::wcout << L"  [x] OpenAI Codex: Removed notify hook\n";
+            anyUninstalled = true;
+        } else {
+            std::wcout << L"  [ ] OpenAI Codex: Failed to remove\n";
+        }
     }
+    
+    save_install_manifest();
 
-    backup_file(configPath);
-
-    const char* LINE_WHITESPACE = " \t\r";
-    auto is_notify_key_line = [](const std::string& line) -> bool {
-        const std::string notifyKey = "notify";
-        if (line.rfind(notifyKey, 0) != 0) return false;
-        size_t pos = notifyKey.size();
-        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
-        return pos < line.size() && line[pos] == '=';
-    };
-
-    // Remove any existing toasty notify lines (including older incorrect section placement)
-    std::string cleaned;
-    size_t pos = 0;
-    while (pos < content.size()) {
-        size_t lineEnd = content.find('\n', pos);
-        size_t lineLen = (lineEnd == std::string::npos) ? (content.size() - pos) : (lineEnd - pos);
-        std::string line = content.substr(pos, lineLen);
-
-        size_t firstNonWs = line.find_first_not_of(LINE_WHITESPACE);
-        std::string trimmed = (firstNonWs == std::string::npos) ? "" : line.substr(firstNonWs);
-        bool isToastyNotify = is_notify_key_line(trimmed) && trimmed.find("toasty") != std::string::npos;
+    if (anyUninstalled) {
+        std::wcout << L"\nDone! Hooks have been removed.\n";
+    } else {
+        std::wcout << L"\nNo hooks were installed.\n";
+    }
+}
 
-        if (!isToastyNotify) {
-            cleaned += line;
-            if (lineEnd != std::string::npos) cleaned += '\n';
-        }
+// Create the Start Menu shortcut that carries our AUMID (required for toasts from an
+// unpackaged exe)
+bool write_start_menu_shortcut(std::wstring& shortcutPath) {
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
 
-        if (lineEnd == std::string::npos) break;
-        pos = lineEnd + 1;
+    wchar_t startMenuPath[MAX_PATH];
+    if (FAILED(SHGetFolderPathW(nullptr, CSIDL_PROGRAMS, nullptr, 0, startMenuPath))) {
+        return false;
     }
-    content = cleaned;
 
-    // Find first TOML table so notify can be inserted as top-level key
-    size_t firstTablePos = std::string::npos;
-    pos = 0;
-    while (pos < content.size()) {
-        size_t lineEnd = content.find('\n', pos);
-        size_t lineLen = (lineEnd == std::string::npos) ? (content.size() - pos) : (lineEnd - pos);
-        std::string line = content.substr(pos, lineLen);
+    shortcutPath = std::wstring(startMenuPath) + L"\\Toasty.lnk";
 
-        size_t firstNonWs = line.find_first_not_of(LINE_WHITESPACE);
-        if (firstNonWs != std::string::npos && line[firstNonWs] == '[') {
-            firstTablePos = pos;
-            break;
-        }
+    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 
-        if (lineEnd == std::string::npos) break;
-        pos = lineEnd + 1;
+    IShellLinkW* shellLink = nullptr;
+    HRESULT hr = CoCreateInstance(CLSID_ShellLink, nullptr, CLSCTX_INPROC_SERVER,
+                                   IID_IShellLinkW, (void**)&shellLink);
+    if (FAILED(hr)) {
+        CoUninitialize();
+        return false;
     }
 
-    // Replace top-level notify if present; otherwise insert before first table
-    size_t searchLimit = (firstTablePos == std::string::npos) ? content.size() : firstTablePos;
-    size_t topNotifyStart = std::string::npos;
-    size_t topNotifyEnd = std::string::npos;
-    pos = 0;
-    while (pos < searchLimit) {
-        size_t lineEnd = content.find('\n', pos);
-        size_t lineLen = (lineEnd == std::string::npos) ? (content.size() - pos) : (lineEnd - pos);
-        std::string line = content.substr(pos, lineLen);
+    shellLink->SetPath(exePath);
+    shellLink->SetDescription(L"Toasty - Toast Notification CLI");
 
-        size_t firstNonWs = line.find_first_not_of(LINE_WHITESPACE);
-        std::string trimmed = (firstNonWs == std::string::npos) ? "" : line.substr(firstNonWs);
-        if (is_notify_key_line(trimmed)) {
-            topNotifyStart = pos;
-            topNotifyEnd = (lineEnd == std::string::npos) ? content.size() : (lineEnd + 1);
-            break;
+    IPropertyStore* propStore = nullptr;
+    hr = shellLink->QueryInterface(IID_IPropertyStore, (void**)&propStore);
+    if (SUCCEEDED(hr)) {
+        PROPVARIANT pv;
+        hr = InitPropVariantFromString(APP_ID, &pv);
+        if (SUCCEEDED(hr)) {
+            propStore->SetValue(PKEY_AppUserModel_ID, pv);
+            PropVariantClear(&pv);
         }
-
-        if (lineEnd == std::string::npos) break;
-        pos = lineEnd + 1;
-    }
-
-    if (topNotifyStart != std::string::npos) {
-        content.replace(topNotifyStart, topNotifyEnd - topNotifyStart, notifyLine);
-    } else if (firstTablePos != std::string::npos) {
-        content.insert(firstTablePos, notifyLine);
-    } else {
-        if (!content.empty() && content.back() != '\n') content += '\n';
-        content += notifyLine;
+        propStore->Commit();
+        propStore->Release();
     }
 
-    if (!bomPrefix.empty()) {
-        content.insert(0, bomPrefix);
+    IPersistFile* persistFile = nullptr;
+    hr = shellLink->QueryInterface(IID_IPersistFile, (void**)&persistFile);
+    if (SUCCEEDED(hr)) {
+        hr = persistFile->Save(shortcutPath.c_str(), TRUE);
+        persistFile->Release();
     }
 
-    return write_file(configPath, content);
+    shellLink->Release();
+    CoUninitialize();
+    return SUCCEEDED(hr);
 }
 
-// Check if Claude hook is installed
-bool is_claude_installed() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.claude\\settings.json");
-    std::string content = read_file(configPath);
-    if (content.empty()) return false;
-    
-    try {
-        auto rootObj = JsonObject::Parse(to_hstring(content));
-        if (rootObj.HasKey(L"hooks")) {
-            auto hooksObj = rootObj.GetNamedObject(L"hooks");
-            if (hooksObj.HasKey(L"Stop")) {
-                auto stopArray = hooksObj.GetNamedArray(L"Stop");
-                return has_toasty_hook(stopArray);
-            }
-        }
-    } catch (const hresult_error&) {
-        // Config exists but couldn't be parsed
-        return false;
+// Identifies what registration writes: exe path, AUMID, protocol name and version.
+// A match with the state file means the shortcut and protocol keys are already current.
+ULONGLONG get_registration_fingerprint() {
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+    std::wstring identity = std::wstring(exePath) + L"|" + APP_ID + L"|" + PROTOCOL_NAME + L"|" + TOASTY_VERSION;
+    return fnv1a_64(std::string_view(reinterpret_cast<const char*>(identity.data()), identity.size() * sizeof(wchar_t)));
+}
+
+void save_registration_fingerprint(ULONGLONG fingerprint) {
+    if (StateFile* state = get_state_file()) {
+        state->update([fingerprint](ToastyState& s) { s.registrationFingerprint = fingerprint; });
     }
-    
-    return false;
 }
 
-// Check if Gemini hook is installed
-bool is_gemini_installed() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.gemini\\settings.json");
-    std::string content = read_file(configPath);
-    if (content.empty()) return false;
-    
-    try {
-        auto rootObj = JsonObject::Parse(to_hstring(content));
-        if (rootObj.HasKey(L"hooks")) {
-            auto hooksObj = rootObj.GetNamedObject(L"hooks");
-            if (hooksObj.HasKey(L"AfterAgent")) {
-                auto array = hooksObj.GetNamedArray(L"AfterAgent");
-                return has_toasty_hook(array);
-            }
-        }
-    } catch (const hresult_error&) {
-        // Config exists but couldn't be parsed
-        return false;
+bool create_shortcut() {
+    std::wstring shortcutPath;
+    if (write_start_menu_shortcut(shortcutPath)) {
+        // Also register the protocol handler for click-to-focus
+        register_protocol();
+        save_registration_fingerprint(get_registration_fingerprint());
+        std::wcout << L"Registered! Shortcut created at:\n" << shortcutPath << L"\n";
+        return true;
     }
-    
     return false;
 }
 
-// Check if Copilot hook is installed
-bool is_copilot_installed() {
-    std::wstring configPath = L".github\\hooks\\toasty.json";
-    std::string content = read_file(configPath);
-    if (content.empty()) return false;
-    
-    try {
-        auto rootObj = JsonObject::Parse(to_hstring(content));
-        if (rootObj.HasKey(L"hooks")) {
-            auto hooksObj = rootObj.GetNamedObject(L"hooks");
-            if (hooksObj.HasKey(L"sessionEnd")) {
-                auto array = hooksObj.GetNamedArray(L"sessionEnd");
-                for (const auto& item : array) {
-                    if (item.ValueType() == JsonValueType::Object) {
-                        auto obj = item.GetObject();
-                        if (obj.HasKey(L"bash")) {
-                            std::wstring bash = obj.GetNamedString(L"bash").c_str();
-                            if (bash.find(L"toasty") != std::wstring::npos) {
-                                return true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    } catch (const hresult_error&) {
-        // Config exists but couldn't be parsed
+bool is_registered() {
+    wchar_t startMenuPath[MAX_PATH];
+    if (FAILED(SHGetFolderPathW(nullptr, CSIDL_PROGRAMS, nullptr, 0, startMenuPath))) {
         return false;
     }
-    
-    return false;
+    std::wstring shortcutPath = std::wstring(startMenuPath) + L"\\Toasty.lnk";
+    return GetFileAttributesW(shortcutPath.c_str()) != INVALID_FILE_ATTRIBUTES;
 }
 
-// Remove toasty hooks from a JSON array
-JsonArray remove_toasty_hooks(const JsonArray& hooks) {
-    JsonArray newArray;
-    for (const auto& hookItem : hooks) {
-        if (hookItem.ValueType() == JsonValueType::Object) {
-            auto hookObj = hookItem.GetObject();
-            bool isToasty = false;
+// Register on first use (or after the exe moved or was upgraded). Normally a single
+// state-file read: the registry and Start Menu are only touched when the fingerprint
+// changes. Use --register to force it.
+bool ensure_registered() {
+    ULONGLONG fingerprint = get_registration_fingerprint();
+    StateFile* state = get_state_file();
+    if (state && state->read().registrationFingerprint == fingerprint) {
+        return true;
+    }
 
-            // Check direct command field (correct format)
-            if (hookObj.HasKey(L"command")) {
-                std::wstring cmd = hookObj.GetNamedString(L"command").c_str();
-                if (cmd.find(L"toasty") != std::wstring::npos) {
-                    isToasty = true;
-                }
-            }
-            // Check nested hooks array (legacy format)
-            if (!isToasty && hookObj.HasKey(L"hooks")) {
-                auto innerHooks = hookObj.GetNamedArray(L"hooks");
-                for (const auto& innerHook : innerHooks) {
-                    if (innerHook.ValueType() == JsonValueType::Object) {
-                        auto innerObj = innerHook.GetObject();
-                        if (innerObj.HasKey(L"command")) {
-                            std::wstring cmd = innerObj.GetNamedString(L"command").c_str();
-                            if (cmd.find(L"toasty") != std::wstring::npos) {
-                                isToasty = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-            // Check bash field (Copilot format)
-            if (!isToasty && hookObj.HasKey(L"bash")) {
-                std::wstring bash = hookObj.GetNamedString(L"bash").c_str();
-                if (bash.find(L"toasty") != std::wstring::npos) {
-                    isToasty = true;
-                }
-            }
+    // Protocol handler for click-to-focus
+    register_protocol();
 
-            if (!isToasty) {
-                newArray.Append(hookItem);
-            }
-        }
+    std::wstring shortcutPath;
+    if (!is_registered() && !write_start_menu_shortcut(shortcutPath)) {
+        return false;
     }
-    return newArray;
+
+    save_registration_fingerprint(fingerprint);
+    return true;
 }
 
-// Uninstall hook for Claude Code
-bool uninstall_claude() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.claude\\settings.json");
-    std::string existingContent = read_file(configPath);
-    
-    if (existingContent.empty()) {
-        return true; // Nothing to uninstall
-    }
-    
+// Background queue for network side channels (%LOCALAPPDATA%\Toasty\queue).
+// The foreground process drops a job file and spawns a detached worker
+// (toasty --drain-queue) that sends every queued job and then checks for updates.
+// ntfy job file (.job): UTF-8, lines "server", "topic", "title", then the message to EOF.
+// Best-effort sinks cut short by the required ones are queued as .sink (queue_sink_job).
+std::wstring get_queue_dir() {
+    const std::wstring& dataDir = get_toasty_data_dir();
+    return dataDir.empty() ? L"" : dataDir + L"\\queue";
+}
+
+// Queue one ntfy push for the background worker
+bool enqueue_ntfy_job(const NtfyConfig& config, const std::wstring& title, const std::wstring& message) {
+    std::wstring queueDir = get_queue_dir();
+    if (queueDir.empty()) return false;
+
     try {
-        backup_file(configPath);
-        auto rootObj = JsonObject::Parse(to_hstring(existingContent));
-        
-        if (rootObj.HasKey(L"hooks")) {
-            auto hooksObj = rootObj.GetNamedObject(L"hooks");
-            if (hooksObj.HasKey(L"Stop")) {
-                auto stopArray = hooksObj.GetNamedArray(L"Stop");
-                auto newArray = remove_toasty_hooks(stopArray);
-                hooksObj.SetNamedValue(L"Stop", newArray);
-                rootObj.SetNamedValue(L"hooks", hooksObj);
-                
-                std::string jsonStr = from_hstring(rootObj.Stringify());
-                return write_file(configPath, jsonStr);
-            }
-        }
-    } catch (const hresult_error& ex) {
-        std::wcerr << L"Error uninstalling Claude hook: " << ex.message().c_str() << L"\n";
+        fs::create_directories(queueDir);
+    } catch (...) {
         return false;
     }
-    
-    return true;
-}
 
-// Uninstall hook for Gemini CLI
-bool uninstall_gemini() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.gemini\\settings.json");
-    std::string existingContent = read_file(configPath);
-    
-    if (existingContent.empty()) {
-        return true; // Nothing to uninstall
+    // Unique, roughly time-ordered name; written as .tmp and renamed so the worker
+    // never picks up a partial job
+    std::wstring name = std::to_wstring(get_filetime_now()) + L"-" + std::to_wstring(GetCurrentProcessId());
+    std::wstring tempPath = queueDir + L"\\" + name + L".tmp";
+    std::wstring jobPath = queueDir + L"\\" + name + L".job";
+
+    std::string job = to_utf8(config.server) + "\n" + to_utf8(config.topic) + "\n" +
+                      to_utf8(title) + "\n" + to_utf8(message);
+    if (!write_file(tempPath, job)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
     }
-    
-    try {
-        backup_file(configPath);
-        auto rootObj = JsonObject::Parse(to_hstring(existingContent));
-        
-        if (rootObj.HasKey(L"hooks")) {
-            auto hooksObj = rootObj.GetNamedObject(L"hooks");
-            if (hooksObj.HasKey(L"AfterAgent")) {
-                auto array = hooksObj.GetNamedArray(L"AfterAgent");
-                auto newArray = remove_toasty_hooks(array);
-                hooksObj.SetNamedValue(L"AfterAgent", newArray);
-                rootObj.SetNamedValue(L"hooks", hooksObj);
-                
-                std::string jsonStr = from_hstring(rootObj.Stringify());
-                return write_file(configPath, jsonStr);
-            }
-        }
-    } catch (const hresult_error& ex) {
-        std::wcerr << L"Error uninstalling Gemini hook: " << ex.message().c_str() << L"\n";
+    if (!MoveFileExW(tempPath.c_str(), jobPath.c_str(), 0)) {
+        DeleteFileW(tempPath.c_str());
         return false;
     }
-    
     return true;
 }
 
-// Uninstall hook for GitHub Copilot
-bool uninstall_copilot() {
-    std::wstring configPath = L".github\\hooks\\toasty.json";
-    
-    try {
-        if (path_exists(configPath)) {
-            backup_file(configPath);
-            fs::remove(configPath);
-        }
-    } catch (const std::exception& e) {
-        // Convert narrow string to wide string
-        int size = MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0);
-        if (size > 0) {
-            std::wstring wideMsg(size - 1, 0);
-            MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &wideMsg[0], size);
-            std::wcerr << L"Error uninstalling Copilot hook: " << wideMsg << L"\n";
-        } else {
-            std::wcerr << L"Error uninstalling Copilot hook\n";
-        }
-        return false;
+// Start "toasty --drain-queue" fully detached: no console, no inherited handles, and
+// outside the agent's job object when allowed, so it outlives the hook
+bool spawn_background_worker() {
+    std::wstring exePath = get_exe_path();
+    if (exePath.empty()) return false;
+
+    std::wstring commandLine = L"\"" + exePath + L"\" --drain-queue";
+    STARTUPINFOW si = { sizeof(STARTUPINFOW) };
+    PROCESS_INFORMATION pi = {};
+
+    DWORD flags = DETACHED_PROCESS | CREATE_NEW_PROCESS_GROUP | CREATE_NO_WINDOW;
+    BOOL created = CreateProcessW(exePath.c_str(), &commandLine[0], nullptr, nullptr, FALSE,
+                                  flags | CREATE_BREAKAWAY_FROM_JOB, nullptr, nullptr, &si, &pi);
+    if (!created && GetLastError() == ERROR_ACCESS_DENIED) {
+        // Job does not allow breakaway; still detached from the console
+        created = CreateProcessW(exePath.c_str(), &commandLine[0], nullptr, nullptr, FALSE,
+                                 flags, nullptr, nullptr, &si, &pi);
     }
-    
+    if (!created) return false;
+
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
     return true;
 }
 
-// Uninstall hook for OpenAI Codex
-bool uninstall_codex() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.codex\\config.toml");
-    std::string content = read_file(configPath);
+// Hand network work (the ntfy push, if given, and the daily update check) to the
+// background worker. Falls back to doing it inline if the job cannot be queued or
+// the worker cannot be started.
+void run_side_channels(const NtfyConfig* ntfy, const std::wstring& title, const std::wstring& message) {
+    bool updateDue = should_check_for_updates();
+    if (!ntfy && !updateDue) {
+        return;  // Nothing to do: no worker
+    }
+
+    bool queued = !ntfy || enqueue_ntfy_job(*ntfy, title, message);
+    if (queued && spawn_background_worker()) {
+        return;
+    }
+
+    auto transport = create_toasty_transport();
+    if (ntfy && !queued) {
+        send_ntfy_notification(*transport, *ntfy, title, message);
+    }
+    check_for_updates(*transport);
+}
+
+// Worker entry point (toasty --drain-queue): send every queued job, then check for updates.
+// Jobs are claimed by renaming, so concurrent workers never send the same job twice.
+// Everything goes through one transport, so a backlog costs one connection per server.
+void drain_background_queue() {
+    auto transport = create_toasty_transport();
+
+    std::wstring queueDir = get_queue_dir();
+    if (!queueDir.empty()) {
+        std::vector<fs::path> jobs;
+        try {
+            for (const auto& entry : fs::directory_iterator(queueDir)) {
+                if (entry.path().extension() == L".job") {
+                    jobs.push_back(entry.path());
+                }
+            }
+        } catch (...) {
+            // Queue directory missing or unreadable
+        }
+        std::sort(jobs.begin(), jobs.end());
+
+        std::vector<std::pair<std::wstring, NtfyMessage>> batch;
+        for (const auto& job : jobs) {
+            fs::path claimed = job;
+            claimed.replace_extension(L".sending");
+            if (!MoveFileExW(job.c_str(), claimed.c_str(), 0)) {
+                continue;  // Another worker took it
+            }
 
-    if (content.empty()) return true;
+            std::string content = read_file_bytes(claimed);
+            DeleteFileW(claimed.c_str());
 
-    if (content.find("toasty") == std::string::npos) return true;
+            // server \n topic \n title \n message...
+            size_t first = content.find('\n');
+            size_t second = first == std::string::npos ? first : content.find('\n', first + 1);
+            size_t third = second == std::string::npos ? second : content.find('\n', second + 1);
+            if (third == std::string::npos) continue;
 
-    backup_file(configPath);
+            NtfyMessage message;
+            message.topic = content.substr(first + 1, second - first - 1);
+            message.title = content.substr(second + 1, third - second - 1);
+            message.message = content.substr(third + 1);
+            batch.emplace_back(from_utf8(content.substr(0, first)), std::move(message));
+        }
+        send_ntfy_batch(*transport, batch);
 
-    // Remove the notify line containing toasty
-    std::string result;
-    std::istringstream stream(content);
-    std::string line;
-    while (std::getline(stream, line)) {
-        if (line.find("notify") != std::string::npos && line.find("toasty") != std::string::npos) {
-            continue; // Skip toasty notify line
+        for (const SinkJob& job : claim_sink_jobs(queueDir)) {
+            std::unique_ptr<NotificationSink> sink = create_portable_sink(job.config);
+            try {
+                if (sink) sink->deliver(job.notification);
+            } catch (...) {
+                // A failed delivery only drops its own job
+            }
         }
-        result += line + '\n';
     }
 
-    return write_file(configPath, result);
+    // Check for updates (throttled to once per day)
+    init_apartment();
+    check_for_updates(*transport);
 }
 
-// Check if Codex hook is installed
-bool is_codex_installed() {
-    std::wstring configPath = expand_env(L"%USERPROFILE%\\.codex\\config.toml");
-    std::string content = read_file(configPath);
-    return content.find("toasty") != std::string::npos;
+// Find any visible console or Windows Terminal window (last-resort focus target)
+HWND find_any_terminal_window() {
+    HWND found = nullptr;
+    EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
+        wchar_t className[256];
+        GetClassNameW(hwnd, className, 256);
+        if (IsWindowVisible(hwnd) &&
+            (wcscmp(className, L"CASCADIA_HOSTING_WINDOW_CLASS") == 0 ||
+             wcscmp(className, L"ConsoleWindowClass") == 0)) {
+            *(HWND*)lParam = hwnd;
+            return FALSE;
+        }
+        return TRUE;
+    }, (LPARAM)&found);
+    return found;
 }
 
-// Show installation status
-void show_status() {
-    std::wcout << L"Installation status:\n\n";
-    
-    bool claudeDetected = detect_claude();
-    bool geminiDetected = detect_gemini();
-    bool copilotDetected = detect_copilot();
-    bool codexDetected = detect_codex();
-    
-    std::wcout << L"Detected agents:\n";
-    std::wcout << L"  " << (claudeDetected ? L"[x]" : L"[ ]") << L" Claude Code\n";
-    std::wcout << L"  " << (geminiDetected ? L"[x]" : L"[ ]") << L" Gemini CLI\n";
-    std::wcout << L"  " << (copilotDetected ? L"[x]" : L"[ ]") << L" GitHub Copilot (in current repo)\n";
-    std::wcout << L"  " << (codexDetected ? L"[x]" : L"[ ]") << L" OpenAI Codex\n";
-    std::wcout << L"\n";
-    
-    std::wcout << L"Installed hooks:\n";
-    std::wcout << L"  " << (is_claude_installed() ? L"[x]" : L"[ ]") << L" Claude Code\n";
-    std::wcout << L"  " << (is_gemini_installed() ? L"[x]" : L"[ ]") << L" Gemini CLI\n";
-    std::wcout << L"  " << (is_copilot_installed() ? L"[x]" : L"[ ]") << L" GitHub Copilot\n";
-    std::wcout << L"  " << (is_codex_installed() ? L"[x]" : L"[ ]") << L" OpenAI Codex\n";
+// Command line options. Parsing is the first pipeline stage and does no other work.
+struct Options {
+    std::wstring message;
+    std::wstring title;         // Only meaningful when explicitTitle
+    std::wstring iconPath;      // Custom icon (-i), empty to use the preset icon
+    const AppPreset* explicitApp = nullptr;  // Set by --app
+    bool explicitTitle = false;
+    bool doInstall = false;
+    bool doUninstall = false;
+    bool doStatus = false;
+    bool doHistory = false;
+    std::wstring historySince;  // --history --since
+    bool json = false;          // --status --json, --history --json
+    bool doFocus = false;
+    bool doRegister = false;
+    bool doDrainQueue = false;  // Internal: background worker mode
+    bool doServe = false;
+    bool highPriority = false;  // --priority high: bypass rate limiting and coalescing
+    std::wstring payloadArg;    // Trailing JSON argument (Codex notify event)
+    std::wstring installAgent;
+    std::wstring recursiveRoot;  // --recursive: per-repository hooks in every repo below
+    bool debug = false;
+};
+
+// Parse arguments into options. Returns -1 to continue, otherwise the exit code.
+int parse_options(int argc, wchar_t* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::wstring arg = argv[i];
+
+        if (arg == L"-h" || arg == L"--help") {
+            print_usage();
+            return 0;
+        }
+        else if (arg == L"-v" || arg == L"--version") {
+            std::wcout << L"toasty v" << TOASTY_VERSION << L"\n";
+            return 0;
+        }
+        else if (arg == L"--install") {
+            options.doInstall = true;
+            // Check if next arg is an agent name
+            if (i + 1 < argc && argv[i + 1][0] != L'-') {
+                options.installAgent = argv[++i];
+            }
+        }
+        else if (arg == L"--uninstall") {
+            options.doUninstall = true;
+        }
+        else if (arg == L"--status") {
+            options.doStatus = true;
+        }
+        else if (arg == L"--json") {
+            options.json = true;
+        }
+        else if (arg == L"--history") {
+            options.doHistory = true;
+        }
+        else if (arg == L"--since") {
+            if (i + 1 >= argc) {
+                std::wcerr << L"Error: --since requires an argument\n";
+                return 1;
+            }
+            options.historySince = argv[++i];
+        }
+        else if (arg == L"--recursive") {
+            if (i + 1 >= argc) {
+                std::wcerr << L"Error: --recursive requires a directory\n";
+                return 1;
+            }
+            options.recursiveRoot = argv[++i];
+        }
+        else if (arg == L"--focus") {
+            options.doFocus = true;
+        }
+        else if (arg == L"--register") {
+            options.doRegister = true;
+        }
+        else if (arg == L"--drain-queue") {
+            options.doDrainQueue = true;
+        }
+        else if (arg == L"--serve") {
+            options.doServe = true;
+        }
+        else if (arg == L"-t" || arg == L"--title") {
+            if (i + 1 < argc) {
+                options.title = argv[++i];
+                options.explicitTitle = true;
+            } else {
+                std::wcerr << L"Error: --title requires an argument\n";
+                return 1;
+            }
+        }
+        else if (arg == L"--app") {
+            if (i + 1 < argc) {
+                std::wstring appName = argv[++i];
+                const AppPreset* preset = find_preset(appName);
+                if (preset) {
+                    // A later --app replaces an earlier custom icon
+                    options.explicitApp = preset;
+                    options.iconPath.clear();
+                } else {
+                    std::wcerr << L"Error: Unknown app preset '" << appName << L"'\n";
+                    std::wcerr << L"Available presets: claude, copilot, gemini, codex, cursor\n";
+                    return 1;
+                }
+            } else {
+                std::wcerr << L"Error: --app requires an argument\n";
+                return 1;
+            }
+        }
+        else if (arg == L"--priority") {
+            if (i + 1 < argc) {
+                std::wstring priority = argv[++i];
+                if (equals_ignore_case(priority, L"high")) {
+                    options.highPriority = true;
+                } else if (equals_ignore_case(priority, L"normal")) {
+                    options.highPriority = false;
+                } else {
+                    std::wcerr << L"Error: Unknown priority '" << priority << L"' (use normal or high)\n";
+                    return 1;
+                }
+            } else {
+                std::wcerr << L"Error: --priority requires an argument\n";
+                return 1;
+            }
+        }
+        else if (arg == L"-i" || arg == L"--icon") {
+            if (i + 1 < argc) {
+                options.iconPath = argv[++i];
+                // Convert relative path to absolute
+                try {
+                    std::filesystem::path p(options.iconPath);
+                    if (!p.is_absolute()) {
+                        p = std::filesystem::absolute(p);
+                    }
+                    options.iconPath = p.wstring();
+                } catch (const std::filesystem::filesystem_error&) {
+                    std::wcerr << L"Warning: Could not resolve icon path, using as-is\n";
+                    // iconPath already set, continue with original path
+                }
+            } else {
+                std::wcerr << L"Error: --icon requires an argument\n";
+                return 1;
+            }
+        }
+        else if (arg == L"--debug") {
+            options.debug = true;
+        }
+        else if (arg == L"--dry-run") {
+            g_dryRun = true;
+        }
+        else if (i == argc - 1 && arg[0] == L'{' && is_payload_argument(to_utf8(arg))) {
+            options.payloadArg = arg;
+        }
+        else if (arg[0] != L'-' && options.message.empty()) {
+            options.message = arg;
+        }
+    }
+    return -1;
 }
 
-// Handle --install command
-void handle_install(const std::wstring& agent) {
-    std::wstring exePath = get_exe_path();
-    
-    if (exePath.empty()) {
-        std::wcerr << L"Error: Could not determine toasty.exe path\n";
-        return;
+// Lazily resolved state for one notification. Each stage runs at most once, and only
+// when a later stage asks for its result: --app skips preset detection entirely, a
+// custom icon skips extraction, and a cached ancestry skips the process-tree walk.
+struct NotificationContext {
+    const Options& options;
+
+    // Ancestry: cross-run cache first, one shared process-table snapshot on a miss
+    bool ancestryLoaded = false;
+    std::vector<AncestorKey> ancestorKeys;
+    AncestryCacheEntry ancestry = {};   // ancestry.flags says which fields are known
+    DWORD walkedFlags = 0;              // Fields resolved by walking in this run
+    std::optional<ProcessTable> processTable;
+
+    bool presetResolved = false;
+    const AppPreset* presetValue = nullptr;
+    std::optional<std::wstring> iconValue;
+    bool windowResolved = false;
+    HWND windowValue = nullptr;
+    bool agentStartResolved = false;
+    ULONGLONG agentStart = 0;
+
+    explicit NotificationContext(const Options& opts) : options(opts) {}
+
+    const AncestryCacheEntry& cached_ancestry() {
+        if (!ancestryLoaded) {
+            ancestryLoaded = true;
+            ancestorKeys = get_nearest_ancestor_keys();
+            if (options.debug || !lookup_ancestry_cache(ancestorKeys, ancestry)) {
+                ancestry = {};
+            }
+        }
+        return ancestry;
     }
-    
-    bool installAll = agent.empty() || agent == L"all";
-    bool explicitAgent = !installAll;  // User explicitly named an agent
-    bool installClaude = installAll || agent == L"claude";
-    bool installGemini = installAll || agent == L"gemini";
-    bool installCopilot = installAll || agent == L"copilot";
-    bool installCodex = installAll || agent == L"codex";
 
-    if (g_dryRun) {
-        std::wcout << L"[dry-run] Install targets:";
-        if (installClaude) std::wcout << L" claude";
-        if (installGemini) std::wcout << L" gemini";
-        if (installCopilot) std::wcout << L" copilot";
-        if (installCodex) std::wcout << L" codex";
-        std::wcout << L"\n";
-        
-        if (installClaude) {
-            std::wstring configPath = expand_env(L"%USERPROFILE%\\.claude\\settings.json");
-            std::wcout << L"[dry-run] Would write: " << configPath << L"\n";
-            std::wstring shellPath = normalize_path_for_shell(exePath);
-            std::wcout << L"[dry-run] Hook command: " << shellPath << L" \"Task complete\" -t \"Claude Code\"\n";
-            std::wcout << L"[dry-run] Hook type: Stop\n";
-        }
-        if (installGemini) {
-            std::wstring configPath = expand_env(L"%USERPROFILE%\\.gemini\\settings.json");
-            std::wcout << L"[dry-run] Would write: " << configPath << L"\n";
-            std::wstring shellPath = normalize_path_for_shell(exePath);
-            std::wcout << L"[dry-run] Hook command: " << shellPath << L" \"Gemini finished\" -t \"Gemini\"\n";
-            std::wcout << L"[dry-run] Hook type: AfterAgent\n";
-        }
-        if (installCopilot) {
-            std::wcout << L"[dry-run] Would write: .github\\hooks\\toasty.json\n";
-            std::wcout << L"[dry-run] Hook command: toasty 'Copilot finished' -t 'GitHub Copilot'\n";
-            std::wcout << L"[dry-run] Hook type: sessionEnd\n";
-        }
-        if (installCodex) {
-            std::wstring configPath = expand_env(L"%USERPROFILE%\\.codex\\config.toml");
-            std::wcout << L"[dry-run] Would write: " << configPath << L"\n";
-            std::wcout << L"[dry-run] Hook type: notify\n";
+    const ProcessTable& process_table() {
+        if (!processTable) {
+            processTable = snapshot_process_table();
         }
-        return;
+        return *processTable;
     }
 
-    std::wcout << L"Detecting AI CLI agents...\n";
+    // Stage: preset resolution (explicit --app, else auto-detect from ancestors)
+    const AppPreset* preset() {
+        if (!presetResolved) {
+            presetResolved = true;
+            if (options.explicitApp) {
+                presetValue = options.explicitApp;
+            } else if (cached_ancestry().flags & ANCESTRY_PRESET_KNOWN) {
+                presetValue = find_preset(ancestry.preset);
+            } else {
+                presetValue = detect_preset_from_ancestors(process_table(), options.debug);
+                wcsncpy_s(ancestry.preset, presetValue ? presetValue->name.c_str() : L"", _TRUNCATE);
+                walkedFlags |= ANCESTRY_PRESET_KNOWN;
+            }
+        }
+        return presetValue;
+    }
 
-    bool claudeDetected = detect_claude();
-    bool geminiDetected = detect_gemini();
-    bool copilotDetected = detect_copilot();
-    bool codexDetected = detect_codex();
+    std::wstring title() {
+        if (options.explicitTitle) return options.title;
+        const AppPreset* p = preset();
+        return p ? p->title : L"Notification";
+    }
 
-    std::wcout << L"  " << (claudeDetected ? L"[x]" : L"[ ]") << L" Claude Code found\n";
-    std::wcout << L"  " << (geminiDetected ? L"[x]" : L"[ ]") << L" Gemini CLI found\n";
-    std::wcout << L"  " << (copilotDetected ? L"[x]" : L"[ ]") << L" GitHub Copilot (in current repo)\n";
-    std::wcout << L"  " << (codexDetected ? L"[x]" : L"[ ]") << L" OpenAI Codex found\n";
-    std::wcout << L"\n";
+    // Stage: icon resolution (needs the final preset)
+    const std::wstring& icon_path() {
+        if (!iconValue) {
+            if (!options.iconPath.empty()) {
+                iconValue = options.iconPath;
+            } else {
+                // No AI agent detected - use toasty mascot as default icon
+                const AppPreset* p = preset();
+                iconValue = extract_icon_to_cache(p ? p->iconResourceId : IDI_TOASTY);
+                if (iconValue->empty() && options.explicitApp) {
+                    std::wcerr << L"Warning: Failed to extract icon for preset '" << options.explicitApp->name << L"'\n";
+                }
+            }
+        }
+        return *iconValue;
+    }
 
-    std::wcout << L"Installing toasty hooks...\n";
+    // Stage: how long the agent ancestor has been running, -1 if none was found.
+    // Always walks the tree, so only templates using {duration} ask for it.
+    int64_t agent_uptime_ms() {
+        if (!agentStartResolved) {
+            agentStartResolved = true;
+            DWORD pid = 0;
+            if (detect_preset_from_ancestors(process_table(), false, &pid)) {
+                agentStart = get_creation_time(process_table(), pid);
+            }
+        }
+        if (agentStart == 0) return -1;
+        ULONGLONG now = get_filetime_now();
+        return now > agentStart ? static_cast<int64_t>((now - agentStart) / 10000) : 0;
+    }
 
-    bool anyInstalled = false;
+    // Stage: window capture (terminal/IDE window that launched us, for click-to-focus)
+    HWND terminal_window() {
+        if (!windowResolved) {
+            windowResolved = true;
+            HWND cachedWnd = (HWND)(ULONG_PTR)cached_ancestry().terminalWindow;
+            if ((ancestry.flags & ANCESTRY_WINDOW_KNOWN) && (!cachedWnd || IsWindow(cachedWnd))) {
+                windowValue = cachedWnd;
+            } else {
+                windowValue = find_ancestor_window(process_table());
+                ancestry.terminalWindow = (ULONGLONG)(ULONG_PTR)windowValue;
+                walkedFlags |= ANCESTRY_WINDOW_KNOWN;
+            }
 
-    // If user explicitly named an agent, install even if not detected
-    if (installClaude && (claudeDetected || explicitAgent)) {
-        if (install_claude(exePath)) {
-            std::wcout << L"  [x] Claude Code: Added Stop hook\n";
-            anyInstalled = true;
-        } else {
-            std::wcout << L"  [ ] Claude Code: Failed to install\n";
+            // Fallback: if process tree didn't find a window, search for any terminal
+            if (!windowValue) {
+                windowValue = find_any_terminal_window();
+            }
         }
+        return windowValue;
     }
-    
-    if (installGemini && (geminiDetected || explicitAgent)) {
-        if (install_gemini(exePath)) {
-            std::wcout << L"  [x] Gemini CLI: Added AfterAgent hook\n";
-            anyInstalled = true;
-        } else {
-            std::wcout << L"  [ ] Gemini CLI: Failed to install\n";
+
+    // Remember whatever was resolved by walking, for the next invocation
+    void save_ancestry() {
+        if (walkedFlags) {
+            AncestryCacheEntry resolved = ancestry;
+            resolved.flags = walkedFlags;
+            store_ancestry_cache(ancestorKeys, resolved);
         }
     }
-    
-    if (installCopilot && (copilotDetected || explicitAgent)) {
-        if (install_copilot(exePath)) {
-            std::wcout << L"  [x] GitHub Copilot: Added sessionEnd hook\n";
-            std::wcout << L"      Note: This is repo-level only, not global\n";
-            anyInstalled = true;
-        } else {
-            std::wcout << L"  [ ] GitHub Copilot: Failed to install\n";
+};
+
+// Build toast XML with protocol activation for click-to-focus
+std::wstring build_toast_xml(const std::wstring& title, const std::wstring& message, const std::wstring& iconPath) {
+    std::wstring xml;
+    xml.reserve(256 + iconPath.size() + title.size() + message.size());
+    xml = L"<toast activationType=\"protocol\" launch=\"toasty://focus\"><visual><binding template=\"ToastGeneric\">";
+
+    // Add icon if provided
+    if (!iconPath.empty()) {
+        xml += L"<image placement=\"appLogoOverride\" src=\"";
+        append_xml_escaped(xml, iconPath);
+        xml += L"\"/>";
+    }
+
+    xml += L"<text>";
+    append_xml_escaped(xml, title);
+    xml += L"</text><text>";
+    append_xml_escaped(xml, from_utf8(sanitize_text(message, sink_message_limit(SinkKind::Toast))));
+    xml += L"</text></binding></visual></toast>";
+    return xml;
+}
+
+// Rate limit from TOASTY_RATE_LIMIT ("<count>/<seconds>" or "off"), default 5 per 30 seconds
+RateLimit get_rate_limit() {
+    RateLimit limit;
+    wchar_t value[32];
+    DWORD len = GetEnvironmentVariableW(L"TOASTY_RATE_LIMIT", value, 32);
+    if (len > 0 && len < 32 && !parse_rate_limit(to_utf8(to_lower(value)), limit)) {
+        std::wcerr << L"Warning: Ignoring invalid TOASTY_RATE_LIMIT '" << value << L"'\n";
+    }
+    return limit;
+}
+
+std::wstring get_working_directory() {
+    wchar_t cwd[MAX_PATH];
+    DWORD len = GetCurrentDirectoryW(MAX_PATH, cwd);
+    return (len > 0 && len < MAX_PATH) ? std::wstring(cwd, len) : L"";
+}
+
+// Fill in the fields the templates use, and only those: git context means file reads
+// and {duration} a process-tree walk
+TemplateValues resolve_template_values(NotificationContext& context, const AgentPayload& payload,
+                                       const std::wstring& workingDir,
+                                       std::initializer_list<const TextTemplate*> templates) {
+    auto used = [&templates](TemplateField field) {
+        for (const TextTemplate* compiled : templates) {
+            if (compiled->uses(field)) return true;
         }
+        return false;
+    };
+
+    TemplateValues values;
+    if (used(TemplateField::Preset)) {
+        const AppPreset* preset = context.preset();
+        values[TemplateField::Preset] = preset ? to_utf8(preset->title) : "";
     }
-    
-    if (installCodex && (codexDetected || explicitAgent)) {
-        if (install_codex(exePath)) {
-            std::wcout << L"  [x] OpenAI Codex: Added notify hook\n";
-            anyInstalled = true;
-        } else {
-            std::wcout << L"  [ ] OpenAI Codex: Failed to install\n";
+    if (used(TemplateField::Cwd)) {
+        values[TemplateField::Cwd] = to_utf8(workingDir);
+    }
+    if (used(TemplateField::Repo) || used(TemplateField::Branch)) {
+        read_git_context(std::filesystem::path(workingDir), values[TemplateField::Repo], values[TemplateField::Branch]);
+    }
+    if (used(TemplateField::Event)) {
+        values[TemplateField::Event] = json_unescape(payload.eventName);
+    }
+    if (used(TemplateField::Session)) {
+        values[TemplateField::Session] = json_unescape(payload.sessionId);
+    }
+    if (used(TemplateField::Message)) {
+        values[TemplateField::Message] = payload_summary(sanitize_json_string(payload.lastMessage, MAX_MESSAGE_BYTES));
+    }
+    if (used(TemplateField::Duration)) {
+        values[TemplateField::Duration] = format_duration(context.agent_uptime_ms());
+    }
+    for (const TextTemplate* compiled : templates) {
+        for (std::string_view name : compiled->env_names()) {
+            wchar_t value[2048];
+            DWORD len = GetEnvironmentVariableW(from_utf8(std::string(name)).c_str(), value, 2048);
+            values.env.emplace_back(std::string(name), len > 0 && len < 2048 ? to_utf8(std::wstring(value, len)) : "");
         }
     }
-    
-    if (anyInstalled) {
-        std::wcout << L"\nDone! You'll get notifications when AI agents finish.\n";
-    } else {
-        std::wcout << L"\nNo agents were installed. Check detection status above.\n";
+    return values;
+}
+
+// Spend a token from the bucket for this source and working directory. Returns false
+// if the notification should be dropped; otherwise suppressed is the number of events
+// dropped since the last one that was shown.
+bool check_rate_limit(const std::wstring& source, const std::wstring& workingDir, uint32_t& suppressed) {
+    suppressed = 0;
+    RateLimit limit = get_rate_limit();
+    const std::wstring& dataDir = get_toasty_data_dir();
+    if (limit.capacity <= 0 || dataDir.empty()) {
+        return true;
     }
+
+    std::error_code ec;
+    std::filesystem::create_directories(dataDir, ec);
+
+    // Paths are case-insensitive on Windows, so normalize before keying
+    std::wstring dir = to_lower(workingDir);
+
+    uint64_t key = rate_limit_key(to_utf8(source), to_utf8(dir));
+    int64_t nowMs = static_cast<int64_t>(get_filetime_now() / 10000);
+    RateDecision decision = take_rate_token(std::filesystem::path(dataDir) / L"ratelimit.state", key, limit, nowMs);
+    suppressed = decision.suppressed;
+    return decision.allowed;
 }
 
-// Handle --uninstall command
-void handle_uninstall() {
-    if (g_dryRun) {
-        std::wcout << L"[dry-run] Would check and remove hooks from:\n";
-        std::wstring claudePath = expand_env(L"%USERPROFILE%\\.claude\\settings.json");
-        std::wstring geminiPath = expand_env(L"%USERPROFILE%\\.gemini\\settings.json");
-        std::wstring codexPath = expand_env(L"%USERPROFILE%\\.codex\\config.toml");
-        std::wcout << L"[dry-run]   Claude: " << claudePath << L"\n";
-        std::wcout << L"[dry-run]   Gemini: " << geminiPath << L"\n";
-        std::wcout << L"[dry-run]   Copilot: .github\\hooks\\toasty.json\n";
-        std::wcout << L"[dry-run]   Codex: " << codexPath << L"\n";
+// Appends to %LOCALAPPDATA%\Toasty\history unless TOASTY_HISTORY is off
+void record_history(const HistoryRecord& record, bool debug) {
+    wchar_t value[16];
+    DWORD len = GetEnvironmentVariableW(L"TOASTY_HISTORY", value, 16);
+    std::string setting = len > 0 && len < 16 ? to_utf8(std::wstring(value, len)) : "";
+    std::filesystem::path dir = history_directory(get_toasty_data_dir(), setting);
+    if (dir.empty()) {
         return;
     }
+    std::string error;
+    if (!HistoryLog(dir).append(record, error) && debug) {
+        std::wcerr << L"[debug] History not recorded: " << from_utf8(error) << L"\n";
+    }
+}
 
-    std::wcout << L"Removing toasty hooks...\n";
-    
-    bool anyUninstalled = false;
-    
-    if (is_claude_installed()) {
-        if (uninstall_claude()) {
-            std::wcout << L"  [x] Claude Code: Removed hooks\n";
-            anyUninstalled = true;
-        } else {
-            std::wcout << L"  [ ] Claude Code: Failed to remove\n";
-        }
+// --history: answered from the log's time and preset indexes
+int show_history(const Options& options) {
+    HistoryQuery query;
+    std::wstring since = options.historySince.empty() ? L"1d" : options.historySince;
+    if (!parse_history_since(to_utf8(since), get_unix_time_ms(), query.sinceMs)) {
+        std::wcerr << L"Error: Invalid --since '" << since << L"' (use 30m, 2h, 7d or 2026-10-17 13:30)\n";
+        return 1;
     }
-    
-    if (is_gemini_installed()) {
-        if (uninstall_gemini()) {
-            std::wcout << L"  [x] Gemini CLI: Removed hooks\n";
-            anyUninstalled = true;
-        } else {
-            std::wcout << L"  [ ] Gemini CLI: Failed to remove\n";
-        }
+    if (options.explicitApp) {
+        query.preset = to_utf8(options.explicitApp->name);
     }
-    
-    if (is_copilot_installed()) {
-        if (uninstall_copilot()) {
-            std::wcout << L"  [x] GitHub Copilot: Removed hooks\n";
-            anyUninstalled = true;
-        } else {
-            std::wcout << L"  [ ] GitHub Copilot: Failed to remove\n";
-        }
+
+    const std::wstring& dataDir = get_toasty_data_dir();
+    HistoryQueryStats stats;
+    std::vector<HistoryRecord> records;
+    if (!dataDir.empty()) {
+        records = HistoryLog(std::filesystem::path(dataDir) / L"history").query(query, &stats);
     }
-    
-    if (is_codex_installed()) {
-        if (uninstall_codex()) {
-            std::wcout << L"  [x] OpenAI Codex: Removed notify hook\n";
-            anyUninstalled = true;
-        } else {
-            std::wcout << L"  [ ] OpenAI Codex: Failed to remove\n";
-        }
+    // UTF-8 straight to stdout, as --status --json does
+    for (const HistoryRecord& record : records) {
+        std::cout << (options.json ? history_json(record) : history_line(record)) << "\n";
     }
-    
-    if (anyUninstalled) {
-        std::wcout << L"\nDone! Hooks have been removed.\n";
-    } else {
-        std::wcout << L"\nNo hooks were installed.\n";
+    if (records.empty() && !options.json) {
+        std::wcout << L"No notifications since " << since
+                   << (query.preset.empty() ? L"" : L" from " + options.explicitApp->name) << L"\n";
+    }
+    if (options.debug) {
+        std::wcerr << L"[debug] History: read " << stats.recordsRead << L" records from " << stats.segmentsRead
+                   << L" of " << stats.segments << L" segments\n";
     }
+    return 0;
 }
 
-// Create a Start Menu shortcut with our AppUserModelId
-bool create_shortcut() {
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+// Burst coalescing window from TOASTY_COALESCE_MS (0 = disabled, the default), capped
+// at MAX_BURST_WINDOW_MS
+int get_coalesce_window_ms() {
+    wchar_t value[16];
+    DWORD len = GetEnvironmentVariableW(L"TOASTY_COALESCE_MS", value, 16);
+    if (len == 0 || len >= 16) {
+        return 0;
+    }
+    return parse_coalesce_window(to_utf8(std::wstring(value, len)));
+}
 
-    wchar_t startMenuPath[MAX_PATH];
-    if (FAILED(SHGetFolderPathW(nullptr, CSIDL_PROGRAMS, nullptr, 0, startMenuPath))) {
-        return false;
+// Merge notifications that arrive within the window into one summary toast.
+// Returns false if this process joined another's burst (nothing left to show);
+// otherwise we lead the burst, and title/message/icon describe everything that joined.
+bool coalesce_notification(const std::wstring& source, std::wstring& title, std::wstring& message,
+                           std::wstring& iconPath, int windowMs) {
+    const std::wstring& dataDir = get_toasty_data_dir();
+    if (dataDir.empty()) {
+        return true;
     }
 
-    std::wstring shortcutPath = std::wstring(startMenuPath) + L"\\Toasty.lnk";
+    std::error_code ec;
+    std::filesystem::create_directories(dataDir, ec);
+    std::filesystem::path spoolPath = std::filesystem::path(dataDir) / L"burst.spool";
 
-    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    DWORD pid = GetCurrentProcessId();
+    ULONGLONG startTime = get_process_creation_time(pid);
+    auto isAlive = [](uint32_t leaderPid, uint64_t leaderStart) {
+        return get_process_creation_time(leaderPid) == leaderStart;
+    };
 
-    IShellLinkW* shellLink = nullptr;
-    HRESULT hr = CoCreateInstance(CLSID_ShellLink, nullptr, CLSCTX_INPROC_SERVER,
-                                   IID_IShellLinkW, (void**)&shellLink);
-    if (FAILED(hr)) {
-        CoUninitialize();
-        return false;
+    BurstEntry entry{ to_utf8(source), to_utf8(title), to_utf8(message) };
+    int64_t nowMs = static_cast<int64_t>(get_filetime_now() / 10000);
+    BurstRole role = join_burst(spoolPath, entry, pid, startTime, windowMs, nowMs, isAlive);
+    if (role != BurstRole::Leader) {
+        return role == BurstRole::Alone;
     }
 
-    shellLink->SetPath(exePath);
-    shellLink->SetDescription(L"Toasty - Toast Notification CLI");
+    Sleep(windowMs);
 
-    IPropertyStore* propStore = nullptr;
-    hr = shellLink->QueryInterface(IID_IPropertyStore, (void**)&propStore);
-    if (SUCCEEDED(hr)) {
-        PROPVARIANT pv;
-        hr = InitPropVariantFromString(APP_ID, &pv);
-        if (SUCCEEDED(hr)) {
-            propStore->SetValue(PKEY_AppUserModel_ID, pv);
-            PropVariantClear(&pv);
-        }
-        propStore->Commit();
-        propStore->Release();
+    std::vector<BurstEntry> entries;
+    if (!close_burst(spoolPath, pid, startTime, entries)) {
+        return false;  // Taken over: the new leader shows our notification with its burst
+    }
+    if (entries.size() <= 1) {
+        return true;  // Alone in the burst: show our own notification
     }
 
-    IPersistFile* persistFile = nullptr;
-    hr = shellLink->QueryInterface(IID_IPersistFile, (void**)&persistFile);
-    if (SUCCEEDED(hr)) {
-        hr = persistFile->Save(shortcutPath.c_str(), TRUE);
-        persistFile->Release();
+    BurstSummary summary = summarize_burst(entries);
+    title = from_utf8(summary.title);
+    message = from_utf8(summary.message);
+
+    // Use the shared agent's icon when the whole burst came from one preset
+    const AppPreset* preset = summary.source.empty() ? nullptr : find_preset(from_utf8(summary.source));
+    iconPath = extract_icon_to_cache(preset ? preset->iconResourceId : IDI_TOASTY);
+    return true;
+}
+
+// Connect to a resident daemon (toasty --serve). Returns nullptr quickly if none is
+// running, in which case the caller shows the toast in-process.
+// Set TOASTY_NO_DAEMON to always use the in-process path.
+std::unique_ptr<IpcConnection> connect_to_daemon() {
+    if (GetEnvironmentVariableW(L"TOASTY_NO_DAEMON", nullptr, 0) > 0) {
+        return nullptr;
     }
 
-    shellLink->Release();
-    CoUninitialize();
+    // Fails immediately when no daemon is listening
+    return ipc_connect(default_ipc_endpoint(), 50);
+}
+
+// Forward a resolved notification to the daemon, with the ntfy push to send (or nullptr).
+// Returns false if the daemon didn't take it.
+bool forward_to_daemon(IpcConnection& connection, const std::wstring& title, const std::wstring& message,
+                       const std::wstring& iconPath, HWND terminalWnd, const NtfyConfig* ntfy) {
+    IpcMessage request;
+    request.type = IPC_NOTIFY;
+    request.set(IPC_FIELD_TITLE, to_utf8(title));
+    request.set(IPC_FIELD_MESSAGE, to_utf8(message));
+    request.set(IPC_FIELD_ICON, to_utf8(iconPath));
+    if (terminalWnd) {
+        request.set(IPC_FIELD_WINDOW, std::to_string((ULONG_PTR)terminalWnd));
+    }
+
+    // ntfy settings come from the hook's environment, not the daemon's
+    if (ntfy) {
+        request.set(IPC_FIELD_NTFY_SERVER, to_utf8(ntfy->server));
+        request.set(IPC_FIELD_NTFY_TOPIC, to_utf8(ntfy->topic));
+    }
+
+    if (!connection.send(request, 1000)) {
+        return false;
+    }
+
+    // Once the request is delivered, a missing reply is treated as success:
+    // showing it again in-process would risk a duplicate toast
+    IpcMessage reply;
+    if (!connection.receive(reply, 3000)) {
+        return true;
+    }
+    const std::string* status = reply.get(IPC_FIELD_STATUS);
+    return reply.type == IPC_REPLY && status && *status == "ok";
+}
+
+// Show a toast in-process, registering the app on first use
+bool show_toast(const std::wstring& xml, HWND terminalWnd) {
+    try {
+        // Auto-register if needed
+        ensure_registered();
+
+        init_apartment();
+
+        // Set our AppUserModelId for this process
+        SetCurrentProcessExplicitAppUserModelID(APP_ID);
+
+        XmlDocument doc;
+        doc.LoadXml(xml);
+
+        ToastNotification toast(doc);
 
-    if (SUCCEEDED(hr)) {
-        // Also register the protocol handler for click-to-focus
-        register_protocol();
-        std::wcout << L"Registered! Shortcut created at:\n" << shortcutPath << L"\n";
+        auto notifier = ToastNotificationManager::CreateToastNotifier(APP_ID);
+        notifier.Show(toast);
+
+        // Save the terminal window handle for click-to-focus
+        record_toast_shown(terminalWnd);
         return true;
     }
-    return false;
+    catch (const hresult_error& ex) {
+        std::wcerr << L"Error: " << ex.message().c_str() << L"\n";
+        return false;
+    }
 }
 
-bool is_registered() {
-    wchar_t startMenuPath[MAX_PATH];
-    if (FAILED(SHGetFolderPathW(nullptr, CSIDL_PROGRAMS, nullptr, 0, startMenuPath))) {
+// Sinks for a preset: TOASTY_SINKS_<PRESET> (e.g. TOASTY_SINKS_CLAUDE), else TOASTY_SINKS,
+// else the local toast plus ntfy (which only sends when TOASTY_NTFY_TOPIC is set)
+bool get_sink_configs(const AppPreset* preset, std::vector<SinkConfig>& configs) {
+    std::wstring name;
+    std::wstring spec = L"toast,ntfy";
+    auto read = [&name, &spec](const std::wstring& varName) {
+        wchar_t value[2048];
+        DWORD len = GetEnvironmentVariableW(varName.c_str(), value, 2048);
+        if (len == 0 || len >= 2048) return false;
+        name = varName;
+        spec = value;
+        return true;
+    };
+
+    std::wstring presetVar;
+    if (preset) {
+        presetVar = L"TOASTY_SINKS_" + preset->name;
+        std::transform(presetVar.begin(), presetVar.end(), presetVar.begin(), ::towupper);
+    }
+    if (presetVar.empty() || !read(presetVar)) {
+        read(L"TOASTY_SINKS");
+    }
+
+    std::string error;
+    if (!parse_sink_configs(to_utf8(spec), configs, error)) {
+        std::wcerr << L"Error: Invalid " << name << L": " << from_utf8(error) << L"\n";
         return false;
     }
-    std::wstring shortcutPath = std::wstring(startMenuPath) + L"\\Toasty.lnk";
-    return GetFileAttributesW(shortcutPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+    return true;
 }
 
-bool ensure_registered() {
-    // Always ensure protocol handler is registered for click-to-focus
-    register_protocol();
+bool has_sink(const std::vector<SinkConfig>& configs, SinkKind kind) {
+    return std::any_of(configs.begin(), configs.end(), [kind](const SinkConfig& c) { return c.kind == kind; });
+}
 
-    if (is_registered()) {
-        return true;
+
+// Network work queued by the daemon's connection threads, sent by one worker thread
+struct DaemonJob {
+    NtfyConfig ntfy;
+    std::wstring title;
+    std::wstring message;
+};
+
+struct DaemonQueue {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<DaemonJob> jobs;
+
+    void push(DaemonJob job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
     }
-    // Silently self-register
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+};
 
-    wchar_t startMenuPath[MAX_PATH];
-    if (FAILED(SHGetFolderPathW(nullptr, CSIDL_PROGRAMS, nullptr, 0, startMenuPath))) {
-        return false;
+// Network side of the daemon. One transport lives as long as the daemon, so pushes
+// reuse a warm connection, and jobs that piled up while a request was in flight are
+// sent together.
+void run_daemon_worker(DaemonQueue& queue) {
+    init_apartment();
+    auto transport = create_toasty_transport();
+    for (;;) {
+        std::deque<DaemonJob> jobs;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.ready.wait(lock, [&queue]() { return !queue.jobs.empty(); });
+            jobs.swap(queue.jobs);
+        }
+
+        std::vector<std::pair<std::wstring, NtfyMessage>> batch;
+        for (const auto& job : jobs) {
+            if (!job.ntfy.topic.empty()) {
+                batch.emplace_back(job.ntfy.server, make_ntfy_message(job.ntfy, job.title, job.message));
+            }
+        }
+        send_ntfy_batch(*transport, batch);
+
+        // Check for updates (throttled to once per day)
+        check_for_updates(*transport);
     }
+}
 
-    std::wstring shortcutPath = std::wstring(startMenuPath) + L"\\Toasty.lnk";
+// Serve one client: show its toast on the daemon's notifier and queue side channels
+void handle_daemon_connection(IpcConnection& connection, const ToastNotifier& notifier, DaemonQueue& queue) {
+    IpcMessage request;
+    if (!connection.receive(request, 5000)) {
+        return;  // Probe or broken client
+    }
 
-    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    IpcMessage reply;
+    reply.type = IPC_REPLY;
 
-    IShellLinkW* shellLink = nullptr;
-    HRESULT hr = CoCreateInstance(CLSID_ShellLink, nullptr, CLSCTX_INPROC_SERVER,
-                                   IID_IShellLinkW, (void**)&shellLink);
-    if (FAILED(hr)) {
-        CoUninitialize();
-        return false;
+    if (request.type == IPC_PING) {
+        reply.set(IPC_FIELD_STATUS, "ok");
+    } else if (request.type == IPC_NOTIFY) {
+        auto field = [&request](uint8_t tag) {
+            const std::string* value = request.get(tag);
+            return value ? from_utf8(*value) : std::wstring();
+        };
+
+        DaemonJob job;
+        job.title = field(IPC_FIELD_TITLE);
+        job.message = field(IPC_FIELD_MESSAGE);
+        job.ntfy.server = field(IPC_FIELD_NTFY_SERVER);
+        job.ntfy.topic = field(IPC_FIELD_NTFY_TOPIC);
+
+        try {
+            XmlDocument doc;
+            doc.LoadXml(build_toast_xml(job.title, job.message, field(IPC_FIELD_ICON)));
+            notifier.Show(ToastNotification(doc));
+            reply.set(IPC_FIELD_STATUS, "ok");
+        } catch (const hresult_error& ex) {
+            reply.set(IPC_FIELD_STATUS, to_utf8(ex.message().c_str()));
+        }
+
+        // Save the client's terminal window handle for click-to-focus
+        HWND clientWnd = nullptr;
+        if (const std::string* window = request.get(IPC_FIELD_WINDOW)) {
+            HWND hwnd = (HWND)(ULONG_PTR)std::strtoull(window->c_str(), nullptr, 10);
+            if (IsWindow(hwnd)) {
+                clientWnd = hwnd;
+            }
+        }
+        record_toast_shown(clientWnd);
+
+        queue.push(std::move(job));
+    } else {
+        reply.set(IPC_FIELD_STATUS, "unknown request");
     }
 
-    shellLink->SetPath(exePath);
-    shellLink->SetDescription(L"Toasty - Toast Notification CLI");
+    connection.send(reply, 2000);
+}
 
-    IPropertyStore* propStore = nullptr;
-    hr = shellLink->QueryInterface(IID_IPropertyStore, (void**)&propStore);
-    if (SUCCEEDED(hr)) {
-        PROPVARIANT pv;
-        hr = InitPropVariantFromString(APP_ID, &pv);
-        if (SUCCEEDED(hr)) {
-            propStore->SetValue(PKEY_AppUserModel_ID, pv);
-            PropVariantClear(&pv);
+// Daemon mode (toasty --serve): owns registration, the WinRT apartment, the toast
+// notifier and the network side channels. Clients forward over a per-user named pipe.
+int run_daemon() {
+    std::string endpoint = default_ipc_endpoint();
+    auto listener = ipc_listen(endpoint);
+    if (!listener) {
+        std::wcerr << L"Error: A toasty daemon is already running (or the pipe could not be created)\n";
+        return 1;
+    }
+
+    ensure_registered();
+    init_apartment();
+    SetCurrentProcessExplicitAppUserModelID(APP_ID);
+    ToastNotifier notifier = ToastNotificationManager::CreateToastNotifier(APP_ID);
+
+    DaemonQueue queue;
+    std::thread(run_daemon_worker, std::ref(queue)).detach();
+
+    std::wcout << L"toasty daemon listening on " << from_utf8(endpoint) << L" (Ctrl+C to stop)\n";
+
+    for (;;) {
+        std::unique_ptr<IpcConnection> connection = listener->accept();
+        if (!connection) {
+            Sleep(100);  // Transient pipe error; keep serving
+            continue;
         }
-        propStore->Commit();
-        propStore->Release();
+
+        std::thread([conn = std::move(connection), notifier, &queue]() {
+            init_apartment();
+            handle_daemon_connection(*conn, notifier, queue);
+        }).detach();
     }
+}
 
-    IPersistFile* persistFile = nullptr;
-    hr = shellLink->QueryInterface(IID_IPersistFile, (void**)&persistFile);
-    if (SUCCEEDED(hr)) {
-        hr = persistFile->Save(shortcutPath.c_str(), TRUE);
-        persistFile->Release();
+// Windows platform backend for the shared core (see core/platform.h): paths only.
+// wmain detects presets through the ancestry cache and shows toasts itself, with
+// daemon forwarding and click-to-focus.
+class WindowsPlatform : public Platform {
+public:
+    std::filesystem::path home_dir() const override {
+        return expand_env(L"%USERPROFILE%");
     }
 
-    shellLink->Release();
-    CoUninitialize();
+    std::filesystem::path data_dir() const override {
+        return get_toasty_data_dir();
+    }
 
-    if (SUCCEEDED(hr)) {
-        // Also register the protocol handler for click-to-focus
-        register_protocol();
+    std::filesystem::path exe_path() const override {
+        return get_exe_path();
     }
-    return SUCCEEDED(hr);
+};
+
+std::unique_ptr<Platform> create_platform() {
+    return std::make_unique<WindowsPlatform>();
 }
 
+// Startup pipeline: arg parse -> (mode commands) | preset -> icon -> window capture ->
+// daemon hand-off | registration -> show -> side channels (detached).
+// Only the stages a mode needs ever run.
 int wmain(int argc, wchar_t* argv[]) {
     if (argc < 2) {
         print_usage();
         return 0;
     }
 
-    std::wstring message;
-    std::wstring title = L"Notification";
-    std::wstring iconPath;
-    bool doInstall = false;
-    bool doUninstall = false;
-    bool doStatus = false;
-    bool doFocus = false;
-    bool doRegister = false;
-    std::wstring installAgent;
-    bool explicitApp = false;  // Track if user explicitly set --app
-    bool explicitTitle = false; // Track if user explicitly set -t
-    bool debug = false;
-
-    // Quick scan for --debug and --dry-run flags
-    for (int i = 1; i < argc; i++) {
-        std::wstring flag(argv[i]);
-        if (flag == L"--debug") {
-            debug = true;
-        } else if (flag == L"--dry-run") {
-            g_dryRun = true;
-        }
+    Options options;
+    int parseResult = parse_options(argc, argv, options);
+    if (parseResult >= 0) {
+        return parseResult;
     }
 
-    // Auto-detect parent process and apply preset if found
-    const AppPreset* autoPreset = detect_preset_from_ancestors(debug);
-    if (autoPreset) {
-        title = autoPreset->title;
-        iconPath = extract_icon_to_temp(autoPreset->iconResourceId);
-    } else {
-        // No AI agent detected - use toasty mascot as default icon
-        iconPath = extract_icon_to_temp(IDI_TOASTY);
+    if (options.doStatus) {
+        show_status(*create_platform(), options.json);
+        return 0;
     }
 
-    for (int i = 1; i < argc; i++) {
-        std::wstring arg = argv[i];
-
-        if (arg == L"-h" || arg == L"--help") {
-            print_usage();
-            return 0;
-        }
-        else if (arg == L"-v" || arg == L"--version") {
-            std::wcout << L"toasty v" << TOASTY_VERSION << L"\n";
-            return 0;
-        }
-        else if (arg == L"--install") {
-            doInstall = true;
-            // Check if next arg is an agent name
-            if (i + 1 < argc && argv[i + 1][0] != L'-') {
-                installAgent = argv[++i];
-            }
-        }
-        else if (arg == L"--uninstall") {
-            doUninstall = true;
-        }
-        else if (arg == L"--status") {
-            doStatus = true;
-        }
-        else if (arg == L"--focus") {
-            doFocus = true;
-        }
-        else if (arg == L"--register") {
-            doRegister = true;
-        }
-        else if (arg == L"-t" || arg == L"--title") {
-            if (i + 1 < argc) {
-                title = argv[++i];
-                explicitTitle = true;
-            } else {
-                std::wcerr << L"Error: --title requires an argument\n";
-                return 1;
-            }
-        }
-        else if (arg == L"--app") {
-            if (i + 1 < argc) {
-                std::wstring appName = argv[++i];
-                const AppPreset* preset = find_preset(appName);
-                if (preset) {
-                    // Only override title if user hasn't explicitly set it
-                    if (!explicitTitle) {
-                        title = preset->title;
-                    }
-                    iconPath = extract_icon_to_temp(preset->iconResourceId);
-                    if (iconPath.empty()) {
-                        std::wcerr << L"Warning: Failed to extract icon for preset '" << appName << L"'\n";
-                    }
-                    explicitApp = true;
-                } else {
-                    std::wcerr << L"Error: Unknown app preset '" << appName << L"'\n";
-                    std::wcerr << L"Available presets: claude, copilot, gemini, codex, cursor\n";
-                    return 1;
-                }
-            } else {
-                std::wcerr << L"Error: --app requires an argument\n";
-                return 1;
-            }
-        }
-        else if (arg == L"-i" || arg == L"--icon") {
-            if (i + 1 < argc) {
-                iconPath = argv[++i];
-                // Convert relative path to absolute
-                try {
-                    std::filesystem::path p(iconPath);
-                    if (!p.is_absolute()) {
-                        p = std::filesystem::absolute(p);
-                    }
-                    iconPath = p.wstring();
-                } catch (const std::filesystem::filesystem_error& e) {
-                    std::wcerr << L"Warning: Could not resolve icon path, using as-is\n";
-                    // iconPath already set, continue with original path
-                }
-            } else {
-                std::wcerr << L"Error: --icon requires an argument\n";
-                return 1;
-            }
-        }
-        else if (arg == L"--debug") {
-            // Already handled in pre-scan
-        }
-        else if (arg == L"--dry-run") {
-            // Already handled in pre-scan
-        }
-        else if (arg[0] != L'-' && message.empty()) {
-            message = arg;
-        }
+    if (options.doHistory) {
+        return show_history(options);
     }
 
-    if (doStatus) {
-        init_apartment();
-        show_status();
-        return 0;
+    if (!options.recursiveRoot.empty()) {
+        bool copilot = options.doUninstall || options.installAgent == from_utf8(hook_agent_info(HookAgent::Copilot).name);
+        if (!(options.doInstall || options.doUninstall) || !copilot) {
+            std::wcerr << L"Error: --recursive works with --install copilot or --uninstall (Copilot hooks are per repository)\n";
+            return 1;
+        }
+        return handle_recursive(*create_platform(), options.recursiveRoot, options.doInstall);
     }
 
-    if (doInstall) {
+    if (options.doInstall) {
         init_apartment();
-        handle_install(installAgent);
+        handle_install(*create_platform(), options.installAgent);
         return 0;
     }
 
-    if (doUninstall) {
+    if (options.doUninstall) {
         init_apartment();
-        handle_uninstall();
+        handle_uninstall(*create_platform());
         return 0;
     }
 
-    if (doFocus) {
+    if (options.doFocus) {
         // Called by protocol handler when toast is clicked
         // Detach from console entirely to prevent flash
         FreeConsole();
@@ -2032,17 +2474,7 @@ int wmain(int argc, wchar_t* argv[]) {
         HWND targetWnd = get_saved_console_window_handle();
         if (!targetWnd) {
             // Fallback: find any terminal window
-            EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
-                wchar_t className[256];
-                GetClassNameW(hwnd, className, 256);
-                if (IsWindowVisible(hwnd) &&
-                    (wcscmp(className, L"CASCADIA_HOSTING_WINDOW_CLASS") == 0 ||
-                     wcscmp(className, L"ConsoleWindowClass") == 0)) {
-                    *(HWND*)lParam = hwnd;
-                    return FALSE;
-                }
-                return TRUE;
-            }, (LPARAM)&targetWnd);
+            targetWnd = find_any_terminal_window();
         }
 
         if (targetWnd) {
@@ -2061,13 +2493,17 @@ int wmain(int argc, wchar_t* argv[]) {
 
             // Also try standard approach
             force_foreground_window(targetWnd);
+
+            if (StateFile* state = get_state_file()) {
+                state->update([](ToastyState& s) { s.focusCount++; });
+            }
             return 0;
         }
 
         return 1;
     }
 
-    if (doRegister) {
+    if (options.doRegister) {
         if (create_shortcut()) {
             std::wcout << L"App registered for notifications.\n";
             return 0;
@@ -2077,94 +2513,257 @@ int wmain(int argc, wchar_t* argv[]) {
         }
     }
 
+    if (options.doServe) {
+        return run_daemon();
+    }
+
+    if (options.doDrainQueue) {
+        drain_background_queue();
+        return 0;
+    }
+
+    // The agent's event, if any: fills in a missing message and the real working directory
+    std::string payloadText;
+    AgentPayload payload;
+    bool hasPayload = read_agent_payload(to_utf8(options.payloadArg), payloadText, payload);
+
+    std::wstring message = options.message;
+    if (message.empty() && !payload.lastMessage.empty()) {
+        message = from_utf8(payload_summary(sanitize_json_string(payload.lastMessage, MAX_MESSAGE_BYTES)));
+    }
+    if (message.empty() && !hasPayload) {
+        message = options.payloadArg;  // JSON, but not an agent event
+    }
+    std::wstring workingDir = payload.cwd.empty() ? get_working_directory() : from_utf8(json_unescape(payload.cwd));
+
     if (message.empty()) {
         std::wcerr << L"Error: Message is required.\n";
         print_usage();
         return 1;
     }
 
-    try {
-        // Auto-register if needed
-        ensure_registered();
-
-        init_apartment();
-
-        // Set our AppUserModelId for this process
-        SetCurrentProcessExplicitAppUserModelID(APP_ID);
+    // -t and the message may be templates; the agent's own text never is
+    TextTemplate titleTemplate = TextTemplate::compile(options.explicitTitle ? to_utf8(options.title) : "");
+    TextTemplate messageTemplate = TextTemplate::compile(to_utf8(options.message));
 
-        // Save the terminal window handle for click-to-focus
-        // Walk process tree to find the actual terminal/IDE window
-        HWND terminalWnd = find_ancestor_window();
-
-        // Fallback: if process tree didn't find a window, search for any terminal
-        if (!terminalWnd) {
-            EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
-                wchar_t className[256];
-                GetClassNameW(hwnd, className, 256);
-                if (IsWindowVisible(hwnd) &&
-                    (wcscmp(className, L"CASCADIA_HOSTING_WINDOW_CLASS") == 0 ||
-                     wcscmp(className, L"ConsoleWindowClass") == 0)) {
-                    *(HWND*)lParam = hwnd;
-                    return FALSE;
-                }
-                return TRUE;
-            }, (LPARAM)&terminalWnd);
-        }
+    NotificationContext context(options);
 
-        if (terminalWnd) {
-            save_console_window_handle(terminalWnd);
+    try {
+        std::wstring title = context.title();
+        if (!titleTemplate.is_literal() || !messageTemplate.is_literal()) {
+            TemplateValues values = resolve_template_values(context, payload, workingDir, { &titleTemplate, &messageTemplate });
+            if (!titleTemplate.is_literal()) title = from_utf8(titleTemplate.render(values));
+            if (!messageTemplate.is_literal()) message = from_utf8(messageTemplate.render(values));
         }
 
-        // Build toast XML with protocol activation for click-to-focus
-        std::wstring xml = L"<toast activationType=\"protocol\" launch=\"toasty://focus\"><visual><binding template=\"ToastGeneric\">";
-        
-        // Add icon if provided
-        if (!iconPath.empty()) {
-            xml += L"<image placement=\"appLogoOverride\" src=\"" + escape_xml(iconPath) + L"\"/>";
-        }
-        
-        xml += L"<text>" + escape_xml(title) + L"</text>"
-               L"<text>" + escape_xml(message) + L"</text>"
-               L"</binding></visual></toast>";
+        // Strip terminal escapes and control characters, repair the text and bound its
+        // size once, before it is copied into any sink
+        title = from_utf8(sanitize_text(title, MAX_TITLE_BYTES, true));
+        message = from_utf8(sanitize_text(message, MAX_MESSAGE_BYTES));
+        std::wstring iconPath = context.icon_path();
+        std::wstring xml = build_toast_xml(title, message, iconPath);
 
         if (g_dryRun) {
             std::wcout << L"[dry-run] Title: " << title << L"\n";
             std::wcout << L"[dry-run] Message: " << message << L"\n";
             std::wcout << L"[dry-run] Icon: " << (iconPath.empty() ? L"(none)" : iconPath) << L"\n";
+            if (hasPayload) {
+                std::wcout << L"[dry-run] Payload:";
+                if (!payload.eventName.empty()) std::wcout << L" event=" << from_utf8(json_unescape(payload.eventName));
+                if (!payload.sessionId.empty()) std::wcout << L" session=" << from_utf8(json_unescape(payload.sessionId));
+                if (!payload.cwd.empty()) std::wcout << L" cwd=" << workingDir;
+                std::wcout << L"\n";
+            }
             std::wcout << L"[dry-run] Toast XML:\n" << xml << L"\n";
 
             // Show ntfy status
-            wchar_t topicBuf[256] = {};
-            if (GetEnvironmentVariableW(L"TOASTY_NTFY_TOPIC", topicBuf, 256) && topicBuf[0] != L'\0') {
-                wchar_t serverBuf[256] = {};
-                std::wstring server = L"ntfy.sh";
-                if (GetEnvironmentVariableW(L"TOASTY_NTFY_SERVER", serverBuf, 256) && serverBuf[0] != L'\0') {
-                    server = serverBuf;
-                }
-                std::wcout << L"[dry-run] ntfy: would POST to https://" << server << L"/" << topicBuf << L"\n";
+            NtfyConfig ntfy;
+            if (get_ntfy_config(ntfy)) {
+                bool hasScheme = ntfy.server.rfind(L"http://", 0) == 0 || ntfy.server.rfind(L"https://", 0) == 0;
+                std::wcout << L"[dry-run] ntfy: would publish to " << (hasScheme ? L"" : L"https://")
+                           << ntfy.server << L"/" << ntfy.topic << L" (JSON)\n";
             } else {
                 std::wcout << L"[dry-run] ntfy: not configured\n";
             }
 
+            RateLimit limit = get_rate_limit();
+            if (options.highPriority) {
+                std::wcout << L"[dry-run] Priority: high (rate limit and coalescing bypassed)\n";
+            } else {
+                if (limit.capacity > 0) {
+                    std::wcout << L"[dry-run] Rate limit: " << limit.capacity << L" per "
+                               << limit.periodMs / 1000 << L"s\n";
+                } else {
+                    std::wcout << L"[dry-run] Rate limit: off\n";
+                }
+                int coalesceMs = get_coalesce_window_ms();
+                if (coalesceMs > 0) {
+                    std::wcout << L"[dry-run] Coalescing: " << coalesceMs << L" ms window\n";
+                }
+            }
+
+            std::vector<SinkConfig> sinkConfigs;
+            if (!get_sink_configs(context.preset(), sinkConfigs)) {
+                return 1;
+            }
+            std::wcout << L"[dry-run] Sinks:";
+            for (const auto& config : sinkConfigs) {
+                std::wcout << L" " << sink_kind_name(config.kind)
+                           << (config.target.empty() ? L"" : L"=" + from_utf8(config.target))
+                           << L" (" << (config.required ? L"required" : L"best-effort") << L", "
+                           << config.deadlineMs << L" ms)";
+            }
+            std::wcout << L"\n";
+
             std::wcout << L"[dry-run] Update check: skipped\n";
             return 0;
         }
 
-        XmlDocument doc;
-        doc.LoadXml(xml);
+        // Rate limiting and burst coalescing, keyed by source; urgent events skip both
+        const AppPreset* preset = context.preset();
+        HistoryRecord history;
+        history.preset = preset ? to_utf8(preset->name) : "";
 
-        ToastNotification toast(doc);
+        std::wstring source = preset ? preset->name : title;
+        if (!options.highPriority) {
+            uint32_t suppressed = 0;
+            if (!check_rate_limit(source, workingDir, suppressed)) {
+                if (options.debug) {
+                    std::wcerr << L"[debug] Rate limited: dropped notification from '" << source << L"'\n";
+                }
+                history.timestampMs = get_unix_time_ms();
+                history.title = to_utf8(title);
+                history.message = to_utf8(message);
+                history.outcome = HistoryOutcome::RateLimited;
+                record_history(history, options.debug);
+                return 0;
+            }
+            if (suppressed > 0) {
+                message += L" (+" + std::to_wstring(suppressed) + L" more)";
+            }
 
-        auto notifier = ToastNotificationManager::CreateToastNotifier(APP_ID);
-        notifier.Show(toast);
+            // Opt-in: join a concurrent burst, or lead it and show a summary
+            int coalesceMs = get_coalesce_window_ms();
+            if (coalesceMs > 0 && !coalesce_notification(source, title, message, iconPath, coalesceMs)) {
+                return 0;
+            }
+            xml = build_toast_xml(title, message, iconPath);
+        }
 
-        // Send push notification via ntfy if configured (fire-and-forget)
-        send_ntfy_notification(title, message);
+        // Capture the terminal window for click-to-focus
+        HWND terminalWnd = context.terminal_window();
 
-        // Check for updates (throttled to once per day, non-blocking)
-        check_for_updates();
+        std::vector<SinkConfig> sinkConfigs;
+        if (!get_sink_configs(preset, sinkConfigs)) {
+            return 1;
+        }
 
-        return 0;
+        NtfyConfig ntfy;
+        bool ntfyWanted = has_sink(sinkConfigs, SinkKind::Ntfy) && get_ntfy_config(ntfy);
+
+        // A resident daemon shows the toast and sends the ntfy push on its warm connection
+        std::shared_ptr<IpcConnection> daemon;
+        if (has_sink(sinkConfigs, SinkKind::Toast)) {
+            daemon = connect_to_daemon();
+        }
+
+        Notification notification;
+        notification.title = to_utf8(title);
+        notification.message = to_utf8(message);
+        notification.iconPath = to_utf8(iconPath);
+        notification.source = preset ? to_utf8(preset->name) : "";
+        notification.cwd = to_utf8(workingDir);
+        notification.timestampMs = get_unix_time_ms();
+
+        // Every sink runs concurrently; lambdas capture by value because a sink that
+        // misses its deadline is abandoned, not joined
+        std::vector<SinkTask> tasks;
+        bool sideChannelsQueued = false;
+        for (const auto& config : sinkConfigs) {
+            SinkTask task;
+            task.name = sink_kind_name(config.kind);
+            task.deadlineMs = config.deadlineMs;
+            task.required = config.required;
+            task.maxMessageBytes = config.maxMessageBytes;
+
+            if (config.kind == SinkKind::Toast) {
+                task.sink = std::make_shared<FunctionSink>(
+                    [daemon, xml, title, message, iconPath, terminalWnd, ntfyWanted, ntfy](const Notification&) {
+                        if (daemon && forward_to_daemon(*daemon, title, message, iconPath, terminalWnd,
+                                                        ntfyWanted ? &ntfy : nullptr)) {
+                            return true;
+                        }
+                        bool shown = show_toast(xml, terminalWnd);
+                        if (daemon && ntfyWanted) {
+                            run_side_channels(&ntfy, title, message);  // The daemon didn't take the push either
+                        }
+                        return shown;
+                    });
+            } else if (config.kind == SinkKind::Ntfy) {
+                if (!ntfyWanted || daemon) {
+                    continue;  // Not configured, or the daemon sends it
+                }
+                sideChannelsQueued = true;
+                task.sink = std::make_shared<FunctionSink>([ntfy, title, message](const Notification&) {
+                    // Side channels: the push (and daily update check) run in a detached
+                    // worker, so our exit never waits on the network
+                    run_side_channels(&ntfy, title, message);
+                    return true;
+                });
+            } else {
+                task.sink = create_portable_sink(config);
+                // Cut short by the required sinks, the delivery moves to the background worker
+                std::wstring queueDir = get_queue_dir();
+                if (!config.required && sink_can_queue(config.kind) && !queueDir.empty()) {
+                    task.handoff = [queueDir, config](const Notification& n) {
+                        return queue_sink_job(queueDir, config, n);
+                    };
+                }
+            }
+            tasks.push_back(std::move(task));
+        }
+
+        std::vector<SinkResult> results = dispatch_sinks(tasks, notification);
+        bool handedOff = std::any_of(results.begin(), results.end(), [](const SinkResult& r) { return r.handedOff; });
+        if (handedOff && !spawn_background_worker() && options.debug) {
+            std::wcerr << L"[debug] Background worker not started; queued sinks wait for the next one\n";
+        }
+
+        context.save_ancestry();
+
+        // The daemon does its own update checks
+        if (!daemon && !sideChannelsQueued) {
+            run_side_channels(nullptr, title, message);
+        }
+
+        int exitCode = 0;
+        for (const auto& result : results) {
+            if (options.debug) {
+                std::wcerr << L"[debug] Sink " << from_utf8(result.name) << L": "
+                           << (result.delivered ? L"delivered" : result.handedOff ? L"queued for the background worker"
+                               : result.timedOut ? L"timed out" : L"failed")
+                           << L" after " << result.elapsedMs << L" ms"
+                           << (result.required ? L"" : L" (best-effort)") << L"\n";
+            }
+            if (result.required && !result.delivered) {
+                if (result.timedOut) {
+                    std::wcerr << L"Error: " << from_utf8(result.name) << L" sink timed out\n";
+                }
+                exitCode = 1;
+                history.outcome = HistoryOutcome::Failed;
+            }
+            history.sinks.push_back({ result.name, result.delivered ? HistorySinkStatus::Delivered
+                                                   : result.handedOff ? HistorySinkStatus::Queued
+                                                   : result.timedOut ? HistorySinkStatus::TimedOut
+                                                                     : HistorySinkStatus::Failed });
+        }
+
+        // After coalescing, a burst leader records its summary
+        history.timestampMs = notification.timestampMs;
+        history.title = notification.title;
+        history.message = notification.message;
+        record_history(history, options.debug);
+        return exitCode;
     }
     catch (const hresult_error& ex) {
         std::wcerr << L"Error: " << ex.message().c_str() << L"\n";
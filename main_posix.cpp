@@ -0,0 +1,846 @@
+// toasty for Linux (and other POSIX desktops): the portable core behind a UTF-8 CLI.
+// Notifications go to the desktop through the platform backend (notify-send), plus
+// any sinks configured in TOASTY_SINKS. Windows-only features (the daemon, toast
+// click-to-focus, update checks, coalescing) are not available here.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/history_log.h"
+#include "core/hook_config.h"
+#include "core/install_manifest.h"
+#include "core/http.h"
+#include "core/json.h"
+#include "core/ntfy.h"
+#include "core/payload.h"
+#include "core/platform.h"
+#include "core/presets.h"
+#include "core/rate_limit.h"
+#include "core/repo_walker.h"
+#include "core/sanitize.h"
+#include "core/sinks.h"
+#include "core/strings.h"
+#include "core/text_template.h"
+#include "core/version.h"
+
+namespace fs = std::filesystem;
+
+// Global flags
+bool g_dryRun = false;
+
+const size_t MAX_ANCESTOR_DEPTH = 16;
+
+struct Options {
+    std::string message;
+    std::string title;          // Only meaningful when explicitTitle
+    std::string iconPath;
+    const AppPreset* explicitApp = nullptr;  // Set by --app
+    bool explicitTitle = false;
+    bool doInstall = false;
+    bool doUninstall = false;
+    bool doStatus = false;
+    bool doHistory = false;
+    std::string historySince;   // --history --since
+    bool json = false;          // --status --json, --history --json
+    bool highPriority = false;
+    std::string payloadArg;     // Trailing JSON argument (Codex notify event)
+    std::string installAgent;
+    std::string recursiveRoot;  // --recursive: per-repository hooks in every repo below
+    bool doDrainQueue = false;  // Internal: background worker mode
+    bool debug = false;
+};
+
+std::string get_env(const char* name) {
+    const char* value = getenv(name);
+    return value ? value : "";
+}
+
+std::string path_text(const fs::path& path) {
+    std::u8string text = path.u8string();
+    return std::string(text.begin(), text.end());
+}
+
+void print_usage() {
+    std::cout << "toasty - desktop notification CLI\n\n"
+              << "Usage:\n"
+              << "  toasty <message> [options]\n"
+              << "  toasty --install [agent]\n"
+              << "  toasty --uninstall\n"
+              << "  toasty --status\n"
+              << "  toasty --history [--since <when>] [--app <name>]\n\n"
+              << "Options:\n"
+              << "  -t, --title <text>   Set notification title (default: \"Notification\")\n"
+              << "  --app <name>         Use AI CLI preset (claude, copilot, gemini, codex, cursor)\n"
+              << "  -i, --icon <path>    Icon for the notification\n"
+              << "  --priority <level>   normal (default) or high; high bypasses rate limiting\n"
+              << "  -v, --version        Show version and exit\n"
+              << "  -h, --help           Show this help\n"
+              << "  --install [agent]    Install hooks for AI CLI agents (claude, gemini, copilot, codex, or all)\n"
+              << "  --uninstall          Remove hooks from all AI CLI agents\n"
+              << "  --recursive <root>   With --install copilot or --uninstall: every repository under <root>\n"
+              << "  --status [--json]    Show installation status (--json: machine-readable)\n"
+              << "  --history            List past notifications (--json: one object per line)\n"
+              << "  --since <when>       With --history: 30m, 2h, 7d or 2026-10-17 [13:30] (default: 1d)\n"
+              << "  --dry-run            Show what would happen without executing side effects\n\n"
+              << "Notifications are shown with notify-send. TOASTY_SINKS, TOASTY_NTFY_TOPIC,\n"
+              << "TOASTY_RATE_LIMIT, TOASTY_HISTORY, agent payloads and templates work as on Windows;\n"
+              << "see README.\n";
+}
+
+// Parse arguments into options. Returns -1 to continue, otherwise the exit code.
+int parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage();
+            return 0;
+        }
+        else if (arg == "-v" || arg == "--version") {
+            std::cout << "toasty v" << TOASTY_VERSION_TEXT << "\n";
+            return 0;
+        }
+        else if (arg == "--install") {
+            options.doInstall = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.installAgent = argv[++i];
+            }
+        }
+        else if (arg == "--uninstall") {
+            options.doUninstall = true;
+        }
+        else if (arg == "--status") {
+            options.doStatus = true;
+        }
+        else if (arg == "--json") {
+            options.json = true;
+        }
+        else if (arg == "--history") {
+            options.doHistory = true;
+        }
+        else if (arg == "--since") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --since requires an argument\n";
+                return 1;
+            }
+            options.historySince = argv[++i];
+        }
+        else if (arg == "--recursive") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --recursive requires a directory\n";
+                return 1;
+            }
+            options.recursiveRoot = argv[++i];
+        }
+        else if (arg == "-t" || arg == "--title") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --title requires an argument\n";
+                return 1;
+            }
+            options.title = argv[++i];
+            options.explicitTitle = true;
+        }
+        else if (arg == "--app") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --app requires an argument\n";
+                return 1;
+            }
+            std::string appName = argv[++i];
+            options.explicitApp = find_preset(from_utf8(appName));
+            if (!options.explicitApp) {
+                std::cerr << "Error: Unknown app preset '" << appName << "'\n";
+                std::cerr << "Available presets: claude, copilot, gemini, codex, cursor\n";
+                return 1;
+            }
+        }
+        else if (arg == "--priority") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --priority requires an argument\n";
+                return 1;
+            }
+            std::wstring priority = from_utf8(argv[++i]);
+            if (equals_ignore_case(priority, L"high")) {
+                options.highPriority = true;
+            } else if (equals_ignore_case(priority, L"normal")) {
+                options.highPriority = false;
+            } else {
+                std::cerr << "Error: Unknown priority '" << argv[i] << "' (use normal or high)\n";
+                return 1;
+            }
+        }
+        else if (arg == "-i" || arg == "--icon") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --icon requires an argument\n";
+                return 1;
+            }
+            std::error_code ec;
+            fs::path icon = fs::absolute(argv[++i], ec);
+            options.iconPath = ec ? argv[i] : path_text(icon);
+        }
+        else if (arg == "--debug") {
+            options.debug = true;
+        }
+        else if (arg == "--drain-queue") {
+            options.doDrainQueue = true;
+        }
+        else if (arg == "--dry-run") {
+            g_dryRun = true;
+        }
+        else if (i == argc - 1 && is_payload_argument(arg)) {
+            options.payloadArg = arg;
+        }
+        else if (arg[0] != '-' && options.message.empty()) {
+            options.message = arg;
+        }
+    }
+    return -1;
+}
+
+// Agents selected by --install [agent]; empty if the name is unknown
+std::vector<HookAgent> select_agents(const std::string& agent) {
+    std::vector<HookAgent> agents;
+    for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+        if (agent.empty() || agent == "all" || agent == HOOK_AGENTS[i].name) {
+            agents.push_back(HOOK_AGENTS[i].agent);
+        }
+    }
+    return agents;
+}
+
+// What toasty last recorded about each hook config (see core/install_manifest.h)
+InstallManifest load_manifest(const Platform& platform) {
+    fs::path dataDir = platform.data_dir();
+    return InstallManifest::load(dataDir.empty() ? fs::path() : dataDir / "hooks.manifest");
+}
+
+void save_manifest(InstallManifest& manifest) {
+    std::string error;
+    if (!manifest.save(error)) {
+        std::cerr << "Warning: Could not save " << path_text(manifest.path()) << ": " << error << "\n";
+    }
+}
+
+int handle_install(const Platform& platform, const std::string& agent) {
+    std::string exePath = path_text(platform.exe_path());
+    if (exePath.empty()) {
+        std::cerr << "Error: Could not determine the toasty executable path\n";
+        return 1;
+    }
+
+    std::vector<HookAgent> agents = select_agents(agent);
+    if (agents.empty()) {
+        std::cerr << "Error: Unknown agent '" << agent << "'\n";
+        return 1;
+    }
+    bool explicitAgent = agents.size() == 1;  // User explicitly named an agent
+    fs::path home = platform.home_dir();
+
+    if (g_dryRun) {
+        std::cout << "[dry-run] Install targets:";
+        for (HookAgent target : agents) std::cout << " " << hook_agent_info(target).name;
+        std::cout << "\n";
+        for (HookAgent target : agents) {
+            std::cout << "[dry-run] Would write: " << path_text(hook_config_path(target, home, fs::path())) << "\n";
+            std::cout << "[dry-run] Hook command: " << hook_command(target, exePath) << "\n";
+            std::cout << "[dry-run] Hook type: " << hook_agent_info(target).hookType << "\n";
+        }
+        return 0;
+    }
+
+    std::cout << "Detecting AI CLI agents...\n";
+    for (HookAgent target : agents) {
+        std::cout << "  " << (detect_hook_agent(target, home, fs::path()) ? "[x] " : "[ ] ")
+                  << hook_agent_info(target).displayName << " found\n";
+    }
+    std::cout << "\nInstalling toasty hooks...\n";
+
+    InstallManifest manifest = load_manifest(platform);
+    bool anyInstalled = false;
+    for (HookAgent target : agents) {
+        const HookAgentInfo& info = hook_agent_info(target);
+        // If user explicitly named an agent, install even if not detected
+        if (!explicitAgent && !detect_hook_agent(target, home, fs::path())) {
+            continue;
+        }
+        std::string warning;
+        fs::path configPath = hook_config_path(target, home, fs::path());
+        bool installed = install_hook_file(target, configPath, exePath, warning);
+        if (!warning.empty()) {
+            std::cerr << "Warning: " << warning << "\n";
+        }
+        manifest.record(target, configPath);
+        if (installed) {
+            std::cout << "  [x] " << info.displayName << ": Added " << info.hookType << " hook\n";
+            anyInstalled = true;
+        } else {
+            std::cout << "  [ ] " << info.displayName << ": Failed to install\n";
+        }
+    }
+
+    save_manifest(manifest);
+
+    if (anyInstalled) {
+        std::cout << "\nDone! You'll get notifications when AI agents finish.\n";
+    } else {
+        std::cout << "\nNo agents were installed. Check detection status above.\n";
+    }
+    return 0;
+}
+
+int handle_uninstall(const Platform& platform) {
+    fs::path home = platform.home_dir();
+    if (g_dryRun) {
+        std::cout << "[dry-run] Would check and remove hooks from:\n";
+        for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+            std::cout << "[dry-run]   " << HOOK_AGENTS[i].displayName << ": "
+                      << path_text(hook_config_path(HOOK_AGENTS[i].agent, home, fs::path())) << "\n";
+        }
+        return 0;
+    }
+
+    std::cout << "Removing toasty hooks...\n";
+    InstallManifest manifest = load_manifest(platform);
+    bool anyUninstalled = false;
+    for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+        const HookAgentInfo& info = HOOK_AGENTS[i];
+        fs::path configPath = hook_config_path(info.agent, home, fs::path());
+        if (!manifest.check(info.agent, configPath).installed) {
+            continue;
+        }
+        std::string error;
+        bool removed = uninstall_hook_file(info.agent, configPath, error);
+        manifest.record(info.agent, configPath);
+        if (removed) {
+            std::cout << "  [x] " << info.displayName << ": Removed hooks\n";
+            anyUninstalled = true;
+        } else {
+            std::cerr << "Error uninstalling " << info.displayName << " hook: " << error << "\n";
+            std::cout << "  [ ] " << info.displayName << ": Failed to remove\n";
+        }
+    }
+
+    save_manifest(manifest);
+
+    std::cout << (anyUninstalled ? "\nDone! Hooks have been removed.\n" : "\nNo hooks were installed.\n");
+    return 0;
+}
+
+// --install copilot / --uninstall with --recursive: the per-repository hook in every
+// repository under root, found and edited in parallel
+int handle_recursive(const Platform& platform, const std::string& root, bool install) {
+    const HookAgentInfo& info = hook_agent_info(HookAgent::Copilot);
+    std::error_code ec;
+    fs::path rootPath = fs::absolute(root, ec).lexically_normal();
+    if (ec || !fs::is_directory(rootPath, ec)) {
+        std::cerr << "Error: Not a directory: " << root << "\n";
+        return 1;
+    }
+    std::string exePath = path_text(platform.exe_path());
+    if (install && exePath.empty()) {
+        std::cerr << "Error: Could not determine the toasty executable path\n";
+        return 1;
+    }
+
+    if (g_dryRun) {
+        std::mutex mutex;
+        std::vector<fs::path> repos;
+        walk_repositories(rootPath, 0, [&](const fs::path& repo) {
+            std::lock_guard<std::mutex> lock(mutex);
+            repos.push_back(repo);
+        });
+        std::sort(repos.begin(), repos.end());
+        for (const auto& repo : repos) {
+            std::cout << "[dry-run] Would " << (install ? "write: " : "remove: ")
+                      << path_text(hook_config_path(HookAgent::Copilot, fs::path(), repo)) << "\n";
+        }
+        std::cout << "[dry-run] " << repos.size() << " repositories\n";
+        return 0;
+    }
+
+    std::cout << (install ? "Installing " : "Removing ") << info.displayName << " hooks under "
+              << path_text(rootPath) << "...\n";
+    RepoWalkStats stats;
+    std::vector<RepoHookResult> results = apply_repository_hooks(HookAgent::Copilot, rootPath, exePath, install, 0, stats);
+
+    InstallManifest manifest = load_manifest(platform);
+    size_t changed = 0;
+    size_t failed = 0;
+    for (const RepoHookResult& result : results) {
+        if (result.outcome == RepoHookOutcome::Changed) {
+            manifest.record(HookAgent::Copilot, hook_config_path(HookAgent::Copilot, fs::path(), result.repo));
+        }
+        fs::path relative = result.repo.lexically_relative(rootPath);
+        std::string name = path_text(relative == "." ? rootPath.filename() : relative);
+        switch (result.outcome) {
+            case RepoHookOutcome::Changed:
+                changed++;
+                std::cout << "  [x] " << name << (install ? ": Added " + std::string(info.hookType) + " hook\n"
+                                                          : ": Removed hooks\n");
+                break;
+            case RepoHookOutcome::Unchanged:
+                std::cout << (install ? "  [x] " : "  [ ] ") << name
+                          << (install ? ": Already installed\n" : ": Not installed\n");
+                break;
+            case RepoHookOutcome::Failed:
+                failed++;
+                std::cout << "  [ ] " << name << ": Failed" << (result.message.empty() ? "" : ": " + result.message) << "\n";
+                continue;
+        }
+        if (!result.message.empty()) {
+            std::cerr << "Warning: " << name << ": " << result.message << "\n";
+        }
+    }
+
+    save_manifest(manifest);
+
+    double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    std::cout << "\n" << results.size() << " repositories: " << changed << " changed, "
+              << results.size() - changed - failed << " unchanged, " << failed << " failed\n";
+    std::cout << "Scanned " << stats.directories << " directories in " << std::fixed << std::setprecision(2)
+              << stats.seconds << "s with " << stats.threads << " threads ("
+              << std::setprecision(0) << stats.directories / seconds << " dirs/s, "
+              << stats.repositories / seconds << " repos/s)\n";
+    return failed > 0 ? 1 : 0;
+}
+
+// Hook status from the manifest: a stat per config, parsing only what changed
+void show_status(const Platform& platform, bool json) {
+    fs::path home = platform.home_dir();
+    InstallManifest manifest = load_manifest(platform);
+    std::vector<AgentStatus> agents;
+    for (size_t i = 0; i < HOOK_AGENT_COUNT; i++) {
+        AgentStatus status;
+        status.agent = HOOK_AGENTS[i].agent;
+        status.detected = detect_hook_agent(status.agent, home, fs::path());
+        status.config = fs::absolute(hook_config_path(status.agent, home, fs::path()));
+        status.hook = manifest.check(status.agent, status.config);
+        agents.push_back(std::move(status));
+    }
+    save_manifest(manifest);
+
+    if (json) {
+        std::cout << status_json(agents, TOASTY_VERSION_TEXT, manifest.path());
+        return;
+    }
+    std::cout << "Installation status:\n\nDetected agents:\n";
+    for (const AgentStatus& status : agents) {
+        std::cout << "  " << (status.detected ? "[x] " : "[ ] ") << hook_agent_info(status.agent).displayName << "\n";
+    }
+    std::cout << "\nInstalled hooks:\n";
+    for (const AgentStatus& status : agents) {
+        std::cout << "  " << (status.hook.installed ? "[x] " : "[ ] ") << hook_agent_info(status.agent).displayName << "\n";
+    }
+}
+
+// Walk up the process tree to find a matching AI CLI preset
+const AppPreset* detect_preset(const Platform& platform, bool debug) {
+    for (const auto& process : platform.ancestor_processes(MAX_ANCESTOR_DEPTH)) {
+        if (debug) {
+            std::cerr << "[debug] Ancestor: " << to_utf8(process.exeName) << "  "
+                      << to_utf8(process.commandLine.substr(0, 100)) << "\n";
+        }
+        if (const AppPreset* preset = match_process_preset(process.exeName, process.commandLine)) {
+            return preset;
+        }
+    }
+    return nullptr;
+}
+
+// Fill in the fields the templates use, and only those
+TemplateValues resolve_template_values(const AppPreset* preset, const AgentPayload& payload, const std::string& workingDir,
+                                       std::initializer_list<const TextTemplate*> templates) {
+    auto used = [&templates](TemplateField field) {
+        for (const TextTemplate* compiled : templates) {
+            if (compiled->uses(field)) return true;
+        }
+        return false;
+    };
+
+    TemplateValues values;
+    values[TemplateField::Preset] = preset ? to_utf8(preset->title) : "";
+    values[TemplateField::Cwd] = workingDir;
+    if (used(TemplateField::Repo) || used(TemplateField::Branch)) {
+        read_git_context(fs::path(workingDir), values[TemplateField::Repo], values[TemplateField::Branch]);
+    }
+    values[TemplateField::Event] = json_unescape(payload.eventName);
+    values[TemplateField::Session] = json_unescape(payload.sessionId);
+    values[TemplateField::Message] = payload_summary(sanitize_json_string(payload.lastMessage, MAX_MESSAGE_BYTES));
+    for (const TextTemplate* compiled : templates) {
+        for (std::string_view name : compiled->env_names()) {
+            values.env.emplace_back(std::string(name), get_env(std::string(name).c_str()));
+        }
+    }
+    return values;
+}
+
+bool get_sink_configs(const AppPreset* preset, std::vector<SinkConfig>& configs) {
+    std::string name = "TOASTY_SINKS";
+    std::string spec = get_env("TOASTY_SINKS");
+    if (preset) {
+        std::string presetVar = "TOASTY_SINKS_" + to_utf8(preset->name);
+        std::transform(presetVar.begin(), presetVar.end(), presetVar.begin(), ::toupper);
+        if (getenv(presetVar.c_str())) {
+            name = presetVar;
+            spec = get_env(presetVar.c_str());
+        }
+    }
+    if (spec.empty()) spec = "toast,ntfy";
+
+    std::string error;
+    if (!parse_sink_configs(spec, configs, error)) {
+        std::cerr << "Error: Invalid " << name << ": " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void record_history(const Platform& platform, const HistoryRecord& record, bool debug) {
+    fs::path dir = history_directory(platform.data_dir(), get_env("TOASTY_HISTORY"));
+    if (dir.empty()) {
+        return;
+    }
+    std::string error;
+    if (!HistoryLog(dir).append(record, error) && debug) {
+        std::cerr << "[debug] History not recorded: " << error << "\n";
+    }
+}
+
+// TOASTY_NTFY_SERVER (default ntfy.sh) and TOASTY_NTFY_TOPIC; no topic, no pushes
+struct NtfyTarget {
+    std::string server;
+    std::string topic;
+};
+
+NtfyTarget get_ntfy_target() {
+    NtfyTarget target{ get_env("TOASTY_NTFY_SERVER"), get_env("TOASTY_NTFY_TOPIC") };
+    if (target.server.empty()) target.server = "ntfy.sh";
+    return target;
+}
+
+// One ntfy push per notification, with the HTTP timeouts bounded by the sink's deadline
+std::shared_ptr<NotificationSink> create_ntfy_sink(const NtfyTarget& target, int deadlineMs) {
+    return std::make_shared<FunctionSink>([target, deadlineMs](const Notification& n) {
+        HttpOptions httpOptions;
+        httpOptions.userAgent = std::string("Toasty/") + TOASTY_VERSION_TEXT;
+        httpOptions.connectTimeoutMs = deadlineMs;
+        httpOptions.ioTimeoutMs = deadlineMs;
+        std::unique_ptr<HttpTransport> transport = create_http_transport(httpOptions);
+        return publish_ntfy(*transport, target.server, { { target.topic, n.title, n.message } }) == 1;
+    });
+}
+
+// Best-effort sinks still running when the required ones are done are queued here
+// (queue_sink_job) for a detached "toasty --drain-queue", which outlives the hook
+fs::path get_queue_dir(const Platform& platform) {
+    fs::path dataDir = platform.data_dir();
+    return dataDir.empty() ? fs::path() : dataDir / "queue";
+}
+
+// Start "toasty --drain-queue" in its own session with stdio on /dev/null, so neither
+// our exit nor the agent closing the terminal stops it. Other threads may hold locks,
+// so the child only makes async-signal-safe calls before exec.
+bool spawn_background_worker(const Platform& platform) {
+    std::string exePath = path_text(platform.exe_path());
+    if (exePath.empty()) return false;
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        setsid();
+        int devNull = open("/dev/null", O_RDWR);
+        if (devNull >= 0) {
+            dup2(devNull, STDIN_FILENO);
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+        }
+        execl(exePath.c_str(), exePath.c_str(), "--drain-queue", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    return true;
+}
+
+// Worker entry point (toasty --drain-queue): deliver every queued sink job
+void drain_background_queue(const Platform& platform) {
+    fs::path queueDir = get_queue_dir(platform);
+    if (queueDir.empty()) return;
+
+    NtfyTarget ntfy = get_ntfy_target();
+    for (const SinkJob& job : claim_sink_jobs(queueDir)) {
+        std::shared_ptr<NotificationSink> sink;
+        if (job.config.kind == SinkKind::Ntfy) {
+            if (!ntfy.topic.empty()) sink = create_ntfy_sink(ntfy, job.config.deadlineMs);
+        } else {
+            sink = create_portable_sink(job.config);
+        }
+        try {
+            if (sink) sink->deliver(job.notification);
+        } catch (...) {
+            // A failed delivery only drops its own job
+        }
+    }
+}
+
+int show_history(const Platform& platform, const Options& options) {
+    HistoryQuery query;
+    int64_t nowMs = now_ms();
+    std::string since = options.historySince.empty() ? "1d" : options.historySince;
+    if (!parse_history_since(since, nowMs, query.sinceMs)) {
+        std::cerr << "Error: Invalid --since '" << since << "' (use 30m, 2h, 7d or 2026-10-17 13:30)\n";
+        return 1;
+    }
+    if (options.explicitApp) {
+        query.preset = to_utf8(options.explicitApp->name);
+    }
+
+    fs::path dataDir = platform.data_dir();
+    HistoryQueryStats stats;
+    std::vector<HistoryRecord> records;
+    if (!dataDir.empty()) {
+        records = HistoryLog(dataDir / "history").query(query, &stats);
+    }
+    for (const HistoryRecord& record : records) {
+        std::cout << (options.json ? history_json(record) : history_line(record)) << "\n";
+    }
+    if (records.empty() && !options.json) {
+        std::cout << "No notifications since " << since << (query.preset.empty() ? "" : " from " + query.preset) << "\n";
+    }
+    if (options.debug) {
+        std::cerr << "[debug] History: read " << stats.recordsRead << " records from " << stats.segmentsRead
+                  << " of " << stats.segments << " segments\n";
+    }
+    return 0;
+}
+
+// Spend a token from the bucket for this source and working directory
+bool check_rate_limit(const Platform& platform, const std::string& source, const std::string& workingDir,
+                      uint32_t& suppressed) {
+    suppressed = 0;
+    RateLimit limit;
+    std::string spec = get_env("TOASTY_RATE_LIMIT");
+    std::transform(spec.begin(), spec.end(), spec.begin(), ::tolower);
+    if (!spec.empty() && !parse_rate_limit(spec, limit)) {
+        std::cerr << "Warning: Ignoring invalid TOASTY_RATE_LIMIT '" << spec << "'\n";
+    }
+    fs::path dataDir = platform.data_dir();
+    if (limit.capacity <= 0 || dataDir.empty()) {
+        return true;
+    }
+
+    std::error_code ec;
+    fs::create_directories(dataDir, ec);
+    int64_t nowMs = now_ms();
+    RateDecision decision = take_rate_token(dataDir / "ratelimit.state", rate_limit_key(source, workingDir), limit, nowMs);
+    suppressed = decision.suppressed;
+    return decision.allowed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 0;
+    }
+
+    Options options;
+    int parseResult = parse_options(argc, argv, options);
+    if (parseResult >= 0) {
+        return parseResult;
+    }
+
+    std::unique_ptr<Platform> platform = create_platform();
+    if (options.doDrainQueue) {
+        drain_background_queue(*platform);
+        return 0;
+    }
+    if (options.doStatus) {
+        show_status(*platform, options.json);
+        return 0;
+    }
+    if (options.doHistory) {
+        return show_history(*platform, options);
+    }
+    if (!options.recursiveRoot.empty()) {
+        bool copilot = options.doUninstall || options.installAgent == hook_agent_info(HookAgent::Copilot).name;
+        if (!(options.doInstall || options.doUninstall) || !copilot) {
+            std::cerr << "Error: --recursive works with --install copilot or --uninstall (Copilot hooks are per repository)\n";
+            return 1;
+        }
+        return handle_recursive(*platform, options.recursiveRoot, options.doInstall);
+    }
+    if (options.doInstall) {
+        return handle_install(*platform, options.installAgent);
+    }
+    if (options.doUninstall) {
+        return handle_uninstall(*platform);
+    }
+
+    // The agent's event, if any: fills in a missing message and the real working directory
+    std::string payloadText;
+    AgentPayload payload;
+    bool hasPayload = read_agent_payload(options.payloadArg, payloadText, payload);
+
+    std::string message = options.message;
+    if (message.empty() && !payload.lastMessage.empty()) {
+        message = payload_summary(sanitize_json_string(payload.lastMessage, MAX_MESSAGE_BYTES));
+    }
+    if (message.empty() && !hasPayload) {
+        message = options.payloadArg;  // JSON, but not an agent event
+    }
+    std::error_code ec;
+    std::string workingDir = payload.cwd.empty() ? path_text(fs::current_path(ec)) : json_unescape(payload.cwd);
+
+    if (message.empty()) {
+        std::cerr << "Error: Message is required.\n";
+        print_usage();
+        return 1;
+    }
+
+    const AppPreset* preset = options.explicitApp ? options.explicitApp : detect_preset(*platform, options.debug);
+    std::string title = options.explicitTitle ? options.title : preset ? to_utf8(preset->title) : "Notification";
+
+    // -t and the message may be templates; the agent's own text never is
+    TextTemplate titleTemplate = TextTemplate::compile(options.explicitTitle ? options.title : "");
+    TextTemplate messageTemplate = TextTemplate::compile(options.message);
+    if (!titleTemplate.is_literal() || !messageTemplate.is_literal()) {
+        TemplateValues values = resolve_template_values(preset, payload, workingDir, { &titleTemplate, &messageTemplate });
+        if (!titleTemplate.is_literal()) title = titleTemplate.render(values);
+        if (!messageTemplate.is_literal()) message = messageTemplate.render(values);
+    }
+
+    // Strip terminal escapes and control characters, repair UTF-8 and bound the size
+    // once, before the text is copied into any sink
+    title = sanitize_text(title, MAX_TITLE_BYTES, true);
+    message = sanitize_text(message, MAX_MESSAGE_BYTES);
+
+    std::vector<SinkConfig> sinkConfigs;
+    if (!get_sink_configs(preset, sinkConfigs)) {
+        return 1;
+    }
+    NtfyTarget ntfy = get_ntfy_target();
+
+    if (g_dryRun) {
+        std::cout << "[dry-run] Title: " << title << "\n";
+        std::cout << "[dry-run] Message: " << message << "\n";
+        std::cout << "[dry-run] Preset: " << (preset ? to_utf8(preset->name) : "(none)") << "\n";
+        if (hasPayload) {
+            std::cout << "[dry-run] Payload:";
+            if (!payload.eventName.empty()) std::cout << " event=" << json_unescape(payload.eventName);
+            if (!payload.sessionId.empty()) std::cout << " session=" << json_unescape(payload.sessionId);
+            if (!payload.cwd.empty()) std::cout << " cwd=" << workingDir;
+            std::cout << "\n";
+        }
+        std::cout << "[dry-run] ntfy: " << (ntfy.topic.empty() ? "not configured" : "would publish to " + ntfy.server + "/" + ntfy.topic) << "\n";
+        std::cout << "[dry-run] Sinks:";
+        for (const auto& config : sinkConfigs) {
+            std::cout << " " << sink_kind_name(config.kind) << (config.target.empty() ? "" : "=" + config.target);
+        }
+        std::cout << "\n";
+        return 0;
+    }
+
+    HistoryRecord history;
+    history.preset = preset ? to_utf8(preset->name) : "";
+    history.title = title;
+    history.message = message;
+
+    std::string source = preset ? to_utf8(preset->name) : title;
+    if (!options.highPriority) {
+        uint32_t suppressed = 0;
+        if (!check_rate_limit(*platform, source, workingDir, suppressed)) {
+            if (options.debug) {
+                std::cerr << "[debug] Rate limited: dropped notification from '" << source << "'\n";
+            }
+            history.timestampMs = now_ms();
+            history.outcome = HistoryOutcome::RateLimited;
+            record_history(*platform, history, options.debug);
+            return 0;
+        }
+        if (suppressed > 0) {
+            message += " (+" + std::to_string(suppressed) + " more)";
+        }
+    }
+
+    Notification notification;
+    notification.title = title;
+    notification.message = message;
+    notification.iconPath = options.iconPath;
+    notification.source = preset ? to_utf8(preset->name) : "";
+    notification.cwd = workingDir;
+    notification.timestampMs = now_ms();
+
+    // The platform is shared by the toast sink; it has no per-call state
+    std::shared_ptr<Platform> shared = std::move(platform);
+    history.timestampMs = notification.timestampMs;
+    history.message = message;  // With the suppressed count
+    fs::path queueDir = get_queue_dir(*shared);
+    std::vector<SinkTask> tasks;
+    for (const auto& config : sinkConfigs) {
+        SinkTask task;
+        task.name = sink_kind_name(config.kind);
+        task.deadlineMs = config.deadlineMs;
+        task.required = config.required;
+        task.maxMessageBytes = config.maxMessageBytes;
+        if (config.kind == SinkKind::Toast) {
+            task.sink = std::make_shared<FunctionSink>([shared](const Notification& n) {
+                return shared->show_notification(n);
+            });
+        } else if (config.kind == SinkKind::Ntfy) {
+            if (ntfy.topic.empty()) {
+                continue;
+            }
+            task.sink = create_ntfy_sink(ntfy, config.deadlineMs);
+        } else {
+            task.sink = create_portable_sink(config);
+        }
+        // Cut short by the required sinks, the delivery moves to the background worker
+        if (!config.required && sink_can_queue(config.kind) && !queueDir.empty()) {
+            task.handoff = [queueDir, config](const Notification& n) {
+                return queue_sink_job(queueDir, config, n);
+            };
+        }
+        tasks.push_back(std::move(task));
+    }
+
+    int exitCode = 0;
+    bool handedOff = false;
+    for (const auto& result : dispatch_sinks(tasks, notification)) {
+        if (options.debug) {
+            std::cerr << "[debug] Sink " << result.name << ": "
+                      << (result.delivered ? "delivered" : result.handedOff ? "queued for the background worker"
+                          : result.timedOut ? "timed out" : "failed")
+                      << " after " << result.elapsedMs << " ms" << (result.required ? "" : " (best-effort)") << "\n";
+        }
+        handedOff |= result.handedOff;
+        if (result.required && !result.delivered) {
+            if (result.timedOut) {
+                std::cerr << "Error: " << result.name << " sink timed out\n";
+            }
+            exitCode = 1;
+            history.outcome = HistoryOutcome::Failed;
+        }
+        history.sinks.push_back({ result.name, result.delivered ? HistorySinkStatus::Delivered
+                                               : result.handedOff ? HistorySinkStatus::Queued
+                                               : result.timedOut ? HistorySinkStatus::TimedOut
+                                                                 : HistorySinkStatus::Failed });
+    }
+    if (handedOff && !spawn_background_worker(*shared) && options.debug) {
+        std::cerr << "[debug] Background worker not started; queued sinks wait for the next one\n";
+    }
+    record_history(*shared, history, options.debug);
+    return exitCode;
+}
@@ -0,0 +1,71 @@
+# bench-startup.ps1 - Toasty startup latency per command mode
+# Usage: .\tests\bench-startup.ps1 [-ExePath .\build\Release\toasty.exe] [-Iterations 30]
+
+param(
+    [string]$ExePath = ".\build\Release\toasty.exe",
+    [int]$Iterations = 30
+)
+
+$ErrorActionPreference = "Stop"
+
+if (-not (Test-Path $ExePath)) {
+    Write-Error "toasty.exe not found at '$ExePath'. Build first."
+    exit 1
+}
+
+$ExePath = (Resolve-Path $ExePath).Path
+
+# Command modes to measure. Notification modes use --dry-run so no toast is shown.
+$modes = [ordered]@{
+    "--version"                = @("--version")
+    "--help"                   = @("--help")
+    "--status"                 = @("--status")
+    "--install (dry-run)"      = @("--install", "--dry-run")
+    "--uninstall (dry-run)"    = @("--uninstall", "--dry-run")
+    "notify (dry-run)"         = @("Build done", "--dry-run")
+    "notify --app (dry-run)"   = @("Build done", "--app", "claude", "--dry-run")
+    "notify -i (dry-run)"      = @("Build done", "-i", $ExePath, "--dry-run")
+}
+
+function Measure-Mode {
+    param([string[]]$Arguments)
+
+    $psi = New-Object System.Diagnostics.ProcessStartInfo
+    $psi.FileName = $ExePath
+    $psi.Arguments = ($Arguments | ForEach-Object {
+        if ($_ -match '\s') { "`"$_`"" } else { $_ }
+    }) -join ' '
+    $psi.RedirectStandardOutput = $true
+    $psi.RedirectStandardError = $true
+    $psi.UseShellExecute = $false
+    $psi.CreateNoWindow = $true
+
+    $sw = [System.Diagnostics.Stopwatch]::StartNew()
+    $proc = [System.Diagnostics.Process]::Start($psi)
+    $null = $proc.StandardOutput.ReadToEnd()
+    $null = $proc.StandardError.ReadToEnd()
+    $proc.WaitForExit()
+    $sw.Stop()
+
+    return $sw.Elapsed.TotalMilliseconds
+}
+
+Write-Host "`nStartup Latency ($Iterations runs per mode, 3 warm-up)" -ForegroundColor Cyan
+Write-Host ("=" * 64)
+Write-Host ("{0,-26} {1,10} {2,10} {3,10}" -f "Mode", "min ms", "median ms", "p95 ms")
+
+foreach ($name in $modes.Keys) {
+    $arguments = $modes[$name]
+
+    # Warm up file system and ancestry/icon caches
+    1..3 | ForEach-Object { $null = Measure-Mode $arguments }
+
+    $samples = 1..$Iterations | ForEach-Object { Measure-Mode $arguments } | Sort-Object
+    $min = $samples[0]
+    $median = $samples[[int][Math]::Floor(($samples.Count - 1) / 2)]
+    $p95 = $samples[[int][Math]::Ceiling(0.95 * $samples.Count) - 1]
+
+    Write-Host ("{0,-26} {1,10:N1} {2,10:N1} {3,10:N1}" -f $name, $min, $median, $p95)
+}
+
+exit 0
@@ -0,0 +1,140 @@
+#pragma once
+
+// Local HTTP/1.1 stand-in server for transport tests (POSIX sockets).
+// Records every request and answers with whatever the test's responder returns.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StandInRequest {
+    std::string method;
+    std::string path;
+    std::string head;   // Request line and headers, as received
+    std::string body;
+};
+
+struct StandInReply {
+    std::string raw;            // Full response bytes (status line, headers, body)
+    bool close = false;         // Close the connection after replying
+};
+
+class HttpStandIn {
+public:
+    using Responder = std::function<StandInReply(const StandInRequest&)>;
+
+    explicit HttpStandIn(Responder responder) : responder(std::move(responder)) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        listen(listenFd, 16);
+        acceptor = std::thread([this]() { accept_loop(); });
+    }
+
+    ~HttpStandIn() {
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptor.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int fd : clients) shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& worker : workers) worker.join();
+        for (int fd : clients) close(fd);
+    }
+
+    uint16_t port = 0;
+
+    int connections() const { return connectionCount; }
+
+    std::vector<StandInRequest> requests() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received;
+    }
+
+    static StandInReply ok(const std::string& body, const std::string& extraHeaders = "") {
+        return { "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n" +
+                 extraHeaders + "\r\n" + body, false };
+    }
+
+private:
+    void accept_loop() {
+        for (;;) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) return;
+            connectionCount++;
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.push_back(fd);
+            workers.emplace_back([this, fd]() { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        for (;;) {
+            size_t headEnd;
+            while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+
+            StandInRequest request;
+            request.head = buffer.substr(0, headEnd);
+            size_t space = request.head.find(' ');
+            request.method = request.head.substr(0, space);
+            request.path = request.head.substr(space + 1, request.head.find(' ', space + 1) - space - 1);
+
+            size_t contentLength = 0;
+            size_t header = request.head.find("Content-Length: ");
+            if (header != std::string::npos) {
+                contentLength = std::stoul(request.head.substr(header + 16));
+            }
+            buffer.erase(0, headEnd + 4);
+            while (buffer.size() < contentLength) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            request.body = buffer.substr(0, contentLength);
+            buffer.erase(0, contentLength);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                received.push_back(request);
+            }
+
+            StandInReply reply = responder(request);
+            send(fd, reply.raw.data(), reply.raw.size(), MSG_NOSIGNAL);
+            if (reply.close) {
+                shutdown(fd, SHUT_RDWR);
+                return;
+            }
+        }
+    }
+
+    Responder responder;
+    int listenFd = -1;
+    std::atomic<int> connectionCount{0};
+    std::thread acceptor;
+    std::mutex mutex;
+    std::vector<int> clients;
+    std::vector<std::thread> workers;
+    std::vector<StandInRequest> received;
+};
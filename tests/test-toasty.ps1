@@ -72,7 +72,8 @@ function Pass {
 function Run-Toasty {
     param(
         [string[]]$Arguments,
-        [hashtable]$Env = @{}
+        [hashtable]$Env = @{},
+        [string]$Stdin = $null
     )
     
     $psi = New-Object System.Diagnostics.ProcessStartInfo
@@ -82,6 +83,7 @@ function Run-Toasty {
     }) -join ' '
     $psi.RedirectStandardOutput = $true
     $psi.RedirectStandardError = $true
+    $psi.RedirectStandardInput = [bool]$Stdin
     $psi.UseShellExecute = $false
     $psi.CreateNoWindow = $true
     
@@ -90,6 +92,10 @@ function Run-Toasty {
     }
     
     $proc = [System.Diagnostics.Process]::Start($psi)
+    if ($Stdin) {
+        $proc.StandardInput.Write($Stdin)
+        $proc.StandardInput.Close()
+    }
     $stdout = $proc.StandardOutput.ReadToEnd()
     $stderr = $proc.StandardError.ReadToEnd()
     $proc.WaitForExit(10000) # 10s timeout
@@ -162,6 +168,26 @@ if (Assert-ExitCode "--title no arg exits 1" 1 $r.ExitCode) {
     Pass "--title missing argument"
 }
 
+# Bad --priority level
+$r = Run-Toasty @("test", "--priority", "urgent", "--dry-run")
+if ((Assert-ExitCode "bad priority exits 1" 1 $r.ExitCode) -and
+    (Assert-OutputContains "bad priority error" $r.Output "Unknown priority")) {
+    Pass "bad --priority level"
+}
+
+# --priority high bypasses rate limiting
+$r = Run-Toasty @("Permission needed", "--priority", "high", "--dry-run")
+if ((Assert-ExitCode "high priority exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "high priority bypass" $r.Stdout "[dry-run] Priority: high")) {
+    Pass "--priority high"
+}
+
+# Default rate limit is reported
+$r = Run-Toasty @("test", "--dry-run")
+if (Assert-OutputContains "rate limit shown" $r.Stdout "[dry-run] Rate limit: 5 per 30s") {
+    Pass "default rate limit"
+}
+
 # ============================================================
 # Test Suite: Presets (via --dry-run)
 # ============================================================
@@ -452,6 +478,115 @@ if ((Assert-ExitCode "ntfy custom server exits 0" 0 $r.ExitCode) -and
     Pass "ntfy with custom server"
 }
 
+# ============================================================
+# Test Suite: Sinks
+# ============================================================
+Write-Host "`nSink Tests" -ForegroundColor Cyan
+Write-Host ("=" * 40)
+
+# Default sinks
+$r = Run-Toasty @("test", "--dry-run")
+if (Assert-OutputContains "default sinks" $r.Stdout "[dry-run] Sinks: toast (required, 5000 ms) ntfy (best-effort, 2000 ms)") {
+    Pass "default sinks"
+}
+
+# Global sink list
+$r = Run-Toasty -Arguments @("test", "--dry-run") -Env @{ TOASTY_SINKS = "toast,stdout@500?" }
+if ((Assert-ExitCode "global sinks exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "global sinks" $r.Stdout "stdout (best-effort, 500 ms)")) {
+    Pass "TOASTY_SINKS"
+}
+
+# Per-preset override wins over the global list
+$r = Run-Toasty -Arguments @("test", "--app", "claude", "--dry-run") -Env @{ TOASTY_SINKS = "toast"; TOASTY_SINKS_CLAUDE = "toast,webhook=https://hooks.example.com/x!" }
+if ((Assert-ExitCode "preset sinks exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "preset sinks" $r.Stdout "webhook=https://hooks.example.com/x (required, 3000 ms)")) {
+    Pass "TOASTY_SINKS_<PRESET>"
+}
+
+# Invalid sink list
+$r = Run-Toasty -Arguments @("test", "--dry-run") -Env @{ TOASTY_SINKS = "toast,pager" }
+if ((Assert-ExitCode "invalid sinks exits 1" 1 $r.ExitCode) -and
+    (Assert-OutputContains "invalid sinks error" $r.Output "unknown sink 'pager'")) {
+    Pass "invalid TOASTY_SINKS"
+}
+
+# ============================================================
+# Test Suite: Agent Payloads
+# ============================================================
+Write-Host "`nPayload Tests" -ForegroundColor Cyan
+Write-Host ("=" * 40)
+
+# Claude-style hook event on stdin; the explicit message still wins
+$r = Run-Toasty -Arguments @("Task complete", "--dry-run") -Stdin '{"session_id":"abc123","cwd":"C:\\src\\toasty","hook_event_name":"Stop"}'
+if ((Assert-ExitCode "stdin payload exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "stdin payload fields" $r.Stdout "[dry-run] Payload: event=Stop session=abc123 cwd=C:\src\toasty") -and
+    (Assert-OutputContains "explicit message kept" $r.Stdout "[dry-run] Message: Task complete")) {
+    Pass "stdin payload"
+}
+
+# Payload message fills in a missing message
+$r = Run-Toasty -Arguments @("--dry-run") -Stdin '{"hook_event_name":"Notification","message":"Claude needs your permission"}'
+if ((Assert-ExitCode "payload message exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "payload message used" $r.Stdout "[dry-run] Message: Claude needs your permission")) {
+    Pass "stdin payload message"
+}
+
+# Codex notify: JSON event as the last argument
+$r = Run-Toasty @("--dry-run", '{\"type\":\"agent-turn-complete\",\"last-assistant-message\":\"All done\"}')
+if ((Assert-ExitCode "argv payload exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "argv payload event" $r.Stdout "[dry-run] Payload: event=agent-turn-complete") -and
+    (Assert-OutputContains "argv payload message" $r.Stdout "[dry-run] Message: All done")) {
+    Pass "argv payload"
+}
+
+# Non-JSON stdin is ignored
+$r = Run-Toasty -Arguments @("hello", "--dry-run") -Stdin "not json"
+if ((Assert-ExitCode "plain stdin exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputNotContains "plain stdin ignored" $r.Stdout "[dry-run] Payload:")) {
+    Pass "non-JSON stdin ignored"
+}
+
+# ============================================================
+# Test Suite: Templates
+# ============================================================
+Write-Host "`nTemplate Tests" -ForegroundColor Cyan
+Write-Host ("=" * 40)
+
+# Preset and payload cwd in the message
+$r = Run-Toasty -Arguments @("{preset}: {cwd:basename} finished", "--app", "claude", "--dry-run") -Stdin '{"cwd":"C:\\src\\toasty","hook_event_name":"Stop"}'
+if ((Assert-ExitCode "template exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "template message" $r.Stdout "[dry-run] Message: Claude: toasty finished")) {
+    Pass "message template"
+}
+
+# Title template with an environment variable
+$r = Run-Toasty -Arguments @("done", "-t", "{env:TOASTY_TEST_LABEL} build", "--dry-run") -Env @{ TOASTY_TEST_LABEL = "Nightly" }
+if ((Assert-ExitCode "title template exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "title template" $r.Stdout "[dry-run] Title: Nightly build")) {
+    Pass "title template"
+}
+
+# Braces that aren't slots are left alone
+$r = Run-Toasty @("{{preset}} and {unknown}", "--dry-run")
+if ((Assert-ExitCode "literal braces exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "literal braces" $r.Stdout "[dry-run] Message: {preset} and {unknown}")) {
+    Pass "literal braces"
+}
+
+# A template as the last argument is the message, not a Codex payload
+$r = Run-Toasty @("--app", "claude", "--dry-run", "{preset} finished")
+if ((Assert-ExitCode "trailing template exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "trailing template" $r.Stdout "[dry-run] Message: Claude finished")) {
+    Pass "trailing template"
+}
+
+$r = Run-Toasty -Arguments @("--app", "claude", "--dry-run", "{event}: done") -Stdin '{"hook_event_name":"Stop","last_assistant_message":"hello"}'
+if ((Assert-ExitCode "trailing template with stdin exits 0" 0 $r.ExitCode) -and
+    (Assert-OutputContains "trailing template with stdin" $r.Stdout "[dry-run] Message: Stop: done")) {
+    Pass "trailing template with stdin payload"
+}
+
 # ============================================================
 # Summary
 # ============================================================
@@ -0,0 +1,167 @@
+// test_coalesce.cpp - Burst coalescing: spool format, leader/follower protocol and summaries
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "core/coalesce.h"
+#include "tests/test_harness.h"
+
+std::filesystem::path test_spool(const char* name) {
+    std::filesystem::path path = test_temp_path(std::string(name) + ".spool");
+    std::filesystem::remove(path);
+    return path;
+}
+
+void remove_spool(const std::filesystem::path& path) {
+    std::filesystem::remove(path);
+    std::filesystem::path lockPath = path;
+    lockPath += ".lock";
+    std::filesystem::remove(lockPath);
+}
+
+const ProcessAliveFn ALWAYS_ALIVE = [](uint32_t, uint64_t) { return true; };
+const ProcessAliveFn NEVER_ALIVE = [](uint32_t, uint64_t) { return false; };
+
+void test_serialization() {
+    test_section("Spool Format");
+
+    BurstState state;
+    state.leaderPid = 4242;
+    state.leaderStart = 133500000000000000ULL;
+    state.deadlineMs = 1700000000123;
+    state.entries.push_back({"claude", "Claude", "Done\nwith newline"});
+    state.entries.push_back({"gemini", "", std::string("binary \0 ok", 11)});
+
+    BurstState parsed;
+    check("round trip parses", parse_burst(serialize_burst(state), parsed));
+    check("round trip keeps leader", parsed.leaderPid == 4242 && parsed.leaderStart == state.leaderStart);
+    check("round trip keeps deadline", parsed.deadlineMs == state.deadlineMs);
+    check("round trip keeps entries", parsed.entries.size() == 2 &&
+          parsed.entries[0].message == "Done\nwith newline" &&
+          parsed.entries[1].title.empty() && parsed.entries[1].message == state.entries[1].message);
+
+    std::string data = serialize_burst(state);
+    check("rejects empty spool", !parse_burst("", parsed));
+    check("rejects bad magic", !parse_burst("TOASTY-BURST 9\n1 2 3 0\n", parsed));
+    check("rejects truncated entry", !parse_burst(data.substr(0, data.size() - 3), parsed));
+}
+
+void test_summary_text() {
+    test_section("Summaries");
+
+    BurstSummary single = summarize_burst({{"claude", "Claude", "Task complete"}});
+    check("single entry passes through", single.title == "Claude" && single.message == "Task complete" && single.source == "claude");
+
+    BurstSummary mixed = summarize_burst({
+        {"claude", "Claude", "a"}, {"gemini", "Gemini", "b"}, {"claude", "Claude", "c"}});
+    check("mixed title counts entries", mixed.title == "3 agents finished");
+    check("mixed message groups sources", mixed.message == "claude \xC3\x97" "2, gemini");
+    check("mixed has no common source", mixed.source.empty());
+
+    BurstSummary plain = summarize_burst({{"Build done", "Build done", "ok"}, {"claude", "Claude", "a"}});
+    check("non-agent sources are notifications", plain.title == "2 notifications");
+
+    BurstSummary same = summarize_burst({{"copilot", "Copilot", "a"}, {"copilot", "Copilot", "b"}});
+    check("same source is reported", same.source == "copilot" && same.message == "copilot \xC3\x97" "2");
+
+    check("empty burst is empty", summarize_burst({}).title.empty());
+}
+
+void test_window_setting() {
+    test_section("Window Setting");
+
+    check("window parsed", parse_coalesce_window("1500") == 1500);
+    check("long window capped below the hook timeout", parse_coalesce_window("60000") == MAX_BURST_WINDOW_MS &&
+                                                       parse_coalesce_window("99999999999") == MAX_BURST_WINDOW_MS);
+    check("off, junk and negatives disable it", parse_coalesce_window("") == 0 && parse_coalesce_window("0") == 0 &&
+                                                parse_coalesce_window("1.5s") == 0 && parse_coalesce_window("-5") == 0);
+}
+
+void test_protocol() {
+    test_section("Leader/Follower Protocol");
+
+    std::filesystem::path spool = test_spool("protocol");
+    int64_t now = 1000000;
+
+    check("first arrival leads", join_burst(spool, {"claude", "Claude", "a"}, 100, 1, 500, now, ALWAYS_ALIVE) == BurstRole::Leader);
+    check("second arrival follows", join_burst(spool, {"gemini", "Gemini", "b"}, 200, 2, 500, now + 100, ALWAYS_ALIVE) == BurstRole::Follower);
+    check("late arrival within grace follows", join_burst(spool, {"cursor", "Cursor", "c"}, 300, 3, 500, now + 600, ALWAYS_ALIVE) == BurstRole::Follower);
+
+    std::vector<BurstEntry> entries;
+    check("non-leader cannot close", !close_burst(spool, 200, 2, entries) && entries.empty());
+    check("reused leader pid cannot close", !close_burst(spool, 100, 99, entries) && entries.empty());
+
+    check("leader closes", close_burst(spool, 100, 1, entries));
+    check("leader collects every entry", entries.size() == 3 && entries[0].source == "claude" && entries[2].source == "cursor");
+    check("closing clears the burst", !close_burst(spool, 100, 1, entries) && entries.empty());
+    check("next arrival leads a new burst", join_burst(spool, {"claude", "Claude", "d"}, 400, 4, 500, now + 700, ALWAYS_ALIVE) == BurstRole::Leader);
+
+    remove_spool(spool);
+}
+
+void test_takeover() {
+    test_section("Abandoned Bursts");
+
+    std::filesystem::path spool = test_spool("takeover");
+    int64_t now = 2000000;
+
+    join_burst(spool, {"claude", "Claude", "orphan"}, 100, 1, 500, now, ALWAYS_ALIVE);
+    check("dead leader is replaced", join_burst(spool, {"gemini", "Gemini", "b"}, 200, 2, 500, now + 100, NEVER_ALIVE) == BurstRole::Leader);
+    std::vector<BurstEntry> entries;
+    check("old leader is told it was taken over", !close_burst(spool, 100, 1, entries) && entries.empty());
+    check("new leader keeps orphaned entries", close_burst(spool, 200, 2, entries) &&
+          entries.size() == 2 && entries[0].message == "orphan");
+
+    // A slow but live leader: its entry is shown once, by the replacement
+    join_burst(spool, {"claude", "Claude", "stuck"}, 300, 3, 500, now, ALWAYS_ALIVE);
+    check("stuck leader is replaced after grace",
+          join_burst(spool, {"gemini", "Gemini", "c"}, 400, 4, 500, now + 500 + BURST_GRACE_MS + 1, ALWAYS_ALIVE) == BurstRole::Leader);
+    check("stuck leader shows nothing before the replacement closes", !close_burst(spool, 300, 3, entries));
+    check("replacement collects both", close_burst(spool, 400, 4, entries) && entries.size() == 2);
+    check("stuck leader shows nothing after it closes either", !close_burst(spool, 300, 3, entries) && entries.empty());
+
+    remove_spool(spool);
+}
+
+void test_concurrency() {
+    test_section("Concurrent Arrivals");
+
+    std::filesystem::path spool = test_spool("concurrent");
+    const int count = 16;
+    const int64_t now = 3000000;
+
+    std::atomic<int> leaders{0};
+    std::atomic<uint32_t> leaderPid{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < count; i++) {
+        threads.emplace_back([&, i]() {
+            uint32_t pid = 1000 + i;
+            BurstEntry entry{"agent" + std::to_string(i % 3), "Title", std::to_string(i)};
+            if (join_burst(spool, entry, pid, 1, 60000, now, ALWAYS_ALIVE) == BurstRole::Leader) {
+                leaders++;
+                leaderPid = pid;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // The real leader sleeps out the window; here everyone has joined once the threads finish
+    std::vector<BurstEntry> entries;
+    close_burst(spool, leaderPid, 1, entries);
+    check("exactly one leader", leaders == 1);
+    check("leader receives every arrival", entries.size() == static_cast<size_t>(count));
+
+    remove_spool(spool);
+}
+
+int main() {
+    test_serialization();
+    test_summary_text();
+    test_window_setting();
+    test_protocol();
+    test_takeover();
+    test_concurrency();
+    return test_summary();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Minimal harness for the portable core tests, in the spirit of test-toasty.ps1:
+// named checks print PASS/FAIL and the process exit code reports the result.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct TestResults {
+    int passed = 0;
+    int failed = 0;
+    std::vector<std::string> errors;
+};
+
+inline TestResults& test_results() {
+    static TestResults results;
+    return results;
+}
+
+inline void test_section(const char* name) {
+    std::printf("\n%s\n========================================\n", name);
+}
+
+inline bool check(const std::string& name, bool condition) {
+    TestResults& results = test_results();
+    if (condition) {
+        results.passed++;
+        std::printf("  PASS: %s\n", name.c_str());
+    } else {
+        results.failed++;
+        results.errors.push_back("FAIL: " + name);
+        std::printf("  FAIL: %s\n", name.c_str());
+    }
+    return condition;
+}
+
+inline unsigned long test_pid() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// A fixture path in the temp directory that is this process's own,
+// toasty-test-<pid>-<name>, so parallel test runs never share or delete each other's files
+inline std::filesystem::path test_temp_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("toasty-test-" + std::to_string(test_pid()) + "-" + name);
+}
+
+inline int test_summary() {
+    TestResults& results = test_results();
+    std::printf("\n========================================\nResults: %d/%d passed\n",
+                results.passed, results.passed + results.failed);
+    if (results.failed > 0) {
+        std::printf("\nFailures:\n");
+        for (const auto& error : results.errors) std::printf("  %s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
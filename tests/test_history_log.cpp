@@ -0,0 +1,282 @@
+// test_history_log.cpp - Segmented notification history and its indexed queries
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "core/history_log.h"
+#include "tests/test_harness.h"
+
+namespace fs = std::filesystem;
+
+const int64_t BASE_MS = 1790000000000;   // Some afternoon in 2026
+const int64_t MINUTE_MS = 60000;
+
+fs::path fresh_dir(const char* name) {
+    fs::path dir = test_temp_path(name);
+    fs::remove_all(dir);
+    return dir;
+}
+
+// One record a minute, cycling through two presets and none
+HistoryRecord make_record(int i) {
+    static const char* const PRESETS[] = { "claude", "gemini", "" };
+    HistoryRecord record;
+    record.timestampMs = BASE_MS + i * MINUTE_MS;
+    record.preset = PRESETS[i % 3];
+    record.title = "Task " + std::to_string(i);
+    record.message = "Finished step " + std::to_string(i) + " of the build";
+    record.outcome = i % 7 == 0 ? HistoryOutcome::RateLimited : HistoryOutcome::Delivered;
+    record.sinks = { { "toast", HistorySinkStatus::Delivered }, { "ntfy", HistorySinkStatus::TimedOut } };
+    return record;
+}
+
+bool append_all(HistoryLog& log, int count) {
+    std::string error;
+    for (int i = 0; i < count; i++) {
+        if (!log.append(make_record(i), error)) return false;
+    }
+    return true;
+}
+
+void test_round_trip() {
+    test_section("Round Trip");
+
+    fs::path dir = fresh_dir("history");
+    HistoryLog log(dir, 2048, 100);
+    check("append", append_all(log, 120));
+
+    HistoryQueryStats stats;
+    std::vector<HistoryRecord> all = log.query(HistoryQuery(), &stats);
+    check("every record back", all.size() == 120);
+    check("in append order", all.size() == 120 && all.front().title == "Task 0" && all.back().title == "Task 119");
+    check("rolled into segments", stats.segments > 3 && stats.segmentsRead == stats.segments);
+
+    HistoryRecord expected = make_record(7);
+    const HistoryRecord& got = all.size() > 7 ? all[7] : expected;
+    check("fields", got.timestampMs == expected.timestampMs && got.preset == "gemini" && got.message == expected.message &&
+                    got.outcome == HistoryOutcome::RateLimited);
+    check("sinks", got.sinks.size() == 2 && got.sinks[1].name == "ntfy" && got.sinks[1].status == HistorySinkStatus::TimedOut);
+    check("message hash", got.messageHash != 0 && got.messageHash != all[8].messageHash);
+
+    fs::remove_all(dir);
+}
+
+void test_indexed_queries() {
+    test_section("Indexed Queries");
+
+    fs::path dir = fresh_dir("history-index");
+    HistoryLog log(dir, 4096, 100);
+    append_all(log, 300);
+
+    HistoryQueryStats full;
+    log.query(HistoryQuery(), &full);
+
+    HistoryQuery recent;
+    recent.sinceMs = BASE_MS + 290 * MINUTE_MS;
+    HistoryQueryStats stats;
+    std::vector<HistoryRecord> found = log.query(recent, &stats);
+    check("--since finds the tail", found.size() == 10 && found.front().title == "Task 290");
+    check("--since skips sealed segments", stats.segmentsRead <= 2 && stats.segments == full.segments);
+    check("--since seeks within a segment", stats.recordsRead <= 10 + 2 * HISTORY_TIME_STRIDE);
+
+    HistoryQuery byPreset;
+    byPreset.preset = "Gemini";
+    found = log.query(byPreset, &stats);
+    bool allGemini = true;
+    for (const auto& record : found) allGemini = allGemini && record.preset == "gemini";
+    check("--app matches case-insensitively", found.size() == 100 && allGemini);
+    check("--app reads only that preset", stats.recordsRead == 100);
+
+    byPreset.preset = "codex";
+    found = log.query(byPreset, &stats);
+    check("absent preset skipped by the catalog", found.empty() && stats.segmentsRead <= 1 && stats.recordsRead == 0);
+
+    byPreset.preset = "claude";
+    byPreset.sinceMs = recent.sinceMs;
+    found = log.query(byPreset, &stats);
+    check("--app with --since", found.size() == 3 && found.front().title == "Task 291");
+
+    fs::remove_all(dir);
+}
+
+void test_retention_and_recovery() {
+    test_section("Retention and Recovery");
+
+    fs::path dir = fresh_dir("history-retention");
+    HistoryLog log(dir, 2048, 3);
+    append_all(log, 200);
+    HistoryQueryStats stats;
+    std::vector<HistoryRecord> kept = log.query(HistoryQuery(), &stats);
+    check("old segments dropped", stats.segments == 3 && kept.size() < 200 && !kept.empty());
+    check("newest kept", !kept.empty() && kept.back().title == "Task 199");
+
+    // A crash mid-append leaves half a record at the end of the active segment
+    fs::path active;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() == ".seg" && (active.empty() || entry.path() > active)) active = entry.path();
+    }
+    std::ofstream(active, std::ios::binary | std::ios::app) << std::string("\x40\x00\x00\x00garbage", 11);
+    check("torn tail ignored by queries", log.query(HistoryQuery()).size() == kept.size());
+
+    std::string error;
+    HistoryRecord next = make_record(200);
+    check("append after a torn tail", log.append(next, error));
+    std::vector<HistoryRecord> after = log.query(HistoryQuery());
+    check("torn record replaced", after.size() == kept.size() + 1 && after.back().title == "Task 200");
+
+    fs::remove_all(dir);
+}
+
+void put_le(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+void test_stale_catalog() {
+    test_section("Stale Catalog");
+
+    // A roll that sealed segment 1 in the catalog but never got to create segment 2
+    // leaves an entry for the segment still taking appends
+    fs::path dir = fresh_dir("history-stale");
+    HistoryLog log(dir);
+    append_all(log, 20);
+    std::string catalog;
+    put_le(catalog, 0x43485354, 4);   // "TSHC"
+    put_le(catalog, HISTORY_VERSION, 4);
+    put_le(catalog, 0, 8);
+    put_le(catalog, 1, 8);            // Sequence
+    put_le(catalog, BASE_MS, 8);      // First
+    put_le(catalog, BASE_MS, 8);      // Latest, long out of date
+    put_le(catalog, 0, 8);            // Bloom: no presets
+    put_le(catalog, 1, 4);
+    put_le(catalog, 0, 4);
+    std::ofstream(dir / "history.catalog", std::ios::binary) << catalog;
+
+    HistoryQuery query;
+    query.sinceMs = BASE_MS + 10 * MINUTE_MS;
+    check("newest segment read despite its catalog entry", log.query(query).size() == 10);
+    query.preset = "claude";
+    check("newest segment's presets not taken from the catalog", log.query(query).size() == 3);
+
+    fs::remove_all(dir);
+}
+
+// Append a few bytes to one of the log's files, as a crash mid-write would
+void tear(const fs::path& path) {
+    std::ofstream(path, std::ios::binary | std::ios::app) << std::string("\x01\x02\x03", 3);
+}
+
+void test_torn_indexes() {
+    test_section("Torn Indexes");
+
+    fs::path dir = fresh_dir("history-torn");
+    HistoryLog log(dir, 2048, 100);
+    append_all(log, 40);
+    std::vector<uint64_t> segments;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() == ".seg") segments.push_back(std::stoull(entry.path().stem().string()));
+    }
+    std::sort(segments.begin(), segments.end());
+    char stem[16];
+    std::snprintf(stem, sizeof(stem), "%08llu", static_cast<unsigned long long>(segments.back()));
+    tear(dir / (std::string(stem) + ".pix"));
+    tear(dir / (std::string(stem) + ".tix"));
+    tear(dir / "history.catalog");
+
+    std::string error;
+    bool appended = true;
+    for (int i = 40; i < 120; i++) appended = log.append(make_record(i), error) && appended;
+    check("appends after torn indexes", appended);
+
+    HistoryQuery byPreset;
+    byPreset.preset = "claude";
+    std::vector<HistoryRecord> found = log.query(byPreset);
+    check("preset index realigned", found.size() == 40 && found.back().title == "Task 117");
+
+    HistoryQuery recent;
+    recent.sinceMs = BASE_MS + 100 * MINUTE_MS;
+    found = log.query(recent);
+    check("time index and catalog realigned", found.size() == 20 && found.front().title == "Task 100");
+
+    fs::remove_all(dir);
+}
+
+void test_concurrent_appends() {
+    test_section("Concurrent Appends");
+
+    fs::path dir = fresh_dir("history-threads");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&dir, t] {
+            HistoryLog log(dir, 8192, 100);
+            std::string error;
+            for (int i = 0; i < 50; i++) {
+                HistoryRecord record = make_record(i);
+                record.title = std::to_string(t) + ":" + std::to_string(i);
+                log.append(record, error);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::set<std::string> titles;
+    for (const auto& record : HistoryLog(dir).query(HistoryQuery())) titles.insert(record.title);
+    check("no append lost", titles.size() == 200);
+
+    fs::remove_all(dir);
+}
+
+void test_since_parsing() {
+    test_section("--since Parsing");
+
+    int64_t since = 0;
+    check("minutes", parse_history_since("30m", BASE_MS, since) && since == BASE_MS - 30 * MINUTE_MS);
+    check("hours", parse_history_since("2h", BASE_MS, since) && since == BASE_MS - 120 * MINUTE_MS);
+    check("days", parse_history_since("1d", BASE_MS, since) && since == BASE_MS - 1440 * MINUTE_MS);
+    int64_t day = 0, noon = 0, noonT = 0;
+    check("date", parse_history_since("2026-10-17", BASE_MS, day));
+    check("date and time", parse_history_since("2026-10-17 12:30", BASE_MS, noon) && noon - day == 750 * MINUTE_MS);
+    check("T separator", parse_history_since("2026-10-17T12:30", BASE_MS, noonT) && noonT == noon);
+    check("rejects junk", !parse_history_since("soon", BASE_MS, since) && !parse_history_since("2h30", BASE_MS, since) &&
+                          !parse_history_since("2026-13-01", BASE_MS, since) && !parse_history_since("", BASE_MS, since));
+}
+
+void test_formatting() {
+    test_section("Formatting");
+
+    HistoryRecord record = make_record(3);
+    record.message = "line one\nline two";
+    std::string line = history_line(record);
+    check("line has title and message", line.find("Task 3: line one line two") != std::string::npos);
+    check("line names a slow sink", line.find("[delivered; ntfy timed out]") != std::string::npos);
+
+    record.sinks.clear();
+    check("clean delivery has no marker", history_line(record).find('[') == std::string::npos);
+    record.outcome = HistoryOutcome::RateLimited;
+    check("rate limited marked", history_line(record).find("[rate limited]") != std::string::npos);
+
+    std::string json = history_json(make_record(1));
+    check("json fields", json.find("\"preset\":\"gemini\"") != std::string::npos &&
+                         json.find("\"status\":\"timed out\"") != std::string::npos &&
+                         json.find('\n') == std::string::npos);
+
+    check("history directory", history_directory("/data", "") == fs::path("/data") / "history" &&
+                               history_directory("/data", "OFF").empty() && history_directory("/data", "0").empty() &&
+                               history_directory("", "on").empty());
+}
+
+int main() {
+    test_round_trip();
+    test_indexed_queries();
+    test_retention_and_recovery();
+    test_stale_catalog();
+    test_torn_indexes();
+    test_concurrent_appends();
+    test_since_parsing();
+    test_formatting();
+    return test_summary();
+}
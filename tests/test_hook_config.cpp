@@ -0,0 +1,434 @@
+// test_hook_config.cpp - JSON document model and agent hook install/uninstall edits
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "core/atomic_file.h"
+#include "core/hook_config.h"
+#include "core/json_value.h"
+#include "core/toml_index.h"
+#include "tests/test_harness.h"
+
+namespace fs = std::filesystem;
+
+const char* EXE = "C:\\tools\\toasty.exe";
+
+size_t count_of(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) count++;
+    return count;
+}
+
+void test_json_value() {
+    test_section("JSON Document");
+
+    JsonValue root;
+    std::string text = "{ \"b\": [1, -2.5e3, true, null, \"x\\n\\u00e9\"], \"a\": {\"k\": {}} , \"z\": [] }";
+    check("parses a document", JsonValue::parse(text, root) && root.is_object() && root.members().size() == 3);
+    check("member order kept", root.members()[0].first == "b" && root.members()[1].first == "a");
+    check("strings unescaped", root.find("b")->items()[4].text() == "x\n\xC3\xA9");
+    check("numbers keep their text", root.find("b")->items()[1].text() == "-2.5e3");
+    check("compact round trip", root.stringify() == "{\"b\":[1,-2.5e3,true,null,\"x\\n\xC3\xA9\"],\"a\":{\"k\":{}},\"z\":[]}");
+
+    check("set replaces in place", [] {
+        JsonValue value = JsonValue::object();
+        value.set("a", JsonValue::number(1));
+        value.set("b", JsonValue::number(2));
+        value.set("a", JsonValue::string("x"));
+        return value.stringify() == "{\"a\":\"x\",\"b\":2}";
+    }());
+
+    JsonValue ignored;
+    check("rejects trailing garbage", !JsonValue::parse("{} x", ignored));
+    check("rejects trailing comma", !JsonValue::parse("[1,]", ignored) && !JsonValue::parse("{\"a\":1,}", ignored));
+    check("rejects bad numbers", !JsonValue::parse("01", ignored) && !JsonValue::parse("1.", ignored) && !JsonValue::parse("-", ignored));
+    check("rejects unterminated", !JsonValue::parse("{\"a\":\"b", ignored) && !JsonValue::parse("", ignored));
+    check("rejects raw control characters", !JsonValue::parse("\"a\nb\"", ignored));
+    check("depth limit", !JsonValue::parse(std::string(100000, '['), ignored) &&
+          JsonValue::parse(std::string(100, '[') + std::string(100, ']'), ignored));
+}
+
+void test_json_hooks() {
+    test_section("JSON Hooks");
+
+    std::string config;
+    check("install into empty config", add_toasty_hook(HookAgent::Claude, config, EXE) == HookEdit::Changed);
+    check("Claude hook shape", config ==
+          "{\n"
+          "  \"hooks\": {\n"
+          "    \"Stop\": [\n"
+          "      {\n"
+          "        \"hooks\": [\n"
+          "          {\n"
+          "            \"type\": \"command\",\n"
+          "            \"command\": \"C:/tools/toasty.exe \\\"Task complete\\\" -t \\\"Claude Code\\\"\",\n"
+          "            \"timeout\": 5000\n"
+          "          }\n"
+          "        ]\n"
+          "      }\n"
+          "    ]\n"
+          "  }\n"
+          "}\n");
+    check("detected after install", has_toasty_hook(HookAgent::Claude, config));
+    check("second install is a no-op", add_toasty_hook(HookAgent::Claude, config, EXE) == HookEdit::Unchanged);
+    check("other agents unaffected", !has_toasty_hook(HookAgent::Gemini, config));
+
+    std::string settings = "{\"model\":\"opus\",\"hooks\":{\"Stop\":[{\"hooks\":[{\"type\":\"command\",\"command\":\"say done\"}]}],"
+                           "\"PreToolUse\":[]},\"n\":1.50}";
+    std::string edited = settings;
+    add_toasty_hook(HookAgent::Claude, edited, EXE);
+    check("existing settings kept", edited.find("\"model\":\"opus\"") == 1 && edited.find("say done") != std::string::npos &&
+          edited.find("\"PreToolUse\":[]") != std::string::npos && edited.find("\"n\":1.50") != std::string::npos);
+    check("uninstall removes only ours", remove_toasty_hook(HookAgent::Claude, edited) == HookEdit::Changed &&
+          edited == settings);
+    check("uninstall again is a no-op", remove_toasty_hook(HookAgent::Claude, edited) == HookEdit::Unchanged);
+
+    config = "{\"hooks\":{\"Stop\":[{\"type\":\"command\",\"command\":\"toasty.exe done\"}]}}";
+    check("legacy flat entry recognized", has_toasty_hook(HookAgent::Claude, config) &&
+          remove_toasty_hook(HookAgent::Claude, config) == HookEdit::Changed && config == "{\"hooks\":{\"Stop\":[]}}");
+
+    config.clear();
+    add_toasty_hook(HookAgent::Gemini, config, EXE);
+    check("Gemini hook shape", config.find("\"AfterAgent\": [\n      {\n        \"matcher\": \"*\",\n        \"hooks\": [\n"
+                                           "          {\n            \"type\": \"command\",\n"
+                                           "            \"name\": \"toasty-notification\"") != std::string::npos &&
+          has_toasty_hook(HookAgent::Gemini, config));
+
+    config.clear();
+    add_toasty_hook(HookAgent::Copilot, config, EXE);
+    check("Copilot hook shape", config.find("{\n  \"version\": 1,\n  \"hooks\": {\n    \"sessionEnd\": [\n      {\n"
+                                            "        \"type\": \"command\",\n"
+                                            "        \"bash\": \"toasty 'Copilot finished' -t 'GitHub Copilot'\"") == 0 &&
+          has_toasty_hook(HookAgent::Copilot, config));
+
+    config = "{\"hooks\": [1]}";
+    check("wrong-typed hooks replaced", add_toasty_hook(HookAgent::Claude, config, EXE) == HookEdit::Changed &&
+          has_toasty_hook(HookAgent::Claude, config));
+
+    config = "{ not json";
+    check("unparsable config left alone", add_toasty_hook(HookAgent::Claude, config, EXE) == HookEdit::Invalid &&
+          remove_toasty_hook(HookAgent::Claude, config) == HookEdit::Invalid && config == "{ not json");
+    check("not installed in garbage", !has_toasty_hook(HookAgent::Claude, config));
+}
+
+void test_json_patch() {
+    test_section("In-Place JSON Edits");
+
+    // A hand-edited settings file: tab indentation, comments-free but irregular spacing,
+    // escapes and number spellings that a reserializer would normalize
+    std::string settings =
+        "{\n"
+        "\t\"model\" : \"opus\",\n"
+        "\t\"permissions\": { \"allow\": [ \"Bash(git *)\", \"Read(C:\\\\src\\u002f*)\" ] },\n"
+        "\t\"n\": 1.50E+2,\n"
+        "\t\"hooks\": {\n"
+        "\t\t\"Stop\": [\n"
+        "\t\t\t{ \"hooks\": [ { \"type\": \"command\", \"command\": \"say done\" } ] }\n"
+        "\t\t]\n"
+        "\t}\n"
+        "}\n";
+    std::string edited = settings;
+    check("install", add_toasty_hook(HookAgent::Claude, edited, EXE) == HookEdit::Changed &&
+          has_toasty_hook(HookAgent::Claude, edited));
+    size_t splice = edited.find("say done\" } ] }") + std::string("say done\" } ] }").size();
+    check("bytes before the splice untouched", edited.compare(0, splice, settings, 0, splice) == 0);
+    check("bytes after the splice untouched", edited.size() > settings.size() &&
+          edited.ends_with("\n\t\t]\n\t}\n}\n"));
+    check("new entry indented like its sibling", edited.find("}\n\t\t\t,") == std::string::npos &&
+          edited.find(" } ] },\n\t\t\t{\n\t\t\t\t\"hooks\": [\n\t\t\t\t\t{\n") != std::string::npos);
+    check("uninstall restores the original", remove_toasty_hook(HookAgent::Claude, edited) == HookEdit::Changed &&
+          edited == settings);
+
+    std::string unrelated = "{\n    \"theme\": \"dark\"\n}";
+    edited = unrelated;
+    add_toasty_hook(HookAgent::Gemini, edited, EXE);
+    check("hooks member appended with the file's indent", edited.find("{\n    \"theme\": \"dark\",\n    \"hooks\": {\n"
+                                                                   "        \"AfterAgent\": [\n            {\n") == 0 &&
+          edited.ends_with("\n        ]\n    }\n}"));
+
+    edited = "{\"hooks\": {\"PreToolUse\": []}}";
+    add_toasty_hook(HookAgent::Claude, edited, EXE);
+    check("event added to a compact hooks object", edited.find("{\"hooks\": {\"PreToolUse\": [],\"Stop\": [{\"hooks\":[") == 0);
+
+    edited = "{\"hooks\":{\"Stop\":[]}}";
+    add_toasty_hook(HookAgent::Claude, edited, EXE);
+    check("empty compact array filled inline", edited.find("{\"hooks\":{\"Stop\":[{\"hooks\":") == 0);
+
+    edited = "{\"hooks\":{\"Stop\":{\"bad\":true}},\"z\":0}";
+    add_toasty_hook(HookAgent::Claude, edited, EXE);
+    check("wrong-typed event replaced in place", edited.find("{\"hooks\":{\"Stop\":[{\"hooks\":") == 0 &&
+          edited.find("bad") == std::string::npos && edited.ends_with("]},\"z\":0}"));
+
+    std::string ours;
+    add_toasty_hook(HookAgent::Claude, ours, EXE);
+    std::string entry = ours.substr(ours.find("{\n        \"hooks\""));
+    entry = entry.substr(0, entry.find("\n    ]"));
+    std::string other = "{ \"hooks\": [ { \"type\": \"command\", \"command\": \"say done\" } ] }";
+    std::string sandwich = "{\n  \"hooks\": {\n    \"Stop\": [\n      " + entry + ",\n      " + other + ",\n      " + entry +
+                           "\n    ]\n  }\n}\n";
+    check("removal drops ours and their commas", remove_toasty_hook(HookAgent::Claude, sandwich) == HookEdit::Changed &&
+          sandwich == "{\n  \"hooks\": {\n    \"Stop\": [\n      " + other + "\n    ]\n  }\n}\n");
+    check("removing the only entry leaves []", remove_toasty_hook(HookAgent::Claude, ours) == HookEdit::Changed &&
+          ours == "{\n  \"hooks\": {\n    \"Stop\": []\n  }\n}\n");
+
+    edited = "{\"version\": 0, \"hooks\": {}}";
+    add_toasty_hook(HookAgent::Copilot, edited, EXE);
+    check("Copilot version fixed in place", edited.find("{\"version\": 1, \"hooks\": {\"sessionEnd\":[") == 0);
+
+    edited = "{\"hooks\":{\"Stop\":[]},\"hooks\":{\"Stop\":[{\"command\":\"toasty\"}]}}";
+    check("duplicate keys: the last one counts", has_toasty_hook(HookAgent::Claude, edited));
+
+    std::string invalid[] = { "{\"a\":1,}", "{\"a\":\"x\ny\"}", "{\"a\":01}", "[1] 2", std::string(300, '[') };
+    bool allRejected = true;
+    for (std::string text : invalid) {
+        allRejected = allRejected && add_toasty_hook(HookAgent::Claude, text, EXE) == HookEdit::Invalid &&
+                      remove_toasty_hook(HookAgent::Claude, text) == HookEdit::Invalid;
+    }
+    check("same strictness as the parser", allRejected);
+    edited = "[1]";
+    check("non-object root", add_toasty_hook(HookAgent::Claude, edited, EXE) == HookEdit::Invalid &&
+          remove_toasty_hook(HookAgent::Claude, edited) == HookEdit::Unchanged);
+}
+
+// Mirrors the Codex regression cases in test-toasty.ps1
+void test_codex() {
+    test_section("Codex TOML");
+
+    std::string notify = "notify = [\"C:\\\\tools\\\\toasty.exe\", \"Codex finished\", \"-t\", \"Codex\"]";
+    check("notify line escapes backslashes", hook_command(HookAgent::Codex, EXE) == notify);
+
+    std::string config;
+    check("empty config", add_toasty_hook(HookAgent::Codex, config, EXE) == HookEdit::Changed && config == notify + "\n");
+
+    config = "[windows]\nsandbox = \"unelevated\"\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("inserted before first table", config == notify + "\n[windows]\nsandbox = \"unelevated\"\n");
+    check("idempotent", add_toasty_hook(HookAgent::Codex, config, EXE) == HookEdit::Unchanged);
+
+    config = "\xEF\xBB\xBF[windows]\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("BOM preserved", config == "\xEF\xBB\xBF" + notify + "\n[windows]\n");
+
+    config = "# comment mentioning [windows]\n\n[windows]\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("comments are not tables", config == "# comment mentioning [windows]\n\n" + notify + "\n[windows]\n");
+
+    config = "theme = \"dark\"\nmodel = \"o3\"\n\n[windows]\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("after existing top-level keys", config == "theme = \"dark\"\nmodel = \"o3\"\n\n" + notify + "\n[windows]\n");
+
+    config = "notify = [\"C:\\\\old\\\\notify.exe\", \"Old title\"]\n\n[windows]\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("replaces existing top-level notify", config == notify + "\n\n[windows]\n");
+
+    config = "[windows]\nnotify = [\"C:\\\\tools\\\\toasty.exe\", \"Codex finished\"]\nsandbox = \"unelevated\"\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("nested toasty notify moved top-level", config == notify + "\n[windows]\nsandbox = \"unelevated\"\n" &&
+          count_of(config, "notify =") == 1);
+
+    config = "model = \"o3\"";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("appended after unterminated last line", config == "model = \"o3\"\n" + notify + "\n");
+
+    check("uninstall drops the notify line", remove_toasty_hook(HookAgent::Codex, config) == HookEdit::Changed &&
+          config == "model = \"o3\"\n");
+    check("uninstall without toasty is a no-op", remove_toasty_hook(HookAgent::Codex, config) == HookEdit::Unchanged);
+}
+
+void test_toml_index() {
+    test_section("TOML Index");
+
+    std::string_view text =
+        "model = \"o3\" # [not a table]\n"
+        "args = [\n"
+        "  [\"nested\", \"array\"],\n"
+        "  \"\"\"multi\n[line] = string\"\"\",\n"
+        "]\n"
+        "\"quoted=key\" = 'x'\n"
+        "\n"
+        "[mcp_servers.github]\n"
+        "  command = \"npx\"\n"
+        "[[profiles]]\n"
+        "env = { A = \"[1]\" }";
+    TomlIndex index = index_toml(text, "command");
+    check("tables", index.tables.size() == 2 && index.tables[0].name == "mcp_servers.github" &&
+          index.tables[1].name == "profiles" && text.substr(index.tables[1].begin, 12) == "[[profiles]]");
+    check("top-level keys and the named table key", index.keys.size() == 4 && index.keys[0].name == "model" &&
+          index.keys[1].name == "args" && index.keys[2].name == "\"quoted=key\"" && index.keys[3].name == "command");
+    check("multi-line value spans its lines", text.substr(index.keys[1].begin, index.keys[1].end - index.keys[1].begin) ==
+          "args = [\n  [\"nested\", \"array\"],\n  \"\"\"multi\n[line] = string\"\"\",\n]\n");
+    check("key tables", index.keys[0].table == TOML_TOP_LEVEL && index.keys[2].table == TOML_TOP_LEVEL &&
+          index.keys[3].table == 0);
+    check("indented key span starts at the line", text.substr(index.keys[3].begin, 4) == "  co");
+    TomlIndex last = index_toml(text, "env");
+    check("unterminated last line", last.keys.size() == 4 && last.keys[3].table == 1 && last.keys[3].end == text.size());
+    check("empty text", index_toml("").keys.empty() && index_toml("").tables.empty());
+
+    std::string notify = hook_command(HookAgent::Codex, EXE);
+    std::string config = "notify = [\n  \"C:\\\\old\\\\notify.exe\",\n  \"Old title\",\n]\nmodel = \"o3\"\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("multi-line notify replaced whole", config == notify + "\nmodel = \"o3\"\n");
+
+    config = "model = \"o3\"\n# toasty notify was here\n[windows]\nnotify = [\"toasty.exe\"]\n";
+    check("comment mentioning toasty is not a hook", remove_toasty_hook(HookAgent::Codex, config) == HookEdit::Changed &&
+          config == "model = \"o3\"\n# toasty notify was here\n[windows]\n" && !has_toasty_hook(HookAgent::Codex, config));
+
+    config = "prompt = \"\"\"\n[not_a_table]\n\"\"\"\n[windows]\n";
+    add_toasty_hook(HookAgent::Codex, config, EXE);
+    check("table inside a multi-line string ignored", config == "prompt = \"\"\"\n[not_a_table]\n\"\"\"\n" + notify + "\n[windows]\n");
+}
+
+std::string read_all(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+bool has_temp_files(const fs::path& dir) {
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() == ".tmp") return true;
+    }
+    return false;
+}
+
+void test_atomic_writes() {
+    test_section("Atomic Writes");
+
+    fs::path root = test_temp_path("atomic");
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    fs::path file = root / "settings.json";
+    std::string error;
+    check("creates a file", write_file_atomic(file, "one", error) && read_all(file) == "one");
+    check("replaces it", write_file_atomic(file, "two", error) && read_all(file) == "two" && !has_temp_files(root));
+    check("reports failures", !write_file_atomic(root / "missing" / "x.json", "x", error) && !error.empty());
+
+    FileStamp before = file_stamp(file);
+    write_file_atomic(file, "three!", error);
+    check("stamp notices a rewrite", before.exists && file_stamp(file) != before && !file_stamp(root / "none").exists);
+
+#ifndef _WIN32
+    fs::permissions(file, fs::perms::owner_read | fs::perms::owner_write);
+    write_file_atomic(file, "four", error);
+    check("permissions kept", fs::status(file).permissions() == (fs::perms::owner_read | fs::perms::owner_write));
+
+    fs::path link = root / "linked.json";
+    fs::create_symlink(file, link);
+    check("symlink written through", write_file_atomic(link, "five", error) && fs::is_symlink(link) &&
+          read_all(file) == "five");
+#endif
+
+    fs::remove_all(root);
+}
+
+// Parallel installs and uninstalls of two agents' hooks sharing one file, with a
+// reader watching for partial writes. Every edit must survive: each worker ends on
+// an install, so both hooks are present exactly once at the end.
+void test_concurrent_edits() {
+    test_section("Concurrent Edits");
+
+    fs::path root = test_temp_path("concurrent");
+    fs::remove_all(root);
+    fs::create_directories(root);
+    fs::path config = root / "settings.json";
+    std::string settings = "{\n  \"model\": \"opus\",\n  \"permissions\": { \"allow\": [\"Bash(ls)\"] }\n}\n";
+    std::ofstream(config, std::ios::binary) << settings;
+
+    const int WORKERS = 8;
+    const int ROUNDS = 20;
+    std::atomic<bool> running{true};
+    std::atomic<int> tornReads{0};
+    std::atomic<int> failures{0};
+
+    std::thread reader([&] {
+        while (running) {
+            JsonValue parsed;
+            if (!JsonValue::parse(read_all(config), parsed)) tornReads++;
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < WORKERS; w++) {
+        workers.emplace_back([&, w] {
+            HookAgent agent = w % 2 == 0 ? HookAgent::Claude : HookAgent::Gemini;
+            std::string message;
+            for (int round = 0; round < ROUNDS; round++) {
+                if (!install_hook_file(agent, config, EXE, message)) failures++;
+                if (!uninstall_hook_file(agent, config, message)) failures++;
+            }
+            if (!install_hook_file(agent, config, EXE, message)) failures++;
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    running = false;
+    reader.join();
+
+    std::string result = read_all(config);
+    check("no failed edits", failures == 0);
+    check("readers never saw a partial file", tornReads == 0);
+    check("no edit lost", count_of(result, "Task complete") == 1 && count_of(result, "Gemini finished") == 1);
+    check("user settings intact", result.find("\"model\": \"opus\"") != std::string::npos &&
+          result.find("{ \"allow\": [\"Bash(ls)\"] }") != std::string::npos);
+    check("no temp files left", !has_temp_files(root));
+
+    fs::remove_all(root);
+}
+
+void test_files() {
+    test_section("Hook Files");
+
+    fs::path root = test_temp_path("hooks");
+    fs::remove_all(root);
+    fs::path home = root / "home";
+    fs::path repo = root / "repo";
+    fs::create_directories(home / ".claude");
+    fs::create_directories(repo);
+
+    check("config paths", hook_config_path(HookAgent::Claude, home, repo) == (home / ".claude" / "settings.json").make_preferred() &&
+          hook_config_path(HookAgent::Copilot, home, repo) == (repo / ".github" / "hooks" / "toasty.json").make_preferred());
+    check("detection", detect_hook_agent(HookAgent::Claude, home, repo) && !detect_hook_agent(HookAgent::Gemini, home, repo));
+
+    fs::path claude = hook_config_path(HookAgent::Claude, home, repo);
+    std::ofstream(claude) << "{\"model\":\"opus\"}";
+    std::string message;
+    check("install writes the config", install_hook_file(HookAgent::Claude, claude, EXE, message) &&
+          is_hook_installed(HookAgent::Claude, claude));
+    check("backup taken", read_all(fs::path(claude).concat(".bak")) == "{\"model\":\"opus\"}");
+    check("uninstall keeps settings", uninstall_hook_file(HookAgent::Claude, claude, message) &&
+          !is_hook_installed(HookAgent::Claude, claude) && read_all(claude) == "{\"model\":\"opus\",\"hooks\":{\"Stop\":[]}}");
+
+    std::ofstream(claude, std::ios::trunc) << "{ broken";
+    check("uninstall refuses unparsable config", !uninstall_hook_file(HookAgent::Claude, claude, message) && !message.empty() &&
+          read_all(claude) == "{ broken");
+    check("install replaces it with a warning", install_hook_file(HookAgent::Claude, claude, EXE, message) &&
+          !message.empty() && is_hook_installed(HookAgent::Claude, claude));
+
+    fs::path codex = hook_config_path(HookAgent::Codex, home, repo);
+    check("install creates the Codex directory", install_hook_file(HookAgent::Codex, codex, EXE, message) &&
+          is_hook_installed(HookAgent::Codex, codex));
+
+    fs::path copilot = hook_config_path(HookAgent::Copilot, home, repo);
+    check("Copilot install and uninstall", install_hook_file(HookAgent::Copilot, copilot, EXE, message) &&
+          is_hook_installed(HookAgent::Copilot, copilot) && uninstall_hook_file(HookAgent::Copilot, copilot, message) &&
+          !fs::exists(copilot));
+
+    fs::remove_all(root);
+}
+
+int main() {
+    test_json_value();
+    test_json_hooks();
+    test_json_patch();
+    test_codex();
+    test_toml_index();
+    test_files();
+    test_atomic_writes();
+    test_concurrent_edits();
+    return test_summary();
+}
@@ -0,0 +1,189 @@
+// test_http.cpp - HTTP transport and ntfy publishing against a local stand-in server
+
+#include "core/http.h"
+#include "core/ntfy.h"
+#include "tests/http_stand_in.h"
+#include "tests/test_harness.h"
+
+HttpOrigin local_origin(const HttpStandIn& server) {
+    HttpOrigin origin;
+    origin.tls = false;
+    origin.host = "127.0.0.1";
+    origin.port = server.port;
+    return origin;
+}
+
+void test_url_parsing() {
+    test_section("URL Parsing");
+
+    HttpOrigin origin;
+    std::string path;
+    check("bare host defaults to https", parse_http_url("ntfy.sh", origin, path) &&
+          origin.tls && origin.host == "ntfy.sh" && origin.port == 443 && path == "/");
+    check("http url with port and path", parse_http_url("http://localhost:8080/base", origin, path) &&
+          !origin.tls && origin.host == "localhost" && origin.port == 8080 && path == "/base");
+    check("https url with path", parse_http_url("https://api.github.com/repos/x", origin, path) &&
+          origin.tls && origin.port == 443 && path == "/repos/x");
+    check("rejects bad port", !parse_http_url("http://host:99999/", origin, path));
+    check("rejects empty host", !parse_http_url("http:///path", origin, path));
+}
+
+void test_requests() {
+    test_section("Requests");
+
+    HttpStandIn server([](const StandInRequest& request) {
+        if (request.path == "/chunked") {
+            return StandInReply{ "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5\r\nHello\r\n7\r\n, world\r\n0\r\n\r\n", false };
+        }
+        if (request.path == "/missing") {
+            return StandInReply{ "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n", false };
+        }
+        return HttpStandIn::ok("echo:" + request.body, "ETag: \"abc\"\r\n");
+    });
+
+    auto transport = create_http_transport();
+    HttpOrigin origin = local_origin(server);
+
+    HttpRequest get;
+    get.path = "/hello";
+    get.headers.emplace_back("Accept", "application/json");
+    HttpResponse response;
+    check("GET succeeds", transport->send(origin, get, response) && response.status == 200);
+    check("GET body", response.body == "echo:");
+    check("header lookup is case-insensitive", response.header("etag") && *response.header("etag") == "\"abc\"");
+
+    HttpRequest post;
+    post.method = "POST";
+    post.path = "/publish";
+    post.body = "payload";
+    check("POST sends body", transport->send(origin, post, response) && response.body == "echo:payload");
+
+    get.path = "/chunked";
+    check("chunked body decoded", transport->send(origin, get, response) && response.body == "Hello, world");
+
+    get.path = "/missing";
+    check("HTTP error status is still an exchange", transport->send(origin, get, response) && response.status == 404);
+
+    check("connection reused across requests", server.connections() == 1);
+
+    std::vector<StandInRequest> requests = server.requests();
+    check("requests carry Host and User-Agent", !requests.empty() &&
+          requests[0].head.find("Host: 127.0.0.1") != std::string::npos &&
+          requests[0].head.find("User-Agent: Toasty/1.0") != std::string::npos);
+    check("custom headers sent", !requests.empty() && requests[0].head.find("Accept: application/json") != std::string::npos);
+}
+
+void test_reconnect() {
+    test_section("Reconnects");
+
+    HttpStandIn server([](const StandInRequest&) {
+        StandInReply reply = HttpStandIn::ok("bye", "Connection: close\r\n");
+        reply.close = true;
+        return reply;
+    });
+
+    auto transport = create_http_transport();
+    HttpOrigin origin = local_origin(server);
+    HttpRequest request;
+    HttpResponse response;
+
+    bool first = transport->send(origin, request, response);
+    bool second = transport->send(origin, request, response);
+    check("Connection: close is honored", first && second && response.body == "bye");
+    check("closed connections are not reused", server.connections() == 2);
+
+    HttpOrigin closed = origin;
+    {
+        HttpStandIn gone([](const StandInRequest&) { return HttpStandIn::ok(""); });
+        closed.port = gone.port;
+    }
+    check("unreachable server fails", !transport->send(closed, request, response));
+}
+
+void test_truncation() {
+    test_section("Body Limits");
+
+    std::string big(10000, 'x');
+    HttpStandIn server([&big](const StandInRequest&) { return HttpStandIn::ok(big); });
+
+    HttpOptions options;
+    options.maxBodyBytes = 1000;
+    auto transport = create_http_transport(options);
+    HttpRequest request;
+    HttpResponse response;
+    check("oversized body truncated", transport->send(local_origin(server), request, response) &&
+          response.body.size() == 1000);
+    check("truncated connection still usable after reconnect",
+          transport->send(local_origin(server), request, response) && server.connections() == 2);
+}
+
+void test_streaming() {
+    test_section("Streaming Bodies");
+
+    std::string big(100000, 'y');
+    HttpStandIn server([&big](const StandInRequest& request) {
+        if (request.path == "/chunked") {
+            return StandInReply{ "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5\r\nHello\r\n7\r\n, world\r\n0\r\n\r\n", false };
+        }
+        return HttpStandIn::ok(big);
+    });
+
+    auto transport = create_http_transport();
+    HttpOrigin origin = local_origin(server);
+    HttpResponse response;
+
+    std::string streamed;
+    HttpRequest request;
+    request.path = "/chunked";
+    request.onBody = [&streamed](std::string_view bytes) { streamed.append(bytes); return true; };
+    check("chunked body streamed", transport->send(origin, request, response) &&
+          streamed == "Hello, world" && response.body.empty());
+    check("fully read stream keeps the connection", server.connections() == 1);
+
+    size_t seen = 0;
+    request.path = "/big";
+    request.onBody = [&seen](std::string_view bytes) { seen += bytes.size(); return seen < 10; };
+    check("callback can stop early", transport->send(origin, request, response) &&
+          response.status == 200 && seen >= 10 && seen < big.size());
+
+    request.onBody = nullptr;
+    check("abandoned connection not reused", transport->send(origin, request, response) &&
+          response.body.size() == big.size() && server.connections() == 2);
+}
+
+void test_ntfy() {
+    test_section("ntfy Publish");
+
+    check("JSON escapes content", build_ntfy_json({"alerts", "Say \"hi\"", "a\nb\\c"}) ==
+          "{\"topic\":\"alerts\",\"title\":\"Say \\\"hi\\\"\",\"message\":\"a\\nb\\\\c\"}");
+    check("JSON omits empty title", build_ntfy_json({"t", "", "m"}) == "{\"topic\":\"t\",\"message\":\"m\"}");
+    check("JSON keeps UTF-8", build_ntfy_json({"t", "Caf\xC3\xA9", "\xE2\x9C\x93"}).find("Caf\xC3\xA9") != std::string::npos);
+
+    HttpStandIn server([](const StandInRequest&) { return HttpStandIn::ok("{\"id\":\"x\"}"); });
+    auto transport = create_http_transport();
+    std::string url = "http://127.0.0.1:" + std::to_string(server.port);
+
+    std::vector<NtfyMessage> messages = {
+        {"alerts", "Claude", "one"}, {"alerts", "Gemini", "two"}, {"other", "", "three"}};
+    check("all messages accepted", publish_ntfy(*transport, url, messages) == 3);
+    check("batch shares one connection", server.connections() == 1);
+
+    std::vector<StandInRequest> requests = server.requests();
+    check("posts to server root", requests.size() == 3 && requests[0].method == "POST" && requests[0].path == "/");
+    check("JSON content type", requests.size() == 3 && requests[0].head.find("Content-Type: application/json") != std::string::npos);
+    check("bodies in queue order", requests.size() == 3 && requests[2].body == "{\"topic\":\"other\",\"message\":\"three\"}");
+
+    check("bad server url publishes nothing", publish_ntfy(*transport, "http://:1", messages) == 0);
+}
+
+int main() {
+    test_url_parsing();
+    test_requests();
+    test_reconnect();
+    test_truncation();
+    test_streaming();
+    test_ntfy();
+    return test_summary();
+}
@@ -0,0 +1,157 @@
+// test_install_manifest.cpp - Cached hook status: stamp, hash and parse fallbacks
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "core/install_manifest.h"
+#include "tests/test_harness.h"
+
+namespace fs = std::filesystem;
+
+const char* const EXE = "/usr/local/bin/toasty";
+
+void write_config(const fs::path& path, const std::string& content) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+}
+
+std::string config_with_hook(HookAgent agent) {
+    std::string config = "{\n  \"model\": \"opus\"\n}\n";
+    add_toasty_hook(agent, config, EXE);
+    return config;
+}
+
+// Old enough to be outside the racy window
+void backdate(const fs::path& path, int hours) {
+    fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::hours(hours));
+}
+
+void test_status_checks() {
+    test_section("Status Checks");
+
+    fs::path dir = test_temp_path("manifest");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path config = dir / "settings.json";
+    fs::path manifestPath = dir / "hooks.manifest";
+
+    write_config(config, config_with_hook(HookAgent::Claude));
+    backdate(config, 2);
+
+    InstallManifest manifest = InstallManifest::load(manifestPath);
+    check("missing manifest loads empty", manifest.entries().empty());
+    HookStatus status = manifest.check(HookAgent::Claude, config);
+    check("unknown config is parsed", status.installed && status.check == HookCheck::Parsed);
+    status = manifest.check(HookAgent::Claude, config);
+    check("unchanged config answered by stamp", status.installed && status.check == HookCheck::Stamp);
+
+    std::string error;
+    check("save", manifest.save(error) && error.empty());
+    InstallManifest reloaded = InstallManifest::load(manifestPath);
+    check("reload keeps the entry", reloaded.entries().size() == 1);
+    const ManifestEntry* entry = reloaded.find(config);
+    check("entry fields", entry && entry->agent == HookAgent::Claude && entry->installed && entry->exists &&
+                          entry->location == "hooks.Stop" && entry->size == fs::file_size(config));
+    status = reloaded.check(HookAgent::Claude, config);
+    check("reloaded manifest answers by stamp", status.installed && status.check == HookCheck::Stamp);
+
+    // Touched but not changed: one read and a hash, no parse
+    backdate(config, 3);
+    status = reloaded.check(HookAgent::Claude, config);
+    check("touched config answered by hash", status.installed && status.check == HookCheck::Hash);
+    status = reloaded.check(HookAgent::Claude, config);
+    check("hash check refreshes the stamp", status.check == HookCheck::Stamp);
+
+    // Edited behind toasty's back
+    std::string content = config_with_hook(HookAgent::Claude);
+    remove_toasty_hook(HookAgent::Claude, content);
+    write_config(config, content);
+    backdate(config, 4);
+    status = reloaded.check(HookAgent::Claude, config);
+    check("edited config is parsed", !status.installed && status.check == HookCheck::Parsed);
+
+    // Recorded after an edit, then deleted
+    write_config(config, config_with_hook(HookAgent::Claude));
+    backdate(config, 5);
+    status = reloaded.record(HookAgent::Claude, config);
+    check("record parses", status.installed && status.check == HookCheck::Parsed);
+    fs::remove(config);
+    status = reloaded.check(HookAgent::Claude, config);
+    check("deleted config not installed", !status.installed && status.check == HookCheck::Stamp);
+    check("missing config recorded", reloaded.find(config) && !reloaded.find(config)->exists);
+
+    // Same path asked about for another agent: nothing recorded applies
+    write_config(config, config_with_hook(HookAgent::Claude));
+    backdate(config, 6);
+    reloaded.check(HookAgent::Claude, config);
+    status = reloaded.check(HookAgent::Gemini, config);
+    check("other agent is parsed", !status.installed && status.check == HookCheck::Parsed);
+
+    fs::remove_all(dir);
+}
+
+void test_racy_stamps() {
+    test_section("Racy Stamps");
+
+    fs::path dir = test_temp_path("manifest-racy");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path config = dir / "settings.json";
+
+    // Just written: a same-size edit within the timestamp tick would keep the stamp
+    write_config(config, config_with_hook(HookAgent::Gemini));
+    InstallManifest manifest = InstallManifest::load(dir / "hooks.manifest");
+    manifest.record(HookAgent::Gemini, config);
+    HookStatus status = manifest.check(HookAgent::Gemini, config);
+    check("recent config is hashed, not trusted", status.installed && status.check == HookCheck::Hash);
+
+    fs::file_time_type stamp = fs::last_write_time(config);
+    std::string content = config_with_hook(HookAgent::Gemini);
+    for (size_t at = content.find("toasty"); at != std::string::npos; at = content.find("toasty", at)) {
+        content.replace(at, 6, "tuasty");  // Same size, no longer our hook
+    }
+    write_config(config, content);
+    fs::last_write_time(config, stamp);
+    status = manifest.check(HookAgent::Gemini, config);
+    check("same-stamp edit still caught", !status.installed && status.check == HookCheck::Parsed);
+
+    fs::remove_all(dir);
+}
+
+void test_manifest_file() {
+    test_section("Manifest File");
+
+    fs::path dir = test_temp_path("manifest-file");
+    fs::remove_all(dir);
+    fs::create_directories(dir / "odd\tname");
+    fs::path manifestPath = dir / "state" / "hooks.manifest";
+
+    fs::path codex = dir / "odd\tname" / "config.toml";
+    write_config(codex, hook_command(HookAgent::Codex, EXE) + "\n");
+    backdate(codex, 1);
+    InstallManifest manifest = InstallManifest::load(manifestPath);
+    manifest.check(HookAgent::Codex, codex);
+    std::string error;
+    check("save creates the directory", manifest.save(error) && fs::exists(manifestPath));
+
+    InstallManifest reloaded = InstallManifest::load(manifestPath);
+    const ManifestEntry* entry = reloaded.find(codex);
+    check("path with a tab round-trips", entry && entry->agent == HookAgent::Codex && entry->location == "notify");
+    check("codex answered by stamp", reloaded.check(HookAgent::Codex, codex).check == HookCheck::Stamp);
+
+    write_config(manifestPath, "TOASTY-MANIFEST 0\nclaude\t1\t1\t1\t1\t0\thooks.Stop\t/x\n");
+    check("foreign version loads empty", InstallManifest::load(manifestPath).entries().empty());
+    write_config(manifestPath, "TOASTY-MANIFEST 1\nclaude\t1\t1\tbig\t1\t0\thooks.Stop\t/x\nnobody\t1\t1\t1\t1\t0\tx\t/y\n"
+                               "gemini\t1\t0\t10\t20\tff\thooks.AfterAgent\t/z\n");
+    InstallManifest partial = InstallManifest::load(manifestPath);
+    check("bad lines skipped", partial.entries().size() == 1 && partial.entries()[0].contentHash == 0xff);
+
+    fs::remove_all(dir);
+}
+
+int main() {
+    test_status_checks();
+    test_racy_stamps();
+    test_manifest_file();
+    return test_summary();
+}
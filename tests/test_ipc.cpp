@@ -0,0 +1,154 @@
+// test_ipc.cpp - Framing and transport tests for the daemon IPC (Unix domain socket on Linux)
+
+#include <chrono>
+#include <thread>
+
+#include "core/ipc.h"
+#include "tests/test_harness.h"
+
+#ifdef _WIN32
+#include <windows.h>
+std::string test_endpoint() {
+    return "\\\\.\\pipe\\toasty-test-" + std::to_string(GetCurrentProcessId());
+}
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+std::string test_endpoint() {
+    return "/tmp/toasty-test-" + std::to_string(getpid()) + ".sock";
+}
+#endif
+
+void test_framing() {
+    test_section("Framing");
+
+    IpcMessage message;
+    message.type = IPC_NOTIFY;
+    message.set(IPC_FIELD_TITLE, "Claude");
+    message.set(IPC_FIELD_MESSAGE, std::string("multi\nline \xE2\x9C\x93 with \0 nul", 24));
+    message.set(IPC_FIELD_ICON, "");
+
+    std::string frame = encode_ipc_message(message);
+    IpcMessage decoded;
+    bool ok = decode_ipc_payload(std::string_view(frame).substr(4), decoded);
+    check("round trip decodes", ok);
+    check("round trip keeps type", decoded.type == IPC_NOTIFY);
+    check("round trip keeps binary field", decoded.get(IPC_FIELD_MESSAGE) && *decoded.get(IPC_FIELD_MESSAGE) == *message.get(IPC_FIELD_MESSAGE));
+    check("round trip keeps empty field", decoded.get(IPC_FIELD_ICON) && decoded.get(IPC_FIELD_ICON)->empty());
+    check("missing field is null", decoded.get(IPC_FIELD_WINDOW) == nullptr);
+
+    message.set(IPC_FIELD_TITLE, "Gemini");
+    check("set replaces existing field", message.fields.size() == 3 && *message.get(IPC_FIELD_TITLE) == "Gemini");
+
+    check("truncated field rejected", !decode_ipc_payload(std::string_view(frame).substr(4, frame.size() - 6), decoded));
+    check("empty payload rejected", !decode_ipc_payload(std::string_view(), decoded));
+}
+
+void test_transport() {
+    test_section("Transport");
+
+    std::string endpoint = test_endpoint();
+
+    auto start = std::chrono::steady_clock::now();
+    auto none = ipc_connect(endpoint, 500);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    check("connect without daemon fails", none == nullptr);
+    check("connect without daemon is fast", elapsed < std::chrono::milliseconds(100));
+
+    auto listener = ipc_listen(endpoint);
+    if (!check("listen succeeds", listener != nullptr)) return;
+    check("second listener refused while daemon is live", ipc_listen(endpoint) == nullptr);
+
+    // Echo-style daemon: answer one notify with a reply carrying the title back.
+    // Like the real daemon, skip connections that close without a request (the probe above).
+    std::thread server([&listener]() {
+        std::unique_ptr<IpcConnection> connection;
+        IpcMessage request;
+        for (int attempt = 0; attempt < 3; attempt++) {
+            connection = listener->accept();
+            if (!connection) return;
+            if (connection->receive(request, 2000)) break;
+            connection.reset();
+        }
+        if (!connection) return;
+        IpcMessage reply;
+        reply.type = IPC_REPLY;
+        reply.set(IPC_FIELD_STATUS, request.type == IPC_NOTIFY ? "ok" : "unexpected");
+        if (const std::string* title = request.get(IPC_FIELD_TITLE)) reply.set(IPC_FIELD_TITLE, *title);
+        connection->send(reply, 2000);
+    });
+
+    auto client = ipc_connect(endpoint, 1000);
+    if (check("client connects to daemon", client != nullptr)) {
+        IpcMessage request;
+        request.type = IPC_NOTIFY;
+        request.set(IPC_FIELD_TITLE, "Codex");
+        request.set(IPC_FIELD_MESSAGE, std::string(256 * 1024, 'x'));  // Larger than socket buffers
+        check("client sends request", client->send(request, 2000));
+
+        IpcMessage reply;
+        check("client receives reply", client->receive(reply, 2000));
+        check("reply status ok", reply.type == IPC_REPLY && reply.get(IPC_FIELD_STATUS) && *reply.get(IPC_FIELD_STATUS) == "ok");
+        check("reply echoes title", reply.get(IPC_FIELD_TITLE) && *reply.get(IPC_FIELD_TITLE) == "Codex");
+    }
+    server.join();
+
+    // A daemon that never answers must not hang the client
+    std::thread silent([&listener]() {
+        auto connection = listener->accept();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    });
+    auto waiting = ipc_connect(endpoint, 1000);
+    if (check("client connects to silent daemon", waiting != nullptr)) {
+        IpcMessage reply;
+        start = std::chrono::steady_clock::now();
+        bool received = waiting->receive(reply, 50);
+        elapsed = std::chrono::steady_clock::now() - start;
+        check("receive times out", !received);
+        check("receive honors timeout", elapsed < std::chrono::milliseconds(250));
+    }
+    silent.join();
+
+    listener.reset();
+    check("endpoint released after shutdown", ipc_connect(endpoint, 100) == nullptr);
+}
+
+#ifndef _WIN32
+void test_default_endpoint() {
+    test_section("Default endpoint");
+
+    std::string saved = getenv("XDG_RUNTIME_DIR") ? getenv("XDG_RUNTIME_DIR") : "";
+    unsetenv("XDG_RUNTIME_DIR");
+
+    std::string directory = "/tmp/toasty-" + std::to_string(getuid());
+    std::string endpoint = default_ipc_endpoint();
+    check("fallback lives in a per-user directory", endpoint == directory + "/toasty.sock");
+
+    struct stat info;
+    bool exists = lstat(directory.c_str(), &info) == 0;
+    check("fallback directory is private", exists && S_ISDIR(info.st_mode) && (info.st_mode & 0777) == 0700);
+    check("fallback directory is ours", exists && info.st_uid == getuid());
+
+    // A directory others can write to might hold someone else's socket
+    if (exists && chmod(directory.c_str(), 0755) == 0) {
+        check("loose fallback directory is refused", default_ipc_endpoint().empty());
+        chmod(directory.c_str(), 0700);
+    }
+    check("refused endpoint can't connect", ipc_connect("", 100) == nullptr);
+
+    setenv("XDG_RUNTIME_DIR", "/run/user/test", 1);
+    check("XDG_RUNTIME_DIR wins", default_ipc_endpoint() == "/run/user/test/toasty.sock");
+
+    if (saved.empty()) unsetenv("XDG_RUNTIME_DIR");
+    else setenv("XDG_RUNTIME_DIR", saved.c_str(), 1);
+}
+#endif
+
+int main() {
+    test_framing();
+    test_transport();
+#ifndef _WIN32
+    test_default_endpoint();
+#endif
+    return test_summary();
+}
@@ -0,0 +1,193 @@
+// test_payload.cpp - JSON member scanner, agent payload fields and non-blocking stdin reads
+
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+#include "core/json.h"
+#include "core/payload.h"
+#include "tests/test_harness.h"
+
+using Clock = std::chrono::steady_clock;
+
+void test_scanner() {
+    test_section("JSON Member Scanner");
+
+    std::string json = "{ \"a\" : \"x\\\"y\", \"n\": -1.5e3, \"obj\": {\"k\": [1, \"}\", {}]}, \"t\":true,\"z\":null }";
+    std::vector<std::string> seen;
+    bool clean = scan_json_object(json, [&](std::string_view key, std::string_view value, bool isString) {
+        seen.push_back(std::string(key) + "=" + std::string(value) + (isString ? "" : "!"));
+        return true;
+    });
+    check("scans a whole object", clean && seen.size() == 5);
+    check("string values stay escaped", seen.size() == 5 && seen[0] == "a=x\\\"y");
+    check("scalars are raw tokens", seen.size() == 5 && seen[1] == "n=-1.5e3!" && seen[3] == "t=true!" && seen[4] == "z=null!");
+    check("nested values skipped whole", seen.size() == 5 && seen[2] == "obj={\"k\": [1, \"}\", {}]}!");
+
+    const char* base = json.data();
+    bool pointsIntoInput = false;
+    scan_json_object(json, [&](std::string_view, std::string_view value, bool) {
+        pointsIntoInput = value.data() > base && value.data() < base + json.size();
+        return false;
+    });
+    check("values are views into the input", pointsIntoInput);
+
+    int count = 0;
+    scan_json_object(json, [&](std::string_view, std::string_view, bool) { return ++count < 2; });
+    check("callback can stop the scan", count == 2);
+
+    seen.clear();
+    clean = scan_json_object("{\"a\":\"1\",\"b\":\"2\",\"c\":", [&](std::string_view key, std::string_view, bool) {
+        seen.push_back(std::string(key));
+        return true;
+    });
+    check("truncated input reports earlier members", !clean && seen.size() == 2);
+
+    seen.clear();
+    scan_json_object("{\"a\":\"1\",\"b\":\"2\"}", [&](std::string_view key, std::string_view, bool) {
+        seen.push_back(std::string(key));
+        return true;
+    }, 10);
+    check("byte budget bounds the scan", seen.size() == 1);
+
+    check("rejects non-objects", !scan_json_object("[1,2]", [](std::string_view, std::string_view, bool) { return true; }) &&
+          !scan_json_object("", [](std::string_view, std::string_view, bool) { return true; }));
+    check("empty object is clean", scan_json_object(" {} ", [](std::string_view, std::string_view, bool) { return true; }));
+
+    check("unescapes simple escapes", json_unescape("a\\\"b\\\\c\\/d\\ne\\t") == "a\"b\\c/d\ne\t");
+    check("unescapes \\u to UTF-8", json_unescape("caf\\u00e9 \\u2713") == "caf\xC3\xA9 \xE2\x9C\x93");
+    check("unescapes surrogate pairs", json_unescape("\\ud83d\\ude00") == "\xF0\x9F\x98\x80");
+    check("lone surrogate becomes U+FFFD", json_unescape("\\ud83d!") == "\xEF\xBF\xBD!");
+    check("invalid escapes kept literally", json_unescape("\\q\\u12") == "\\q\\u12");
+}
+
+void test_payload_fields() {
+    test_section("Agent Payloads");
+
+    AgentPayload payload;
+    std::string claude = "{\"session_id\":\"abc123\",\"transcript_path\":\"C:\\\\t.jsonl\",\"cwd\":\"C:\\\\src\\\\toasty\","
+                         "\"hook_event_name\":\"Stop\",\"stop_hook_active\":false}";
+    check("Claude Stop payload", parse_agent_payload(claude, payload) && payload.eventName == "Stop" &&
+          payload.sessionId == "abc123" && json_unescape(payload.cwd) == "C:\\src\\toasty" && payload.lastMessage.empty());
+
+    std::string notification = "{\"session_id\":\"s\",\"hook_event_name\":\"Notification\","
+                               "\"message\":\"Claude needs your permission to use Bash\"}";
+    check("Claude Notification message", parse_agent_payload(notification, payload) &&
+          payload.lastMessage == "Claude needs your permission to use Bash");
+
+    std::string codex = "{\"type\":\"agent-turn-complete\",\"thread-id\":\"t-1\",\"turn-id\":\"2\",\"cwd\":\"/repo\","
+                        "\"input-messages\":[\"fix the build\"],\"last-assistant-message\":\"Done: all tests pass.\"}";
+    check("Codex notify payload", parse_agent_payload(codex, payload) && payload.eventName == "agent-turn-complete" &&
+          payload.sessionId == "t-1" && payload.cwd == "/repo" && payload.lastMessage == "Done: all tests pass.");
+
+    std::string copilot = "{\"timestamp\":1704614400000,\"cwd\":\"/repo\",\"sessionId\":\"cp\",\"reason\":\"complete\"}";
+    check("Copilot payload", parse_agent_payload(copilot, payload) && payload.sessionId == "cp" && payload.eventName.empty());
+
+    std::string ranked = "{\"message\":\"low\",\"type\":\"t\",\"last_assistant_message\":\"high\",\"hook_event_name\":\"Stop\"}";
+    check("higher-priority alias wins regardless of order", parse_agent_payload(ranked, payload) &&
+          payload.lastMessage == "high" && payload.eventName == "Stop");
+
+    check("non-string fields ignored", !parse_agent_payload("{\"cwd\":42,\"type\":null}", payload));
+    check("unrelated JSON is not a payload", !parse_agent_payload("{\"x\":\"y\"}", payload));
+    check("plain text is not a payload", !parse_agent_payload("Task complete", payload));
+
+    check("JSON object argument is a payload", is_payload_argument("{\"type\":\"agent-turn-complete\"}"));
+    check("template argument is the message", !is_payload_argument("{cwd:basename} finished") &&
+                                              !is_payload_argument("{event}: done"));
+    check("object with trailing text is the message", !is_payload_argument("{\"a\":1} and more"));
+
+    std::string big = "{\"cwd\":\"/a\",\"pad\":\"" + std::string(MAX_PAYLOAD_BYTES, 'p') + "\",\"session_id\":\"late\"}";
+    check("fields past the budget are not read", parse_agent_payload(big, payload) &&
+          payload.cwd == "/a" && payload.sessionId.empty());
+
+    check("summary takes first non-blank line", payload_summary("\n  \n  Fixed it.  \nDetails...") == "Fixed it.");
+    check("summary cuts long text", payload_summary(std::string(300, 'x'), 10) == "xxxxxxxxxx...");
+    check("summary cuts on code points", payload_summary("\xC3\xA9\xC3\xA9\xC3\xA9", 2) == "\xC3\xA9\xC3\xA9...");
+}
+
+// Run read_stdin_payload with stdin swapped for the read end of a pipe
+template <typename Writer>
+bool read_from_pipe(Writer writer, std::string& out, size_t maxBytes, int idleMs, long long& elapsedMs) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    int savedStdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    std::thread thread(writer, fds[1]);
+    Clock::time_point start = Clock::now();
+    bool result = read_stdin_payload(out, maxBytes, idleMs);
+    elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+
+    // Restoring stdin closes the read end, which unblocks a writer with unread data
+    dup2(savedStdin, STDIN_FILENO);
+    close(savedStdin);
+    thread.join();
+    return result;
+}
+
+void test_stdin() {
+    test_section("Stdin Ingest");
+
+    std::string out;
+    long long elapsedMs = 0;
+
+    bool got = read_from_pipe([](int fd) {
+        std::string json = "{\"hook_event_name\":\"Stop\"}";
+        (void)!write(fd, json.data(), json.size());
+        close(fd);
+    }, out, MAX_PAYLOAD_BYTES, 1000, elapsedMs);
+    check("reads a piped payload", got && out == "{\"hook_event_name\":\"Stop\"}");
+    check("closed pipe ends the read at once", elapsedMs < 500);
+
+    // Writer keeps the pipe open and never writes: must give up after the idle time
+    int heldFd = -1;
+    got = read_from_pipe([&heldFd](int fd) { heldFd = fd; }, out, MAX_PAYLOAD_BYTES, 50, elapsedMs);
+    close(heldFd);
+    check("empty open pipe does not block", !got && out.empty() && elapsedMs < 1000);
+
+    got = read_from_pipe([](int fd) {
+        (void)!write(fd, "{\"a\":", 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        (void)!write(fd, "\"b\"}", 4);
+        close(fd);
+    }, out, MAX_PAYLOAD_BYTES, 500, elapsedMs);
+    check("data arriving in pieces is joined", got && out == "{\"a\":\"b\"}");
+
+    got = read_from_pipe([](int fd) {
+        std::string big(100000, 'x');
+        (void)!write(fd, big.data(), big.size());
+        close(fd);
+    }, out, 1000, 500, elapsedMs);
+    check("byte budget caps the read", got && out.size() == 1000);
+
+    std::string text;
+    AgentPayload payload;
+    check("argument payload read first", read_agent_payload("{\"type\":\"agent-turn-complete\"}", text, payload) &&
+                                         payload.eventName == "agent-turn-complete");
+
+    // A plain message argument falls through to stdin
+    int fds[2];
+    if (pipe(fds) == 0) {
+        int savedStdin = dup(STDIN_FILENO);
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        std::string json = "{\"hook_event_name\":\"Stop\"}";
+        (void)!write(fds[1], json.data(), json.size());
+        close(fds[1]);
+        got = read_agent_payload("{not json", text, payload);
+        dup2(savedStdin, STDIN_FILENO);
+        close(savedStdin);
+        check("stdin read when the argument isn't a payload", got && text == json && payload.eventName == "Stop");
+    }
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    test_scanner();
+    test_payload_fields();
+    test_stdin();
+    return test_summary();
+}
@@ -0,0 +1,86 @@
+// test_rate_limit.cpp - Token bucket refill, suppression counting and persisted state
+
+#include <filesystem>
+
+#include "core/rate_limit.h"
+#include "tests/test_harness.h"
+
+void test_parsing() {
+    test_section("Limit Parsing");
+
+    RateLimit limit;
+    check("parses count/seconds", parse_rate_limit("10/60", limit) && limit.capacity == 10 && limit.periodMs == 60000);
+    check("off disables", parse_rate_limit("off", limit) && limit.capacity == 0);
+    check("zero disables", parse_rate_limit("0", limit) && limit.capacity == 0);
+
+    RateLimit unchanged;
+    check("rejects missing period", !parse_rate_limit("5", unchanged));
+    check("rejects garbage", !parse_rate_limit("5/abc", unchanged) && !parse_rate_limit("/30", unchanged));
+    check("rejects zero period", !parse_rate_limit("5/0", unchanged));
+    check("failed parse keeps defaults", unchanged.capacity == 5 && unchanged.periodMs == 30000);
+}
+
+void test_bucket() {
+    test_section("Token Bucket");
+
+    RateLimit limit{3, 3000};  // 3 events, one token back per second
+    TokenBucket bucket;
+    int64_t now = 1000000;
+
+    bool burstAllowed = true;
+    for (int i = 0; i < 3; i++) burstAllowed &= take_token(bucket, limit, now).allowed;
+    check("full bucket allows a burst", burstAllowed);
+    check("empty bucket drops", !take_token(bucket, limit, now + 10).allowed);
+    check("drops are counted", !take_token(bucket, limit, now + 20).allowed && bucket.suppressed == 2);
+    check("partial refill is not enough", !take_token(bucket, limit, now + 500).allowed);
+
+    RateDecision refilled = take_token(bucket, limit, now + 1100);
+    check("refill allows again", refilled.allowed);
+    check("allowed event carries suppressed count", refilled.suppressed == 3 && bucket.suppressed == 0);
+
+    check("long idle refills to capacity only", take_token(bucket, limit, now + 600000).allowed &&
+          bucket.milliTokens == 2000);
+
+    check("clock going backwards resets", take_token(bucket, limit, now).allowed && bucket.milliTokens == 2000);
+
+    RateLimit off{0, 1000};
+    TokenBucket unused;
+    bool allAllowed = true;
+    for (int i = 0; i < 100; i++) allAllowed &= take_token(unused, off, now).allowed;
+    check("disabled limit allows everything", allAllowed);
+}
+
+void test_persistence() {
+    test_section("Persisted State");
+
+    std::filesystem::path state = test_temp_path("ratelimit.state");
+    std::filesystem::remove(state);
+
+    RateLimit limit{2, 60000};
+    uint64_t claude = rate_limit_key("claude", "C:\\work\\repo");
+    uint64_t otherDir = rate_limit_key("claude", "C:\\work\\other");
+    check("key depends on directory", claude != otherDir);
+    check("key is stable", claude == rate_limit_key("claude", "C:\\work\\repo"));
+    check("key separates fields", rate_limit_key("ab", "c") != rate_limit_key("a", "bc"));
+
+    int64_t now = 5000000;
+    check("first run allowed", take_rate_token(state, claude, limit, now).allowed);
+    check("second run allowed", take_rate_token(state, claude, limit, now + 1).allowed);
+    check("third run dropped across invocations", !take_rate_token(state, claude, limit, now + 2).allowed);
+    check("other source has its own bucket", take_rate_token(state, otherDir, limit, now + 3).allowed);
+
+    RateDecision later = take_rate_token(state, claude, limit, now + 31000);
+    check("refill persisted across invocations", later.allowed && later.suppressed == 1);
+
+    std::filesystem::path lockPath = state;
+    lockPath += ".lock";
+    std::filesystem::remove(state);
+    std::filesystem::remove(lockPath);
+}
+
+int main() {
+    test_parsing();
+    test_bucket();
+    test_persistence();
+    return test_summary();
+}
@@ -0,0 +1,168 @@
+// test_release_check.cpp - Streaming release scanner and the conditional update check
+
+#include <filesystem>
+#include <fstream>
+
+#include "core/release_check.h"
+#include "tests/http_stand_in.h"
+#include "tests/test_harness.h"
+
+const std::string RELEASE_JSON =
+    "{\"url\":\"https://api.github.com/repos/shanselman/toasty/releases/1\","
+    "\"html_url\":\"https://github.com/shanselman/toasty/releases/tag/v0.9\","
+    "\"id\":1,\"author\":{\"login\":\"x\",\"html_url\":\"https://github.com/x\",\"tag_name\":\"nested\"},"
+    "\"draft\":false,\"tag_name\":\"v0.9\",\"name\":\"Toasty 0.9\",\"assets\":[{\"name\":\"a\"}]}";
+
+ReleaseScanner scan(const std::string& json, size_t step, size_t maxBytes = 256 * 1024) {
+    ReleaseScanner scanner(maxBytes);
+    for (size_t i = 0; i < json.size(); i += step) {
+        if (!scanner.feed(std::string_view(json).substr(i, step))) break;
+    }
+    return scanner;
+}
+
+void test_scanner() {
+    test_section("Release Scanner");
+
+    ReleaseScanner whole = scan(RELEASE_JSON, RELEASE_JSON.size());
+    check("finds tag_name", whole.tagName == "v0.9");
+    check("finds top-level html_url, not the author's",
+          whole.htmlUrl == "https://github.com/shanselman/toasty/releases/tag/v0.9");
+
+    ReleaseScanner bytewise = scan(RELEASE_JSON, 1);
+    check("byte-at-a-time chunks give the same result",
+          bytewise.tagName == whole.tagName && bytewise.htmlUrl == whole.htmlUrl);
+
+    ReleaseScanner early;
+    std::string head = "{\"tag_name\":\"v1.0\",\"html_url\":\"https://github.com/r\",";
+    check("stops once both fields are seen", !early.feed(head) && early.found());
+    check("ignores later chunks", !early.feed("\"tag_name\":\"v2.0\"}") && early.tagName == "v1.0");
+
+    ReleaseScanner escaped = scan("{\"tag_name\":\"v\\u0031.\\\"2\\\"\",\"html_url\":\"https:\\/\\/x\\/\\ud83d\\ude00\"}", 3);
+    check("decodes escapes", escaped.tagName == "v1.\"2\"");
+    check("decodes surrogate pairs", escaped.htmlUrl == "https://x/\xF0\x9F\x98\x80");
+
+    ReleaseScanner nested = scan("{\"author\":{\"tag_name\":\"no\",\"html_url\":\"no\"},\"list\":[\"tag_name\",1]}", 4);
+    check("nested members are not matches", !nested.found() && nested.tagName.empty() && nested.htmlUrl.empty());
+
+    ReleaseScanner literal = scan("{\"tag_name\":null,\"x\":\"v9\",\"html_url\":\"u\"}", 5);
+    check("non-string value leaves field empty", literal.tagName.empty() && literal.htmlUrl == "u");
+
+    std::string padded = "{\"body\":\"" + std::string(5000, 'z') + "\",\"tag_name\":\"v1\",\"html_url\":\"u\"}";
+    check("gives up past its byte budget", !scan(padded, 512, 4096).found());
+    check("long skipped values are fine within budget", scan(padded, 512).found());
+
+    std::string huge = "{\"tag_name\":\"" + std::string(ReleaseScanner::MAX_VALUE_BYTES + 1, 'v') +
+                       "\",\"html_url\":\"u\"}";
+    check("oversized value dropped", scan(huge, 64).tagName.empty());
+
+    check("malformed escape stops scanning", !scan("{\"tag_name\":\"\\q\",\"html_url\":\"u\"}", 1).found());
+}
+
+HttpOrigin local_origin(const HttpStandIn& server) {
+    HttpOrigin origin;
+    origin.tls = false;
+    origin.host = "127.0.0.1";
+    origin.port = server.port;
+    return origin;
+}
+
+void test_conditional_fetch() {
+    test_section("Conditional Fetch");
+
+    HttpStandIn server([](const StandInRequest& request) {
+        if (request.head.find("If-None-Match: \"rel-9\"") != std::string::npos) {
+            return StandInReply{ "HTTP/1.1 304 Not Modified\r\nETag: \"rel-9\"\r\n\r\n", false };
+        }
+        return HttpStandIn::ok(RELEASE_JSON, "ETag: \"rel-9\"\r\n");
+    });
+    auto transport = create_http_transport();
+    HttpOrigin origin = local_origin(server);
+    const std::string path = "/repos/shanselman/toasty/releases/latest";
+
+    ReleaseInfo info;
+    check("first check downloads", fetch_latest_release(*transport, origin, path, info) == ReleaseCheckResult::Updated);
+    check("records tag, url and etag", info.tagName == "v0.9" && info.etag == "\"rel-9\"" &&
+          info.htmlUrl == "https://github.com/shanselman/toasty/releases/tag/v0.9");
+
+    std::vector<StandInRequest> requests = server.requests();
+    check("first request is unconditional", requests.size() == 1 &&
+          requests[0].head.find("If-None-Match") == std::string::npos &&
+          requests[0].head.find("Accept: application/vnd.github+json") != std::string::npos);
+
+    ReleaseInfo cached = info;
+    check("second check is a 304", fetch_latest_release(*transport, origin, path, cached) == ReleaseCheckResult::NotModified);
+    check("304 keeps cached info", cached.tagName == "v0.9" && cached.etag == "\"rel-9\"");
+
+    ReleaseInfo etagOnly;
+    etagOnly.etag = "\"rel-9\"";
+    check("etag without a cached tag is not sent",
+          fetch_latest_release(*transport, origin, path, etagOnly) == ReleaseCheckResult::Updated);
+}
+
+void test_early_stop() {
+    test_section("Early Stop");
+
+    // The fields come first; the rest of this body should never be read
+    std::string body = "{\"tag_name\":\"v2.0\",\"html_url\":\"https://github.com/r\",\"body\":\"" +
+                       std::string(2 * 1024 * 1024, 'x') + "\"}";
+    HttpStandIn server([&body](const StandInRequest& request) {
+        if (request.path == "/broken") return HttpStandIn::ok("{\"message\":\"Not Found\"}");
+        if (request.path == "/missing") {
+            return StandInReply{ "HTTP/1.1 404 Not Found\r\nContent-Length: 2\r\n\r\n{}", false };
+        }
+        return HttpStandIn::ok(body);
+    });
+    HttpOptions options;
+    options.maxBodyBytes = 4 * 1024 * 1024;
+    auto transport = create_http_transport(options);
+    HttpOrigin origin = local_origin(server);
+
+    ReleaseInfo info;
+    check("large body stops after the fields",
+          fetch_latest_release(*transport, origin, "/big", info) == ReleaseCheckResult::Updated &&
+          info.tagName == "v2.0" && info.etag.empty());
+
+    ReleaseInfo missing;
+    check("body without fields fails", fetch_latest_release(*transport, origin, "/broken", missing) == ReleaseCheckResult::Failed);
+    check("error status fails", fetch_latest_release(*transport, origin, "/missing", missing) == ReleaseCheckResult::Failed);
+    check("failure leaves info untouched", missing.tagName.empty() && missing.etag.empty());
+    check("abandoned body forces a new connection", server.connections() == 2);
+
+    HttpOrigin closed = origin;
+    closed.port = 1;
+    check("unreachable server fails", fetch_latest_release(*transport, closed, "/", missing) == ReleaseCheckResult::Failed);
+}
+
+void test_cache_file() {
+    test_section("Release Cache");
+
+    std::filesystem::path path = test_temp_path("release.cache");
+    std::filesystem::remove(path);
+
+    check("missing cache loads empty", load_release_cache(path).tagName.empty());
+
+    ReleaseInfo info{ "W/\"abc\"", "v1.2", "https://github.com/shanselman/toasty/releases/tag/v1.2" };
+    check("cache saves", save_release_cache(path, info));
+    ReleaseInfo loaded = load_release_cache(path);
+    check("cache round-trips", loaded.etag == info.etag && loaded.tagName == info.tagName && loaded.htmlUrl == info.htmlUrl);
+
+    ReleaseInfo multiline{ "e", "v1\nv2", "u" };
+    check("refuses values with newlines", !save_release_cache(path, multiline) && load_release_cache(path).tagName == "v1.2");
+
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "something else\n\"e\"\nv9\nu\n";
+    }
+    check("foreign file loads empty", load_release_cache(path).etag.empty());
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    test_scanner();
+    test_conditional_fetch();
+    test_early_stop();
+    test_cache_file();
+    return test_summary();
+}
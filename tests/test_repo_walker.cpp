@@ -0,0 +1,110 @@
+// test_repo_walker.cpp - Parallel repository discovery and per-repository hook installs
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+
+#include "core/hook_config.h"
+#include "core/repo_walker.h"
+#include "tests/test_harness.h"
+
+namespace fs = std::filesystem;
+
+void make_repo(const fs::path& dir) {
+    fs::create_directories(dir / ".git" / "objects");
+}
+
+// A checkout root of repositories, with the places a walk must not look inside
+fs::path make_tree() {
+    fs::path root = test_temp_path("walker");
+    fs::remove_all(root);
+    make_repo(root / "app");
+    make_repo(root / "libs" / "core");
+    make_repo(root / "libs" / "ui");
+    make_repo(root / "app" / "vendor" / "nested");                 // Repository inside a repository
+    fs::create_directories(root / "worktree");
+    std::ofstream(root / "worktree" / ".git") << "gitdir: ../app/.git/worktrees/wt\n";   // Worktree: .git is a file
+    make_repo(root / "app" / "node_modules" / "left-pad");          // Pruned
+    make_repo(root / "app" / ".git" / "modules" / "sub");           // Inside .git: pruned
+    fs::create_directories(root / "docs" / "empty");
+    for (int i = 0; i < 40; i++) make_repo(root / "many" / ("repo" + std::to_string(i)));
+    return root;
+}
+
+std::set<fs::path> find_repos(const fs::path& root, size_t threads, RepoWalkStats& stats) {
+    std::mutex mutex;
+    std::set<fs::path> found;
+    stats = walk_repositories(root, threads, [&](const fs::path& repo) {
+        std::lock_guard<std::mutex> lock(mutex);
+        found.insert(fs::relative(repo, root));
+    });
+    return found;
+}
+
+void test_walk() {
+    test_section("Repository Walk");
+
+    fs::path root = make_tree();
+    RepoWalkStats stats;
+    std::set<fs::path> found = find_repos(root, 1, stats);
+
+    std::set<fs::path> expected = { "app", fs::path("libs") / "core", fs::path("libs") / "ui",
+                                    fs::path("app") / "vendor" / "nested", "worktree" };
+    for (int i = 0; i < 40; i++) expected.insert(fs::path("many") / ("repo" + std::to_string(i)));
+    check("finds every repository", found == expected);
+    check("node_modules pruned", !found.count(fs::path("app") / "node_modules" / "left-pad"));
+    check("stats", stats.repositories == expected.size() && stats.threads == 1 && stats.directories > expected.size());
+
+    RepoWalkStats parallel;
+    check("same result in parallel", find_repos(root, 8, parallel) == expected && parallel.threads == 8 &&
+          parallel.directories == stats.directories);
+
+#ifndef _WIN32
+    fs::create_directory_symlink(root, root / "libs" / "loop");
+    RepoWalkStats linked;
+    check("symlinks not followed", find_repos(root, 4, linked) == expected);
+#endif
+
+    RepoWalkStats missing;
+    check("missing root", find_repos(root / "nope", 4, missing).empty() && missing.repositories == 0);
+
+    fs::remove_all(root);
+}
+
+void test_repository_hooks() {
+    test_section("Repository Hooks");
+
+    fs::path root = make_tree();
+    const char* exe = "/usr/local/bin/toasty";
+    RepoWalkStats stats;
+    std::vector<RepoHookResult> results = apply_repository_hooks(HookAgent::Copilot, root, exe, true, 4, stats);
+    bool allChanged = std::all_of(results.begin(), results.end(),
+                                  [](const RepoHookResult& r) { return r.outcome == RepoHookOutcome::Changed; });
+    check("installed in every repository", results.size() == 45 && allChanged &&
+          is_hook_installed(HookAgent::Copilot, root / "libs" / "ui" / ".github" / "hooks" / "toasty.json"));
+    check("results sorted", std::is_sorted(results.begin(), results.end(),
+                                           [](const RepoHookResult& a, const RepoHookResult& b) { return a.repo < b.repo; }));
+    check("nothing outside repositories", !fs::exists(root / ".github") && !fs::exists(root / "docs" / ".github"));
+
+    results = apply_repository_hooks(HookAgent::Copilot, root, exe, true, 4, stats);
+    check("second run unchanged", std::all_of(results.begin(), results.end(), [](const RepoHookResult& r) {
+        return r.outcome == RepoHookOutcome::Unchanged;
+    }));
+
+    results = apply_repository_hooks(HookAgent::Copilot, root, exe, false, 4, stats);
+    check("uninstalled everywhere", results.size() == 45 &&
+          !is_hook_installed(HookAgent::Copilot, root / "app" / ".github" / "hooks" / "toasty.json") &&
+          std::all_of(results.begin(), results.end(), [](const RepoHookResult& r) {
+              return r.outcome == RepoHookOutcome::Changed;
+          }));
+
+    fs::remove_all(root);
+}
+
+int main() {
+    test_walk();
+    test_repository_hooks();
+    return test_summary();
+}
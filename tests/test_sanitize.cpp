@@ -0,0 +1,132 @@
+// test_sanitize.cpp - ANSI stripping, control characters, UTF-8 repair and
+// grapheme-safe truncation of notification text
+
+#include <string>
+
+#include "core/sanitize.h"
+#include "core/sinks.h"
+#include "tests/test_harness.h"
+
+void test_escapes() {
+    test_section("Escape Sequences");
+
+    check("SGR colors", sanitize_text("\x1b[1;32mPASS\x1b[0m all tests", 100) == "PASS all tests");
+    check("cursor movement", sanitize_text("50%\x1b[2K\x1b[1G100%", 100) == "50%100%");
+    check("private CSI", sanitize_text("\x1b[?25lhidden cursor\x1b[?25h", 100) == "hidden cursor");
+    check("OSC title with BEL", sanitize_text("\x1b]0;window title\x07" "done", 100) == "done");
+    check("OSC hyperlink with ST", sanitize_text("\x1b]8;;https://x.test\x1b\\link\x1b]8;;\x1b\\", 100) == "link");
+    check("charset selection", sanitize_text("\x1b(Bplain", 100) == "plain");
+    check("two-character escape", sanitize_text("a\x1b" "7b\x1b" "8c", 100) == "abc");
+    check("C1 CSI", sanitize_text("\xC2\x9B" "31mred", 100) == "red");
+    check("ESC then ordinary text", sanitize_text("x\x1b\xC3\xA9", 100) == "x\xC3\xA9");
+    check("unterminated CSI at end", sanitize_text("done\x1b[3", 100) == "done");
+
+    TextSanitizer split(100);
+    split.write("\x1b[3");
+    split.write("1mred\x1b");
+    split.write("[0m!");
+    check("sequence split across writes", split.finish() == "red!");
+}
+
+void test_controls() {
+    test_section("Control Characters");
+
+    check("newlines and tabs kept", sanitize_text("a\n\tb", 100) == "a\n\tb");
+    check("CRLF becomes LF", sanitize_text("a\r\nb\rc", 100) == "a\nb\nc");
+    check("other C0 dropped", sanitize_text(std::string("a\x00" "b\x07\x08" "c", 6), 100) == "abc");
+    check("DEL and C1 dropped", sanitize_text("a\x7f" "b\xC2\x85" "c", 100) == "abc");
+    check("single line", sanitize_text("Build\nfailed\tnow", 100, true) == "Build failed now");
+}
+
+void test_utf8_repair() {
+    test_section("UTF-8 Repair");
+
+    check("valid text unchanged", sanitize_text("caf\xC3\xA9 \xE2\x9C\x93 \xF0\x9F\x8E\x89", 100) ==
+          "caf\xC3\xA9 \xE2\x9C\x93 \xF0\x9F\x8E\x89");
+    check("invalid byte", sanitize_text("a\xFF" "b", 100) == "a\xEF\xBF\xBD" "b");
+    check("truncated sequence", sanitize_text("a\xE2\x9C" "b", 100) == "a\xEF\xBF\xBD\xEF\xBF\xBD" "b");
+    check("overlong", sanitize_text("\xC0\xAF", 100) == "\xEF\xBF\xBD\xEF\xBF\xBD");
+    check("sequence cut at end", sanitize_text("ok\xF0\x9F", 100) == "ok\xEF\xBF\xBD\xEF\xBF\xBD");
+
+    TextSanitizer split(100);
+    split.write("\xE2\x9C");
+    split.write("\x93");
+    check("sequence split across writes", split.finish() == "\xE2\x9C\x93");
+
+    check("wide input", sanitize_text(std::wstring(L"\x1b[31mr\u00e9d"), 100) == "r\xC3\xA9" "d");
+}
+
+void test_truncation() {
+    test_section("Truncation");
+
+    check("fits exactly", sanitize_text("0123456789", 10) == "0123456789");
+    check("cut with ellipsis", sanitize_text("0123456789A", 10) == "0123456...");
+    check("trailing space trimmed before ellipsis", sanitize_text("done and more text", 12) == "done and...");
+    check("escapes don't count", sanitize_text("\x1b[1mbold\x1b[0m", 4) == "bold");
+
+    // e + combining acute (3 bytes): never split from its base letter
+    check("combining mark stays with letter", sanitize_text("abcde\xCC\x81xyz", 8) == "abcd...");
+    // Woman + ZWJ + laptop: kept whole or dropped whole
+    std::string technologist = "\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x92\xBB";
+    check("ZWJ sequence kept whole", sanitize_text("hi " + technologist + " there", 17) == "hi " + technologist + "...");
+    check("ZWJ sequence dropped whole", sanitize_text("hi " + technologist + " there", 12) == "hi...");
+    // Two flags (four regional indicators): cut between the pairs, never inside one
+    std::string flags = "\xF0\x9F\x87\xAF\xF0\x9F\x87\xB5\xF0\x9F\x87\xBA\xF0\x9F\x87\xB8";
+    check("flag pairs", sanitize_text(flags, 14) == flags.substr(0, 8) + "...");
+    check("skin tone modifier", sanitize_text("\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD!", 7) == "...");
+
+    check("tiny budget", sanitize_text("abcdef", 2) == "");
+
+    // A huge message only costs the part that is kept
+    std::string huge(8 << 20, 'x');
+    TextSanitizer bounded(64);
+    check("stops reading when full", !bounded.write(huge) && bounded.full() && bounded.finish().size() == 64);
+}
+
+void test_json_strings() {
+    test_section("JSON Strings");
+
+    check("escapes decoded", sanitize_json_string("line1\\nline2 \\\"q\\\" \\u00e9", 100) == "line1\nline2 \"q\" \xC3\xA9");
+    check("escaped ANSI stripped", sanitize_json_string("\\u001b[32mgreen\\u001b[0m", 100) == "green");
+    check("surrogate pair", sanitize_json_string("\\ud83c\\udf89", 100) == "\xF0\x9F\x8E\x89");
+    check("lone surrogate", sanitize_json_string("\\ud83c!", 100) == "\xEF\xBF\xBD!");
+    check("invalid escape kept", sanitize_json_string("C:\\x \\u12", 100) == "C:\\x \\u12");
+    check("truncated", sanitize_json_string("a\\tb" + std::string(10000, 'c'), 20) == "a\tb" + std::string(14, 'c') + "...");
+}
+
+void test_sink_limits() {
+    test_section("Sink Limits");
+
+    std::vector<SinkConfig> configs;
+    std::string error;
+    check("limits from defaults", parse_sink_configs("toast,ntfy,stdout", configs, error) && configs.size() == 3 &&
+          configs[0].maxMessageBytes == sink_message_limit(SinkKind::Toast) &&
+          configs[1].maxMessageBytes == sink_message_limit(SinkKind::Ntfy) &&
+          configs[2].maxMessageBytes == MAX_MESSAGE_BYTES);
+    check("toast tighter than ntfy", sink_message_limit(SinkKind::Toast) < sink_message_limit(SinkKind::Ntfy));
+
+    std::string received;
+    SinkTask task;
+    task.name = "capture";
+    task.deadlineMs = 2000;
+    task.required = true;
+    task.maxMessageBytes = 16;
+    task.sink = std::make_shared<FunctionSink>([&received](const Notification& n) {
+        received = n.message;
+        return true;
+    });
+    Notification notification;
+    notification.message = "All 318 tests passed on the first try";
+    std::vector<SinkResult> results = dispatch_sinks({ task }, notification);
+    check("dispatch cuts per sink", results.size() == 1 && results[0].delivered && received == "All 318 tests...");
+}
+
+int main() {
+    test_escapes();
+    test_controls();
+    test_utf8_repair();
+    test_truncation();
+    test_json_strings();
+    test_sink_limits();
+    return test_summary();
+}
@@ -0,0 +1,230 @@
+// test_sinks.cpp - Sink configuration parsing and concurrent dispatch with deadlines
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "core/sanitize.h"
+#include "core/sinks.h"
+#include "tests/test_harness.h"
+
+#ifndef _WIN32
+#include "tests/http_stand_in.h"
+#endif
+
+SinkTask make_task(const std::string& name, int sleepMs, bool result, int deadlineMs, bool required) {
+    SinkTask task;
+    task.name = name;
+    task.deadlineMs = deadlineMs;
+    task.required = required;
+    task.sink = std::make_shared<FunctionSink>([sleepMs, result](const Notification&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        return result;
+    });
+    return task;
+}
+
+long long elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+Notification sample_notification() {
+    Notification notification;
+    notification.title = "Claude";
+    notification.message = "Done \"quoted\"\n";
+    notification.source = "claude";
+    notification.cwd = "C:\\work";
+    notification.timestampMs = 1700000000000;
+    return notification;
+}
+
+void test_parsing() {
+    test_section("Sink Configuration");
+
+    std::vector<SinkConfig> configs;
+    std::string error;
+    check("parses default list", parse_sink_configs("toast,ntfy", configs, error) && configs.size() == 2);
+    check("toast required by default", configs.size() == 2 && configs[0].required && configs[0].deadlineMs == 5000);
+    check("ntfy best-effort by default", configs.size() == 2 && !configs[1].required);
+
+    check("parses targets, deadlines and flags",
+          parse_sink_configs(" webhook=https://user@hooks.example.com/x@1500! , file=C:\\logs\\toasty.jsonl? ,stdout", configs, error) &&
+          configs.size() == 3);
+    check("webhook target keeps '@'", configs.size() == 3 && configs[0].target == "https://user@hooks.example.com/x");
+    check("webhook deadline and required", configs.size() == 3 && configs[0].deadlineMs == 1500 && configs[0].required);
+    check("file made best-effort", configs.size() == 3 && configs[1].kind == SinkKind::File && !configs[1].required);
+    check("stdout kind", configs.size() == 3 && configs[2].kind == SinkKind::Stdout);
+
+    check("rejects unknown sink", !parse_sink_configs("toast,pager", configs, error) && error.find("pager") != std::string::npos);
+    check("rejects missing target", !parse_sink_configs("webhook", configs, error));
+    check("rejects unexpected target", !parse_sink_configs("toast=x", configs, error));
+    check("rejects zero deadline", !parse_sink_configs("toast@0", configs, error));
+    check("rejects empty list", !parse_sink_configs(" , ", configs, error));
+}
+
+void test_json() {
+    test_section("Notification JSON");
+
+    check("escapes and orders fields", notification_json(sample_notification()) ==
+          "{\"title\":\"Claude\",\"message\":\"Done \\\"quoted\\\"\\n\",\"source\":\"claude\","
+          "\"cwd\":\"C:\\\\work\",\"timestamp\":1700000000000}");
+}
+
+void test_dispatch() {
+    test_section("Dispatch");
+
+    Notification notification = sample_notification();
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = dispatch_sinks({ make_task("a", 150, true, 2000, true), make_task("b", 150, true, 2000, true) },
+                                  notification);
+    long long concurrent = elapsed_ms(start);
+    check("required sinks run concurrently", concurrent < 280);
+    check("both delivered", results.size() == 2 && results[0].delivered && results[1].delivered);
+
+    start = std::chrono::steady_clock::now();
+    results = dispatch_sinks({ make_task("fast", 10, true, 2000, true), make_task("slow", 2000, true, 5000, false) },
+                             notification);
+    check("slow best-effort sink doesn't delay", elapsed_ms(start) < 500);
+    check("slow best-effort sink abandoned", results.size() == 2 && results[1].timedOut && !results[1].delivered);
+    check("required result kept", results.size() == 2 && results[0].delivered && results[0].name == "fast");
+
+    std::vector<Notification> handed;
+    SinkTask webhook = make_task("webhook", 2000, true, 5000, false);
+    webhook.maxMessageBytes = 4;
+    webhook.handoff = [&handed](const Notification& n) {
+        handed.push_back(n);
+        return true;
+    };
+    start = std::chrono::steady_clock::now();
+    results = dispatch_sinks({ make_task("fast", 10, true, 2000, true), webhook }, notification);
+    check("handoff doesn't delay either", elapsed_ms(start) < 500);
+    check("unfinished best-effort sink handed off", results.size() == 2 && results[1].handedOff && !results[1].timedOut &&
+          handed.size() == 1 && handed[0].title == notification.title);
+    check("handoff gets the sink's cut message", handed.size() == 1 && handed[0].message == sanitize_text(notification.message, 4));
+
+    handed.clear();
+    webhook.deadlineMs = 100;
+    results = dispatch_sinks({ make_task("slow", 300, true, 2000, true), webhook }, notification);
+    check("own deadline passed: abandoned, not handed off", results.size() == 2 && results[1].timedOut &&
+          !results[1].handedOff && handed.empty());
+
+    start = std::chrono::steady_clock::now();
+    results = dispatch_sinks({ make_task("hung", 3000, true, 100, true) }, notification);
+    check("required deadline enforced", elapsed_ms(start) < 1000 && results.size() == 1 && results[0].timedOut);
+
+    results = dispatch_sinks({ make_task("only", 20, true, 1000, false) }, notification);
+    check("best-effort alone waits for its own deadline", results.size() == 1 && results[0].delivered);
+
+    SinkTask throwing;
+    throwing.name = "throws";
+    throwing.required = true;
+    throwing.deadlineMs = 1000;
+    throwing.sink = std::make_shared<FunctionSink>([](const Notification&) -> bool {
+        throw std::runtime_error("sink failure");
+    });
+    results = dispatch_sinks({ throwing, make_task("ok", 10, true, 1000, true), make_task("fails", 10, false, 1000, true) },
+                             notification);
+    check("exception is isolated", results.size() == 3 && !results[0].delivered && !results[0].timedOut);
+    check("others unaffected by failures", results.size() == 3 && results[1].delivered && !results[2].delivered);
+}
+
+void test_portable_sinks() {
+    test_section("Portable Sinks");
+
+    Notification notification = sample_notification();
+
+    std::filesystem::path log = test_temp_path("sink.jsonl");
+    std::filesystem::remove(log);
+
+    SinkConfig fileConfig;
+    fileConfig.kind = SinkKind::File;
+    fileConfig.target = log.string();
+    auto fileSink = create_portable_sink(fileConfig);
+    check("file sink appends", fileSink && fileSink->deliver(notification) && fileSink->deliver(notification));
+
+    std::ifstream file(log);
+    std::string line;
+    int lines = 0;
+    bool allJson = true;
+    while (std::getline(file, line)) {
+        lines++;
+        allJson &= line == notification_json(notification);
+    }
+    file.close();
+    check("file holds one JSON line per notification", lines == 2 && allJson);
+    std::filesystem::remove(log);
+    std::filesystem::remove(log.string() + ".lock");
+
+    SinkConfig toastConfig;
+    check("toast is platform-specific", create_portable_sink(toastConfig) == nullptr);
+
+#ifndef _WIN32
+    HttpStandIn server([](const StandInRequest&) { return HttpStandIn::ok("ok"); });
+    SinkConfig webhookConfig;
+    webhookConfig.kind = SinkKind::Webhook;
+    webhookConfig.target = "http://127.0.0.1:" + std::to_string(server.port) + "/hook";
+    webhookConfig.deadlineMs = 2000;
+    auto webhook = create_portable_sink(webhookConfig);
+    check("webhook delivers", webhook && webhook->deliver(notification));
+    auto requests = server.requests();
+    check("webhook posts notification JSON", requests.size() == 1 && requests[0].path == "/hook" &&
+          requests[0].body == notification_json(notification));
+
+    webhookConfig.target = "http://127.0.0.1:1/hook";
+    check("unreachable webhook fails", !create_portable_sink(webhookConfig)->deliver(notification));
+#endif
+}
+
+void test_queue() {
+    test_section("Sink Queue");
+
+    Notification notification = sample_notification();
+    Notification parsed;
+    check("notification JSON round-trips", parse_notification_json(notification_json(notification), parsed) &&
+          parsed.title == notification.title && parsed.message == notification.message &&
+          parsed.source == notification.source && parsed.cwd == notification.cwd &&
+          parsed.timestampMs == notification.timestampMs);
+    check("non-object is not a notification", !parse_notification_json("Done", parsed));
+
+    std::filesystem::path dir = test_temp_path("sink-queue");
+    std::filesystem::remove_all(dir);
+
+    SinkConfig webhook;
+    webhook.kind = SinkKind::Webhook;
+    webhook.target = "http://127.0.0.1:9/a,b";
+    webhook.deadlineMs = 1500;
+    SinkConfig file;
+    file.kind = SinkKind::File;
+    file.target = (dir / "out.jsonl").string();
+    file.deadlineMs = 1000;
+    check("jobs queue", queue_sink_job(dir, webhook, notification) && queue_sink_job(dir, file, notification));
+
+    std::vector<SinkJob> jobs = claim_sink_jobs(dir);
+    check("claims every job", jobs.size() == 2);
+    bool webhookFound = false;
+    for (const auto& job : jobs) {
+        if (job.config.kind == SinkKind::Webhook) {
+            webhookFound = job.config.target == "http://127.0.0.1:9/a,b" && job.config.deadlineMs == 1500 &&
+                           job.notification.message == notification.message;
+        }
+    }
+    check("job keeps sink and notification", webhookFound);
+    check("claimed jobs are gone", claim_sink_jobs(dir).empty());
+
+    std::ofstream(dir / "1-torn.sink") << "webhook\n";
+    check("torn job dropped", claim_sink_jobs(dir).empty() && !std::filesystem::exists(dir / "1-torn.sink") &&
+          !std::filesystem::exists(dir / "1-torn.claimed"));
+    std::filesystem::remove_all(dir);
+}
+
+int main() {
+    test_parsing();
+    test_json();
+    test_dispatch();
+    test_portable_sinks();
+    test_queue();
+    return test_summary();
+}
@@ -0,0 +1,158 @@
+// test_state_file.cpp - Memory-mapped state file: persistence, versioning and seqlock updates
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "core/state_file.h"
+#include "tests/test_harness.h"
+
+std::filesystem::path test_state_path(const char* name) {
+    std::filesystem::path path = test_temp_path(std::string(name) + ".bin");
+    std::filesystem::remove(path);
+    return path;
+}
+
+void remove_state(const std::filesystem::path& path) {
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + ".lock");
+}
+
+// Overwrite one u32 header word of a (closed) state file
+void poke_u32(const std::filesystem::path& path, size_t offset, uint32_t value) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void test_persistence() {
+    test_section("Persistence");
+
+    std::filesystem::path path = test_state_path("persist");
+    {
+        auto state = StateFile::open(path);
+        if (!check("creates and maps a new file", state != nullptr)) return;
+        check("new file is zeroed", state->read() == ToastyState());
+        check("file has fixed size", std::filesystem::file_size(path) == STATE_FILE_SIZE);
+
+        check("update succeeds", state->update([](ToastyState& s) {
+            s.registrationFingerprint = 0x1234567890abcdefULL;
+            s.lastConsoleWindow = 42;
+            s.notificationCount++;
+        }));
+        check("update visible to same mapping", state->read().lastConsoleWindow == 42);
+    }
+    {
+        auto state = StateFile::open(path);
+        ToastyState snapshot = state ? state->read() : ToastyState();
+        check("values survive reopen", snapshot.registrationFingerprint == 0x1234567890abcdefULL &&
+              snapshot.lastConsoleWindow == 42 && snapshot.notificationCount == 1);
+
+        auto other = StateFile::open(path);
+        state->update([](ToastyState& s) { s.focusCount = 7; });
+        check("second mapping sees writes", other && other->read().focusCount == 7);
+
+        uint32_t before = state->sequence();
+        state->update([](ToastyState& s) { s.focusCount = 7; });
+        check("unchanged update writes nothing", state->sequence() == before);
+        state->update([](ToastyState& s) { s.focusCount = 8; });
+        check("changed update advances sequence by two", state->sequence() == before + 2);
+    }
+    remove_state(path);
+}
+
+void test_versioning() {
+    test_section("Versioning");
+
+    std::filesystem::path path = test_state_path("version");
+    {
+        auto state = StateFile::open(path);
+        state->update([](ToastyState& s) { s.notificationCount = 99; });
+    }
+
+    poke_u32(path, 4, STATE_FILE_VERSION + 1);
+    {
+        auto state = StateFile::open(path);
+        check("other version is reset", state && state->read() == ToastyState());
+        state->update([](ToastyState& s) { s.notificationCount = 5; });
+    }
+
+    poke_u32(path, 0, 0xDEADBEEF);
+    {
+        auto state = StateFile::open(path);
+        check("foreign magic is reset", state && state->read().notificationCount == 0);
+    }
+
+    {
+        std::ofstream garbage(path, std::ios::binary | std::ios::trunc);
+        garbage << "not a state file";
+    }
+    {
+        auto state = StateFile::open(path);
+        check("short garbage file is reset", state && state->read() == ToastyState() &&
+              std::filesystem::file_size(path) == STATE_FILE_SIZE);
+    }
+
+    {
+        auto state = StateFile::open(path);
+        state->update([](ToastyState& s) { s.focusCount = 3; });
+    }
+    poke_u32(path, 12, 41);  // Odd sequence: a writer died mid-update
+    {
+        auto state = StateFile::open(path);
+        check("reader recovers from dead writer", state && state->read().focusCount == 3);
+        check("next write repairs sequence", state->update([](ToastyState& s) { s.focusCount = 4; }) &&
+              state->sequence() % 2 == 0 && state->read().focusCount == 4);
+    }
+    remove_state(path);
+}
+
+void test_concurrency() {
+    test_section("Concurrent Writers and Readers");
+
+    std::filesystem::path path = test_state_path("concurrent");
+    const int writers = 4;
+    const int increments = 200;
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&]() {
+        auto state = StateFile::open(path);
+        while (!stop) {
+            // Writers keep these two fields equal; a torn snapshot would differ
+            ToastyState snapshot = state->read();
+            if (snapshot.notificationCount != snapshot.lastNotification) torn++;
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < writers; i++) {
+        threads.emplace_back([&]() {
+            auto state = StateFile::open(path);  // Separate mapping, like another process
+            for (int n = 0; n < increments; n++) {
+                state->update([](ToastyState& s) {
+                    s.notificationCount++;
+                    s.lastNotification = s.notificationCount;
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    stop = true;
+    reader.join();
+
+    auto state = StateFile::open(path);
+    check("no lost updates", state && state->read().notificationCount == static_cast<uint64_t>(writers * increments));
+    check("readers never see torn state", torn == 0);
+    remove_state(path);
+}
+
+int main() {
+    test_persistence();
+    test_versioning();
+    test_concurrency();
+    return test_summary();
+}
@@ -0,0 +1,191 @@
+// test_strings.cpp - UTF-8 conversion, escaping, version comparison and preset lookup
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "core/char_scan.h"
+#include "core/json.h"
+#include "core/presets.h"
+#include "core/strings.h"
+#include "tests/test_harness.h"
+
+void test_utf8() {
+    test_section("UTF-8 Conversion");
+
+    check("ASCII round-trips", to_utf8(L"Task complete") == "Task complete" && from_utf8("Task complete") == L"Task complete");
+    check("BMP characters", to_utf8(L"caf\u00e9 \u2713") == "caf\xC3\xA9 \xE2\x9C\x93" &&
+          from_utf8("caf\xC3\xA9 \xE2\x9C\x93") == L"caf\u00e9 \u2713");
+
+    std::wstring emoji = from_utf8("\xF0\x9F\x98\x80");
+    check("supplementary characters", to_utf8(emoji) == "\xF0\x9F\x98\x80" &&
+          emoji.size() == (sizeof(wchar_t) == 2 ? 2u : 1u));
+
+    check("invalid bytes become U+FFFD", from_utf8("a\xFF" "b") == L"a\uFFFD" L"b");
+    check("truncated sequence", from_utf8("a\xE2\x9C") == L"a\uFFFD\uFFFD");
+    check("overlong encoding rejected", from_utf8("\xC0\xAF") == L"\uFFFD\uFFFD");
+    check("encoded surrogate rejected", from_utf8("\xED\xA0\x80").front() == 0xFFFD);
+    check("empty", to_utf8(L"").empty() && from_utf8("").empty());
+}
+
+void test_escaping() {
+    test_section("Escaping");
+
+    check("XML entities", escape_xml(L"a & b <c> \"d\" 'e'") == L"a &amp; b &lt;c&gt; &quot;d&quot; &apos;e&apos;");
+    check("XML UTF-8 overload", escape_xml(std::string_view("<\xE2\x9C\x93>")) == "&lt;\xE2\x9C\x93&gt;");
+    check("XML plain text unchanged", escape_xml(L"Build completed") == L"Build completed");
+
+    check("JSON escapes", escape_json_string(L"C:\\a \"b\"\n\r\t") == L"C:\\\\a \\\"b\\\"\\n\\r\\t");
+    check("JSON UTF-8 overload", escape_json_string(std::string_view("a\\b")) == "a\\\\b");
+
+    check("shell path", normalize_path_for_shell(L"D:\\app\\toasty\\toasty.exe") == L"D:/app/toasty/toasty.exe");
+    check("shell path UTF-8", normalize_path_for_shell(std::string_view("C:\\x")) == "C:/x");
+
+    check("to_lower", to_lower(L"CLAUDE.Exe") == L"claude.exe");
+    check("to_lower_ascii leaves UTF-8 alone", to_lower_ascii("Caf\xC3\x89 OK") == "caf\xC3\x89 ok");
+    check("equals_ignore_case", equals_ignore_case(L"High", L"high") && !equals_ignore_case(L"high", L"higher"));
+    check("equals_ignore_case narrow", equals_ignore_case(std::string_view("Content-Length"), "content-length") &&
+                                       !equals_ignore_case(std::string_view("\xC3\x89"), "\xC3\xA9"));
+}
+
+// Character-at-a-time reference for escape_xml
+std::wstring reference_escape_xml(std::wstring_view text) {
+    std::wstring result;
+    for (wchar_t c : text) {
+        switch (c) {
+            case L'&': result += L"&amp;"; break;
+            case L'<': result += L"&lt;"; break;
+            case L'>': result += L"&gt;"; break;
+            case L'"': result += L"&quot;"; break;
+            case L'\'': result += L"&apos;"; break;
+            default: result += c; break;
+        }
+    }
+    return result;
+}
+
+// Every level the CPU supports must agree with the reference, with the special
+// character at each offset of a vector, in the tail, and next to non-ASCII text
+bool simd_matches_reference(SimdLevel level) {
+    force_simd_level(level);
+    for (size_t length = 0; length <= 70; length++) {
+        for (size_t pos = 0; pos <= length; pos++) {
+            std::wstring text(length, L'a');
+            if (length > 3) text[length / 2] = L'\u00e9';
+            if (length > 5) text[1] = static_cast<wchar_t>(0x263C);   // Low byte '<'
+            if (pos < length) text[pos] = L"&<>\"'"[pos % 5];
+            if (escape_xml(text) != reference_escape_xml(text)) return false;
+            if (escape_xml(to_utf8(text)) != to_utf8(reference_escape_xml(text))) return false;
+            if (find_first_in_set(text, CharSet{{'&', '<', '>', '"', '\''}, 5, false}) != (pos < length ? pos : length)) return false;
+        }
+    }
+    return true;
+}
+
+void test_simd_escaping() {
+    test_section("Vectorized Escaping");
+
+    SimdLevel best = simd_level();
+    check("scalar matches reference", simd_matches_reference(SimdLevel::Scalar));
+    check("SSE2 matches reference", simd_matches_reference(SimdLevel::Sse2));
+    check("AVX2 matches reference", simd_matches_reference(SimdLevel::Avx2));
+    force_simd_level(best);
+
+    std::wstring clean = L"Build completed in 12s";
+    const wchar_t* before = clean.data();
+    check("in place: nothing to escape", !escape_xml_in_place(clean) && clean.data() == before &&
+          clean == L"Build completed in 12s");
+    std::wstring dirty = L"a<b";
+    check("in place: escaped", escape_xml_in_place(dirty) && dirty == L"a&lt;b");
+    std::string json = "C:\\x \"y\"";
+    check("in place: JSON", escape_json_string_in_place(json) && json == "C:\\\\x \\\"y\\\"");
+
+    std::wstring xml = L"<text>";
+    append_xml_escaped(xml, L"R&D");
+    check("append into document", xml == L"<text>R&amp;D");
+
+    CharSet controls = {{'"'}, 1, true};
+    bool controlsFound = true;
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2}) {
+        force_simd_level(level);
+        std::string bytes(40, 'x');
+        bytes[3] = '\x7F';
+        bytes[5] = '\xC3';   // Non-ASCII bytes are not controls
+        bytes[33] = '\x1F';
+        controlsFound = controlsFound && find_first_in_set(bytes, controls) == 33 &&
+                        find_first_in_set(std::wstring(30, L'\u2000') + L"\x01", controls) == 30;
+    }
+    force_simd_level(best);
+    check("control characters", controlsFound);
+
+    std::string quoted;
+    append_json_string(quoted, std::string("tab\there \x01 \xC3\xA9 \"q\"") + std::string(40, 'z'));
+    check("append_json_string", quoted == "\"tab\\there \\u0001 \xC3\xA9 \\\"q\\\"" + std::string(40, 'z') + "\"");
+}
+
+void test_versions() {
+    test_section("Version Comparison");
+
+    check("newer minor", is_newer_version(L"0.7", L"v0.8"));
+    check("newer major", is_newer_version(L"0.7", L"1.0"));
+    check("same version", !is_newer_version(L"0.7", L"v0.7"));
+    check("older version", !is_newer_version(L"0.7", L"0.6"));
+    check("minor compares numerically", is_newer_version(L"0.9", L"0.10"));
+    check("patch ignored", !is_newer_version(L"0.7", L"0.7.1"));
+    check("suffixes ignored", is_newer_version(L"0.7", L"V0.8-beta"));
+    check("garbage is 0.0", !is_newer_version(L"0.7", L"latest") && is_newer_version(L"junk", L"0.1"));
+}
+
+void test_presets() {
+    test_section("Presets");
+
+    const AppPreset* claude = find_preset(L"Claude");
+    check("find by name, any case", claude && claude->title == L"Claude");
+    check("unknown name", find_preset(L"vim") == nullptr);
+    check("every preset findable", [] {
+        for (size_t i = 0; i < APP_PRESET_COUNT; i++) {
+            if (find_preset(APP_PRESETS[i].name) != &APP_PRESETS[i]) return false;
+        }
+        return true;
+    }());
+
+    const AppPreset* gemini = check_command_line_for_preset(L"node C:\\npm\\node_modules\\@google\\gemini-cli\\dist\\index.js");
+    check("command line pattern", gemini && gemini->name == L"gemini");
+    check("no pattern", check_command_line_for_preset(L"node server.js") == nullptr);
+
+    check("match by exe name", match_process_preset(L"codex", L"") == find_preset(L"codex"));
+    check("match by command line", match_process_preset(L"node", L"/usr/lib/node_modules/@anthropic-ai/claude-code/cli.js") == claude);
+    check("no match", match_process_preset(L"bash", L"-bash") == nullptr);
+}
+
+void test_hashing_and_files() {
+    test_section("Hashing and Files");
+
+    check("fnv1a_64 of nothing is the offset", fnv1a_64("") == FNV1A_64_OFFSET);
+    check("fnv1a_64 known value", fnv1a_64("a") == 0xaf63dc4c8601ec8cULL);
+    check("fnv1a_64 continues over pieces", fnv1a_64("bar", fnv1a_64("foo")) == fnv1a_64("foobar"));
+    check("path_key is the generic form", path_key(std::filesystem::path("a") / "b.json") == "a/b.json");
+#ifdef _WIN32
+    check("path_key folds case on Windows", path_key("C:\\Users\\Me") == path_key("c:/users/me"));
+#else
+    check("path_key keeps case on POSIX", path_key("/home/Me") != path_key("/home/me"));
+#endif
+    check("fnv1a_32 known values", fnv1a_32("") == 0x811c9dc5u && fnv1a_32("a") == 0xe40c292cu);
+
+    std::filesystem::path path = test_temp_path("read.bin");
+    std::string bytes("a\0b\r\n", 5);
+    std::ofstream(path, std::ios::binary) << bytes;
+    check("read_file_bytes keeps every byte", read_file_bytes(path) == bytes);
+    std::filesystem::remove(path);
+    check("missing file reads as empty", read_file_bytes(path).empty());
+}
+
+int main() {
+    test_utf8();
+    test_escaping();
+    test_simd_escaping();
+    test_versions();
+    test_presets();
+    test_hashing_and_files();
+    return test_summary();
+}
@@ -0,0 +1,102 @@
+// test_template.cpp - Title/message template compilation, rendering and git context
+
+#include <filesystem>
+#include <fstream>
+
+#include "core/text_template.h"
+#include "tests/test_harness.h"
+
+TemplateValues sample_values() {
+    TemplateValues values;
+    values[TemplateField::Preset] = "Claude";
+    values[TemplateField::Cwd] = "C:\\src\\toasty";
+    values[TemplateField::Repo] = "/home/me/work/toasty/";
+    values[TemplateField::Branch] = "main";
+    values[TemplateField::Event] = "Stop";
+    values[TemplateField::Session] = "abc123";
+    values[TemplateField::Message] = "All tests pass";
+    values[TemplateField::Duration] = "4m 05s";
+    values.env = { { "TOASTY_TEST", "hello" } };
+    return values;
+}
+
+void test_compile() {
+    test_section("Template Compilation");
+
+    TextTemplate plain = TextTemplate::compile("Task complete");
+    check("plain text is literal", plain.is_literal() && plain.render(TemplateValues()) == "Task complete");
+
+    TextTemplate t = TextTemplate::compile("{preset}: {cwd:basename} finished in {duration}");
+    check("slots detected", !t.is_literal() && t.uses(TemplateField::Preset) &&
+          t.uses(TemplateField::Cwd) && t.uses(TemplateField::Duration));
+    check("unused fields not flagged", !t.uses(TemplateField::Branch) && !t.uses(TemplateField::Env));
+    check("renders slots", t.render(sample_values()) == "Claude: toasty finished in 4m 05s");
+
+    check("full cwd", TextTemplate::compile("in {cwd}").render(sample_values()) == "in C:\\src\\toasty");
+    check("basename ignores trailing separator",
+          TextTemplate::compile("{repo:basename}@{branch}").render(sample_values()) == "toasty@main");
+    check("payload fields", TextTemplate::compile("{event} {session}: {message}").render(sample_values()) ==
+          "Stop abc123: All tests pass");
+
+    TextTemplate env = TextTemplate::compile("{env:TOASTY_TEST} {env:MISSING}!");
+    std::vector<std::string_view> names = env.env_names();
+    check("env names listed", names.size() == 2 && names[0] == "TOASTY_TEST" && names[1] == "MISSING");
+    check("env values rendered, missing ones empty", env.render(sample_values()) == "hello !");
+
+    check("doubled braces are literal", TextTemplate::compile("{{preset}} }}").render(sample_values()) == "{preset} }");
+    check("unknown names kept as written", TextTemplate::compile("{foo} {preset:upper} {env:}").is_literal() &&
+          TextTemplate::compile("{foo} {preset:upper} {env:}").render(sample_values()) == "{foo} {preset:upper} {env:}");
+    check("unclosed brace kept", TextTemplate::compile("a {preset").render(sample_values()) == "a {preset");
+    check("stray brace before a slot", TextTemplate::compile("x { {preset}").render(sample_values()) == "x { Claude");
+    check("empty fields render empty", TextTemplate::compile("[{branch}]").render(TemplateValues()) == "[]");
+    check("UTF-8 passes through", TextTemplate::compile("\xE2\x9C\x93 {preset}").render(sample_values()) ==
+          "\xE2\x9C\x93 Claude");
+
+    std::string long_text(10000, 'x');
+    check("long literal round-trips", TextTemplate::compile(long_text + "{preset}").render(sample_values()) ==
+          long_text + "Claude");
+}
+
+void test_duration() {
+    test_section("Durations");
+
+    check("seconds", format_duration(42000) == "42s");
+    check("minutes", format_duration(245000) == "4m 05s");
+    check("hours", format_duration(3720000) == "1h 02m");
+    check("zero", format_duration(999) == "0s");
+    check("unknown", format_duration(-1).empty());
+}
+
+void test_git_context() {
+    test_section("Git Context");
+
+    std::filesystem::path root = test_temp_path("git");
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "repo" / ".git");
+    std::filesystem::create_directories(root / "repo" / "src" / "deep");
+    std::ofstream(root / "repo" / ".git" / "HEAD") << "ref: refs/heads/feature/templates\n";
+
+    std::string repo, branch;
+    check("finds repo from a subdirectory", read_git_context(root / "repo" / "src" / "deep", repo, branch) &&
+          std::filesystem::path(repo) == root / "repo" && branch == "feature/templates");
+
+    std::filesystem::create_directories(root / "worktree");
+    std::filesystem::create_directories(root / "gitdirs" / "wt");
+    std::ofstream(root / "worktree" / ".git") << "gitdir: ../gitdirs/wt\n";
+    std::ofstream(root / "gitdirs" / "wt" / "HEAD") << "0123456789abcdef0123456789abcdef01234567\n";
+    check("worktree .git file and detached HEAD", read_git_context(root / "worktree", repo, branch) &&
+          std::filesystem::path(repo) == root / "worktree" && branch == "0123456");
+
+    std::filesystem::create_directories(root / "plain");
+    bool inRepo = read_git_context(root / "plain", repo, branch);
+    check("outside a repository", !inRepo || std::filesystem::path(repo) != root / "plain");
+
+    std::filesystem::remove_all(root);
+}
+
+int main() {
+    test_compile();
+    test_duration();
+    test_git_context();
+    return test_summary();
+}